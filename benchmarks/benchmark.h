@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Minimal harness shared by the benchmark executables.
+ *
+ * Each benchmark measures named phases. A phase runs a number of times and its median duration is kept, since the median is
+ * less sensitive to scheduling noise than the mean. Results are written as JSON, one result per line, so that they can be compared
+ * with a baseline without a JSON library.
+ *
+ * Common arguments:
+ *  --output <path>      write the results to this JSON file
+ *  --baseline <path>    compare the results with this JSON file
+ *  --iterations <n>     number of runs per phase
+ */
+namespace vre::bench
+{
+    struct BenchmarkResult
+    {
+        std::string name;
+        double      median_ns  = 0.0;
+        double      min_ns     = 0.0;
+        uint32_t    iterations = 0;
+    };
+
+    struct BenchmarkOptions
+    {
+        const char *output_path   = nullptr;
+        const char *baseline_path = nullptr;
+        uint32_t    iterations    = 15;
+    };
+
+    inline BenchmarkOptions parse_options(int argc, char **argv)
+    {
+        BenchmarkOptions options;
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            if (strcmp(argv[i], "--output") == 0)
+            {
+                options.output_path = argv[i + 1];
+            }
+            else if (strcmp(argv[i], "--baseline") == 0)
+            {
+                options.baseline_path = argv[i + 1];
+            }
+            else if (strcmp(argv[i], "--iterations") == 0)
+            {
+                options.iterations = static_cast<uint32_t>(std::max(1, atoi(argv[i + 1])));
+            }
+        }
+        return options;
+    }
+
+    // --=== Results ===--
+
+    /** Writes the results as JSON, one result per line. */
+    inline bool write_results(const char *path, const std::string &benchmark_name, const std::vector<BenchmarkResult> &results)
+    {
+        FILE *file = fopen(path, "w");
+        if (!file)
+        {
+            return false;
+        }
+        fprintf(file, "{\"benchmark\": \"%s\", \"results\": [\n", benchmark_name.c_str());
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const auto &result = results[i];
+            fprintf(file,
+                    "{\"name\": \"%s\", \"median_ns\": %.1f, \"min_ns\": %.1f, \"iterations\": %u}%s\n",
+                    result.name.c_str(),
+                    result.median_ns,
+                    result.min_ns,
+                    result.iterations,
+                    i + 1 < results.size() ? "," : "");
+        }
+        fputs("]}\n", file);
+        return fclose(file) == 0;
+    }
+
+    /** Reads results written by write_results. Returns an empty list if the file can't be read. */
+    inline std::vector<BenchmarkResult> read_results(const char *path)
+    {
+        std::vector<BenchmarkResult> results;
+        FILE                        *file = fopen(path, "r");
+        if (!file)
+        {
+            return results;
+        }
+
+        char line[512];
+        while (fgets(line, sizeof(line), file))
+        {
+            char            name[256];
+            BenchmarkResult result;
+            if (sscanf(line,
+                       "{\"name\": \"%255[^\"]\", \"median_ns\": %lf, \"min_ns\": %lf, \"iterations\": %u",
+                       name,
+                       &result.median_ns,
+                       &result.min_ns,
+                       &result.iterations)
+                == 4)
+            {
+                result.name = name;
+                results.push_back(result);
+            }
+        }
+        fclose(file);
+        return results;
+    }
+
+    /**
+     * Prints the relative difference of each phase with the baseline.
+     * Phases slower than the baseline by more than the tolerance (a fraction, e.g. 0.2 for 20%) are marked as regressions.
+     * A tolerance of 0 disables the check. Returns the number of regressions.
+     */
+    inline uint32_t compare_results(const std::vector<BenchmarkResult> &results,
+                                    const std::vector<BenchmarkResult> &baseline,
+                                    double                              tolerance = 0.0)
+    {
+        uint32_t regression_count = 0;
+        printf("\n%-40s %14s %14s %9s\n", "Phase", "Baseline (ns)", "Current (ns)", "Change");
+        for (const auto &result : results)
+        {
+            auto it = std::find_if(baseline.begin(),
+                                   baseline.end(),
+                                   [&](const BenchmarkResult &other) { return other.name == result.name; });
+            if (it == baseline.end())
+            {
+                printf("%-40s %14s %14.0f %9s\n", result.name.c_str(), "-", result.median_ns, "new");
+                continue;
+            }
+            const double change      = result.median_ns / it->median_ns - 1.0;
+            const bool   is_regressed = tolerance > 0.0 && change > tolerance;
+            printf("%-40s %14.0f %14.0f %+8.1f%%%s\n",
+                   result.name.c_str(),
+                   it->median_ns,
+                   result.median_ns,
+                   change * 100.0,
+                   is_regressed ? "  <-- REGRESSION" : "");
+            if (is_regressed)
+            {
+                regression_count++;
+            }
+        }
+        return regression_count;
+    }
+
+    // --=== Benchmark ===--
+
+    class Benchmark
+    {
+      private:
+        std::string                  m_name;
+        BenchmarkOptions             m_options;
+        std::vector<BenchmarkResult> m_results;
+
+      public:
+        /** The name is the one of the executable, which is also the name of its baseline and of its performance test. */
+        Benchmark(const char *name, const BenchmarkOptions &options) : m_name(name), m_options(options) {}
+
+        /** Runs the phase the configured number of times, after one warm-up run. */
+        template<typename F>
+        const BenchmarkResult &run(const std::string &phase_name, F &&phase)
+        {
+            return run(phase_name, m_options.iterations, std::forward<F>(phase));
+        }
+
+        template<typename F>
+        const BenchmarkResult &run(const std::string &phase_name, uint32_t iterations, F &&phase)
+        {
+            phase();
+
+            std::vector<double> durations(iterations);
+            for (auto &duration : durations)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                phase();
+                duration = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            }
+            std::sort(durations.begin(), durations.end());
+
+            auto &result = m_results.emplace_back(BenchmarkResult {
+                .name       = phase_name,
+                .median_ns  = durations[durations.size() / 2],
+                .min_ns     = durations[0],
+                .iterations = iterations,
+            });
+            printf("%-40s median %12.0f ns   min %12.0f ns\n", result.name.c_str(), result.median_ns, result.min_ns);
+            return result;
+        }
+
+        [[nodiscard]] const std::vector<BenchmarkResult> &results() const { return m_results; }
+
+        /** Writes and compares the results according to the options. Returns the exit code of the benchmark. */
+        int finish() const
+        {
+            if (m_options.output_path != nullptr && !write_results(m_options.output_path, m_name, m_results))
+            {
+                fprintf(stderr, "Failed to write \"%s\"\n", m_options.output_path);
+                return 1;
+            }
+            if (m_options.baseline_path != nullptr)
+            {
+                const auto baseline = read_results(m_options.baseline_path);
+                if (baseline.empty())
+                {
+                    fprintf(stderr, "Failed to read baseline \"%s\"\n", m_options.baseline_path);
+                    return 1;
+                }
+                compare_results(m_results, baseline);
+            }
+            return 0;
+        }
+    };
+
+    /** Prevents the compiler from optimizing away a computed value. */
+    template<typename T>
+    inline void keep(const T &value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile T sink;
+        sink = value;
+#endif
+    }
+} // namespace vre::bench
@@ -0,0 +1,43 @@
+# Runs a benchmark several times and compares the median of the runs with a baseline.
+# Invoked by the performance tests registered with add_perf_test.
+#
+# Variables:
+#  BENCHMARK     path to the benchmark executable
+#  PERF_COMPARE  path to the perf_compare executable
+#  BASELINE      path to the baseline JSON file
+#  RUNS          number of runs of the benchmark
+#  TOLERANCE     allowed slowdown, as a fraction of the baseline
+#  OUTPUT_DIR    directory where the results of the runs are written
+#
+# If the VRE_UPDATE_PERF_BASELINES environment variable is set to 1, the baseline is replaced by the results instead.
+
+get_filename_component(benchmark_name ${BENCHMARK} NAME_WE)
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+
+set(run_files "")
+foreach (run RANGE 1 ${RUNS})
+    set(run_file "${OUTPUT_DIR}/${benchmark_name}_${run}.json")
+    message(STATUS "Run ${run}/${RUNS} of ${benchmark_name}")
+
+    execute_process(
+            COMMAND ${BENCHMARK} --output ${run_file}
+            OUTPUT_QUIET
+            RESULT_VARIABLE result
+    )
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "${benchmark_name} failed with code ${result}")
+    endif ()
+    list(APPEND run_files ${run_file})
+endforeach ()
+
+if ("$ENV{VRE_UPDATE_PERF_BASELINES}" STREQUAL "1")
+    set(update_flag --update)
+endif ()
+
+execute_process(
+        COMMAND ${PERF_COMPARE} --baseline ${BASELINE} --tolerance ${TOLERANCE} ${update_flag} ${run_files}
+        RESULT_VARIABLE result
+)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "Performance regression in ${benchmark_name}")
+endif ()
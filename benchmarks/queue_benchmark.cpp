@@ -0,0 +1,149 @@
+#include "benchmark.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vr_engine/utils/data/mpmc_queue.h>
+#include <vr_engine/utils/data/spsc_queue.h>
+
+using namespace vre;
+using namespace vre::bench;
+
+/**
+ * Throughput of the lock-free queues.
+ *
+ * Each phase moves the same number of values from the producer threads to the consumer threads, one at a time or in batches. A
+ * std::deque behind a mutex is measured as a reference. Threads yield when the queue is full or empty, so that the results stay
+ * meaningful on machines with fewer cores than threads.
+ */
+
+// --=== Constants ===--
+
+#define VALUE_COUNT    (1 << 20)
+#define QUEUE_CAPACITY (1 << 12)
+#define BATCH_SIZE     32
+
+// --=== Types ===--
+
+/** Reference queue */
+class MutexQueue
+{
+  private:
+    std::mutex           m_mutex;
+    std::deque<uint64_t> m_values;
+
+  public:
+    size_t try_push(const uint64_t *values, size_t count)
+    {
+        std::lock_guard lock(m_mutex);
+        count = std::min(count, QUEUE_CAPACITY - m_values.size());
+        m_values.insert(m_values.end(), values, values + count);
+        return count;
+    }
+
+    size_t try_pop(uint64_t *out_values, size_t max_count)
+    {
+        std::lock_guard lock(m_mutex);
+        const auto      count = std::min(max_count, m_values.size());
+        std::copy(m_values.begin(), m_values.begin() + static_cast<ptrdiff_t>(count), out_values);
+        m_values.erase(m_values.begin(), m_values.begin() + static_cast<ptrdiff_t>(count));
+        return count;
+    }
+};
+
+// --=== Transfer ===--
+
+/** Moves VALUE_COUNT values through the queue, split between the producers, and returns their sum as seen by the consumers. */
+template<typename Queue>
+uint64_t transfer(Queue &queue, uint32_t producer_count, uint32_t consumer_count, size_t batch_size)
+{
+    std::atomic<uint64_t>    received_count = 0;
+    std::atomic<uint64_t>    sum            = 0;
+    std::vector<std::thread> threads;
+
+    for (uint32_t producer = 0; producer < producer_count; producer++)
+    {
+        threads.emplace_back(
+            [&, producer]()
+            {
+                const uint64_t begin = VALUE_COUNT * producer / producer_count;
+                const uint64_t end   = VALUE_COUNT * (producer + 1) / producer_count;
+                uint64_t       values[BATCH_SIZE];
+                for (uint64_t next = begin; next < end;)
+                {
+                    const auto count = std::min<uint64_t>(batch_size, end - next);
+                    for (uint64_t i = 0; i < count; i++)
+                    {
+                        values[i] = next + i;
+                    }
+                    const auto pushed_count = queue.try_push(values, count);
+                    next += pushed_count;
+                    if (pushed_count == 0)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+    }
+    for (uint32_t consumer = 0; consumer < consumer_count; consumer++)
+    {
+        threads.emplace_back(
+            [&]()
+            {
+                uint64_t values[BATCH_SIZE];
+                uint64_t local_sum = 0;
+                while (received_count.load(std::memory_order_relaxed) < VALUE_COUNT)
+                {
+                    const auto count = queue.try_pop(values, batch_size);
+                    if (count == 0)
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        local_sum += values[i];
+                    }
+                    received_count.fetch_add(count, std::memory_order_relaxed);
+                }
+                sum.fetch_add(local_sum, std::memory_order_relaxed);
+            });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    return sum.load();
+}
+
+// --=== Main ===--
+
+int main(int argc, char **argv)
+{
+    auto options = parse_options(argc, argv);
+    // Each run moves a million values, fewer runs are enough
+    options.iterations = std::min(options.iterations, 7u);
+    Benchmark benchmark("queue_benchmark", options);
+
+    auto spsc_queue  = std::make_unique<SpscQueue<uint64_t, QUEUE_CAPACITY>>();
+    auto mpmc_queue  = std::make_unique<MpmcQueue<uint64_t, QUEUE_CAPACITY>>();
+    auto mutex_queue = std::make_unique<MutexQueue>();
+
+    for (size_t batch_size : {1, BATCH_SIZE})
+    {
+        const auto suffix = batch_size == 1 ? std::string() : "_batch_" + std::to_string(batch_size);
+
+        benchmark.run("spsc/1p1c" + suffix, [&]() { keep(transfer(*spsc_queue, 1, 1, batch_size)); });
+        for (uint32_t thread_count : {1u, 2u, 4u})
+        {
+            const auto threads = std::to_string(thread_count) + "p" + std::to_string(thread_count) + "c";
+            benchmark.run("mpmc/" + threads + suffix, [&]() { keep(transfer(*mpmc_queue, thread_count, thread_count, batch_size)); });
+            benchmark.run("mutex_deque/" + threads + suffix,
+                          [&]() { keep(transfer(*mutex_queue, thread_count, thread_count, batch_size)); });
+        }
+    }
+
+    return benchmark.finish();
+}
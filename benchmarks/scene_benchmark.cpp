@@ -0,0 +1,274 @@
+#include "benchmark.h"
+
+#include <cmath>
+#include <random>
+#include <vr_engine/core/renderer/instance_batcher.h>
+#include <vr_engine/core/renderer/light_clusters.h>
+#include <vr_engine/core/renderer/lod_selector.h>
+
+using namespace vre;
+using namespace vre::bench;
+
+/**
+ * Full-frame CPU benchmark on synthetic scenes.
+ *
+ * The scenes contain a growing number of instances sharing a fixed set of materials, meshes and lights. Each phase of the CPU side
+ * of a stereo frame is measured separately, with the same engine classes as the renderer: transform update and LOD selection in
+ * the InstanceBatcher and the LodSelector, rebuild and upload of the batches, and light binning in the LightClusterer. Changes to
+ * these classes are then visible in the results.
+ */
+
+// --=== Constants ===--
+
+#define MATERIAL_COUNT          64
+#define MESH_COUNT              256
+#define LOD_COUNT               4
+#define LIGHT_COUNT             256
+#define SCENE_HALF_SIZE         100.0f
+#define INTERPUPILLARY_DISTANCE 0.064f
+#define EYE_WIDTH               2064
+#define EYE_HEIGHT              2208
+
+// --=== Types ===--
+
+struct SceneInstance
+{
+    float    position[3] = {0.0f, 0.0f, 0.0f};
+    float    scale       = 1.0f;
+    uint64_t mesh        = 0;
+    uint64_t material    = 0;
+};
+
+struct SyntheticScene
+{
+    InstanceBatcher                  batcher;
+    std::vector<InstanceBatcher::Id> ids;
+    // LOD chain of each mesh, indexed by mesh id
+    std::vector<std::vector<MeshLod>> mesh_lods;
+    LodSelector                       lod_selector;
+    std::vector<InstanceTransform>    instance_buffer;
+    std::vector<PointLight>           lights;
+    LightClusterer                    light_clusterer;
+};
+
+// --=== Scene generation ===--
+
+std::vector<SceneInstance> generate_instances(uint32_t count, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float>   position(-SCENE_HALF_SIZE, SCENE_HALF_SIZE);
+    std::uniform_real_distribution<float>   scale(0.2f, 2.0f);
+    std::uniform_int_distribution<uint32_t> material(0, MATERIAL_COUNT - 1);
+    std::uniform_int_distribution<uint32_t> mesh(1, MESH_COUNT);
+
+    std::vector<SceneInstance> instances(count);
+    for (auto &instance : instances)
+    {
+        instance.position[0] = position(rng);
+        instance.position[1] = position(rng) * 0.1f;
+        instance.position[2] = position(rng);
+        instance.scale       = scale(rng);
+        instance.material    = material(rng);
+        instance.mesh        = mesh(rng);
+    }
+    return instances;
+}
+
+/** LOD chains in which each LOD has a quarter of the triangles and twice the error of the previous one. */
+std::vector<std::vector<MeshLod>> generate_mesh_lods(std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> first_error(0.002f, 0.02f);
+
+    std::vector<std::vector<MeshLod>> mesh_lods(MESH_COUNT + 1);
+    for (uint32_t mesh = 1; mesh <= MESH_COUNT; mesh++)
+    {
+        uint32_t index_count = 3 * 4096;
+        float    error       = first_error(rng);
+        for (uint32_t lod = 0; lod < LOD_COUNT; lod++)
+        {
+            mesh_lods[mesh].push_back({.index_count = index_count, .error = lod == 0 ? 0.0f : error});
+            index_count /= 4;
+            error *= 2.0f;
+        }
+    }
+    return mesh_lods;
+}
+
+std::vector<PointLight> generate_lights(std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> position(-SCENE_HALF_SIZE, SCENE_HALF_SIZE);
+    std::uniform_real_distribution<float> radius(1.0f, 10.0f);
+
+    std::vector<PointLight> lights(LIGHT_COUNT);
+    for (auto &light : lights)
+    {
+        light.position[0] = position(rng);
+        light.position[1] = 2.0f;
+        light.position[2] = position(rng);
+        light.radius      = radius(rng);
+    }
+    return lights;
+}
+
+/** Transform of an instance spinning around Y. */
+InstanceTransform spinning_transform(const SceneInstance &instance, float time)
+{
+    const float sin_a = std::sin(time) * instance.scale;
+    const float cos_a = std::cos(time) * instance.scale;
+    return InstanceTransform {
+        .rows = {
+            {cos_a, 0.0f, sin_a, instance.position[0]},
+            {0.0f, instance.scale, 0.0f, instance.position[1]},
+            {-sin_a, 0.0f, cos_a, instance.position[2]},
+        },
+    };
+}
+
+// --=== Phases ===--
+
+void update_transforms(SyntheticScene &scene, const std::vector<SceneInstance> &instances, float time)
+{
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        scene.batcher.set_transform(scene.ids[i], spinning_transform(instances[i], time));
+    }
+}
+
+/** Same selection as the renderer, from the two eyes of a headset looking down -z. */
+void select_lods(SyntheticScene &scene, float lod_bias)
+{
+    LodView views[2];
+    for (uint32_t eye = 0; eye < 2; eye++)
+    {
+        views[eye] = {
+            .position    = {(static_cast<float>(eye) - 0.5f) * INTERPUPILLARY_DISTANCE, 0.0f, 0.0f},
+            .angle_left  = -0.8f,
+            .angle_right = 0.8f,
+            .angle_up    = 0.8f,
+            .angle_down  = -0.8f,
+            .width       = EYE_WIDTH,
+            .height      = EYE_HEIGHT,
+        };
+    }
+    scene.lod_selector.set_views(views, 2, lod_bias);
+
+    scene.batcher.select_lods(
+        [&](uint64_t mesh, const InstanceTransform &transform, uint32_t current_lod)
+        {
+            const auto &lods        = scene.mesh_lods[mesh];
+            const float position[3] = {transform.rows[0][3], transform.rows[1][3], transform.rows[2][3]};
+            return scene.lod_selector.select(lods.data(),
+                                             static_cast<uint32_t>(lods.size()),
+                                             position,
+                                             max_axis_scale(transform),
+                                             current_lod);
+        });
+}
+
+void write_instances(SyntheticScene &scene)
+{
+    scene.batcher.update();
+    scene.instance_buffer.resize(scene.batcher.instance_count());
+    scene.batcher.write_instances(scene.instance_buffer.data());
+}
+
+void bin_lights(SyntheticScene &scene)
+{
+    ClusterView views[2];
+    for (uint32_t eye = 0; eye < 2; eye++)
+    {
+        views[eye] = {
+            .position    = {(static_cast<float>(eye) - 0.5f) * INTERPUPILLARY_DISTANCE, 0.0f, 0.0f},
+            .angle_left  = -0.8f,
+            .angle_right = 0.8f,
+            .angle_up    = 0.8f,
+            .angle_down  = -0.8f,
+        };
+    }
+    scene.light_clusterer.set_views(views, 2);
+    scene.light_clusterer.bin_lights(scene.lights.data(), static_cast<uint32_t>(scene.lights.size()));
+}
+
+// --=== Main ===--
+
+int main(int argc, char **argv)
+{
+    const auto options = parse_options(argc, argv);
+    Benchmark  benchmark("scene_benchmark", options);
+
+    for (uint32_t instance_count : {1000u, 10000u, 100000u})
+    {
+        std::mt19937 rng(42);
+        const auto   instances = generate_instances(instance_count, rng);
+        const auto   prefix    = std::to_string(instance_count / 1000) + "k/";
+
+        SyntheticScene scene;
+        scene.mesh_lods = generate_mesh_lods(rng);
+        scene.lights    = generate_lights(rng);
+
+        benchmark.run(prefix + "build",
+                      [&]()
+                      {
+                          scene.batcher = {};
+                          scene.ids.clear();
+                          for (const auto &instance : instances)
+                          {
+                              scene.ids.push_back(scene.batcher.add_instance(instance.mesh,
+                                                                             instance.material,
+                                                                             spinning_transform(instance, 0.0f)));
+                          }
+                          scene.batcher.update();
+                      });
+
+        float time = 0.0f;
+        benchmark.run(prefix + "transform_update",
+                      [&]()
+                      {
+                          time += 0.011f;
+                          update_transforms(scene, instances, time);
+                      });
+        // Once the LODs are selected, they are stable from one frame to the next
+        benchmark.run(prefix + "lod_selection", [&]() { select_lods(scene, 0.0f); });
+        // The governor changing the LOD bias moves most instances to another batch, which rebuilds the batches
+        float lod_bias = 0.0f;
+        benchmark.run(prefix + "lod_switch",
+                      [&]()
+                      {
+                          lod_bias = lod_bias == 0.0f ? 2.0f : 0.0f;
+                          select_lods(scene, lod_bias);
+                          scene.batcher.update();
+                      });
+        benchmark.run(prefix + "instance_write", [&]() { write_instances(scene); });
+        benchmark.run(prefix + "light_binning", [&]() { bin_lights(scene); });
+        benchmark.run(prefix + "frame",
+                      [&]()
+                      {
+                          time += 0.011f;
+                          update_transforms(scene, instances, time);
+                          select_lods(scene, 0.0f);
+                          write_instances(scene);
+                          bin_lights(scene);
+                      });
+
+        // Random moves, as done when the game code updates specific instances
+        std::uniform_int_distribution<size_t> index(0, scene.ids.size() - 1);
+        std::vector<size_t>                   moved(10000);
+        for (auto &i : moved)
+        {
+            i = index(rng);
+        }
+        benchmark.run(prefix + "move_10k",
+                      [&]()
+                      {
+                          time += 0.011f;
+                          for (const auto i : moved)
+                          {
+                              scene.batcher.set_transform(scene.ids[i], spinning_transform(instances[i], time));
+                          }
+                      });
+
+        keep(scene.instance_buffer.size());
+        keep(scene.light_clusterer.light_indices().size());
+    }
+
+    return benchmark.finish();
+}
@@ -0,0 +1,145 @@
+#include "benchmark.h"
+
+#include <random>
+#include <vr_engine/utils/sort.h>
+
+using namespace vre;
+using namespace vre::bench;
+
+/**
+ * Radix sorts against std::sort.
+ *
+ * Keys are sorted alone, as 64-bit draw keys with unused high bits and as random 32-bit ids, and with a 32-bit payload, as done when
+ * sorting entities by key. Each run sorts a fresh copy of the same input, so the copy is part of every measure.
+ */
+
+// --=== Types ===--
+
+struct KeyValue
+{
+    uint32_t key   = 0;
+    uint32_t value = 0;
+};
+
+// --=== Input generation ===--
+
+std::vector<uint64_t> generate_draw_keys(size_t count, std::mt19937_64 &rng)
+{
+    // Same layout as the draw keys of the scene benchmark: 6 bits of material, 8 of mesh, 14 of depth and 32 of index
+    std::vector<uint64_t> keys(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint64_t material = rng() % 64;
+        const uint64_t mesh     = rng() % 256;
+        const uint64_t depth    = rng() & 0x3FFF;
+        keys[i]                 = (material << 56) | (mesh << 46) | (depth << 32) | i;
+    }
+    return keys;
+}
+
+std::vector<uint32_t> generate_ids(size_t count, std::mt19937_64 &rng)
+{
+    std::vector<uint32_t> ids(count);
+    for (auto &id : ids)
+    {
+        id = static_cast<uint32_t>(rng());
+    }
+    return ids;
+}
+
+// --=== Main ===--
+
+int main(int argc, char **argv)
+{
+    const auto options = parse_options(argc, argv);
+    Benchmark  benchmark("sort_benchmark", options);
+
+    for (size_t count : {10000u, 100000u, 1000000u})
+    {
+        std::mt19937_64 rng(42);
+        const auto      prefix = std::to_string(count / 1000) + "k/";
+
+        // 64-bit draw keys
+        const auto            draw_keys = generate_draw_keys(count, rng);
+        std::vector<uint64_t> keys_64;
+        std::vector<uint64_t> scratch_64(count);
+
+        benchmark.run(prefix + "draw_keys/std_sort",
+                      [&]()
+                      {
+                          keys_64 = draw_keys;
+                          std::sort(keys_64.begin(), keys_64.end());
+                      });
+        benchmark.run(prefix + "draw_keys/radix_sort",
+                      [&]()
+                      {
+                          keys_64 = draw_keys;
+                          radix_sort(keys_64.data(), keys_64.size(), scratch_64.data());
+                      });
+        benchmark.run(prefix + "draw_keys/radix_sort_8_bits",
+                      [&]()
+                      {
+                          keys_64 = draw_keys;
+                          radix_sort<8>(keys_64.data(), keys_64.size(), scratch_64.data());
+                      });
+        benchmark.run(prefix + "draw_keys/parallel_radix_sort",
+                      [&]()
+                      {
+                          keys_64 = draw_keys;
+                          parallel_radix_sort(keys_64);
+                      });
+
+        // 32-bit ids
+        const auto            ids = generate_ids(count, rng);
+        std::vector<uint32_t> keys_32;
+        std::vector<uint32_t> scratch_32(count);
+
+        benchmark.run(prefix + "ids/std_sort",
+                      [&]()
+                      {
+                          keys_32 = ids;
+                          std::sort(keys_32.begin(), keys_32.end());
+                      });
+        benchmark.run(prefix + "ids/radix_sort",
+                      [&]()
+                      {
+                          keys_32 = ids;
+                          radix_sort(keys_32.data(), keys_32.size(), scratch_32.data());
+                      });
+
+        // 32-bit keys with a payload. std::sort needs the pairs in a single array.
+        std::vector<KeyValue> pairs(count);
+        std::vector<KeyValue> sorted_pairs;
+        std::vector<uint32_t> values(count);
+        std::vector<uint32_t> sorted_values;
+        std::vector<uint32_t> value_scratch(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            pairs[i]  = {ids[i], i};
+            values[i] = i;
+        }
+
+        benchmark.run(prefix + "key_value/std_sort",
+                      [&]()
+                      {
+                          sorted_pairs = pairs;
+                          std::sort(sorted_pairs.begin(),
+                                    sorted_pairs.end(),
+                                    [](const KeyValue &a, const KeyValue &b) { return a.key < b.key; });
+                      });
+        benchmark.run(prefix + "key_value/radix_sort",
+                      [&]()
+                      {
+                          keys_32       = ids;
+                          sorted_values = values;
+                          radix_sort(keys_32.data(), sorted_values.data(), count, scratch_32.data(), value_scratch.data());
+                      });
+
+        keep(keys_64.back());
+        keep(keys_32.back());
+        keep(sorted_pairs.back().value);
+        keep(sorted_values.back());
+    }
+
+    return benchmark.finish();
+}
@@ -5,10 +5,25 @@
 
 #include "test_framework/test_framework.h"
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define TF_HAS_CYCLE_COUNTER 1
+#ifndef _MSC_VER
+#include <x86intrin.h>
+#endif
+#endif
+
+#if !(WIN32 || _WIN32 || WIN64 || _WIN64)
+#include <time.h>
+#endif
+
+// Minimal duration of a benchmark sample, in nanoseconds
+#define TF_BENCH_MIN_SAMPLE_NS 5000000
+
 // --- Macros for pretty printing ---
 
 // If WIN32 or _WIN32 or WIN64 or _WIN64 is defined, we are on a Windows platform.
@@ -89,7 +104,8 @@ typedef struct tf_linked_list_it
 
 typedef struct tf_context
 {
-    tf_linked_list errors;
+    tf_linked_list  errors;
+    tf_bench_result last_bench_result;
 } tf_context;
 
 // --- Functions ---
@@ -333,6 +349,180 @@ bool tf_assert_error(tf_context *context, size_t line_number, const char *file,
                             recoverable);
 }
 
+// Benchmarks
+
+uint64_t tf_time_ns(void)
+{
+#if WIN32 || _WIN32 || WIN64 || _WIN64
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (uint64_t) ((double) counter.QuadPart * 1e9 / (double) frequency.QuadPart);
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000ull + (uint64_t) time.tv_nsec;
+#endif
+}
+
+uint64_t tf_cycles(void)
+{
+#ifdef TF_HAS_CYCLE_COUNTER
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Two-sided 95% quantile of the Student t distribution
+double tf_student_t_95(uint32_t degrees_of_freedom)
+{
+    static const double table[30] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                     2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                     2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (degrees_of_freedom == 0)
+    {
+        return 0.0;
+    }
+    return degrees_of_freedom <= 30 ? table[degrees_of_freedom - 1] : 1.960;
+}
+
+tf_bench tf_bench_begin(tf_context *context, const char *name)
+{
+    tf_bench bench       = {0};
+    bench.context        = context;
+    bench.name           = name;
+    bench.iterations     = 1;
+    bench.is_calibrating = true;
+    return bench;
+}
+
+void tf_bench_start_sample(tf_bench *bench)
+{
+    // The current call to tf_bench_running counts as the first iteration
+    bench->remaining                = bench->iterations - 1;
+    bench->is_sample_started        = true;
+    bench->sample_start_allocations = tf_allocation_count();
+    bench->sample_start_cycles      = tf_cycles();
+    bench->sample_start_ns          = tf_time_ns();
+}
+
+void tf_bench_report(tf_bench *bench)
+{
+    tf_bench_result result = {
+        .name                  = bench->name,
+        .sample_count          = TF_BENCH_SAMPLE_COUNT,
+        .iterations_per_sample = bench->iterations,
+        .min_ns                = bench->samples_ns[0],
+    };
+
+    double sum = 0.0;
+    for (uint32_t i = 0; i < TF_BENCH_SAMPLE_COUNT; i++)
+    {
+        sum += bench->samples_ns[i];
+        if (bench->samples_ns[i] < result.min_ns)
+        {
+            result.min_ns = bench->samples_ns[i];
+        }
+    }
+    result.mean_ns = sum / TF_BENCH_SAMPLE_COUNT;
+
+    double squared_deviations = 0.0;
+    for (uint32_t i = 0; i < TF_BENCH_SAMPLE_COUNT; i++)
+    {
+        const double deviation = bench->samples_ns[i] - result.mean_ns;
+        squared_deviations += deviation * deviation;
+    }
+    result.stddev_ns     = sqrt(squared_deviations / (TF_BENCH_SAMPLE_COUNT - 1));
+    result.confidence_ns = tf_student_t_95(TF_BENCH_SAMPLE_COUNT - 1) * result.stddev_ns / sqrt(TF_BENCH_SAMPLE_COUNT);
+
+    const double total_iterations = (double) bench->iterations * TF_BENCH_SAMPLE_COUNT;
+    result.cycles                 = (double) bench->total_cycles / total_iterations;
+    result.allocations            = tf_counts_allocations() ? (double) bench->total_allocations / total_iterations : NAN;
+
+    bench->context->last_bench_result = result;
+
+    // Print it
+    printf("  [");
+    TF_FORMAT_BOLD;
+    printf("Bench");
+    TF_FORMAT_RESET;
+    printf("] %s\n", result.name);
+    printf("    %.3f ns/iter +- %.3f ns (95%% CI), stddev %.3f ns, min %.3f ns\n",
+           result.mean_ns,
+           result.confidence_ns,
+           result.stddev_ns,
+           result.min_ns);
+    if (tf_counts_allocations())
+    {
+        printf("    %.1f cycles/iter, %.2f allocations/iter, %u samples of %llu iterations\n",
+               result.cycles,
+               result.allocations,
+               result.sample_count,
+               (unsigned long long) result.iterations_per_sample);
+    }
+    else
+    {
+        printf("    %.1f cycles/iter, %u samples of %llu iterations\n",
+               result.cycles,
+               result.sample_count,
+               (unsigned long long) result.iterations_per_sample);
+    }
+}
+
+bool tf_bench_next_sample(tf_bench *bench)
+{
+    if (!bench->is_sample_started)
+    {
+        tf_bench_start_sample(bench);
+        return true;
+    }
+
+    // End the current sample
+    const uint64_t elapsed_ns  = tf_time_ns() - bench->sample_start_ns;
+    const uint64_t cycles      = tf_cycles() - bench->sample_start_cycles;
+    const uint64_t allocations = tf_allocation_count() - bench->sample_start_allocations;
+
+    if (bench->is_calibrating)
+    {
+        if (elapsed_ns < TF_BENCH_MIN_SAMPLE_NS)
+        {
+            // Estimate the needed count from the last sample, but grow at least 2 times and at most 100 times
+            const double estimate   = (double) bench->iterations * 1.2 * TF_BENCH_MIN_SAMPLE_NS / (double) (elapsed_ns + 1);
+            const double growth_max = (double) bench->iterations * 100.0;
+            uint64_t     iterations = (uint64_t) (estimate < growth_max ? estimate : growth_max);
+            bench->iterations       = iterations > bench->iterations * 2 ? iterations : bench->iterations * 2;
+        }
+        else
+        {
+            // Long enough, the samples can begin. The calibration samples also served as warm-up.
+            bench->is_calibrating = false;
+        }
+    }
+    else
+    {
+        bench->samples_ns[bench->sample_index] = (double) elapsed_ns / (double) bench->iterations;
+        bench->total_cycles += cycles;
+        bench->total_allocations += allocations;
+        bench->sample_index++;
+
+        if (bench->sample_index == TF_BENCH_SAMPLE_COUNT)
+        {
+            tf_bench_report(bench);
+            return false;
+        }
+    }
+
+    tf_bench_start_sample(bench);
+    return true;
+}
+
+tf_bench_result tf_last_bench_result(tf_context *context)
+{
+    return context->last_bench_result;
+}
+
 // Main
 
 bool tf_run_test(tf_test_function pfn_test)
@@ -8,6 +8,25 @@
 #include <exception>
 #include <string>
 
+// --- Allocation counting ---
+
+// Incremented by the replaced allocation functions of test_framework_allocations.cpp, which only the benchmarks link.
+// Per-thread counts keep the benchmarks unaffected by background threads.
+thread_local uint64_t tf_thread_allocation_count = 0;
+bool                  tf_allocations_are_counted = false;
+
+uint64_t tf_allocation_count(void)
+{
+    return tf_thread_allocation_count;
+}
+
+bool tf_counts_allocations(void)
+{
+    return tf_allocations_are_counted;
+}
+
+// --- Assertions ---
+
 bool tf_assert_throws(tf_context *context, size_t line_number, const char *file, const tf_callback& fn, bool recoverable)
 {
     // Run the test
@@ -0,0 +1,77 @@
+/**
+ * @file Simple lightweight testing framework for C or C++ projects, inspired by Google Tests API. Allocation counting for the
+ * benchmarks.
+ * @author Martin Danhier
+ *
+ * The global allocation functions are replaced to count the allocations of each thread. Since the replacement applies to the whole
+ * executable, this file is only linked in the benchmarks, and the other tests keep the default allocation functions.
+ */
+
+#include "test_framework/test_framework.hpp"
+
+#include <cstdlib>
+#include <new>
+
+#if WIN32 || _WIN32 || WIN64 || _WIN64
+#include <malloc.h>
+#endif
+
+// Defined in test_framework.cpp
+extern thread_local uint64_t tf_thread_allocation_count;
+extern bool                  tf_allocations_are_counted;
+
+// Tells the benchmarks that the allocations are counted, before the tests start
+[[maybe_unused]] static const bool tf_allocation_counting_enabled = (tf_allocations_are_counted = true);
+
+void *operator new(std::size_t size)
+{
+    tf_thread_allocation_count++;
+    void *pointer = std::malloc(size > 0 ? size : 1);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    tf_thread_allocation_count++;
+    const auto align = static_cast<std::size_t>(alignment);
+    size             = size > 0 ? size : 1;
+#if WIN32 || _WIN32 || WIN64 || _WIN64
+    void *pointer = _aligned_malloc(size, align);
+#else
+    // The size must be a multiple of the alignment
+    void *pointer = std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept
+{
+#if WIN32 || _WIN32 || WIN64 || _WIN64
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+void operator delete(void *pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(pointer, alignment);
+}
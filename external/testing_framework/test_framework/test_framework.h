@@ -15,6 +15,10 @@ extern "C"
 #include <stddef.h>
 #include <stdint.h>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 // --- Macros ---
 
 // First macro: add the counter macro
@@ -58,6 +62,14 @@ extern "C"
 
 #define ERROR_AND_QUIT(message) do { if (!tf_assert_error(___context___, __LINE__, __FILE__, (message), false)) return; } while (0)
 
+// Benchmarks: runs the following block repeatedly, then prints timing statistics. The result is then available with LAST_BENCH_RESULT.
+#define BENCH(name) for (tf_bench ___bench___ = tf_bench_begin(___context___, (name)); tf_bench_running(&___bench___);)
+
+#define LAST_BENCH_RESULT tf_last_bench_result(___context___)
+
+// Forces the compiler to assume that all memory was read and written, so that stores before it can't be optimized away.
+#define CLOBBER_MEMORY() tf_clobber_memory()
+
     // clang-format on
 
     // --- Types ---
@@ -72,6 +84,44 @@ extern "C"
 
     typedef void (*tf_test_function)(tf_context *);
 
+// Number of measured samples in a benchmark
+#define TF_BENCH_SAMPLE_COUNT 20
+
+    typedef struct tf_bench_result
+    {
+        const char *name;
+        uint32_t    sample_count;
+        uint64_t    iterations_per_sample;
+        // Statistics of the duration of one iteration, in nanoseconds
+        double mean_ns;
+        double stddev_ns;
+        // Half-width of the 95% confidence interval of the mean
+        double confidence_ns;
+        double min_ns;
+        // Mean per iteration. Cycles are 0 if the platform has no cycle counter, and allocations are NaN if they are not counted.
+        double cycles;
+        double allocations;
+    } tf_bench_result;
+
+    // State of a BENCH block. The number of iterations of each sample is calibrated so that a sample lasts long enough for the
+    // timer resolution to be negligible.
+    typedef struct tf_bench
+    {
+        tf_context *context;
+        const char *name;
+        uint64_t    iterations;
+        uint64_t    remaining;
+        uint32_t    sample_index;
+        bool        is_calibrating;
+        bool        is_sample_started;
+        uint64_t    sample_start_ns;
+        uint64_t    sample_start_cycles;
+        uint64_t    sample_start_allocations;
+        uint64_t    total_cycles;
+        uint64_t    total_allocations;
+        double      samples_ns[TF_BENCH_SAMPLE_COUNT];
+    } tf_bench;
+
     // --- Functions ---
 
     int tf_main(tf_test_function pfn_test);
@@ -92,6 +142,45 @@ extern "C"
 
     bool tf_assert_error(tf_context *context, size_t line_number, const char *file, const char *message, bool recoverable);
 
+    // Benchmarks
+
+    tf_bench tf_bench_begin(tf_context *context, const char *name);
+
+    // Ends the current sample and starts the next one. Returns false when the benchmark is complete.
+    bool tf_bench_next_sample(tf_bench *bench);
+
+    static inline bool tf_bench_running(tf_bench *bench)
+    {
+        if (bench->remaining > 0)
+        {
+            bench->remaining--;
+            return true;
+        }
+        return tf_bench_next_sample(bench);
+    }
+
+    tf_bench_result tf_last_bench_result(tf_context *context);
+
+    // Monotonic time in nanoseconds
+    uint64_t tf_time_ns(void);
+
+    // Value of the CPU timestamp counter, or 0 if there is none
+    uint64_t tf_cycles(void);
+
+    // Number of C++ allocations made by the calling thread since its creation. Implemented in the C++ extension.
+    // The allocations are only counted in the executables that link test_framework_allocations.cpp, e.g. the benchmarks.
+    uint64_t tf_allocation_count(void);
+    bool     tf_counts_allocations(void);
+
+    static inline void tf_clobber_memory(void)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __asm__ volatile("" : : : "memory");
+#elif defined(_MSC_VER)
+        _ReadWriteBarrier();
+#endif
+    }
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -23,6 +23,9 @@
 #define ASSERT_NO_THROWS(fn) do { if (!tf_assert_no_throws(___context___, __LINE__, __FILE__, [&](){fn;}, false)) return; } while (0)
 #define ASSERT_EQ(actual, expected) do { if (!tf_assert_equal(___context___, __LINE__, __FILE__, (actual), (expected), false)) return; } while (0)
 
+// Forces the compiler to compute the given value, even if it is not used afterwards.
+#define DO_NOT_OPTIMIZE(value) tf_do_not_optimize(value)
+
 // clang-format on
 
 // Functions
@@ -33,6 +36,19 @@ using tf_callback = std::function<void()>;
 bool tf_assert_throws(tf_context *context, size_t line_number, const char *file, const tf_callback& fn, bool recoverable);
 bool tf_assert_no_throws(tf_context *context, size_t line_number, const char *file, const tf_callback& fn, bool recoverable);
 
+template<typename T>
+inline void tf_do_not_optimize(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    // Reading through a volatile pointer can't be removed
+    const volatile char *bytes = reinterpret_cast<const volatile char *>(&value);
+    (void) *bytes;
+    _ReadWriteBarrier();
+#endif
+}
+
 template<typename T>
 bool tf_assert_equal(tf_context *context, size_t line_number, const char *file, const T &actual, const T &expected, bool recoverable)
 {
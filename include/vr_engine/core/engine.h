@@ -1,8 +1,17 @@
 #pragma once
 
+#include <vr_engine/core/scene.h>
+
 namespace vre
 {
+    struct CookedMesh;
+    struct InstanceTransform;
+    struct MeshLod;
+    struct MeshQuantization;
+    struct PointLight;
     struct Settings;
+    struct UiPanelSettings;
+    class MetricsRegistry;
 
     class Engine
     {
@@ -21,6 +30,40 @@ namespace vre
 
         void run_main_loop();
 
+        /** Counters, gauges and histograms recorded by the engine systems. */
+        [[nodiscard]] MetricsRegistry &metrics() const;
+
+        // UI panels
+        Id   create_ui_panel(const UiPanelSettings &settings);
+        void destroy_ui_panel(Id panel_id);
+        /** Notifies the engine that the content of the panel changed and that it should be rendered again. */
+        void invalidate_ui_panel(Id panel_id);
+
+        // Meshes
+        /** The vertices must have the layout given in the geometry settings. See VrRenderer::create_mesh for the LODs. */
+        Id   create_mesh(const void             *vertices,
+                         uint32_t                vertex_count,
+                         const uint32_t         *indices,
+                         uint32_t                index_count,
+                         const MeshLod          *lods         = nullptr,
+                         uint32_t                lod_count    = 0,
+                         const MeshQuantization *quantization = nullptr);
+        /**
+         * Uploads a mesh from the asset cooker, with its LODs and the quantization of its positions. The vertex stride of the geometry
+         * settings must be the size of a CookedVertex.
+         */
+        Id   create_mesh(const CookedMesh &mesh);
+        void destroy_mesh(Id mesh_id);
+        /** Instances sharing a mesh and a material are drawn with a single instanced draw. */
+        Id   add_instance(Id mesh_id, Id material_id, const InstanceTransform &transform);
+        void remove_instance(Id instance_id);
+        void set_instance_transform(Id instance_id, const InstanceTransform &transform);
+
+        // Lights
+        /** Each fragment is only shaded by the lights of its cluster, so scenes can have hundreds of dynamic lights. */
+        Id   add_light(const PointLight &light);
+        void remove_light(Id light_id);
+        void set_light(Id light_id, const PointLight &light);
     };
 
 } // namespace vre
\ No newline at end of file
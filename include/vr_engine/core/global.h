@@ -57,10 +57,93 @@ namespace vre
         Extent2D extent  = {500, 500};
     };
 
+    /** A UI panel is a flat rectangle placed in the world, displayed by the compositor as a quad layer. */
+    struct UiPanelSettings
+    {
+        /** Resolution of the panel texture, in pixels */
+        Extent2D resolution          = {512, 512};
+        /** Size of the panel in the world, in meters */
+        float    width               = 1.0f;
+        float    height              = 1.0f;
+        /** Pose of the center of the panel, relative to the reference space */
+        float    position[3]         = {0.0f, 0.0f, -1.0f};
+        float    orientation[4]      = {0.0f, 0.0f, 0.0f, 1.0f};
+        float    background_color[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    };
+
+    struct PerformanceSettings
+    {
+        /** Scale the rendering quality automatically to keep the frame rate */
+        bool adaptive_quality      = true;
+        /** Choose the display refresh rate automatically, when the runtime supports it */
+        bool adaptive_refresh_rate = true;
+
+        /** If set, the metrics are appended to this CSV file every metrics_dump_interval seconds */
+        const char *metrics_csv_path      = nullptr;
+        /** If set, the metrics of the last interval are written to this JSON file every metrics_dump_interval seconds */
+        const char *metrics_json_path     = nullptr;
+        double      metrics_dump_interval = 10.0;
+
+        /** If set, the poses and events of the session are recorded to this file */
+        const char *record_path = nullptr;
+        /**
+         * If set, the poses recorded in this file are rendered instead of the tracked ones, so that performance runs are reproducible.
+         * The recorded refresh rate changes are requested again, instead of the ones of the adaptive refresh rate. The engine quits at
+         * the end of the recording, or where the recorded session ended.
+         */
+        const char *replay_path = nullptr;
+    };
+
+    /**
+     * The vertices and indices of all meshes are stored in two shared GPU buffers, allocated once with these capacities. All vertices
+     * have the same layout.
+     */
+    struct GeometrySettings
+    {
+        /** Size of a vertex, in bytes */
+        uint32_t vertex_stride      = 32;
+        uint32_t max_vertex_count   = 1 << 20;
+        /** Indices are 32-bit */
+        uint32_t max_index_count    = 1 << 22;
+        /** Maximum number of mesh instances drawn in a frame */
+        uint32_t max_instance_count = 1 << 16;
+    };
+
+    /**
+     * The point lights are binned each frame into clusters of the view frusta, so that the shading of a fragment only loops over the
+     * lights of its cluster. The buffers of the lights and of the clusters are allocated once with these capacities.
+     */
+    struct LightingSettings
+    {
+        uint32_t max_light_count              = 1024;
+        /** The lights that don't fit in a full cluster are dropped */
+        uint32_t max_lights_per_cluster       = 64;
+        /** Bin the lights once for both eyes, in a frustum that encloses them, when their fields of view allow it */
+        bool     share_clusters_between_views = true;
+    };
+
+    struct RenderingSettings
+    {
+        /**
+         * Render with VK_KHR_dynamic_rendering when the device supports it: the attachments are given when recording, so there are no
+         * render pass nor framebuffer objects to create for each swapchain image. Otherwise, a render pass is used.
+         */
+        bool dynamic_rendering = true;
+        /**
+         * Run the compute passes on a dedicated compute queue when the device has one, synchronized with the graphics queue by
+         * timeline semaphores, so that they overlap the rendering. Otherwise, they run on the graphics queue.
+         */
+        bool async_compute     = true;
+    };
+
     struct Settings
     {
         const ApplicationInfo      application_info       = {};
         const MirrorWindowSettings mirror_window_settings = {};
+        const PerformanceSettings  performance_settings   = {};
+        const GeometrySettings     geometry_settings      = {};
+        const LightingSettings     lighting_settings      = {};
+        const RenderingSettings    rendering_settings     = {};
     };
 
 #ifdef RENDERER_VULKAN
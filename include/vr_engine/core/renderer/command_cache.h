@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <vr_engine/utils/data/map.h>
+
+namespace vre
+{
+    /** Incremental FNV-1a hash of the inputs of recorded commands: the handles, offsets and extents they were recorded with. */
+    class ContentHash
+    {
+      private:
+        constexpr static uint64_t OFFSET_BASIS = 14695981039346656037ULL;
+        constexpr static uint64_t PRIME        = 1099511628211ULL;
+
+        uint64_t m_value = OFFSET_BASIS;
+
+      public:
+        ContentHash &add_bytes(const void *data, size_t size)
+        {
+            const auto *bytes = static_cast<const uint8_t *>(data);
+            for (size_t i = 0; i < size; i++)
+            {
+                m_value ^= bytes[i];
+                m_value *= PRIME;
+            }
+            return *this;
+        }
+
+        template<typename T>
+        ContentHash &add(const T &value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be hashed");
+            return add_bytes(&value, sizeof(T));
+        }
+
+        [[nodiscard]] inline uint64_t value() const { return m_value; }
+    };
+
+    /**
+     * Command buffers recorded once and replayed while the inputs of their commands don't change.
+     *
+     * Each entry is identified by a key, typically a pass and a view, and remembers the content hash its buffer was recorded with.
+     * A lookup with the same hash replays the buffer, and a different hash re-records it in place. The cache must thus belong to a
+     * single frame in flight: its buffers are only looked up once the fence of this frame was waited, when the GPU is done with them.
+     * The data that changes every frame is not recorded, but read from buffers written each frame, push constants or dynamic offsets.
+     */
+    template<typename Buffer>
+    class CommandCache
+    {
+      public:
+        typedef uint64_t Key;
+
+        struct Lookup
+        {
+            // Points to a null buffer the first time the key is looked up, in which case the caller allocates it
+            Buffer *buffer = nullptr;
+            // False if the commands must be recorded again in the buffer
+            bool is_recorded = false;
+        };
+
+      private:
+        struct Entry
+        {
+            Buffer   buffer          = {};
+            uint64_t hash            = 0;
+            bool     is_recorded     = false;
+            uint64_t last_used_frame = 0;
+        };
+
+        Map<Entry>       m_entries     = {};
+        // Kept between calls to avoid allocations
+        std::vector<Key> m_unused_keys = {};
+
+      public:
+        /** Key of the commands of a pass, for one of its views or targets. The pass must not be 0. */
+        static inline Key key(uint32_t pass, uint32_t index)
+        {
+            if (pass == 0)
+            {
+                throw std::invalid_argument("The pass of a command cache key must not be 0");
+            }
+            return (static_cast<Key>(pass) << 32) | index;
+        }
+
+        /**
+         * Looks up the buffer of the key. After the call, the entry is considered recorded with this hash: when the lookup says it is
+         * not, the caller must record the commands before submitting the buffer.
+         */
+        Lookup lookup(Key key, uint64_t hash, uint64_t frame_number)
+        {
+            auto &entry           = m_entries[key];
+            entry.last_used_frame = frame_number;
+
+            const bool is_recorded = entry.is_recorded && entry.hash == hash;
+            entry.hash             = hash;
+            entry.is_recorded      = true;
+            return Lookup {
+                .buffer      = &entry.buffer,
+                .is_recorded = is_recorded,
+            };
+        }
+
+        /** Forces the commands of the key to be recorded again at the next lookup. */
+        void invalidate(Key key)
+        {
+            if (auto *entry = m_entries.get(key); entry != nullptr)
+            {
+                entry->is_recorded = false;
+            }
+        }
+
+        void invalidate_all()
+        {
+            for (auto &entry : m_entries)
+            {
+                entry.value().is_recorded = false;
+            }
+        }
+
+        /** Removes the entries that were not looked up during the last max_unused_frames frames, and calls release on their buffer. */
+        template<typename Release>
+        void evict_unused(uint64_t frame_number, uint64_t max_unused_frames, Release &&release)
+        {
+            m_unused_keys.clear();
+            for (auto &entry : m_entries)
+            {
+                if (entry.value().last_used_frame + max_unused_frames < frame_number)
+                {
+                    m_unused_keys.push_back(entry.key());
+                }
+            }
+            for (const auto key : m_unused_keys)
+            {
+                release(m_entries.get(key)->buffer);
+                m_entries.remove(key);
+            }
+        }
+
+        /** Removes all the entries, and calls release on their buffer. */
+        template<typename Release>
+        void clear(Release &&release)
+        {
+            for (auto &entry : m_entries)
+            {
+                release(entry.value().buffer);
+            }
+            m_entries.clear();
+        }
+
+        [[nodiscard]] inline size_t count() const { return m_entries.count(); }
+    };
+} // namespace vre
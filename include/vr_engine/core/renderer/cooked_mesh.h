@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <vr_engine/core/renderer/lod_selector.h>
+
+/**
+ * Meshes cooked offline by the asset cooker, in the layout the renderer uploads as is.
+ *
+ * The mesh comes with a chain of LODs, simplified with quadric error metrics. They are ranges of a single index buffer that share
+ * the vertices. The index buffer of each LOD is optimized for the vertex cache, then for overdraw, and the vertices are reordered for
+ * fetch locality. The attributes are quantized from 32 to 16 bytes per vertex:
+ * - positions are 16-bit unorm in the bounding box of the mesh. The renderer folds the offset and scale of the mesh into the
+ *   transforms of its instances, so the vertex shader reads them as they are.
+ * - normals are octahedral-encoded in two 16-bit snorm.
+ * - texture coordinates are half floats.
+ */
+namespace vre
+{
+    /** Vertex layout of the meshes given to the cooker. */
+    struct MeshVertex
+    {
+        float position[3] = {};
+        float normal[3]   = {};
+        float uv[2]       = {};
+    };
+
+    /** Vertex layout of the cooked meshes. The geometry settings must use its size as vertex stride. */
+    struct CookedVertex
+    {
+        // R16G16B16A16_UNORM, the last component is unused
+        uint16_t position[4] = {};
+        // R16G16_SNORM
+        int16_t  normal[2]   = {};
+        // R16G16_SFLOAT
+        uint16_t uv[2]       = {};
+    };
+    static_assert(sizeof(CookedVertex) == 16, "Cooked vertices must stay tightly packed");
+
+    struct CookedMesh
+    {
+        // position = position_offset + quantized_position * position_scale
+        float                     position_offset[3] = {};
+        float                     position_scale[3]  = {};
+        std::vector<CookedVertex> vertices           = {};
+        // Indices of all the LODs, the finest first
+        std::vector<uint32_t>     indices            = {};
+        std::vector<MeshLod>      lods               = {};
+    };
+
+    // --=== Quantization ===--
+
+    uint16_t quantize_unorm16(float value);
+    int16_t  quantize_snorm16(float value);
+    uint16_t quantize_half(float value);
+    float    dequantize_half(uint16_t value);
+    /** Projects the unit normal on an octahedron, unfolded in the [-1, 1] square, and quantizes it. */
+    void     encode_octahedral(const float normal[3], int16_t out_encoded[2]);
+    void     decode_octahedral(const int16_t encoded[2], float out_normal[3]);
+
+    // --=== Cooking ===--
+
+    /** Settings of the cooker. */
+    struct CookSettings
+    {
+        // How much worse the vertex cache efficiency may get to reduce overdraw, see optimize_overdraw
+        float    overdraw_threshold  = 1.05f;
+        // Number of LODs, including the full mesh. The chain stops earlier when the simplification can't go further.
+        uint32_t max_lod_count       = 4;
+        // Ratio between the triangle counts of two successive LODs
+        float    lod_triangle_ratio  = 0.5f;
+        // Largest error of a LOD, relative to the size of the bounding box of the mesh
+        float    lod_max_error_ratio = 0.05f;
+    };
+
+    /** Builds the LODs of a triangle list, then optimizes and quantizes them. */
+    CookedMesh cook_mesh(const MeshVertex   *vertices,
+                         size_t              vertex_count,
+                         const uint32_t     *indices,
+                         size_t              index_count,
+                         const CookSettings &settings = {});
+
+    // --=== Files ===--
+
+    std::vector<uint8_t> serialize_cooked_mesh(const CookedMesh &mesh);
+    /** Throws std::runtime_error if the data is not a cooked mesh of the current version. */
+    CookedMesh           deserialize_cooked_mesh(const void *data, size_t size);
+
+    void       save_cooked_mesh(const char *path, const CookedMesh &mesh);
+    CookedMesh load_cooked_mesh(const char *path);
+} // namespace vre
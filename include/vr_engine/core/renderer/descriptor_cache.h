@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <vr_engine/core/renderer/command_cache.h>
+#include <vr_engine/utils/data/map.h>
+#include <vr_engine/utils/data/small_vector.h>
+
+namespace vre
+{
+    /**
+     * Number of descriptors of each type, for a set layout or for the sets of a pool. The types are VkDescriptorType values, kept as
+     * integers so that the sizing logic doesn't depend on Vulkan.
+     */
+    class DescriptorCounts
+    {
+      public:
+        struct TypeCount
+        {
+            uint32_t type  = 0;
+            uint32_t count = 0;
+        };
+
+      private:
+        SmallVector<TypeCount, 8> m_counts = {};
+
+      public:
+        void add(uint32_t type, uint32_t count);
+        [[nodiscard]] uint32_t count(uint32_t type) const;
+
+        /**
+         * Raises each count to the one of the other set, so that a pool sized from these counts can hold sets of both layouts.
+         * @return true if a count was raised
+         */
+        bool include(const DescriptorCounts &other);
+        /** True if a set with the other counts fits in a set with these counts. */
+        [[nodiscard]] bool contains(const DescriptorCounts &other) const;
+
+        [[nodiscard]] inline const SmallVector<TypeCount, 8> &counts() const { return m_counts; }
+        [[nodiscard]] inline bool                             is_empty() const { return m_counts.empty(); }
+    };
+
+    /**
+     * Full key of a cached descriptor object: the bytes of every field it was created with. Fields are added one by one, so that the
+     * padding of the Vulkan structs never ends up in the key.
+     */
+    class DescriptorKey
+    {
+      private:
+        std::vector<uint8_t> m_bytes = {};
+        ContentHash          m_hash  = {};
+
+      public:
+        DescriptorKey &add_bytes(const void *data, size_t size);
+
+        template<typename T>
+        DescriptorKey &add(const T &value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be added to a key");
+            return add_bytes(&value, sizeof(T));
+        }
+
+        [[nodiscard]] inline uint64_t hash() const { return m_hash.value(); }
+        [[nodiscard]] inline bool     operator==(const DescriptorKey &other) const { return m_bytes == other.m_bytes; }
+    };
+
+    /**
+     * Values looked up by a full key. The keys are bucketed by their hash, and compared entirely, so two keys with the same hash
+     * never share a value. Key must have hash() and operator==.
+     *
+     * Values are never removed: the cache is cleared at once, when the objects it holds are destroyed.
+     */
+    template<typename Key, typename T>
+    class KeyedCache
+    {
+      public:
+        struct Entry
+        {
+            Key key   = {};
+            T   value = {};
+            // Index + 1 of the previous entry with the same hash, 0 if there is none
+            size_t next = 0;
+        };
+
+      private:
+        std::vector<Entry> m_entries = {};
+        // Index + 1 of the last entry inserted with each hash
+        Map<size_t>        m_heads   = {};
+
+        static inline typename Map<size_t>::Key map_key(const Key &key)
+        {
+            return key.hash() == Map<size_t>::NULL_KEY ? 1 : key.hash();
+        }
+
+      public:
+        /** Returns the value of the key, or nullptr. The pointer is invalidated by the next insertion. */
+        T *get(const Key &key)
+        {
+            const auto *head = m_heads.get(map_key(key));
+            for (size_t i = head == nullptr ? 0 : *head; i != 0; i = m_entries[i - 1].next)
+            {
+                if (m_entries[i - 1].key == key)
+                {
+                    return &m_entries[i - 1].value;
+                }
+            }
+            return nullptr;
+        }
+
+        /** Adds the value of a key that is not in the cache yet. */
+        T &insert(Key key, T value)
+        {
+            const auto  bucket = map_key(key);
+            const auto *head   = m_heads.get(bucket);
+            m_entries.push_back(Entry {
+                .key   = std::move(key),
+                .value = std::move(value),
+                .next  = head == nullptr ? 0 : *head,
+            });
+            m_heads.set(bucket, m_entries.size());
+            return m_entries.back().value;
+        }
+
+        void clear()
+        {
+            m_entries.clear();
+            m_heads.clear();
+        }
+
+        [[nodiscard]] inline size_t count() const { return m_entries.size(); }
+        [[nodiscard]] inline auto   begin() { return m_entries.begin(); }
+        [[nodiscard]] inline auto   end() { return m_entries.end(); }
+        [[nodiscard]] inline auto   begin() const { return m_entries.begin(); }
+        [[nodiscard]] inline auto   end() const { return m_entries.end(); }
+    };
+} // namespace vre
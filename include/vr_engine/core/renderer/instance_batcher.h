@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <vr_engine/core/renderer/lod_selector.h>
+#include <vr_engine/utils/data/map.h>
+#include <vr_engine/utils/data/storage.h>
+
+namespace vre
+{
+    /** World transform of an instance, as read by the vertex shader: the first three rows of the world matrix, row-major. */
+    struct InstanceTransform
+    {
+        float rows[3][4] = {
+            {1.0f, 0.0f, 0.0f, 0.0f},
+            {0.0f, 1.0f, 0.0f, 0.0f},
+            {0.0f, 0.0f, 1.0f, 0.0f},
+        };
+    };
+
+    /** Largest scale of the axes of the transform: the norm of the longest column, whatever the rotation. */
+    [[nodiscard]] float max_axis_scale(const InstanceTransform &transform);
+
+    /** Quantization of the vertex positions of a mesh: position = position_offset + stored position * position_scale. */
+    struct MeshQuantization
+    {
+        float position_offset[3] = {0.0f, 0.0f, 0.0f};
+        float position_scale[3]  = {1.0f, 1.0f, 1.0f};
+    };
+
+    /** Transform of an instance that also dequantizes the positions of its mesh, so that the vertex shader reads them as they are. */
+    InstanceTransform dequantizing_transform(const InstanceTransform &transform, const MeshQuantization &quantization);
+
+    /** Instances sharing a mesh, a LOD of this mesh and a material, drawn with a single instanced draw. */
+    struct InstanceBatch
+    {
+        uint64_t mesh     = 0;
+        uint64_t material = 0;
+        uint32_t lod      = 0;
+        // Range of the batch in the packed instance array
+        uint32_t first_instance = 0;
+        uint32_t instance_count = 0;
+    };
+
+    /**
+     * Groups the instances that share a mesh, a LOD and a material into batches, each drawn with one instanced draw.
+     *
+     * Each batch keeps the transforms of its instances packed, so that moving an instance is a single write and adding or removing
+     * one is O(1). The list of batches, sorted by material, mesh then LOD, and their ranges in the packed instance array are only
+     * rebuilt by update() when the membership changed. Every frame, write_instances copies the transforms of each batch in a
+     * single block.
+     */
+    class InstanceBatcher
+    {
+      public:
+        typedef uint64_t    Id;
+        constexpr static Id NULL_ID = 0;
+
+      private:
+        struct Batch
+        {
+            uint64_t                       mesh       = 0;
+            uint64_t                       material   = 0;
+            uint32_t                       lod        = 0;
+            std::vector<Id>                members    = {};
+            std::vector<InstanceTransform> transforms = {};
+        };
+
+        struct Instance
+        {
+            uint32_t batch = 0;
+            // Index in the members and transforms of the batch
+            uint32_t index = 0;
+        };
+
+        Storage<Instance> m_instances = {};
+        // Batches are never moved, so that the instances can keep their index. Empty ones are reused.
+        std::vector<Batch>    m_batches       = {};
+        std::vector<uint32_t> m_empty_batches = {};
+        // Batch index of each mesh, LOD and material
+        Map<uint32_t> m_batch_indices = {};
+        // Instances whose LOD changed in select_lods
+        std::vector<std::pair<Id, uint32_t>> m_lod_changes = {};
+
+        // Layout built by update()
+        std::vector<InstanceBatch> m_draws          = {};
+        std::vector<uint32_t>      m_draw_batches   = {};
+        uint32_t                   m_instance_count = 0;
+        bool                       m_layout_dirty   = false;
+
+        uint32_t find_or_create_batch(uint64_t mesh, uint64_t material, uint32_t lod);
+        void     attach(Id instance_id, Instance &instance, uint32_t batch_index, const InstanceTransform &transform);
+        /** Removes the instance from its batch, and returns its transform. */
+        InstanceTransform detach(const Instance &instance);
+
+      public:
+        /** The mesh id must be non-null and fit in 28 bits, and the material id must fit in 32 bits. Instances start at LOD 0. */
+        Id   add_instance(uint64_t mesh, uint64_t material, const InstanceTransform &transform);
+        void remove_instance(Id instance_id);
+        void set_transform(Id instance_id, const InstanceTransform &transform);
+        /** Moves the instance to the batch of the LOD, which must be less than MAX_MESH_LOD_COUNT. */
+        void set_lod(Id instance_id, uint32_t lod);
+
+        /**
+         * Calls select(mesh, transform, lod) for each instance, which returns the LOD the instance should use, and moves the instances
+         * whose LOD changed to their new batch.
+         */
+        template<typename Select>
+        void select_lods(Select &&select)
+        {
+            m_lod_changes.clear();
+            for (const auto &batch : m_batches)
+            {
+                for (size_t i = 0; i < batch.members.size(); i++)
+                {
+                    const uint32_t lod = select(batch.mesh, batch.transforms[i], batch.lod);
+                    if (lod != batch.lod)
+                    {
+                        m_lod_changes.emplace_back(batch.members[i], lod);
+                    }
+                }
+            }
+            for (const auto &[instance_id, lod] : m_lod_changes)
+            {
+                set_lod(instance_id, lod);
+            }
+        }
+
+        /**
+         * Rebuilds the list of batches if instances were added or removed since the last call.
+         * @return true if the layout changed
+         */
+        bool update();
+
+        /** Batches built by the last update(), each with its range in the packed instance array. */
+        [[nodiscard]] inline const std::vector<InstanceBatch> &batches() const { return m_draws; }
+        [[nodiscard]] inline uint32_t                          instance_count() const { return m_instance_count; }
+
+        /** Layout health of the instance table and of the batch index, see HashMapStats. */
+        [[nodiscard]] inline HashMapStats instance_table_stats() const { return m_instances.stats(); }
+        [[nodiscard]] inline HashMapStats batch_index_stats() const { return m_batch_indices.stats(); }
+
+        /** Copies the transforms of all instances in the layout of the last update(). The array needs room for instance_count(). */
+        void write_instances(InstanceTransform *out_transforms) const
+        {
+            write_instances(out_transforms, [](uint64_t) -> const MeshQuantization * { return nullptr; });
+        }
+
+        /**
+         * Same as write_instances, with the quantization of the meshes folded in the transforms. quantization_of(mesh) returns the
+         * MeshQuantization of the mesh, or nullptr if its positions are not quantized. The transforms given to select_lods stay in
+         * the units of the mesh before quantization, as the errors of its LODs.
+         */
+        template<typename QuantizationOf>
+        void write_instances(InstanceTransform *out_transforms, QuantizationOf &&quantization_of) const
+        {
+            if (m_layout_dirty)
+            {
+                throw std::logic_error("update() must be called after instances are added or removed");
+            }
+
+            for (size_t i = 0; i < m_draws.size(); i++)
+            {
+                const auto &batch        = m_batches[m_draw_batches[i]];
+                const auto *quantization = quantization_of(batch.mesh);
+                auto       *out          = out_transforms + m_draws[i].first_instance;
+                if (quantization == nullptr)
+                {
+                    memcpy(out, batch.transforms.data(), batch.transforms.size() * sizeof(InstanceTransform));
+                    continue;
+                }
+                for (size_t j = 0; j < batch.transforms.size(); j++)
+                {
+                    out[j] = dequantizing_transform(batch.transforms[j], *quantization);
+                }
+            }
+        }
+    };
+} // namespace vre
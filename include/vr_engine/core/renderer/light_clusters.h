@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vr_engine/utils/data/small_vector.h>
+
+namespace vre
+{
+    /** A point light, in the layout read by the shaders. */
+    struct PointLight
+    {
+        float position[3] = {};
+        /** Distance at which the light stops contributing */
+        float radius      = 1.0f;
+        float color[3]    = {1.0f, 1.0f, 1.0f};
+        float intensity   = 1.0f;
+    };
+    static_assert(sizeof(PointLight) == 32, "Point lights must match their layout in the shaders");
+
+    /** A view rendered in the frame, with the pose and the field of view of its XrView. */
+    struct ClusterView
+    {
+        float position[3]    = {};
+        // Quaternion, as x, y, z, w
+        float orientation[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        // Angles of the sides of the field of view, in radians. Left and down are usually negative.
+        float angle_left     = 0.0f;
+        float angle_right    = 0.0f;
+        float angle_up       = 0.0f;
+        float angle_down     = 0.0f;
+    };
+
+    struct ClusterSettings
+    {
+        /** Number of clusters along the width and the height of the field of view, and along the depth */
+        uint32_t tile_count_x           = 16;
+        uint32_t tile_count_y           = 16;
+        uint32_t slice_count            = 24;
+        /** Depth range of the slices, in meters. Closer fragments are in the first slice, farther ones in no cluster. */
+        float    near                   = 0.05f;
+        float    far                    = 100.0f;
+        /** The lights that don't fit in a full cluster are dropped */
+        uint32_t max_lights_per_cluster = 64;
+        /** Bin the lights once for all the views, in a frustum that encloses them, when their fields of view allow it */
+        bool     share_between_views    = true;
+    };
+
+    /**
+     * A frustum split into clusters, as read by the shaders.
+     *
+     * A position is moved into the space of the grid with the inverse of its pose, where the frustum looks down -z. At a depth
+     * d = -z, the cluster of the position is at:
+     * - tile x = floor((x / d - tan_left) * tile_scale_x), and the same along y with tan_down.
+     * - slice = floor(log(d / near) * slice_scale), clamped to the first slice when d < near.
+     * Its index is (slice * tile_count_y + tile y) * tile_count_x + tile x, plus first_cluster.
+     */
+    struct ClusterGrid
+    {
+        float    position[3]    = {};
+        uint32_t tile_count_x   = 0;
+        float    orientation[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        float    tan_left       = 0.0f;
+        float    tan_down       = 0.0f;
+        // Tiles per unit of tangent
+        float    tile_scale_x   = 0.0f;
+        float    tile_scale_y   = 0.0f;
+        float    near           = 0.0f;
+        // slice_count / log(far / near)
+        float    slice_scale    = 0.0f;
+        uint32_t tile_count_y   = 0;
+        uint32_t slice_count    = 0;
+        uint32_t first_cluster  = 0;
+        uint32_t padding[3]     = {};
+    };
+    static_assert(sizeof(ClusterGrid) == 80, "Cluster grids must match their std430 layout in the shaders");
+
+    /** Range of the light index list of a cluster. */
+    struct LightCluster
+    {
+        uint32_t first_index = 0;
+        uint32_t light_count = 0;
+    };
+
+    /**
+     * Bins the lights of the frame into the clusters of the view frusta, so that each fragment is only shaded by the lights of its
+     * cluster. This is the CPU version of the binning: the lights are first bounded in every grid with branchless loops over
+     * structure-of-arrays, with SSE2 when the target has it and scalar loops otherwise, then scattered in the clusters.
+     *
+     * In stereo, both eyes usually share a single grid, built from a frustum whose apex is moved back until it encloses the frusta
+     * of all the views, so the lights are binned once per frame. When the views can't be enclosed, e.g. with fields of view wider
+     * than 180 degrees, each view has its own grid.
+     */
+    class LightClusterer
+    {
+      private:
+        ClusterSettings             m_settings      = {};
+        SmallVector<ClusterGrid, 2> m_grids         = {};
+        std::vector<LightCluster>   m_clusters      = {};
+        std::vector<uint32_t>       m_light_indices = {};
+        uint32_t                    m_dropped_count = 0;
+        // Bounds of the lights in the current grid, kept between frames to avoid allocations. Empty ranges are culled.
+        std::vector<float>          m_view_x        = {};
+        std::vector<float>          m_view_y        = {};
+        std::vector<float>          m_view_depth    = {};
+        std::vector<float>          m_radius        = {};
+        std::vector<int32_t>        m_ranges[6]     = {};
+        // Depth at which each slice but the first starts, and the far depth
+        std::vector<float>          m_slice_starts  = {};
+
+        void bound_lights(const ClusterGrid &grid, const PointLight *lights, uint32_t light_count);
+
+      public:
+        LightClusterer() = default;
+        explicit LightClusterer(const ClusterSettings &settings);
+
+        /** Builds the grids of the frame, shared by the views when possible. */
+        void set_views(const ClusterView *views, uint32_t view_count);
+
+        /** Bins the lights in the clusters of all the grids. The light indices point to this array. */
+        void bin_lights(const PointLight *lights, uint32_t light_count);
+
+        /** Index of the cluster of a world position in a grid, as computed by the shaders. UINT32_MAX if it is in none. */
+        [[nodiscard]] uint32_t cluster_of(uint32_t grid, const float position[3]) const;
+
+        [[nodiscard]] inline const SmallVector<ClusterGrid, 2> &grids() const { return m_grids; }
+        [[nodiscard]] inline const std::vector<LightCluster>   &clusters() const { return m_clusters; }
+        [[nodiscard]] inline const std::vector<uint32_t>       &light_indices() const { return m_light_indices; }
+        /** Number of times a light was left out of a full cluster during the last binning */
+        [[nodiscard]] inline uint32_t                           dropped_count() const { return m_dropped_count; }
+    };
+} // namespace vre
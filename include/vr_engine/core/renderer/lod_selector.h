@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <vr_engine/utils/data/small_vector.h>
+
+namespace vre
+{
+    /** Maximum number of LODs of a mesh. */
+    constexpr uint32_t MAX_MESH_LOD_COUNT = 8;
+
+    /** A level of detail of a mesh: a range of its index buffer, drawn with the same vertices as the others. */
+    struct MeshLod
+    {
+        uint32_t first_index = 0;
+        uint32_t index_count = 0;
+        /** Largest distance between this LOD and the full mesh, in the units of the mesh */
+        float    error       = 0.0f;
+    };
+
+    /** A view rendered in the frame, with the field of view of its XrView and the resolution of its swapchain. */
+    struct LodView
+    {
+        float    position[3] = {};
+        // Angles of the sides of the field of view, in radians. Left and down are usually negative.
+        float    angle_left  = 0.0f;
+        float    angle_right = 0.0f;
+        float    angle_up    = 0.0f;
+        float    angle_down  = 0.0f;
+        uint32_t width       = 0;
+        uint32_t height      = 0;
+    };
+
+    struct LodSettings
+    {
+        /** LODs are switched before their error covers more than this number of pixels */
+        float max_pixel_error = 1.0f;
+        /**
+         * Relative margin around the error threshold. An instance only switches to a coarser LOD once its error is below
+         * (1 - hysteresis) times the threshold, and back to a finer one once the error is above (1 + hysteresis) times the threshold,
+         * so that instances near the threshold don't pop back and forth.
+         */
+        float hysteresis      = 0.2f;
+    };
+
+    /**
+     * Selects the LOD of the instances from the error of each LOD, projected in pixels in each view.
+     *
+     * Headsets have a high resolution and a wide field of view, which are both taken into account: the error covers more pixels when
+     * the swapchain is bigger or the field of view narrower. All the views use the same LOD, chosen by the view in which the error is
+     * the biggest, so that both eyes see the same geometry.
+     */
+    class LodSelector
+    {
+      private:
+        struct Eye
+        {
+            float position[3]     = {};
+            // Pixels covered by an error of one unit, at a distance of one unit
+            float pixels_per_unit = 0.0f;
+        };
+
+        LodSettings         m_settings        = {};
+        SmallVector<Eye, 2> m_eyes            = {};
+        float               m_pixel_threshold = 0.0f;
+
+      public:
+        LodSelector() = default;
+        explicit LodSelector(const LodSettings &settings) : m_settings(settings) {}
+
+        /**
+         * Sets the views of the frame.
+         * @param lod_bias bias of the frame governor: the error threshold is multiplied by 2^lod_bias, so each step of bias allows
+         * twice the error
+         */
+        void set_views(const LodView *views, uint32_t view_count, float lod_bias);
+
+        /** Largest number of pixels covered by an error at a position, in the views of the frame. */
+        [[nodiscard]] float projected_error(float error, const float position[3]) const;
+
+        /**
+         * Chooses the coarsest LOD whose projected error is below the threshold, with hysteresis around the current LOD.
+         * @param lods LODs of the mesh, from the finest to the coarsest
+         * @param scale scale of the instance, by which the errors of the LODs are multiplied
+         */
+        [[nodiscard]] uint32_t select(const MeshLod *lods,
+                                      uint32_t       lod_count,
+                                      const float    position[3],
+                                      float          scale,
+                                      uint32_t       current_lod) const;
+    };
+} // namespace vre
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Offline optimizations of the index and vertex buffers of triangle meshes, run by the asset cooker.
+ *
+ * They are meant to be chained: the simplification of the LODs comes first, then the vertex cache ordering, then the overdraw
+ * ordering, which moves whole clusters of triangles to keep most of the cache efficiency, and finally the vertex fetch ordering,
+ * which only renames the vertices.
+ */
+namespace vre
+{
+    /** Efficiency of an index buffer with a FIFO post-transform vertex cache. */
+    struct VertexCacheStats
+    {
+        uint32_t vertices_transformed = 0;
+        // Average cache miss ratio: transformed vertices per triangle. 0.5 is the best possible value on a regular grid, 3 the worst.
+        float    acmr                 = 0.0f;
+        // Average transformed vertex ratio: transformed vertices per vertex. 1 is the best possible value.
+        float    atvr                 = 0.0f;
+    };
+
+    /** Simulates a FIFO cache of the given size on the triangle list. */
+    VertexCacheStats analyze_vertex_cache(const uint32_t *indices, size_t index_count, size_t vertex_count, uint32_t cache_size);
+
+    /**
+     * Reorders the triangles so that they reuse the vertices still in the post-transform cache, with Forsyth's algorithm. The
+     * triangles are emitted greedily, each time taking the one whose vertices have the best score: the score of a vertex grows with
+     * its position in the cache, and with the few triangles it has left so that the vertices are finished quickly.
+     * @param out_indices may be the same array as indices
+     */
+    void optimize_vertex_cache(uint32_t *out_indices, const uint32_t *indices, size_t index_count, size_t vertex_count);
+
+    /**
+     * Reorders clusters of triangles so that the ones facing outwards are drawn first, and hide more of the others. The index buffer
+     * must already be optimized for the vertex cache: it is cut into clusters at the cache flushes, and also where the cache
+     * efficiency of the cluster is still within the threshold of the one of the whole mesh.
+     * @param positions 3 floats per vertex, position_stride bytes apart
+     * @param threshold how much worse than the input the vertex cache efficiency may get, 1.05 allows 5% more transformed vertices
+     * @param out_indices may be the same array as indices
+     */
+    void optimize_overdraw(uint32_t       *out_indices,
+                           const uint32_t *indices,
+                           size_t          index_count,
+                           const float    *positions,
+                           size_t          vertex_count,
+                           size_t          position_stride,
+                           float           threshold);
+
+    /**
+     * Simplifies the mesh by collapsing edges, cheapest first, with the quadric error metrics of Garland and Heckbert. A vertex is
+     * only moved onto one of its neighbors, so the simplified index buffer still uses the vertex buffer of the input.
+     *
+     * The vertices on the border of the mesh, and the ones that share their position with another vertex (attribute seams), are
+     * never moved, so that holes and texture seams don't open. Collapses that would flip a triangle are rejected.
+     *
+     * The quadrics only order the collapses. The distance by which the surface moved is the largest distance from a moved vertex to
+     * the plane of an original triangle merged into it, which doesn't shrink as the planes of large flat areas are merged.
+     * @param positions 3 floats per vertex, position_stride bytes apart
+     * @param target_index_count the simplification stops once there are this many indices or less
+     * @param max_error collapses that would move the surface by more than this distance are skipped
+     * @param out_error if not null, receives the largest distance by which the surface moved
+     * @param out_indices room for index_count indices, may be the same array as indices
+     * @return the number of indices of the simplified mesh
+     */
+    size_t simplify(uint32_t       *out_indices,
+                    const uint32_t *indices,
+                    size_t          index_count,
+                    const float    *positions,
+                    size_t          vertex_count,
+                    size_t          position_stride,
+                    size_t          target_index_count,
+                    float           max_error,
+                    float          *out_error = nullptr);
+
+    /**
+     * Reorders the vertices in the order of their first use by the index buffer, so that the vertex fetches read memory linearly,
+     * and rewrites the indices. The vertices that are not referenced are dropped.
+     * @param out_vertices room for vertex_count vertices, must not alias vertices
+     * @return the number of vertices kept
+     */
+    size_t optimize_vertex_fetch(void       *out_vertices,
+                                 uint32_t   *indices,
+                                 size_t      index_count,
+                                 const void *vertices,
+                                 size_t      vertex_count,
+                                 size_t      vertex_size);
+} // namespace vre
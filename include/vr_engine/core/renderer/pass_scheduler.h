@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vr_engine/utils/data/small_vector.h>
+
+namespace vre
+{
+    /** Queue on which a pass runs. */
+    enum class PassQueue : uint8_t
+    {
+        GRAPHICS = 0,
+        // Dedicated async compute queue, which runs alongside the graphics one
+        COMPUTE  = 1,
+    };
+    constexpr uint32_t PASS_QUEUE_COUNT = 2;
+
+    /**
+     * Consecutive passes of a queue, recorded in the same command buffer and submitted together. Each queue has a timeline semaphore:
+     * the batch signals it once done, and waits for the timeline of the other queue to reach the value signaled by the batches it
+     * depends on.
+     */
+    struct PassBatch
+    {
+        PassQueue                queue        = PassQueue::GRAPHICS;
+        // Passes of the batch, in the order they are recorded
+        SmallVector<uint32_t, 8> passes       = {};
+        // Value that the timeline of the other queue must reach before the batch starts, 0 if it doesn't wait
+        uint64_t                 wait_value   = 0;
+        // Value signaled on the timeline of the queue of the batch
+        uint64_t                 signal_value = 0;
+    };
+
+    /**
+     * Splits the passes of a frame into batches for the graphics and async compute queues.
+     *
+     * The passes are added in an order where their dependencies come first. A pass is appended to the current batch of its queue,
+     * unless it depends on a pass of the other queue that this batch doesn't wait for yet. It then starts a new batch, so that the
+     * passes before it don't wait too. The batches must be submitted in the order they were created, which guarantees that each
+     * timeline value is signaled by a submitted batch before it is waited for.
+     *
+     * Without async compute, all the passes run on the graphics queue, in a single batch.
+     */
+    class PassScheduler
+    {
+      private:
+        constexpr static uint32_t NO_BATCH = UINT32_MAX;
+
+        bool                   m_async_compute                     = false;
+        std::vector<PassBatch> m_batches                           = {};
+        // Batch of each pass
+        std::vector<uint32_t>  m_pass_batches                      = {};
+        // Batches that passes of each queue are appended to
+        uint32_t               m_open_batches[PASS_QUEUE_COUNT]    = {NO_BATCH, NO_BATCH};
+        // Last value signaled on the timeline of each queue. They keep growing from frame to frame, like the semaphores.
+        uint64_t               m_timeline_values[PASS_QUEUE_COUNT] = {};
+
+      public:
+        /** Forgets the passes of the previous frame. */
+        void begin_frame(bool async_compute);
+
+        /**
+         * Schedules a pass, and returns its index in the frame.
+         * @param dependencies indices of the passes whose results the pass reads. They must have been added before.
+         */
+        uint32_t add_pass(PassQueue queue, const uint32_t *dependencies, uint32_t dependency_count);
+
+        [[nodiscard]] inline const std::vector<PassBatch> &batches() const { return m_batches; }
+        [[nodiscard]] inline uint32_t batch_of(uint32_t pass) const { return m_pass_batches[pass]; }
+        [[nodiscard]] inline uint64_t timeline_value(PassQueue queue) const { return m_timeline_values[static_cast<uint32_t>(queue)]; }
+    };
+} // namespace vre
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+
+namespace vre
+{
+    /** Quality knobs that the frame governor adjusts to keep the frame rate. */
+    struct QualityLevels
+    {
+        /** Scale applied to the recommended resolution of each view, in ]0, 1] */
+        float    resolution_scale = 1.0f;
+        /** Bias added to the LOD selection. Higher values select coarser LODs sooner. */
+        float    lod_bias         = 0.0f;
+        /** Fixed foveation level, 0 meaning no foveation */
+        uint32_t foveation_level  = 0;
+        /** Distance after which shadows are not rendered anymore, in meters */
+        float    shadow_distance  = 50.0f;
+    };
+
+    struct FrameGovernorSettings
+    {
+        /** Fraction of the frame budget that should stay free to absorb spikes */
+        float target_headroom = 0.1f;
+
+        // PID gains, applied on the normalized headroom error
+        float proportional_gain = 0.2f;
+        float integral_gain     = 0.05f;
+        float derivative_gain   = 0.02f;
+
+        /** Smoothing factor of the measured frame times, in ]0, 1]. Lower values react slower. */
+        float smoothing = 0.1f;
+
+        // Quality at the lowest level. The highest level is the default QualityLevels.
+        QualityLevels min_quality = {
+            .resolution_scale = 0.6f,
+            .lod_bias         = 2.0f,
+            .foveation_level  = 3,
+            .shadow_distance  = 10.0f,
+        };
+        QualityLevels max_quality = {};
+
+        /** Number of frames between two refresh rate decisions, to let the quality settle in between */
+        uint32_t refresh_rate_evaluation_interval = 180;
+    };
+
+    /**
+     * PID controller in velocity form: it returns the change of the control output, which the caller accumulates. There is no integral
+     * term to wind up when the accumulated output is clamped.
+     */
+    class PidController
+    {
+      private:
+        float m_kp             = 0.0f;
+        float m_ki             = 0.0f;
+        float m_kd             = 0.0f;
+        float m_previous_error = 0.0f;
+        float m_previous_delta = 0.0f;
+        bool  m_has_previous   = false;
+
+      public:
+        PidController() = default;
+        PidController(float kp, float ki, float kd) : m_kp(kp), m_ki(ki), m_kd(kd) {}
+
+        /** Returns the change of the control output for the given error. */
+        float update(float error);
+        void  reset();
+    };
+
+    /**
+     * The frame governor watches the CPU and GPU frame times, and scales the quality so that the slowest of both fits in the frame
+     * budget with some headroom. It can also suggest a display refresh rate that matches the measured cost.
+     *
+     * The quality is summarized by a single factor between 0 (min_quality) and 1 (max_quality), driven by a PID controller.
+     */
+    class FrameGovernor
+    {
+      private:
+        FrameGovernorSettings m_settings          = {};
+        PidController         m_controller        = {};
+        double                m_target_frame_time = 1.0 / 90.0;
+        double                m_cpu_time          = 0.0;
+        double                m_gpu_time          = 0.0;
+        float                 m_quality_factor    = 1.0f;
+        QualityLevels         m_quality           = {};
+        uint64_t              m_frame_count       = 0;
+        uint64_t              m_last_rate_change  = 0;
+
+        void update_quality_levels();
+
+      public:
+        FrameGovernor();
+        explicit FrameGovernor(const FrameGovernorSettings &settings);
+
+        /** Sets the duration of a frame at the current display refresh rate, in seconds. */
+        void set_target_frame_time(double target_frame_time);
+
+        /**
+         * Registers the timings of a frame and updates the quality levels.
+         * @param cpu_time time spent by the CPU on the frame, in seconds
+         * @param gpu_time time spent by the GPU on the frame, in seconds. 0 if unknown.
+         */
+        void report_frame(double cpu_time, double gpu_time);
+
+        /**
+         * Chooses the refresh rate that should be used given the measured costs.
+         *
+         * The rate is lowered when the quality is already at its minimum and the budget is still exceeded, and raised when the
+         * quality is at its maximum and the cost fits in the budget of the higher rate. Decisions are spaced by the evaluation interval.
+         * @param available_rates refresh rates supported by the display, in Hz, sorted in increasing order
+         * @return the index of the chosen rate in available_rates
+         */
+        uint32_t choose_refresh_rate(const float *available_rates, uint32_t rate_count, uint32_t current_rate_index);
+
+        [[nodiscard]] inline const QualityLevels &quality() const { return m_quality; }
+        [[nodiscard]] inline float                quality_factor() const { return m_quality_factor; }
+        [[nodiscard]] inline double               target_frame_time() const { return m_target_frame_time; }
+        /** Fraction of the frame budget that is free, using the slowest of CPU and GPU. Negative when the budget is exceeded. */
+        [[nodiscard]] double                      headroom() const;
+    };
+} // namespace vre
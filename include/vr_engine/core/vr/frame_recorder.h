@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace vre
+{
+    // --=== Records ===--
+
+    // The records only contain plain values, so that they can be written to the file as they are.
+
+    struct RecordedPose
+    {
+        float orientation[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        float position[3]    = {0.0f, 0.0f, 0.0f};
+    };
+
+    struct RecordedView
+    {
+        RecordedPose pose = {};
+        /** Angles of the field of view, in radians: left, right, up, down */
+        float        fov[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    };
+
+    /** State of a rendered frame, as given by the runtime. */
+    struct RecordedFrame
+    {
+        static constexpr uint32_t MAX_VIEWS = 4;
+
+        uint64_t     frame_index              = 0;
+        /** Runtime time at which the frame is predicted to be displayed, in nanoseconds */
+        int64_t      predicted_display_time   = 0;
+        int64_t      predicted_display_period = 0;
+        uint64_t     view_state_flags         = 0;
+        uint32_t     view_count               = 0;
+        RecordedView views[MAX_VIEWS]         = {};
+    };
+
+    enum class RecordedEventType : uint32_t
+    {
+        SESSION_STATE_CHANGED = 0,
+        REFRESH_RATE_CHANGED  = 1,
+        INSTANCE_LOSS_PENDING = 2,
+        EVENTS_LOST           = 3,
+    };
+
+    /** Runtime event, received before the frame with the same index. */
+    struct RecordedEvent
+    {
+        uint64_t          frame_index = 0;
+        RecordedEventType type        = RecordedEventType::SESSION_STATE_CHANGED;
+        /** New session state, or number of lost events */
+        uint32_t          value       = 0;
+        /** Refresh rates before and after the change, in Hz */
+        float             from_rate   = 0.0f;
+        float             to_rate     = 0.0f;
+    };
+
+    // --=== Recorder ===--
+
+    /**
+     * Writes the frames and events of a session to a binary file, so that the same head motion can be replayed later.
+     *
+     * The file starts with a small header, followed by a sequence of records, each prefixed by a one-byte tag. Only the used views
+     * of a frame are written.
+     */
+    class FrameRecorder
+    {
+      private:
+        FILE *m_file = nullptr;
+
+      public:
+        FrameRecorder() = default;
+        FrameRecorder(const FrameRecorder &)            = delete;
+        FrameRecorder &operator=(const FrameRecorder &) = delete;
+        ~FrameRecorder();
+
+        /** Creates the file, replacing any existing one. Returns false if it can't be created. */
+        bool open(const char *path);
+        void close();
+
+        [[nodiscard]] inline bool is_open() const { return m_file != nullptr; }
+
+        void record_frame(const RecordedFrame &frame);
+        void record_event(const RecordedEvent &event);
+    };
+
+    // --=== Replayer ===--
+
+    /** Reads a file written by a FrameRecorder, one frame at a time. */
+    class FrameReplayer
+    {
+      private:
+        FILE                      *m_file   = nullptr;
+        std::vector<RecordedEvent> m_events = {};
+
+      public:
+        FrameReplayer() = default;
+        FrameReplayer(const FrameReplayer &)            = delete;
+        FrameReplayer &operator=(const FrameReplayer &) = delete;
+        ~FrameReplayer();
+
+        /** Opens the file and checks its header. Returns false if it can't be read. */
+        bool open(const char *path);
+        void close();
+
+        [[nodiscard]] inline bool is_open() const { return m_file != nullptr; }
+
+        /**
+         * Reads the next frame, along with the events recorded before it.
+         * @return false when there are no more frames
+         */
+        bool next_frame(RecordedFrame &frame);
+
+        /** Events recorded between the previous frame and the last one returned by next_frame. */
+        [[nodiscard]] inline const std::vector<RecordedEvent> &events() const { return m_events; }
+    };
+} // namespace vre
@@ -6,10 +6,19 @@
 typedef struct XrSession_T  *XrSession;
 typedef struct XrInstance_T *XrInstance;
 typedef uint64_t             XrSystemId;
+typedef struct XrSpace_T    *XrSpace;
+struct XrView;
+struct XrCompositionLayerProjectionView;
+struct XrCompositionLayerQuad;
 
 namespace vre
 {
+    struct InstanceTransform;
+    struct MeshLod;
+    struct MeshQuantization;
+    struct PointLight;
     struct Settings;
+    struct UiPanelSettings;
     class Scene;
     class VrSystem;
     class Window;
@@ -53,6 +62,88 @@ namespace vre
         void init_vr_views(XrSession session) const;
 
         void cleanup_vr_views() const;
+
+        [[nodiscard]] uint32_t view_count() const;
+
+        /** Returns the GPU time of the last completed frame, in seconds. 0 if timestamps are not supported. */
+        [[nodiscard]] double last_gpu_frame_time() const;
+
+        /** Publishes the stats of the hash tables of the renderer, as "hash_map.renderer.<table>.<stat>" gauges. */
+        void publish_table_stats() const;
+
+        /**
+         * Renders the given views into their swapchains.
+         * @param views located views for the current frame, one for each VR view
+         * @param view_count number of views in the arrays
+         * @param resolution_scale scale applied to the resolution of the views, in ]0, 1]
+         * @param lod_bias bias of the LOD selection, see LodSelector::set_views
+         * @param out_projection_views filled with the projection views to submit to the compositor
+         */
+        void render_views(const XrView                     *views,
+                          uint32_t                          view_count,
+                          float                             resolution_scale,
+                          float                             lod_bias,
+                          XrCompositionLayerProjectionView *out_projection_views) const;
+
+        // Meshes
+
+        /**
+         * Uploads a mesh to the shared geometry buffers. Fails if there is not enough space left in them.
+         * @param vertices vertex_count vertices, with the stride given in the geometry settings
+         * @param indices index_count 32-bit indices, relative to the first vertex of the mesh
+         * @param lods ranges of the indices drawn for each LOD, from the finest to the coarsest. Without LODs, all the indices are
+         * drawn. Each frame, the LOD of the instances is selected from the error of the LODs projected in the views.
+         * @param quantization if not null, the positions of the vertices are quantized, and dequantized in the transforms of the
+         * instances. The errors of the LODs are in the units of the positions before quantization.
+         * @return the id of the mesh
+         */
+        [[nodiscard]] uint64_t create_mesh(const void             *vertices,
+                                           uint32_t                vertex_count,
+                                           const uint32_t         *indices,
+                                           uint32_t                index_count,
+                                           const MeshLod          *lods         = nullptr,
+                                           uint32_t                lod_count    = 0,
+                                           const MeshQuantization *quantization = nullptr) const;
+        /** The space of the mesh is reused once the frames in flight are done with it. */
+        void                   destroy_mesh(uint64_t mesh_id) const;
+
+        /**
+         * Adds an instance of the mesh. The instances that share a mesh and a material are drawn together with a single instanced
+         * draw, so repeated props cost a draw per kind instead of a draw per instance.
+         * @param material_id must fit in 32 bits
+         * @return the id of the instance
+         */
+        [[nodiscard]] uint64_t add_instance(uint64_t mesh_id, uint64_t material_id, const InstanceTransform &transform) const;
+        void                   remove_instance(uint64_t instance_id) const;
+        void                   set_instance_transform(uint64_t instance_id, const InstanceTransform &transform) const;
+
+        // Lights
+
+        /**
+         * Adds a point light. Each frame, the lights are binned in clusters of the view frusta, so that the fragments are only shaded
+         * by the lights of their cluster: see LightClusterer.
+         * @return the id of the light
+         */
+        [[nodiscard]] uint64_t add_light(const PointLight &light) const;
+        void                   remove_light(uint64_t light_id) const;
+        void                   set_light(uint64_t light_id, const PointLight &light) const;
+
+        // UI panels
+
+        /** Creates a UI panel with its own swapchain. It will be rendered during the next frame. */
+        [[nodiscard]] uint64_t create_ui_panel(XrSession session, const UiPanelSettings &settings) const;
+        void                   destroy_ui_panel(uint64_t panel_id) const;
+        /** Marks the content of the panel as changed, so that it is rendered again during the next frame. */
+        void                   invalidate_ui_panel(uint64_t panel_id) const;
+        [[nodiscard]] uint32_t ui_panel_count() const;
+
+        /**
+         * Fills the quad layers of the UI panels that have content. Panels are only rendered when they are invalidated, in
+         * render_views: the compositor keeps sampling the last released image in between.
+         * @param out_layers array with room for at least ui_panel_count() layers
+         * @return the number of layers written
+         */
+        uint32_t fill_ui_layers(XrSpace space, XrCompositionLayerQuad *out_layers) const;
     };
 
 } // namespace vre
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vr_engine/core/scene.h>
 
 // OpenXR forward declarations
 typedef struct XrInstance_T *XrInstance;
@@ -8,10 +9,15 @@ typedef uint64_t XrSystemId;
 
 namespace vre
 {
+    struct InstanceTransform;
+    struct MeshLod;
+    struct MeshQuantization;
+    struct PointLight;
     struct Settings;
+    struct QualityLevels;
+    struct UiPanelSettings;
     class VrRenderer;
     class Window;
-    class Scene;
     class VrSystem
     {
       private:
@@ -32,6 +38,59 @@ namespace vre
 
         void create_renderer(const Settings &settings, Window *mirror_window = nullptr);
 
+        /**
+         * Polls the OpenXR events without blocking, and updates the session state accordingly.
+         * @return true if the application should quit
+         */
+        bool handle_events();
+
+        /**
+         * Runs a single frame of the XR frame loop. The views are only rendered if the runtime will display them.
+         * If the session is not running, this only sleeps for a short time to avoid a busy main loop.
+         */
+        void render_frame();
+
+        [[nodiscard]] bool is_session_running() const;
+
+        /** Publishes the stats of the hash tables of the renderer in the global metrics registry, if there is a renderer. */
+        void publish_table_stats() const;
+
+        /** Quality levels chosen by the frame governor for the current frame */
+        [[nodiscard]] const QualityLevels &quality_levels() const;
+
+        // UI panels
+
+        /**
+         * Creates a UI panel, displayed by the compositor as a quad layer. Its content is only rendered again when it is invalidated,
+         * so static panels cost almost nothing per frame.
+         */
+        Id   create_ui_panel(const UiPanelSettings &settings);
+        void destroy_ui_panel(Id panel_id);
+        void invalidate_ui_panel(Id panel_id);
+
+        // Meshes
+
+        /** Uploads a mesh to the shared geometry buffers of the renderer. See VrRenderer::create_mesh for the format. */
+        Id   create_mesh(const void             *vertices,
+                         uint32_t                vertex_count,
+                         const uint32_t         *indices,
+                         uint32_t                index_count,
+                         const MeshLod          *lods         = nullptr,
+                         uint32_t                lod_count    = 0,
+                         const MeshQuantization *quantization = nullptr);
+        void destroy_mesh(Id mesh_id);
+        /** Instances sharing a mesh and a material are drawn with a single instanced draw. */
+        Id   add_instance(Id mesh_id, Id material_id, const InstanceTransform &transform);
+        void remove_instance(Id instance_id);
+        void set_instance_transform(Id instance_id, const InstanceTransform &transform);
+
+        // Lights
+
+        /** The lights are binned per cluster of the views every frame. See VrRenderer::add_light. */
+        Id   add_light(const PointLight &light);
+        void remove_light(Id light_id);
+        void set_light(Id light_id, const PointLight &light);
+
         ~VrSystem();
     };
 
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vr_engine/utils/metrics.h>
+
+namespace vre
+{
+    /**
+     * Statistics of a traced Vulkan or OpenXR entry point.
+     *
+     * Calls are counted per frame. At the end of each frame, the count is published in the "api.<name>.calls_per_frame" gauge and
+     * added to the "api.<name>.calls" counter. Timed entry points, which are the ones that can block, also record their duration
+     * in the "api.<name>_ns" histogram.
+     */
+    struct ApiEntryPoint
+    {
+        const char           *name                    = nullptr;
+        bool                  is_timed                = false;
+        std::atomic<uint64_t> frame_call_count        = 0;
+        Counter              *call_count_metric       = nullptr;
+        Gauge                *frame_call_count_metric = nullptr;
+        Histogram            *duration_metric         = nullptr;
+    };
+
+    class ApiTrace
+    {
+      public:
+        /**
+         * Returns the entry point with the given name, creating it on first use. Entry points are never destroyed, so the reference
+         * can be kept. The name must be a string literal.
+         */
+        static ApiEntryPoint &entry_point(const char *name, bool is_timed = false);
+
+        /** Publishes the call counts of the frame in the metrics and resets them. */
+        static void end_frame();
+    };
+
+    /** Counts a call to an entry point, and measures its duration if the entry point is timed. */
+    class ApiCall
+    {
+      private:
+        ApiEntryPoint                        &m_entry;
+        std::chrono::steady_clock::time_point m_start;
+
+      public:
+        explicit ApiCall(ApiEntryPoint &entry) : m_entry(entry)
+        {
+            if (m_entry.is_timed)
+            {
+                m_start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~ApiCall()
+        {
+            m_entry.frame_call_count.fetch_add(1, std::memory_order_relaxed);
+            if (m_entry.is_timed)
+            {
+                const auto duration = std::chrono::steady_clock::now() - m_start;
+                m_entry.duration_metric->record(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+            }
+        }
+
+        ApiCall(const ApiCall &)            = delete;
+        ApiCall &operator=(const ApiCall &) = delete;
+    };
+} // namespace vre
+
+// --=== Macros ===--
+
+#ifdef ENABLE_API_TRACE
+
+#define VRE_API_TRACE_CONCAT2(a, b) a##b
+#define VRE_API_TRACE_CONCAT(a, b)  VRE_API_TRACE_CONCAT2(a, b)
+
+/** Traces the call made in the current scope. Used for the functions that are not called through the traced dispatch table. */
+#define VRE_API_CALL(name, is_timed)                                                                                          \
+    static vre::ApiEntryPoint &VRE_API_TRACE_CONCAT(vre_api_entry_, __LINE__) = vre::ApiTrace::entry_point(name, is_timed); \
+    vre::ApiCall               VRE_API_TRACE_CONCAT(vre_api_call_, __LINE__)(VRE_API_TRACE_CONCAT(vre_api_entry_, __LINE__))
+/** Marks the end of a frame for the per-frame call counts */
+#define VRE_API_TRACE_END_FRAME() vre::ApiTrace::end_frame()
+
+#else
+
+#define VRE_API_CALL(name, is_timed) ((void) 0)
+#define VRE_API_TRACE_END_FRAME()    ((void) 0)
+
+#endif
@@ -3,12 +3,34 @@
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
+#include <string>
 
 namespace vre
 {
     template<typename T>
     class Optional;
 
+    /**
+     * Health of the layout of a hash map. The probe length of an entry is the distance between its slot and the slot given by its
+     * hash. A cluster is a run of consecutive occupied slots: long clusters mean long probes for every key hashed inside them.
+     */
+    struct HashMapStats
+    {
+        // Bucket i counts the clusters with a size in [2^i, 2^(i+1)[. The last bucket also counts the bigger ones.
+        constexpr static size_t CLUSTER_SIZE_BUCKET_COUNT = 8;
+
+        size_t count                                             = 0;
+        size_t capacity                                          = 0;
+        float  load_factor                                       = 0.0f;
+        size_t max_probe_length                                  = 0;
+        float  mean_probe_length                                 = 0.0f;
+        size_t cluster_size_histogram[CLUSTER_SIZE_BUCKET_COUNT] = {};
+        size_t expansion_count                                   = 0;
+
+        /** Publishes the stats in the global metrics registry, as "hash_map.<name>.<stat>" gauges. */
+        void publish(const std::string &name) const;
+    };
+
     /**
      * An hash map stores a set of key-value pairs. Both the key and the value are 64-bit integers.
      *
@@ -74,6 +96,8 @@ namespace vre
         void                            clear();
         [[nodiscard]] size_t            count() const;
         [[nodiscard]] bool              is_empty() const;
+        /** Scans the whole table to measure its layout. Meant for diagnostics, not for hot paths. */
+        [[nodiscard]] HashMapStats      stats() const;
 
         // Iterator
         class Iterator
@@ -47,6 +47,7 @@ namespace vre
         // Methods
         [[nodiscard]] inline size_t count() const { return m_hash_map.count(); }
         [[nodiscard]] inline bool   is_empty() const { return m_hash_map.is_empty(); }
+        [[nodiscard]] HashMapStats  stats() const { return m_hash_map.stats(); }
         [[nodiscard]] inline bool   exists(const Key &key) const { return m_hash_map.exists(key); }
         const T                    *get(const Key &key) const
         {
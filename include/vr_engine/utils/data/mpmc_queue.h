@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace vre
+{
+    /**
+     * Bounded lock-free queue for any number of producer and consumer threads, after Dmitry Vyukov's design.
+     *
+     * Each cell has a sequence number that tells which lap of the ring it is ready for: a producer can write a cell when its sequence
+     * equals the position, and a consumer can read it when it equals the position + 1. Threads claim positions with a CAS on the
+     * shared index of their side, then publish the cell by advancing its sequence. Producers and consumers thus only contend with
+     * their own side, and each cell is only touched by one thread at a time.
+     *
+     * Pushes fail when the queue is full and pops fail when it is empty. Elements are stored inline, so big queues should be allocated
+     * on the heap.
+     */
+    template<typename T, size_t Capacity>
+    class MpmcQueue
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+      private:
+        constexpr static size_t MASK = Capacity - 1;
+
+        struct Cell
+        {
+            std::atomic<uint64_t> sequence;
+            T                     value;
+        };
+
+        // 64 is the cache line size of the supported CPUs
+        alignas(64) std::atomic<uint64_t> m_enqueue_position = 0;
+        alignas(64) std::atomic<uint64_t> m_dequeue_position = 0;
+        alignas(64) Cell m_cells[Capacity];
+
+        /**
+         * Claims up to max_count consecutive cells whose sequence is the position + offset. Returns the number of claimed cells, and
+         * the first claimed position in out_position.
+         */
+        size_t claim(std::atomic<uint64_t> &shared_position, uint64_t offset, size_t max_count, uint64_t &out_position)
+        {
+            if (max_count == 0)
+            {
+                return 0;
+            }
+
+            auto position = shared_position.load(std::memory_order_relaxed);
+            while (true)
+            {
+                // Count the cells that are ready, from the current position
+                size_t  ready_count = 0;
+                int64_t difference  = 0;
+                while (ready_count < max_count)
+                {
+                    const auto sequence = m_cells[(position + ready_count) & MASK].sequence.load(std::memory_order_acquire);
+                    difference          = static_cast<int64_t>(sequence - (position + ready_count + offset));
+                    if (difference != 0)
+                    {
+                        break;
+                    }
+                    ready_count++;
+                }
+
+                if (ready_count > 0)
+                {
+                    // Nobody else can claim these cells once the position is past them
+                    if (shared_position.compare_exchange_weak(position, position + ready_count, std::memory_order_relaxed))
+                    {
+                        out_position = position;
+                        return ready_count;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    // The first cell is still used by the previous lap: the queue is full, or empty for consumers
+                    return 0;
+                }
+                else
+                {
+                    // Another thread claimed the cell in the meantime
+                    position = shared_position.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+      public:
+        MpmcQueue()
+        {
+            for (size_t i = 0; i < Capacity; i++)
+            {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpmcQueue(const MpmcQueue &)            = delete;
+        MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+        template<typename U>
+        bool try_push(U &&value)
+        {
+            uint64_t position = 0;
+            if (claim(m_enqueue_position, 0, 1, position) == 0)
+            {
+                return false;
+            }
+            auto &cell = m_cells[position & MASK];
+            cell.value = std::forward<U>(value);
+            cell.sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Pushes as many values as there are consecutive free cells, with a single CAS. Returns the number of pushed values. */
+        size_t try_push(const T *values, size_t count)
+        {
+            uint64_t   position     = 0;
+            const auto pushed_count = claim(m_enqueue_position, 0, count, position);
+            for (size_t i = 0; i < pushed_count; i++)
+            {
+                auto &cell = m_cells[(position + i) & MASK];
+                cell.value = values[i];
+                cell.sequence.store(position + i + 1, std::memory_order_release);
+            }
+            return pushed_count;
+        }
+
+        bool try_pop(T &out_value) { return try_pop(&out_value, 1) == 1; }
+
+        /** Pops up to max_count values that are ready, with a single CAS. Returns the number of popped values. */
+        size_t try_pop(T *out_values, size_t max_count)
+        {
+            uint64_t   position     = 0;
+            const auto popped_count = claim(m_dequeue_position, 1, max_count, position);
+            for (size_t i = 0; i < popped_count; i++)
+            {
+                auto &cell    = m_cells[(position + i) & MASK];
+                out_values[i] = std::move(cell.value);
+                // Ready for the producers of the next lap
+                cell.sequence.store(position + i + Capacity, std::memory_order_release);
+            }
+            return popped_count;
+        }
+
+        /** Number of elements in the queue. It is only a hint, since other threads can change it at any time. */
+        [[nodiscard]] size_t size() const
+        {
+            const auto dequeue_position = m_dequeue_position.load(std::memory_order_acquire);
+            const auto enqueue_position = m_enqueue_position.load(std::memory_order_acquire);
+            return enqueue_position > dequeue_position ? static_cast<size_t>(enqueue_position - dequeue_position) : 0;
+        }
+
+        [[nodiscard]] constexpr static size_t capacity() { return Capacity; }
+    };
+} // namespace vre
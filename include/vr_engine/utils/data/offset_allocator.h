@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace vre
+{
+    /** Range given by an OffsetAllocator. It must be given back to the same allocator to be freed. */
+    struct OffsetAllocation
+    {
+        constexpr static uint32_t NO_SPACE = 0xFFFFFFFF;
+
+        uint32_t offset = NO_SPACE;
+        uint32_t size   = 0;
+        // Index of the node of the range in the allocator
+        uint32_t node = NO_SPACE;
+
+        [[nodiscard]] inline bool is_valid() const { return offset != NO_SPACE; }
+    };
+
+    /**
+     * Sub-allocates ranges of an abstract space of the given size. It only manages offsets: the space itself is typically a big GPU
+     * buffer, and the unit can be anything (bytes, vertices, indices...).
+     *
+     * Free ranges are sorted in power-of-two bins according to their size, and a bitmask tells which bins are non-empty. An
+     * allocation takes the first range of the smallest bin whose ranges are all big enough, so it is O(1). Only if there is none, the
+     * bin that may contain a big enough range is searched. The rest of the range is given back to the bins.
+     *
+     * Each range knows its neighbors in the space, so that a freed range is merged with the free ranges around it.
+     */
+    class OffsetAllocator
+    {
+      public:
+        constexpr static uint32_t BIN_COUNT = 32;
+
+      private:
+        constexpr static uint32_t NO_NODE = 0xFFFFFFFF;
+
+        struct Node
+        {
+            uint32_t offset = 0;
+            uint32_t size   = 0;
+            // Neighbors in the space
+            uint32_t previous_neighbor = NO_NODE;
+            uint32_t next_neighbor     = NO_NODE;
+            // Neighbors in the bin, if the node is free
+            uint32_t previous_free = NO_NODE;
+            uint32_t next_free     = NO_NODE;
+            bool     used          = false;
+        };
+
+        uint32_t              m_size                 = 0;
+        uint32_t              m_free_space           = 0;
+        uint32_t              m_allocation_count     = 0;
+        uint32_t              m_non_empty_bins       = 0;
+        uint32_t              m_bin_heads[BIN_COUNT] = {};
+        std::vector<Node>     m_nodes                = {};
+        std::vector<uint32_t> m_unused_nodes         = {};
+
+        uint32_t create_node(uint32_t offset, uint32_t size);
+        void     destroy_node(uint32_t node_index);
+        void     insert_free_node(uint32_t node_index);
+        void     remove_free_node(uint32_t node_index);
+        uint32_t find_free_node(uint32_t size) const;
+
+      public:
+        OffsetAllocator() : OffsetAllocator(0) {}
+        explicit OffsetAllocator(uint32_t size);
+
+        /** Returns an invalid allocation if there is no free range big enough. */
+        [[nodiscard]] OffsetAllocation allocate(uint32_t size);
+        void                           free(const OffsetAllocation &allocation);
+        /** Frees all the allocations, and changes the size of the space. */
+        void                           reset(uint32_t size);
+
+        [[nodiscard]] inline uint32_t size() const { return m_size; }
+        [[nodiscard]] inline uint32_t free_space() const { return m_free_space; }
+        [[nodiscard]] inline uint32_t allocation_count() const { return m_allocation_count; }
+        /** Size of the biggest allocation that would currently succeed. */
+        [[nodiscard]] uint32_t        largest_free_range() const;
+    };
+} // namespace vre
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace vre
+{
+    /**
+     * Vector that stores up to N elements inline, and only allocates on the heap when it grows past that.
+     *
+     * It is meant for the small collections of the frame path (one element per view, per swapchain image, per layer...), whose size
+     * is known to stay small: as long as it does, creating, filling and destroying the vector never touches the allocator. Once it
+     * spilled to the heap, the vector keeps its heap buffer until it is destroyed, like a std::vector.
+     *
+     * The interface is a subset of std::vector's. Iterators are plain pointers, and are invalidated by any growth.
+     */
+    template<typename T, size_t N>
+    class SmallVector
+    {
+        static_assert(N > 0, "Use a std::vector if no elements should be stored inline");
+
+      public:
+        using value_type     = T;
+        using size_type      = size_t;
+        using iterator       = T *;
+        using const_iterator = const T *;
+
+      private:
+        alignas(T) unsigned char m_inline[N * sizeof(T)];
+        T     *m_data     = reinterpret_cast<T *>(m_inline);
+        size_t m_size     = 0;
+        size_t m_capacity = N;
+
+        [[nodiscard]] inline bool is_inline() const { return m_data == reinterpret_cast<const T *>(m_inline); }
+
+        /** Moves the elements to a heap buffer of the given capacity. */
+        void reallocate(size_t new_capacity)
+        {
+            auto new_data = static_cast<T *>(::operator new(new_capacity * sizeof(T), std::align_val_t(alignof(T))));
+            std::uninitialized_move(m_data, m_data + m_size, new_data);
+            std::destroy(m_data, m_data + m_size);
+            free_heap_buffer();
+
+            m_data     = new_data;
+            m_capacity = new_capacity;
+        }
+
+        void free_heap_buffer()
+        {
+            if (!is_inline())
+            {
+                ::operator delete(m_data, std::align_val_t(alignof(T)));
+            }
+        }
+
+        /** Grows geometrically so that pushes stay amortized O(1) after the spill. */
+        inline void grow_for(size_t count)
+        {
+            if (count > m_capacity)
+            {
+                reallocate(std::max(count, m_capacity * 2));
+            }
+        }
+
+        /** Takes the elements of the other vector. Its heap buffer is stolen if it has one, otherwise the elements are moved. */
+        void take(SmallVector &other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            if (other.is_inline())
+            {
+                std::uninitialized_move(other.m_data, other.m_data + other.m_size, m_data);
+                m_size = other.m_size;
+                other.clear();
+            }
+            else
+            {
+                m_data           = other.m_data;
+                m_size           = other.m_size;
+                m_capacity       = other.m_capacity;
+                other.m_data     = reinterpret_cast<T *>(other.m_inline);
+                other.m_size     = 0;
+                other.m_capacity = N;
+            }
+        }
+
+      public:
+        // --- Construction ---
+
+        SmallVector() = default;
+
+        explicit SmallVector(size_t count) { resize(count); }
+
+        SmallVector(size_t count, const T &value) { resize(count, value); }
+
+        SmallVector(std::initializer_list<T> values)
+        {
+            reserve(values.size());
+            std::uninitialized_copy(values.begin(), values.end(), m_data);
+            m_size = values.size();
+        }
+
+        SmallVector(const SmallVector &other)
+        {
+            reserve(other.m_size);
+            std::uninitialized_copy(other.m_data, other.m_data + other.m_size, m_data);
+            m_size = other.m_size;
+        }
+
+        SmallVector(SmallVector &&other) noexcept(std::is_nothrow_move_constructible_v<T>) { take(other); }
+
+        ~SmallVector()
+        {
+            std::destroy(m_data, m_data + m_size);
+            free_heap_buffer();
+        }
+
+        SmallVector &operator=(const SmallVector &other)
+        {
+            if (this != &other)
+            {
+                clear();
+                reserve(other.m_size);
+                std::uninitialized_copy(other.m_data, other.m_data + other.m_size, m_data);
+                m_size = other.m_size;
+            }
+            return *this;
+        }
+
+        SmallVector &operator=(SmallVector &&other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            if (this != &other)
+            {
+                clear();
+                if (!other.is_inline())
+                {
+                    // Stealing the other buffer is cheaper than keeping ours
+                    free_heap_buffer();
+                    m_data     = reinterpret_cast<T *>(m_inline);
+                    m_capacity = N;
+                }
+                take(other);
+            }
+            return *this;
+        }
+
+        // --- Modification ---
+
+        void push_back(const T &value) { emplace_back(value); }
+
+        void push_back(T &&value) { emplace_back(std::move(value)); }
+
+        template<typename... Args>
+        T &emplace_back(Args &&...args)
+        {
+            if (m_size == m_capacity)
+            {
+                // The arguments may point into the vector, so build the element before moving the others
+                T value(std::forward<Args>(args)...);
+                grow_for(m_size + 1);
+                new (m_data + m_size) T(std::move(value));
+            }
+            else
+            {
+                new (m_data + m_size) T(std::forward<Args>(args)...);
+            }
+            return m_data[m_size++];
+        }
+
+        void pop_back()
+        {
+            m_size--;
+            std::destroy_at(m_data + m_size);
+        }
+
+        void resize(size_t count)
+        {
+            if (count < m_size)
+            {
+                std::destroy(m_data + count, m_data + m_size);
+            }
+            else
+            {
+                grow_for(count);
+                std::uninitialized_value_construct(m_data + m_size, m_data + count);
+            }
+            m_size = count;
+        }
+
+        void resize(size_t count, const T &value)
+        {
+            if (count < m_size)
+            {
+                std::destroy(m_data + count, m_data + m_size);
+            }
+            else
+            {
+                grow_for(count);
+                std::uninitialized_fill(m_data + m_size, m_data + count, value);
+            }
+            m_size = count;
+        }
+
+        void reserve(size_t capacity)
+        {
+            if (capacity > m_capacity)
+            {
+                reallocate(capacity);
+            }
+        }
+
+        /** Destroys the elements. The capacity is kept. */
+        void clear()
+        {
+            std::destroy(m_data, m_data + m_size);
+            m_size = 0;
+        }
+
+        // --- Access ---
+
+        [[nodiscard]] T &operator[](size_t index) { return m_data[index]; }
+
+        [[nodiscard]] const T &operator[](size_t index) const { return m_data[index]; }
+
+        T &at(size_t index)
+        {
+            if (index >= m_size)
+            {
+                throw std::out_of_range("SmallVector index out of range");
+            }
+            return m_data[index];
+        }
+
+        const T &at(size_t index) const { return const_cast<SmallVector *>(this)->at(index); }
+
+        [[nodiscard]] T &front() { return m_data[0]; }
+
+        [[nodiscard]] const T &front() const { return m_data[0]; }
+
+        [[nodiscard]] T &back() { return m_data[m_size - 1]; }
+
+        [[nodiscard]] const T &back() const { return m_data[m_size - 1]; }
+
+        [[nodiscard]] T *data() { return m_data; }
+
+        [[nodiscard]] const T *data() const { return m_data; }
+
+        [[nodiscard]] size_t size() const { return m_size; }
+
+        [[nodiscard]] size_t capacity() const { return m_capacity; }
+
+        [[nodiscard]] bool empty() const { return m_size == 0; }
+
+        /** True if the elements are in a heap buffer, because the vector grew past N at some point. */
+        [[nodiscard]] bool is_on_heap() const { return !is_inline(); }
+
+        [[nodiscard]] constexpr static size_t inline_capacity() { return N; }
+
+        // --- Iteration ---
+
+        [[nodiscard]] iterator begin() { return m_data; }
+
+        [[nodiscard]] iterator end() { return m_data + m_size; }
+
+        [[nodiscard]] const_iterator begin() const { return m_data; }
+
+        [[nodiscard]] const_iterator end() const { return m_data + m_size; }
+    };
+} // namespace vre
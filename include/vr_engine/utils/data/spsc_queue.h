@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace vre
+{
+    /**
+     * Bounded lock-free queue between one producer thread and one consumer thread.
+     *
+     * The indices are on separate cache lines, and each side keeps a copy of the last index it read from the other side, so that it
+     * only reads the shared line when the queue looks full (producer) or empty (consumer). Neither side ever waits: pushes fail when
+     * the queue is full and pops fail when it is empty.
+     *
+     * Elements are stored inline, so big queues should be allocated on the heap. The consumer side can be used by several threads
+     * if they are externally synchronized, and the same goes for the producer side.
+     */
+    template<typename T, size_t Capacity>
+    class SpscQueue
+    {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+      private:
+        constexpr static size_t MASK = Capacity - 1;
+
+        // Producer side. 64 is the cache line size of the supported CPUs.
+        alignas(64) std::atomic<uint64_t> m_head        = 0;
+        uint64_t                          m_cached_tail = 0;
+        // Consumer side
+        alignas(64) std::atomic<uint64_t> m_tail        = 0;
+        uint64_t                          m_cached_head = 0;
+
+        alignas(64) T m_slots[Capacity];
+
+        /** Number of free slots, as seen by the producer. Only reads the tail if the cached one says there is not enough room. */
+        inline size_t free_slot_count(uint64_t head, size_t wanted_count)
+        {
+            if (Capacity - (head - m_cached_tail) < wanted_count)
+            {
+                m_cached_tail = m_tail.load(std::memory_order_acquire);
+            }
+            return Capacity - (head - m_cached_tail);
+        }
+
+        /** Number of available elements, as seen by the consumer. Only reads the head if the cached one says there are not enough. */
+        inline size_t available_count(uint64_t tail, size_t wanted_count)
+        {
+            if (m_cached_head - tail < wanted_count)
+            {
+                m_cached_head = m_head.load(std::memory_order_acquire);
+            }
+            return m_cached_head - tail;
+        }
+
+      public:
+        SpscQueue()                             = default;
+        SpscQueue(const SpscQueue &)            = delete;
+        SpscQueue &operator=(const SpscQueue &) = delete;
+
+        // --- Producer ---
+
+        /**
+         * Reserves the next slot, so that the element can be written in place. Returns nullptr if the queue is full. The element is
+         * only visible to the consumer after end_push.
+         */
+        T *begin_push()
+        {
+            const auto head = m_head.load(std::memory_order_relaxed);
+            if (free_slot_count(head, 1) == 0)
+            {
+                return nullptr;
+            }
+            return &m_slots[head & MASK];
+        }
+
+        /** Publishes the slot reserved by begin_push. */
+        void end_push() { m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+        template<typename U>
+        bool try_push(U &&value)
+        {
+            T *slot = begin_push();
+            if (slot == nullptr)
+            {
+                return false;
+            }
+            *slot = std::forward<U>(value);
+            end_push();
+            return true;
+        }
+
+        /** Pushes as many values as there is room for, and publishes them at once. Returns the number of pushed values. */
+        size_t try_push(const T *values, size_t count)
+        {
+            const auto head = m_head.load(std::memory_order_relaxed);
+            count           = std::min(count, free_slot_count(head, count));
+            for (size_t i = 0; i < count; i++)
+            {
+                m_slots[(head + i) & MASK] = values[i];
+            }
+            m_head.store(head + count, std::memory_order_release);
+            return count;
+        }
+
+        // --- Consumer ---
+
+        bool try_pop(T &out_value) { return try_pop(&out_value, 1) == 1; }
+
+        /** Pops up to max_count values, and frees their slots at once. Returns the number of popped values. */
+        size_t try_pop(T *out_values, size_t max_count)
+        {
+            const auto tail  = m_tail.load(std::memory_order_relaxed);
+            const auto count = std::min(max_count, available_count(tail, max_count));
+            for (size_t i = 0; i < count; i++)
+            {
+                out_values[i] = std::move(m_slots[(tail + i) & MASK]);
+            }
+            m_tail.store(tail + count, std::memory_order_release);
+            return count;
+        }
+
+        /**
+         * Calls the function on each available element, in order, then frees all their slots at once. The elements are read in
+         * place, which avoids a copy when they don't need to be kept. Returns the number of consumed elements.
+         */
+        template<typename F>
+        size_t consume_all(F &&function)
+        {
+            const auto tail  = m_tail.load(std::memory_order_relaxed);
+            const auto count = available_count(tail, Capacity);
+            for (size_t i = 0; i < count; i++)
+            {
+                function(static_cast<const T &>(m_slots[(tail + i) & MASK]));
+            }
+            m_tail.store(tail + count, std::memory_order_release);
+            return count;
+        }
+
+        /** Drops the available elements. */
+        void clear()
+        {
+            m_cached_head = m_head.load(std::memory_order_acquire);
+            m_tail.store(m_cached_head, std::memory_order_release);
+        }
+
+        // --- Both ---
+
+        /** Number of elements in the queue. It is only a hint, since the other side can change it at any time. */
+        [[nodiscard]] size_t size() const
+        {
+            const auto tail = m_tail.load(std::memory_order_acquire);
+            return static_cast<size_t>(m_head.load(std::memory_order_acquire) - tail);
+        }
+
+        [[nodiscard]] constexpr static size_t capacity() { return Capacity; }
+    };
+} // namespace vre
@@ -73,6 +73,8 @@ namespace vre
 
         [[nodiscard]] size_t count() const { return m_map.count(); }
 
+        [[nodiscard]] HashMapStats stats() const { return m_map.stats(); }
+
         [[nodiscard]] bool exists(Id id) const { return m_map.exists(id); }
 
         // Iterator
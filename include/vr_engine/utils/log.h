@@ -0,0 +1,299 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// --=== Compile-time level ===--
+
+// Messages below this level are compiled out. 0: trace, 1: info, 2: warning, 3: error, 4: nothing
+#ifndef VRE_LOG_LEVEL
+#ifdef DEBUG
+#define VRE_LOG_LEVEL 0
+#else
+#define VRE_LOG_LEVEL 1
+#endif
+#endif
+
+namespace vre
+{
+    // --=== Types ===--
+
+    // Not in uppercase, because DEBUG and ERROR are common macro names
+    enum class LogLevel : uint8_t
+    {
+        Trace   = 0,
+        Info    = 1,
+        Warning = 2,
+        Error   = 3,
+    };
+
+    /**
+     * Destination of the formatted messages. Sinks are called by the logger thread, but also by the threads that call Logger::flush
+     * or Logger::clear_sinks, and by the thread that exits the program. The calls are serialized, so a sink is only called by one
+     * thread at a time, but not always by the same one: it must not rely on thread-local state.
+     */
+    class LogSink
+    {
+      public:
+        virtual ~LogSink() = default;
+
+        /** Writes a formatted message. The message doesn't contain the final new line. */
+        virtual void write(LogLevel level, const std::string &message) = 0;
+        virtual void flush() {}
+    };
+
+    /** Writes warnings and errors to stderr, and the rest to stdout. */
+    class ConsoleLogSink : public LogSink
+    {
+      public:
+        void write(LogLevel level, const std::string &message) override;
+        void flush() override;
+    };
+
+    class FileLogSink : public LogSink
+    {
+      private:
+        FILE *m_file = nullptr;
+
+      public:
+        explicit FileLogSink(const char *path);
+        ~FileLogSink() override;
+
+        FileLogSink(const FileLogSink &)            = delete;
+        FileLogSink &operator=(const FileLogSink &) = delete;
+
+        [[nodiscard]] inline bool is_valid() const { return m_file != nullptr; }
+
+        void write(LogLevel level, const std::string &message) override;
+        void flush() override;
+    };
+
+    /** Keeps the messages in memory. Mostly useful for tests. */
+    class MemoryLogSink : public LogSink
+    {
+      private:
+        struct Data;
+        std::unique_ptr<Data> m_data;
+
+      public:
+        MemoryLogSink();
+        ~MemoryLogSink() override;
+
+        void write(LogLevel level, const std::string &message) override;
+
+        /** Returns a copy of the messages written so far. Can be called from any thread. */
+        [[nodiscard]] std::vector<std::string> messages() const;
+        void                                   clear();
+    };
+
+    // --=== Records ===--
+
+    namespace log_impl
+    {
+        enum class ArgumentType : uint8_t
+        {
+            INT,
+            UINT,
+            DOUBLE,
+            BOOL,
+            STRING,
+            POINTER,
+        };
+
+#define VRE_LOG_RECORD_PAYLOAD_SIZE 224
+
+        /**
+         * Binary record pushed by the threads. Only the arguments are copied: the format string is kept as a pointer, so it must be
+         * a string literal. It is formatted later, on the logger thread.
+         */
+        struct LogRecord
+        {
+            const char *format         = nullptr;
+            uint64_t    timestamp      = 0;
+            LogLevel    level          = LogLevel::Info;
+            uint8_t     argument_count = 0;
+            uint16_t    payload_size   = 0;
+            uint8_t     payload[VRE_LOG_RECORD_PAYLOAD_SIZE];
+
+            inline bool write_bytes(ArgumentType type, const void *data, size_t size)
+            {
+                if (payload_size + 1 + size > VRE_LOG_RECORD_PAYLOAD_SIZE)
+                {
+                    return false;
+                }
+                payload[payload_size] = static_cast<uint8_t>(type);
+                memcpy(payload + payload_size + 1, data, size);
+                payload_size += static_cast<uint16_t>(1 + size);
+                argument_count++;
+                return true;
+            }
+
+            inline void write_string(const char *str, size_t length)
+            {
+                // Type, length, then characters. Long strings are truncated to what remains of the payload.
+                const size_t header_size = 1 + sizeof(uint16_t);
+                if (payload_size + header_size > VRE_LOG_RECORD_PAYLOAD_SIZE)
+                {
+                    return;
+                }
+                length = std::min(length, static_cast<size_t>(VRE_LOG_RECORD_PAYLOAD_SIZE - payload_size - header_size));
+
+                const auto length16   = static_cast<uint16_t>(length);
+                payload[payload_size] = static_cast<uint8_t>(ArgumentType::STRING);
+                memcpy(payload + payload_size + 1, &length16, sizeof(uint16_t));
+                memcpy(payload + payload_size + header_size, str, length);
+                payload_size += static_cast<uint16_t>(header_size + length);
+                argument_count++;
+            }
+
+            template<typename T>
+            inline void write_argument(const T &value)
+            {
+                using U = std::decay_t<T>;
+                if constexpr (std::is_same_v<U, bool>)
+                {
+                    write_bytes(ArgumentType::BOOL, &value, sizeof(bool));
+                }
+                else if constexpr (std::is_enum_v<U>)
+                {
+                    write_argument(static_cast<std::underlying_type_t<U>>(value));
+                }
+                else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>)
+                {
+                    const auto v = static_cast<int64_t>(value);
+                    write_bytes(ArgumentType::INT, &v, sizeof(v));
+                }
+                else if constexpr (std::is_integral_v<U>)
+                {
+                    const auto v = static_cast<uint64_t>(value);
+                    write_bytes(ArgumentType::UINT, &v, sizeof(v));
+                }
+                else if constexpr (std::is_floating_point_v<U>)
+                {
+                    const auto v = static_cast<double>(value);
+                    write_bytes(ArgumentType::DOUBLE, &v, sizeof(v));
+                }
+                else if constexpr (std::is_array_v<T>)
+                {
+                    // String literals
+                    write_string(value, strlen(value));
+                }
+                else if constexpr (std::is_same_v<U, const char *> || std::is_same_v<U, char *>)
+                {
+                    if (value == nullptr)
+                    {
+                        write_string("(null)", 6);
+                    }
+                    else
+                    {
+                        write_string(value, strlen(value));
+                    }
+                }
+                else if constexpr (std::is_convertible_v<const U &, std::string_view>)
+                {
+                    const std::string_view view = value;
+                    write_string(view.data(), view.size());
+                }
+                else if constexpr (std::is_pointer_v<U>)
+                {
+                    const auto v = reinterpret_cast<uintptr_t>(value);
+                    write_bytes(ArgumentType::POINTER, &v, sizeof(v));
+                }
+                else
+                {
+                    static_assert(std::is_pointer_v<U>, "Unsupported log argument type");
+                }
+            }
+        };
+
+        /** Reserves a record in the queue of the current thread. Returns nullptr if the queue is full. */
+        LogRecord *begin_record();
+        /** Publishes the record returned by begin_record. */
+        void       end_record();
+        /** Returns whether messages of this level should be recorded, according to the runtime level. */
+        bool       is_level_enabled(LogLevel level);
+    } // namespace log_impl
+
+    // --=== Logger ===--
+
+    /**
+     * Asynchronous logger.
+     *
+     * Each thread pushes binary records in its own lock-free queue, which never blocks: if the queue is full, the message is dropped
+     * and counted. The queue of a thread is reused by the next thread once it exits. A background thread formats the records and
+     * writes them to the sinks. Format strings use "{}" placeholders.
+     *
+     * The VRE_LOG_* macros below should be preferred, since messages below VRE_LOG_LEVEL are compiled out.
+     */
+    class Logger
+    {
+      public:
+        template<typename... Args>
+        static inline void log(LogLevel level, const char *format, const Args &...args)
+        {
+            if (!log_impl::is_level_enabled(level))
+            {
+                return;
+            }
+
+            auto *record = log_impl::begin_record();
+            if (record == nullptr)
+            {
+                return;
+            }
+            record->format         = format;
+            record->level          = level;
+            record->argument_count = 0;
+            record->payload_size   = 0;
+            (record->write_argument(args), ...);
+            log_impl::end_record();
+        }
+
+        /** Adds a sink. When no sink was ever added, messages go to a console sink. */
+        static void add_sink(const std::shared_ptr<LogSink> &sink);
+        static void clear_sinks();
+        /** Filters messages at runtime, in addition to the compile-time level. */
+        static void set_level(LogLevel level);
+
+        /** Blocks until all messages logged before the call are written to the sinks. */
+        static void flush();
+        /** Number of messages dropped because a queue was full. */
+        [[nodiscard]] static uint64_t dropped_message_count();
+
+        /** Formats a record. Exposed for tests. */
+        static std::string format(const log_impl::LogRecord &record);
+    };
+} // namespace vre
+
+// --=== Macros ===--
+
+#if VRE_LOG_LEVEL <= 0
+#define VRE_LOG_TRACE(...) vre::Logger::log(vre::LogLevel::Trace, __VA_ARGS__)
+#else
+#define VRE_LOG_TRACE(...) ((void) 0)
+#endif
+
+#if VRE_LOG_LEVEL <= 1
+#define VRE_LOG_INFO(...) vre::Logger::log(vre::LogLevel::Info, __VA_ARGS__)
+#else
+#define VRE_LOG_INFO(...) ((void) 0)
+#endif
+
+#if VRE_LOG_LEVEL <= 2
+#define VRE_LOG_WARNING(...) vre::Logger::log(vre::LogLevel::Warning, __VA_ARGS__)
+#else
+#define VRE_LOG_WARNING(...) ((void) 0)
+#endif
+
+#if VRE_LOG_LEVEL <= 3
+#define VRE_LOG_ERROR(...) vre::Logger::log(vre::LogLevel::Error, __VA_ARGS__)
+#else
+#define VRE_LOG_ERROR(...) ((void) 0)
+#endif
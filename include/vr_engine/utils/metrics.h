@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vre
+{
+    // --=== Metrics ===--
+
+    /** Monotonic counter. Safe to increment from any thread. */
+    class Counter
+    {
+      private:
+        std::atomic<uint64_t> m_value = 0;
+
+      public:
+        inline void add(uint64_t amount = 1) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+
+        [[nodiscard]] inline uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+    };
+
+    /** Last value of a measure. Safe to set from any thread. */
+    class Gauge
+    {
+      private:
+        std::atomic<double> m_value = 0.0;
+
+      public:
+        inline void set(double value) { m_value.store(value, std::memory_order_relaxed); }
+
+        [[nodiscard]] inline double value() const { return m_value.load(std::memory_order_relaxed); }
+    };
+
+    struct HistogramSummary
+    {
+        uint64_t count = 0;
+        uint64_t min   = 0;
+        double   mean  = 0.0;
+        uint64_t p50   = 0;
+        uint64_t p95   = 0;
+        uint64_t p99   = 0;
+        uint64_t max   = 0;
+    };
+
+    /**
+     * High dynamic range histogram of unsigned integer values, such as durations in nanoseconds or sizes in bytes.
+     *
+     * Buckets are log-linear: each power of 2 is split in SUB_BUCKET_COUNT linear buckets, so the relative error of the
+     * percentiles is bounded by 1 / SUB_BUCKET_COUNT over the whole uint64_t range. Recording is lock-free.
+     *
+     * Besides the summary of all the values since the creation, the histogram can summarize the values of the current window, which
+     * is closed by end_window.
+     */
+    class Histogram
+    {
+      public:
+        static constexpr uint32_t SUB_BUCKET_BITS  = 5;
+        static constexpr uint32_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+        static constexpr uint32_t BUCKET_COUNT     = SUB_BUCKET_COUNT * (64 - SUB_BUCKET_BITS + 1);
+
+      private:
+        std::atomic<uint64_t> m_counts[BUCKET_COUNT] = {};
+        std::atomic<uint64_t> m_sum                  = 0;
+        std::atomic<uint64_t> m_min                  = UINT64_MAX;
+        std::atomic<uint64_t> m_max                  = 0;
+
+        // Counts at the start of the current window. Only used by the thread that reads the summaries.
+        std::unique_ptr<uint64_t[]> m_window_start_counts = std::make_unique<uint64_t[]>(BUCKET_COUNT);
+        uint64_t                    m_window_start_sum    = 0;
+
+      public:
+        static uint32_t bucket_index(uint64_t value);
+        /** Smallest value that falls in the given bucket. */
+        static uint64_t bucket_lower_bound(uint32_t index);
+        /** Biggest value that falls in the given bucket. */
+        static uint64_t bucket_upper_bound(uint32_t index);
+
+        void record(uint64_t value);
+
+        /** Summary of all the values recorded since the creation of the histogram. */
+        [[nodiscard]] HistogramSummary summary() const;
+        /** Summary of the values recorded since the last call to end_window. */
+        [[nodiscard]] HistogramSummary window_summary() const;
+        void                           end_window();
+    };
+
+    // --=== Snapshots ===--
+
+    /** Values of all the metrics of a registry at a given time. Histograms are summarized over the window of the snapshot. */
+    struct MetricsSnapshot
+    {
+        template<typename T>
+        struct Entry
+        {
+            std::string name;
+            T           value;
+        };
+
+        double                               timestamp  = 0.0;
+        std::vector<Entry<uint64_t>>         counters   = {};
+        std::vector<Entry<double>>           gauges     = {};
+        std::vector<Entry<HistogramSummary>> histograms = {};
+
+        /**
+         * Appends the values to a CSV file, one row per metric. The header is written if the file is empty. Non-finite gauges have
+         * an empty value.
+         */
+        bool append_csv(const char *path) const;
+        /** Writes the values to a JSON file. Non-finite gauges are written as null. */
+        bool write_json(const char *path) const;
+    };
+
+    // --=== Registry ===--
+
+    /**
+     * Named collection of metrics.
+     *
+     * Metrics are created on their first access and are never destroyed before the registry, so the returned references can be
+     * kept to avoid the lookup in hot paths. Names should follow the "system.measure_unit" pattern, e.g. "xr.wait_frame_ns".
+     */
+    class MetricsRegistry
+    {
+      private:
+        struct Data;
+        std::unique_ptr<Data> m_data;
+
+      public:
+        MetricsRegistry();
+        ~MetricsRegistry();
+
+        MetricsRegistry(const MetricsRegistry &)            = delete;
+        MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+        /** Registry used by the engine systems. */
+        static MetricsRegistry &global();
+
+        Counter   &counter(const std::string &name);
+        Gauge     &gauge(const std::string &name);
+        Histogram &histogram(const std::string &name);
+
+        /** Closes the current window of all histograms. */
+        void end_window();
+
+        /** Copies the current values. Histograms are summarized over the current window. */
+        [[nodiscard]] MetricsSnapshot snapshot(double timestamp) const;
+
+        /** Same as snapshot(timestamp).append_csv(path) */
+        bool append_csv(const char *path, double timestamp) const;
+        /** Same as snapshot(0).write_json(path) */
+        bool write_json(const char *path) const;
+    };
+
+    // --=== Writer ===--
+
+    /**
+     * Writes snapshots to the metrics files on its own thread, so that the thread that takes them doesn't wait for the file system.
+     * The pending snapshots are written before the destruction.
+     */
+    class MetricsWriter
+    {
+      private:
+        struct Data;
+        std::unique_ptr<Data> m_data;
+
+      public:
+        /** Either path can be null, to skip that file. */
+        MetricsWriter(const char *csv_path, const char *json_path);
+        ~MetricsWriter();
+
+        MetricsWriter(const MetricsWriter &)            = delete;
+        MetricsWriter &operator=(const MetricsWriter &) = delete;
+
+        /** Queues the snapshot: it is appended to the CSV file, and replaces the content of the JSON file. */
+        void write(MetricsSnapshot &&snapshot);
+    };
+} // namespace vre
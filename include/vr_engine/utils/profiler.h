@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VRE_PROFILER_USE_TSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace vre
+{
+    enum class ProfilerEventType : uint8_t
+    {
+        ZONE,
+        FRAME_MARK,
+        COUNTER,
+    };
+
+    /** Event stored in the per-thread ring buffers. Names must be string literals (or outlive the profiler). */
+    struct ProfilerEvent
+    {
+        const char *name      = nullptr;
+        uint64_t    timestamp = 0;
+        union
+        {
+            // Zones
+            uint64_t duration = 0;
+            // Counters
+            double value;
+        };
+        ProfilerEventType type = ProfilerEventType::ZONE;
+    };
+
+    /**
+     * Low overhead CPU profiler.
+     *
+     * Each thread writes its events in its own lock-free ring buffer. The buffers are drained when the trace is exported, in the
+     * Chrome trace JSON format, which can be opened in chrome://tracing or in the Perfetto UI.
+     *
+     * The macros below should be preferred over the direct use of this class, since they are compiled out when ENABLE_PROFILER is
+     * not defined.
+     */
+    class Profiler
+    {
+      public:
+        /** Returns the current time in profiler ticks. Ticks are converted to real time during the export. */
+        static inline uint64_t now()
+        {
+#ifdef VRE_PROFILER_USE_TSC
+            return __rdtsc();
+#else
+            return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+        }
+
+        static void record_zone(const char *name, uint64_t start, uint64_t end);
+        static void frame_mark();
+        static void counter(const char *name, double value);
+        /** Names the current thread in the exported trace. The name must be a string literal. */
+        static void set_thread_name(const char *name);
+
+        /**
+         * Drains the buffers of all threads and writes their events in a Chrome trace JSON file.
+         * @return true if the file could be written
+         */
+        static bool export_chrome_trace(const char *path);
+        /** Drops all events recorded so far. */
+        static void clear();
+        /** Number of events that were dropped because a buffer was full. */
+        [[nodiscard]] static uint64_t dropped_event_count();
+    };
+
+    /** Records a zone from its construction to its destruction. */
+    class ProfilerZone
+    {
+      private:
+        const char *m_name;
+        uint64_t    m_start;
+
+      public:
+        explicit ProfilerZone(const char *name) : m_name(name), m_start(Profiler::now()) {}
+        ~ProfilerZone() { Profiler::record_zone(m_name, m_start, Profiler::now()); }
+
+        ProfilerZone(const ProfilerZone &)            = delete;
+        ProfilerZone &operator=(const ProfilerZone &) = delete;
+    };
+} // namespace vre
+
+// --=== Macros ===--
+
+#ifdef ENABLE_PROFILER
+
+#define VRE_PROFILER_CONCAT2(a, b) a##b
+#define VRE_PROFILER_CONCAT(a, b)  VRE_PROFILER_CONCAT2(a, b)
+
+/** Profiles the current scope */
+#define VRE_ZONE(name)              vre::ProfilerZone VRE_PROFILER_CONCAT(vre_profiler_zone_, __LINE__)(name)
+/** Marks the end of a frame */
+#define VRE_FRAME_MARK()            vre::Profiler::frame_mark()
+/** Records the value of a counter */
+#define VRE_COUNTER(name, value)    vre::Profiler::counter(name, static_cast<double>(value))
+#define VRE_PROFILER_THREAD(name)   vre::Profiler::set_thread_name(name)
+
+#else
+
+#define VRE_ZONE(name)              ((void) 0)
+#define VRE_FRAME_MARK()            ((void) 0)
+#define VRE_COUNTER(name, value)    ((void) 0)
+#define VRE_PROFILER_THREAD(name)   ((void) 0)
+
+#endif
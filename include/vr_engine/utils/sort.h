@@ -0,0 +1,395 @@
+#pragma once
+
+#include <algorithm>
+#include <barrier>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * LSD radix sorts of unsigned integer keys, such as draw keys and entity ids.
+ *
+ * Keys are sorted digit by digit, from the least significant one. The histograms of all the digits are built in a single read of the
+ * keys, and the passes on digits that are equal for every key are skipped: draw keys often leave their high bits unused. The sorts
+ * are stable, so the key-value variants keep the order of the values that have the same key.
+ *
+ * Each pass moves the elements between the input and a scratch buffer of the same size, which the caller can provide to avoid an
+ * allocation. Below about a thousand keys, the histograms cost more than a comparison sort, so small inputs fall back to std::sort,
+ * or to an insertion sort for the tiny key-value ones. The sorts support up to 2^32 elements.
+ */
+namespace vre
+{
+    // --=== Utils ===--
+
+    namespace sort_utils
+    {
+        // Below these sizes, building and scanning the histograms costs more than a comparison sort
+        constexpr size_t STD_SORT_THRESHOLD       = 1024;
+        constexpr size_t INSERTION_SORT_THRESHOLD = 64;
+        // The parallel sort gives each thread at least this number of elements, otherwise the synchronization and the creation of
+        // the thread cost too much
+        constexpr size_t PARALLEL_MIN_ELEMENTS_PER_THREAD = 1 << 16;
+
+        // Value type of the sorts that only have keys
+        struct NoValue
+        {
+        };
+
+        template<typename Key, uint32_t DigitBits>
+        struct Radix
+        {
+            static_assert(std::is_unsigned_v<Key>, "Radix sort keys must be unsigned integers");
+            static_assert(DigitBits >= 4 && DigitBits <= 16, "Digits must be between 4 and 16 bits");
+
+            constexpr static uint32_t DIGIT_COUNT = 1u << DigitBits;
+            constexpr static uint32_t PASS_COUNT  = (sizeof(Key) * 8 + DigitBits - 1) / DigitBits;
+
+            static inline uint32_t digit(Key key, uint32_t pass)
+            {
+                return static_cast<uint32_t>(key >> (pass * DigitBits)) & (DIGIT_COUNT - 1);
+            }
+        };
+
+        inline void check_sort_size(size_t count)
+        {
+            if (count > UINT32_MAX)
+            {
+                throw std::length_error("Radix sort supports up to 2^32 elements");
+            }
+        }
+
+        inline void check_value_count(size_t key_count, size_t value_count)
+        {
+            if (key_count != value_count)
+            {
+                throw std::invalid_argument("Radix sort needs as many values as keys");
+            }
+        }
+
+        template<typename Key, typename Value>
+        void insertion_sort(Key *keys, Value *values, size_t count)
+        {
+            for (size_t i = 1; i < count; i++)
+            {
+                Key    key = keys[i];
+                size_t j   = i;
+                if constexpr (std::is_same_v<Value, NoValue>)
+                {
+                    for (; j > 0 && keys[j - 1] > key; j--)
+                    {
+                        keys[j] = keys[j - 1];
+                    }
+                }
+                else
+                {
+                    Value value = std::move(values[i]);
+                    for (; j > 0 && keys[j - 1] > key; j--)
+                    {
+                        keys[j]   = keys[j - 1];
+                        values[j] = std::move(values[j - 1]);
+                    }
+                    values[j] = std::move(value);
+                }
+                keys[j] = key;
+            }
+        }
+
+        template<typename Key, typename Value>
+        void copy_range(const Key *src_keys, const Value *src_values, Key *dst_keys, Value *dst_values, size_t begin, size_t end)
+        {
+            std::copy(src_keys + begin, src_keys + end, dst_keys + begin);
+            if constexpr (!std::is_same_v<Value, NoValue>)
+            {
+                std::copy(src_values + begin, src_values + end, dst_values + begin);
+            }
+        }
+
+        template<uint32_t DigitBits, typename Key, typename Value>
+        void radix_sort_impl(Key *keys, Value *values, size_t count, Key *key_scratch, Value *value_scratch)
+        {
+            using R = Radix<Key, DigitBits>;
+
+            // Equal keys can't be told apart, so the stability of std::sort doesn't matter when there are no values
+            if constexpr (std::is_same_v<Value, NoValue>)
+            {
+                if (count <= STD_SORT_THRESHOLD)
+                {
+                    std::sort(keys, keys + count);
+                    return;
+                }
+            }
+            if (count <= INSERTION_SORT_THRESHOLD)
+            {
+                insertion_sort(keys, values, count);
+                return;
+            }
+            check_sort_size(count);
+
+            // Histograms of all the digits, in a single read of the keys
+            std::vector<uint32_t> histograms(R::PASS_COUNT * R::DIGIT_COUNT, 0);
+            for (size_t i = 0; i < count; i++)
+            {
+                const Key key = keys[i];
+                for (uint32_t pass = 0; pass < R::PASS_COUNT; pass++)
+                {
+                    histograms[pass * R::DIGIT_COUNT + R::digit(key, pass)]++;
+                }
+            }
+
+            Key   *src_keys   = keys;
+            Value *src_values = values;
+            Key   *dst_keys   = key_scratch;
+            Value *dst_values = value_scratch;
+            for (uint32_t pass = 0; pass < R::PASS_COUNT; pass++)
+            {
+                uint32_t *offsets = &histograms[pass * R::DIGIT_COUNT];
+
+                // If all the keys have the same digit, the pass would not move anything
+                if (offsets[R::digit(src_keys[0], pass)] == count)
+                {
+                    continue;
+                }
+
+                // Turn the histogram into the position of the first key of each digit
+                uint32_t offset = 0;
+                for (uint32_t digit = 0; digit < R::DIGIT_COUNT; digit++)
+                {
+                    const uint32_t digit_count = offsets[digit];
+                    offsets[digit]             = offset;
+                    offset += digit_count;
+                }
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    const uint32_t position = offsets[R::digit(src_keys[i], pass)]++;
+                    dst_keys[position]      = src_keys[i];
+                    if constexpr (!std::is_same_v<Value, NoValue>)
+                    {
+                        dst_values[position] = std::move(src_values[i]);
+                    }
+                }
+
+                std::swap(src_keys, dst_keys);
+                std::swap(src_values, dst_values);
+            }
+
+            // After an odd number of passes, the result is in the scratch buffer
+            if (src_keys != keys)
+            {
+                copy_range(src_keys, src_values, keys, values, 0, count);
+            }
+        }
+
+        template<uint32_t DigitBits, typename Key, typename Value>
+        void parallel_radix_sort_impl(Key     *keys,
+                                      Value   *values,
+                                      size_t   count,
+                                      Key     *key_scratch,
+                                      Value   *value_scratch,
+                                      uint32_t thread_count)
+        {
+            using R = Radix<Key, DigitBits>;
+
+            if (thread_count == 0)
+            {
+                thread_count = std::max(1u, std::thread::hardware_concurrency());
+            }
+            thread_count = static_cast<uint32_t>(std::min<size_t>(thread_count, count / PARALLEL_MIN_ELEMENTS_PER_THREAD));
+            if (thread_count <= 1)
+            {
+                radix_sort_impl<DigitBits>(keys, values, count, key_scratch, value_scratch);
+                return;
+            }
+            check_sort_size(count);
+
+            // Each thread sorts a contiguous chunk of the input. The histograms of a thread are laid out as [pass][digit], and the
+            // offsets where each thread scatters its keys in the current pass as [thread][digit].
+            std::vector<uint32_t> histograms(thread_count * R::PASS_COUNT * R::DIGIT_COUNT, 0);
+            std::vector<uint32_t> offsets(thread_count * R::DIGIT_COUNT, 0);
+            bool                  skip_pass[R::PASS_COUNT] = {};
+            std::barrier          sync(thread_count);
+
+            auto worker = [&](uint32_t thread_index)
+            {
+                const size_t begin     = count * thread_index / thread_count;
+                const size_t end       = count * (thread_index + 1) / thread_count;
+                uint32_t    *histogram = &histograms[thread_index * R::PASS_COUNT * R::DIGIT_COUNT];
+
+                // Histograms of all the digits of the chunk
+                for (size_t i = begin; i < end; i++)
+                {
+                    const Key key = keys[i];
+                    for (uint32_t pass = 0; pass < R::PASS_COUNT; pass++)
+                    {
+                        histogram[pass * R::DIGIT_COUNT + R::digit(key, pass)]++;
+                    }
+                }
+                sync.arrive_and_wait();
+
+                // The total of the chunks tells which digits are the same for all keys
+                if (thread_index == 0)
+                {
+                    for (uint32_t pass = 0; pass < R::PASS_COUNT; pass++)
+                    {
+                        const uint32_t digit       = R::digit(keys[0], pass);
+                        size_t         digit_count = 0;
+                        for (uint32_t thread = 0; thread < thread_count; thread++)
+                        {
+                            digit_count += histograms[(thread * R::PASS_COUNT + pass) * R::DIGIT_COUNT + digit];
+                        }
+                        skip_pass[pass] = digit_count == count;
+                    }
+                }
+                sync.arrive_and_wait();
+
+                Key   *src_keys           = keys;
+                Value *src_values         = values;
+                Key   *dst_keys           = key_scratch;
+                Value *dst_values         = value_scratch;
+                bool   is_chunk_unchanged = true;
+                for (uint32_t pass = 0; pass < R::PASS_COUNT; pass++)
+                {
+                    if (skip_pass[pass])
+                    {
+                        continue;
+                    }
+
+                    // Once a pass has shuffled the keys, the chunk contains other keys, so its histogram must be computed again
+                    uint32_t *pass_histogram = &histogram[pass * R::DIGIT_COUNT];
+                    if (!is_chunk_unchanged)
+                    {
+                        std::fill(pass_histogram, pass_histogram + R::DIGIT_COUNT, 0);
+                        for (size_t i = begin; i < end; i++)
+                        {
+                            pass_histogram[R::digit(src_keys[i], pass)]++;
+                        }
+                        sync.arrive_and_wait();
+                    }
+                    is_chunk_unchanged = false;
+
+                    // Keys with the same digit are ordered by thread, then by position in the chunk, which keeps the sort stable
+                    if (thread_index == 0)
+                    {
+                        uint32_t offset = 0;
+                        for (uint32_t digit = 0; digit < R::DIGIT_COUNT; digit++)
+                        {
+                            for (uint32_t thread = 0; thread < thread_count; thread++)
+                            {
+                                offsets[thread * R::DIGIT_COUNT + digit] = offset;
+                                offset += histograms[(thread * R::PASS_COUNT + pass) * R::DIGIT_COUNT + digit];
+                            }
+                        }
+                    }
+                    sync.arrive_and_wait();
+
+                    uint32_t *thread_offsets = &offsets[thread_index * R::DIGIT_COUNT];
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        const uint32_t position = thread_offsets[R::digit(src_keys[i], pass)]++;
+                        dst_keys[position]      = src_keys[i];
+                        if constexpr (!std::is_same_v<Value, NoValue>)
+                        {
+                            dst_values[position] = std::move(src_values[i]);
+                        }
+                    }
+                    sync.arrive_and_wait();
+
+                    std::swap(src_keys, dst_keys);
+                    std::swap(src_values, dst_values);
+                }
+
+                // After an odd number of passes, the result is in the scratch buffer
+                if (src_keys != keys)
+                {
+                    copy_range(src_keys, src_values, keys, values, begin, end);
+                }
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(thread_count - 1);
+            for (uint32_t thread_index = 1; thread_index < thread_count; thread_index++)
+            {
+                threads.emplace_back(worker, thread_index);
+            }
+            worker(0);
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+        }
+    } // namespace sort_utils
+
+    // --=== Radix sort ===--
+
+    /** Sorts the keys, using the scratch buffer of count keys as temporary storage. */
+    template<uint32_t DigitBits = 11, typename Key>
+    void radix_sort(Key *keys, size_t count, Key *scratch)
+    {
+        sort_utils::radix_sort_impl<DigitBits, Key, sort_utils::NoValue>(keys, nullptr, count, scratch, nullptr);
+    }
+
+    template<uint32_t DigitBits = 11, typename Key>
+    void radix_sort(std::vector<Key> &keys)
+    {
+        std::vector<Key> scratch(keys.size());
+        radix_sort<DigitBits>(keys.data(), keys.size(), scratch.data());
+    }
+
+    /** Sorts the keys and moves the values along with them. Values with the same key keep their order. */
+    template<uint32_t DigitBits = 11, typename Key, typename Value>
+    void radix_sort(Key *keys, Value *values, size_t count, Key *key_scratch, Value *value_scratch)
+    {
+        sort_utils::radix_sort_impl<DigitBits>(keys, values, count, key_scratch, value_scratch);
+    }
+
+    /** Same as above, with the scratch buffers allocated for the call. Throws if there are not as many values as keys. */
+    template<uint32_t DigitBits = 11, typename Key, typename Value>
+    void radix_sort(std::vector<Key> &keys, std::vector<Value> &values)
+    {
+        sort_utils::check_value_count(keys.size(), values.size());
+        std::vector<Key>   key_scratch(keys.size());
+        std::vector<Value> value_scratch(values.size());
+        radix_sort<DigitBits>(keys.data(), values.data(), keys.size(), key_scratch.data(), value_scratch.data());
+    }
+
+    // --=== Parallel radix sort ===--
+
+    /**
+     * Splits the sort between thread_count threads, or one per hardware thread if it is 0.
+     *
+     * The threads are created for each call and joined before it returns. Each thread gets at least
+     * sort_utils::PARALLEL_MIN_ELEMENTS_PER_THREAD keys, so inputs of fewer than twice that many (128K keys) are sorted on the
+     * calling thread, without creating any thread. Above it, creating a thread costs microseconds, against milliseconds for the sort
+     * of its chunk.
+     */
+    template<uint32_t DigitBits = 11, typename Key>
+    void parallel_radix_sort(std::vector<Key> &keys, uint32_t thread_count = 0)
+    {
+        std::vector<Key> scratch(keys.size());
+        sort_utils::parallel_radix_sort_impl<DigitBits, Key, sort_utils::NoValue>(keys.data(),
+                                                                                  nullptr,
+                                                                                  keys.size(),
+                                                                                  scratch.data(),
+                                                                                  nullptr,
+                                                                                  thread_count);
+    }
+
+    /** Same as above, and moves the values along with the keys. Throws if there are not as many values as keys. */
+    template<uint32_t DigitBits = 11, typename Key, typename Value>
+    void parallel_radix_sort(std::vector<Key> &keys, std::vector<Value> &values, uint32_t thread_count = 0)
+    {
+        sort_utils::check_value_count(keys.size(), values.size());
+        std::vector<Key>   key_scratch(keys.size());
+        std::vector<Value> value_scratch(values.size());
+        sort_utils::parallel_radix_sort_impl<DigitBits>(keys.data(),
+                                                        values.data(),
+                                                        keys.size(),
+                                                        key_scratch.data(),
+                                                        value_scratch.data(),
+                                                        thread_count);
+    }
+} // namespace vre
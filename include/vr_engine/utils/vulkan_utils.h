@@ -2,27 +2,28 @@
 
 #ifdef RENDERER_VULKAN
 
-#include <vulkan/vulkan.h>
 #include <string>
+#include <volk.h>
 
 // --=== Structs ===--
 namespace vre
 {
-    struct VulkanFunctions
-    {
-        PFN_vkCreateShaderModule  vkCreateShaderModule  = nullptr;
-        PFN_vkDestroyShaderModule vkDestroyShaderModule = nullptr;
-    };
-
     struct SceneRendererBinding
     {
-        VkDevice        device = VK_NULL_HANDLE;
-        VulkanFunctions functions;
+        VkDevice               device       = VK_NULL_HANDLE;
+        /** Functions loaded for the device. The table is copied by the scene. */
+        const VolkDeviceTable *device_table = nullptr;
     };
 
     // --=== Functions ===--
 
     void vk_check(VkResult result, const std::string &error_message = "");
 
+    /**
+     * Replaces the functions of the device table used by the engine by wrappers that count their calls and time the blocking ones.
+     * Must be called after volkLoadDeviceTable, before the table is copied. Does nothing if ENABLE_API_TRACE is not defined.
+     */
+    void install_vulkan_api_trace(VolkDeviceTable &device_table);
+
 } // namespace vre
 #endif
\ No newline at end of file
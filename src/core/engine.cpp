@@ -1,10 +1,19 @@
 #include "vr_engine/core/engine.h"
 
 #include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <memory>
 #include <vr_engine/core/global.h>
+#include <vr_engine/core/renderer/cooked_mesh.h>
+#include <vr_engine/core/renderer/instance_batcher.h>
 #include <vr_engine/core/scene.h>
 #include <vr_engine/core/vr/vr_system.h>
 #include <vr_engine/core/window.h>
+#include <vr_engine/utils/api_trace.h>
+#include <vr_engine/utils/global_utils.h>
+#include <vr_engine/utils/metrics.h>
+#include <vr_engine/utils/profiler.h>
 
 namespace vre
 {
@@ -145,22 +154,150 @@ namespace vre
             .detach();
 #endif
 
+        VRE_PROFILER_THREAD("Main thread");
+
+        // Metrics
+        const auto &performance_settings = m_data->settings.performance_settings;
+        auto       &metrics              = MetricsRegistry::global();
+        auto       &frame_time_metric    = metrics.histogram("engine.frame_time_ns");
+        auto       &frame_count_metric   = metrics.counter("engine.frames");
+        const auto  start_time           = std::chrono::steady_clock::now();
+        auto        last_frame_time      = start_time;
+        auto        last_dump_time       = start_time;
+        // The files are written on the thread of the writer, to keep the file system out of the frame
+        std::unique_ptr<MetricsWriter> metrics_writer;
+        if (performance_settings.metrics_csv_path != nullptr || performance_settings.metrics_json_path != nullptr)
+        {
+            metrics_writer =
+                std::make_unique<MetricsWriter>(performance_settings.metrics_csv_path, performance_settings.metrics_json_path);
+        }
+
         // Main loop
         while (!should_quit)
         {
+            VRE_ZONE("Engine::main_loop");
+
             // Update delta time
             //            delta_time = Window::compute_delta_time(&current_frame_time);
 
-            // TODO temp
             // Handle events
-            should_quit = m_data->mirror_window.handle_events();
+            if (m_data->mirror_window.is_valid() && m_data->mirror_window.handle_events())
+            {
+                should_quit = true;
+            }
+            if (m_data->xr_system.handle_events())
+            {
+                should_quit = true;
+            }
 
-            // Run rendering
-            //            m_data->renderer.draw();
+            // Run rendering. The XR system takes care of throttling it depending on the session state.
+            m_data->xr_system.render_frame();
 
             // Trigger update
             //            m_data->update_event.send(delta_time);
+
+            VRE_FRAME_MARK();
+            VRE_API_TRACE_END_FRAME();
+
+            const auto now = std::chrono::steady_clock::now();
+            frame_time_metric.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_frame_time).count());
+            frame_count_metric.add();
+            last_frame_time = now;
+
+            // Periodic dump, for telemetry
+            if (std::chrono::duration<double>(now - last_dump_time).count() >= performance_settings.metrics_dump_interval)
+            {
+                if (metrics_writer)
+                {
+                    m_data->xr_system.publish_table_stats();
+                    metrics_writer->write(metrics.snapshot(std::chrono::duration<double>(now - start_time).count()));
+                }
+                metrics.end_window();
+                last_dump_time = now;
+            }
         }
     }
 
+    MetricsRegistry &Engine::metrics() const
+    {
+        return MetricsRegistry::global();
+    }
+
+    Id Engine::create_ui_panel(const UiPanelSettings &settings)
+    {
+        return m_data->xr_system.create_ui_panel(settings);
+    }
+
+    void Engine::destroy_ui_panel(Id panel_id)
+    {
+        m_data->xr_system.destroy_ui_panel(panel_id);
+    }
+
+    void Engine::invalidate_ui_panel(Id panel_id)
+    {
+        m_data->xr_system.invalidate_ui_panel(panel_id);
+    }
+
+    Id Engine::create_mesh(const void             *vertices,
+                           uint32_t                vertex_count,
+                           const uint32_t         *indices,
+                           uint32_t                index_count,
+                           const MeshLod          *lods,
+                           uint32_t                lod_count,
+                           const MeshQuantization *quantization)
+    {
+        return m_data->xr_system.create_mesh(vertices, vertex_count, indices, index_count, lods, lod_count, quantization);
+    }
+
+    Id Engine::create_mesh(const CookedMesh &mesh)
+    {
+        check(m_data->settings.geometry_settings.vertex_stride == sizeof(CookedVertex),
+              "The vertex stride must be the size of a cooked vertex to upload cooked meshes");
+        MeshQuantization quantization;
+        std::copy(std::begin(mesh.position_offset), std::end(mesh.position_offset), quantization.position_offset);
+        std::copy(std::begin(mesh.position_scale), std::end(mesh.position_scale), quantization.position_scale);
+        return create_mesh(mesh.vertices.data(),
+                           static_cast<uint32_t>(mesh.vertices.size()),
+                           mesh.indices.data(),
+                           static_cast<uint32_t>(mesh.indices.size()),
+                           mesh.lods.data(),
+                           static_cast<uint32_t>(mesh.lods.size()),
+                           &quantization);
+    }
+
+    void Engine::destroy_mesh(Id mesh_id)
+    {
+        m_data->xr_system.destroy_mesh(mesh_id);
+    }
+
+    Id Engine::add_instance(Id mesh_id, Id material_id, const InstanceTransform &transform)
+    {
+        return m_data->xr_system.add_instance(mesh_id, material_id, transform);
+    }
+
+    void Engine::remove_instance(Id instance_id)
+    {
+        m_data->xr_system.remove_instance(instance_id);
+    }
+
+    void Engine::set_instance_transform(Id instance_id, const InstanceTransform &transform)
+    {
+        m_data->xr_system.set_instance_transform(instance_id, transform);
+    }
+
+    Id Engine::add_light(const PointLight &light)
+    {
+        return m_data->xr_system.add_light(light);
+    }
+
+    void Engine::remove_light(Id light_id)
+    {
+        m_data->xr_system.remove_light(light_id);
+    }
+
+    void Engine::set_light(Id light_id, const PointLight &light)
+    {
+        m_data->xr_system.set_light(light_id, light);
+    }
+
 } // namespace vre
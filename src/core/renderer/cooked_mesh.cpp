@@ -0,0 +1,380 @@
+#include "vr_engine/core/renderer/cooked_mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vr_engine/core/renderer/mesh_optimizer.h>
+#include <vr_engine/utils/io.h>
+
+#define COOKED_MESH_MAGIC   0x434D5256 // "VRMC"
+#define COOKED_MESH_VERSION 3
+
+namespace vre
+{
+    // --=== Utils ===--
+
+    namespace cooked_mesh_utils
+    {
+        struct FileHeader
+        {
+            uint32_t magic              = COOKED_MESH_MAGIC;
+            uint32_t version            = COOKED_MESH_VERSION;
+            uint32_t vertex_count       = 0;
+            uint32_t index_count        = 0;
+            uint32_t lod_count          = 0;
+            float    position_offset[3] = {};
+            float    position_scale[3]  = {};
+        };
+
+        inline float sign_not_zero(float value)
+        {
+            return value >= 0.0f ? 1.0f : -1.0f;
+        }
+    } // namespace cooked_mesh_utils
+
+    using namespace cooked_mesh_utils;
+
+    // --=== Quantization ===--
+
+    uint16_t quantize_unorm16(float value)
+    {
+        return static_cast<uint16_t>(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+    }
+
+    int16_t quantize_snorm16(float value)
+    {
+        return static_cast<int16_t>(lroundf(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    uint16_t quantize_half(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        const auto sign     = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        const auto exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+        auto       mantissa = bits & 0x7FFFFF;
+
+        // NaN, then infinity and overflow
+        if ((bits & 0x7FFFFFFF) > 0x7F800000)
+        {
+            return sign | 0x7E00;
+        }
+        if (exponent >= 31)
+        {
+            return sign | 0x7C00;
+        }
+
+        // Subnormal, or too small
+        if (exponent <= 0)
+        {
+            if (exponent < -10)
+            {
+                return sign;
+            }
+            mantissa         |= 0x800000;
+            const auto shift = static_cast<uint32_t>(14 - exponent);
+            auto       half  = static_cast<uint16_t>(mantissa >> shift);
+            // Round to nearest
+            if ((mantissa >> (shift - 1)) & 1)
+            {
+                half++;
+            }
+            return sign | half;
+        }
+
+        auto half = static_cast<uint16_t>(sign | (exponent << 10) | (mantissa >> 13));
+        // Round to nearest. A carry correctly moves to the exponent.
+        if (mantissa & 0x1000)
+        {
+            half++;
+        }
+        return half;
+    }
+
+    float dequantize_half(uint16_t value)
+    {
+        const uint32_t sign     = static_cast<uint32_t>(value & 0x8000) << 16;
+        const uint32_t exponent = (value >> 10) & 0x1F;
+        const uint32_t mantissa = value & 0x3FF;
+
+        if (exponent == 0)
+        {
+            // Zero or subnormal
+            const auto magnitude = ldexpf(static_cast<float>(mantissa), -24);
+            return sign != 0 ? -magnitude : magnitude;
+        }
+
+        uint32_t bits = exponent == 31 ? sign | 0x7F800000 | (mantissa << 13) : sign | ((exponent + 112) << 23) | (mantissa << 13);
+        float    result;
+        memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    void encode_octahedral(const float normal[3], int16_t out_encoded[2])
+    {
+        const auto length = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+        auto       x      = length > 0.0f ? normal[0] / length : 0.0f;
+        auto       y      = length > 0.0f ? normal[1] / length : 0.0f;
+
+        // The lower half is folded over the diagonals
+        if (normal[2] < 0.0f)
+        {
+            const auto folded_x = (1.0f - fabsf(y)) * sign_not_zero(x);
+            const auto folded_y = (1.0f - fabsf(x)) * sign_not_zero(y);
+            x                   = folded_x;
+            y                   = folded_y;
+        }
+
+        out_encoded[0] = quantize_snorm16(x);
+        out_encoded[1] = quantize_snorm16(y);
+    }
+
+    void decode_octahedral(const int16_t encoded[2], float out_normal[3])
+    {
+        auto       x = std::max(static_cast<float>(encoded[0]) / 32767.0f, -1.0f);
+        auto       y = std::max(static_cast<float>(encoded[1]) / 32767.0f, -1.0f);
+        const auto z = 1.0f - fabsf(x) - fabsf(y);
+        if (z < 0.0f)
+        {
+            const auto unfolded_x = (1.0f - fabsf(y)) * sign_not_zero(x);
+            const auto unfolded_y = (1.0f - fabsf(x)) * sign_not_zero(y);
+            x                     = unfolded_x;
+            y                     = unfolded_y;
+        }
+
+        const auto length = sqrtf(x * x + y * y + z * z);
+        out_normal[0]     = x / length;
+        out_normal[1]     = y / length;
+        out_normal[2]     = z / length;
+    }
+
+    // --=== Cooking ===--
+
+    CookedMesh cook_mesh(const MeshVertex   *vertices,
+                         size_t              vertex_count,
+                         const uint32_t     *indices,
+                         size_t              index_count,
+                         const CookSettings &settings)
+    {
+        if (vertex_count == 0 || index_count == 0)
+        {
+            throw std::invalid_argument("A mesh needs vertices and indices");
+        }
+        if (index_count > UINT32_MAX || vertex_count > UINT32_MAX)
+        {
+            throw std::invalid_argument("Cooked meshes support up to 2^32 vertices and indices");
+        }
+
+        // Bounds of the positions, for the error limit of the LODs and for the quantization
+        CookedMesh mesh;
+        float      min[3] = {INFINITY, INFINITY, INFINITY};
+        float      max[3] = {-INFINITY, -INFINITY, -INFINITY};
+        for (size_t i = 0; i < index_count; i++)
+        {
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                min[k] = std::min(min[k], vertices[indices[i]].position[k]);
+                max[k] = std::max(max[k], vertices[indices[i]].position[k]);
+            }
+        }
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            mesh.position_offset[k] = min[k];
+            mesh.position_scale[k]  = max[k] - min[k];
+        }
+        const auto max_lod_error = settings.lod_max_error_ratio
+                                 * sqrtf(mesh.position_scale[0] * mesh.position_scale[0]
+                                         + mesh.position_scale[1] * mesh.position_scale[1]
+                                         + mesh.position_scale[2] * mesh.position_scale[2]);
+
+        // Build the LODs, each simplified from the full mesh so that its error is measured against it. Then reorder their index
+        // buffers.
+        const auto            lod_count = std::min(std::max(settings.max_lod_count, 1u), MAX_MESH_LOD_COUNT);
+        std::vector<uint32_t> lod_indices(indices, indices + index_count);
+        for (uint32_t lod = 0; lod < lod_count; lod++)
+        {
+            auto lod_index_count = index_count;
+            auto error           = 0.0f;
+            if (lod > 0)
+            {
+                const auto target_triangle_count =
+                    static_cast<size_t>(static_cast<double>(index_count / 3) * pow(settings.lod_triangle_ratio, lod));
+                lod_index_count = simplify(lod_indices.data(),
+                                           indices,
+                                           index_count,
+                                           vertices[0].position,
+                                           vertex_count,
+                                           sizeof(MeshVertex),
+                                           target_triangle_count * 3,
+                                           max_lod_error,
+                                           &error);
+
+                // Stop once a LOD is not much smaller than the previous one
+                if (lod_index_count == 0 || lod_index_count * 10 > mesh.lods.back().index_count * 9)
+                {
+                    break;
+                }
+                // The selection expects the errors to grow with the LODs
+                error = std::max(error, mesh.lods.back().error);
+            }
+
+            optimize_vertex_cache(lod_indices.data(), lod_indices.data(), lod_index_count, vertex_count);
+            optimize_overdraw(lod_indices.data(),
+                              lod_indices.data(),
+                              lod_index_count,
+                              vertices[0].position,
+                              vertex_count,
+                              sizeof(MeshVertex),
+                              settings.overdraw_threshold);
+            mesh.lods.push_back(MeshLod {
+                .first_index = static_cast<uint32_t>(mesh.indices.size()),
+                .index_count = static_cast<uint32_t>(lod_index_count),
+                .error       = error,
+            });
+            mesh.indices.insert(mesh.indices.end(), lod_indices.data(), lod_indices.data() + lod_index_count);
+        }
+
+        // Reorder the vertices in the order of the index buffers. The full mesh comes first, so it is the one read linearly.
+        std::vector<MeshVertex> optimized_vertices(vertex_count);
+        optimized_vertices.resize(optimize_vertex_fetch(optimized_vertices.data(),
+                                                        mesh.indices.data(),
+                                                        mesh.indices.size(),
+                                                        vertices,
+                                                        vertex_count,
+                                                        sizeof(MeshVertex)));
+
+        // Quantize
+        mesh.vertices.resize(optimized_vertices.size());
+        for (size_t i = 0; i < optimized_vertices.size(); i++)
+        {
+            const auto &vertex = optimized_vertices[i];
+            auto       &cooked = mesh.vertices[i];
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                const auto scale   = mesh.position_scale[k];
+                cooked.position[k] = scale > 0.0f ? quantize_unorm16((vertex.position[k] - mesh.position_offset[k]) / scale) : 0;
+            }
+            encode_octahedral(vertex.normal, cooked.normal);
+            cooked.uv[0] = quantize_half(vertex.uv[0]);
+            cooked.uv[1] = quantize_half(vertex.uv[1]);
+        }
+
+        return mesh;
+    }
+
+    // --=== Files ===--
+
+    std::vector<uint8_t> serialize_cooked_mesh(const CookedMesh &mesh)
+    {
+        FileHeader header = {
+            .vertex_count = static_cast<uint32_t>(mesh.vertices.size()),
+            .index_count  = static_cast<uint32_t>(mesh.indices.size()),
+            .lod_count    = static_cast<uint32_t>(mesh.lods.size()),
+        };
+        memcpy(header.position_offset, mesh.position_offset, sizeof(header.position_offset));
+        memcpy(header.position_scale, mesh.position_scale, sizeof(header.position_scale));
+
+        // Header, LODs, vertices, then indices
+        const size_t         sizes[]   = {sizeof(FileHeader),
+                                          mesh.lods.size() * sizeof(MeshLod),
+                                          mesh.vertices.size() * sizeof(CookedVertex),
+                                          mesh.indices.size() * sizeof(uint32_t)};
+        const void          *sources[] = {&header, mesh.lods.data(), mesh.vertices.data(), mesh.indices.data()};
+        std::vector<uint8_t> data(sizes[0] + sizes[1] + sizes[2] + sizes[3]);
+        size_t               offset = 0;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            memcpy(data.data() + offset, sources[i], sizes[i]);
+            offset += sizes[i];
+        }
+        return data;
+    }
+
+    CookedMesh deserialize_cooked_mesh(const void *data, size_t size)
+    {
+        FileHeader header;
+        if (size < sizeof(FileHeader))
+        {
+            throw std::runtime_error("Cooked mesh is truncated");
+        }
+        memcpy(&header, data, sizeof(FileHeader));
+        if (header.magic != COOKED_MESH_MAGIC)
+        {
+            throw std::runtime_error("Not a cooked mesh");
+        }
+        if (header.version != COOKED_MESH_VERSION)
+        {
+            throw std::runtime_error("Cooked mesh version " + std::to_string(header.version)
+                                     + " is not supported, it must be cooked again");
+        }
+
+        CookedMesh mesh;
+        memcpy(mesh.position_offset, header.position_offset, sizeof(mesh.position_offset));
+        memcpy(mesh.position_scale, header.position_scale, sizeof(mesh.position_scale));
+        mesh.lods.resize(header.lod_count);
+        mesh.vertices.resize(header.vertex_count);
+        mesh.indices.resize(header.index_count);
+
+        const size_t sizes[]        = {mesh.lods.size() * sizeof(MeshLod),
+                                       mesh.vertices.size() * sizeof(CookedVertex),
+                                       mesh.indices.size() * sizeof(uint32_t)};
+        void        *destinations[] = {mesh.lods.data(), mesh.vertices.data(), mesh.indices.data()};
+        if (size != sizeof(FileHeader) + sizes[0] + sizes[1] + sizes[2])
+        {
+            throw std::runtime_error("Cooked mesh is truncated");
+        }
+        size_t offset = sizeof(FileHeader);
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            memcpy(destinations[i], static_cast<const uint8_t *>(data) + offset, sizes[i]);
+            offset += sizes[i];
+        }
+
+        for (const auto &lod : mesh.lods)
+        {
+            if (static_cast<size_t>(lod.first_index) + lod.index_count > mesh.indices.size())
+            {
+                throw std::runtime_error("Cooked mesh has a LOD out of its index buffer");
+            }
+        }
+        return mesh;
+    }
+
+    void save_cooked_mesh(const char *path, const CookedMesh &mesh)
+    {
+        const auto data = serialize_cooked_mesh(mesh);
+
+        FILE *file = fopen(path, "wb");
+        if (!file)
+        {
+            throw std::runtime_error("Failed to open file \"" + std::string(path) + "\"");
+        }
+        const auto write_count = fwrite(data.data(), 1, data.size(), file);
+        fclose(file);
+        if (write_count != data.size())
+        {
+            throw std::runtime_error("Failed to write file \"" + std::string(path) + "\"");
+        }
+    }
+
+    CookedMesh load_cooked_mesh(const char *path)
+    {
+        size_t size;
+        auto  *data = static_cast<char *>(load_binary_file(path, &size));
+        try
+        {
+            auto mesh = deserialize_cooked_mesh(data, size);
+            delete[] data;
+            return mesh;
+        }
+        catch (...)
+        {
+            delete[] data;
+            throw;
+        }
+    }
+} // namespace vre
@@ -0,0 +1,65 @@
+#include "vr_engine/core/renderer/descriptor_cache.h"
+
+#include <algorithm>
+
+namespace vre
+{
+    // --=== Descriptor counts ===--
+
+    void DescriptorCounts::add(uint32_t type, uint32_t count)
+    {
+        for (auto &type_count : m_counts)
+        {
+            if (type_count.type == type)
+            {
+                type_count.count += count;
+                return;
+            }
+        }
+        m_counts.push_back({.type = type, .count = count});
+    }
+
+    uint32_t DescriptorCounts::count(uint32_t type) const
+    {
+        for (const auto &type_count : m_counts)
+        {
+            if (type_count.type == type)
+            {
+                return type_count.count;
+            }
+        }
+        return 0;
+    }
+
+    bool DescriptorCounts::include(const DescriptorCounts &other)
+    {
+        bool raised = false;
+        for (const auto &other_count : other.m_counts)
+        {
+            const auto current = count(other_count.type);
+            if (other_count.count > current)
+            {
+                add(other_count.type, other_count.count - current);
+                raised = true;
+            }
+        }
+        return raised;
+    }
+
+    bool DescriptorCounts::contains(const DescriptorCounts &other) const
+    {
+        return std::all_of(other.m_counts.begin(),
+                           other.m_counts.end(),
+                           [this](const TypeCount &other_count) { return other_count.count <= count(other_count.type); });
+    }
+
+    // --=== Descriptor keys ===--
+
+    DescriptorKey &DescriptorKey::add_bytes(const void *data, size_t size)
+    {
+        const auto *bytes = static_cast<const uint8_t *>(data);
+        m_bytes.insert(m_bytes.end(), bytes, bytes + size);
+        m_hash.add_bytes(data, size);
+        return *this;
+    }
+} // namespace vre
@@ -0,0 +1,219 @@
+#include "vr_engine/core/renderer/instance_batcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace vre
+{
+    // --=== Utils ===--
+
+    namespace instance_batcher_utils
+    {
+        /** Key of the batch of a mesh, LOD and material. */
+        inline uint64_t batch_key(uint64_t mesh, uint64_t material, uint32_t lod)
+        {
+            if (mesh == 0 || mesh >= (1ull << 28) || material > UINT32_MAX)
+            {
+                throw std::invalid_argument("The mesh id must be non-null and fit in 28 bits, and the material id must fit in 32 bits");
+            }
+            if (lod >= MAX_MESH_LOD_COUNT)
+            {
+                throw std::invalid_argument("LOD out of range");
+            }
+            return (mesh << 36) | (static_cast<uint64_t>(lod) << 32) | material;
+        }
+    } // namespace instance_batcher_utils
+
+    using namespace instance_batcher_utils;
+
+    // --=== Transforms ===--
+
+    float max_axis_scale(const InstanceTransform &transform)
+    {
+        float squared_scale = 0.0f;
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            const auto x  = transform.rows[0][axis];
+            const auto y  = transform.rows[1][axis];
+            const auto z  = transform.rows[2][axis];
+            squared_scale = std::max(squared_scale, x * x + y * y + z * z);
+        }
+        return sqrtf(squared_scale);
+    }
+
+    // --=== Quantization ===--
+
+    InstanceTransform dequantizing_transform(const InstanceTransform &transform, const MeshQuantization &quantization)
+    {
+        // transform * (offset + scale * p) = (transform * scale) * p + transform * offset
+        InstanceTransform result;
+        for (uint32_t row = 0; row < 3; row++)
+        {
+            result.rows[row][3] = transform.rows[row][3];
+            for (uint32_t axis = 0; axis < 3; axis++)
+            {
+                result.rows[row][axis] = transform.rows[row][axis] * quantization.position_scale[axis];
+                result.rows[row][3] += transform.rows[row][axis] * quantization.position_offset[axis];
+            }
+        }
+        return result;
+    }
+
+    // --=== Batches ===--
+
+    uint32_t InstanceBatcher::find_or_create_batch(uint64_t mesh, uint64_t material, uint32_t lod)
+    {
+        const auto key = batch_key(mesh, material, lod);
+        if (const auto *existing_index = m_batch_indices.get(key); existing_index != nullptr)
+        {
+            return *existing_index;
+        }
+
+        uint32_t batch_index;
+        if (!m_empty_batches.empty())
+        {
+            batch_index = m_empty_batches.back();
+            m_empty_batches.pop_back();
+        }
+        else
+        {
+            batch_index = static_cast<uint32_t>(m_batches.size());
+            m_batches.emplace_back();
+        }
+        m_batches[batch_index].mesh     = mesh;
+        m_batches[batch_index].material = material;
+        m_batches[batch_index].lod      = lod;
+        m_batch_indices.set(key, batch_index);
+        return batch_index;
+    }
+
+    void InstanceBatcher::attach(Id instance_id, Instance &instance, uint32_t batch_index, const InstanceTransform &transform)
+    {
+        auto &batch    = m_batches[batch_index];
+        instance.batch = batch_index;
+        instance.index = static_cast<uint32_t>(batch.members.size());
+        batch.members.push_back(instance_id);
+        batch.transforms.push_back(transform);
+        m_layout_dirty = true;
+    }
+
+    InstanceTransform InstanceBatcher::detach(const Instance &instance)
+    {
+        // Move the last instance of the batch in the hole
+        const auto batch_index = instance.batch;
+        const auto index       = instance.index;
+        auto      &batch       = m_batches[batch_index];
+        const auto transform   = batch.transforms[index];
+        if (index + 1 < batch.members.size())
+        {
+            const auto moved_id     = batch.members.back();
+            batch.members[index]    = moved_id;
+            batch.transforms[index] = batch.transforms.back();
+
+            m_instances.get(moved_id)->index = index;
+        }
+        batch.members.pop_back();
+        batch.transforms.pop_back();
+
+        if (batch.members.empty())
+        {
+            m_batch_indices.remove(batch_key(batch.mesh, batch.material, batch.lod));
+            m_empty_batches.push_back(batch_index);
+        }
+
+        m_layout_dirty = true;
+        return transform;
+    }
+
+    // --=== API ===--
+
+    InstanceBatcher::Id InstanceBatcher::add_instance(uint64_t mesh, uint64_t material, const InstanceTransform &transform)
+    {
+        const auto batch_index = find_or_create_batch(mesh, material, 0);
+        const auto instance_id = m_instances.push({});
+        attach(instance_id, *m_instances.get(instance_id), batch_index, transform);
+        return instance_id;
+    }
+
+    void InstanceBatcher::remove_instance(Id instance_id)
+    {
+        const auto *instance = m_instances.get(instance_id);
+        if (instance == nullptr)
+        {
+            return;
+        }
+
+        detach(*instance);
+        m_instances.remove(instance_id);
+    }
+
+    void InstanceBatcher::set_transform(Id instance_id, const InstanceTransform &transform)
+    {
+        const auto *instance = m_instances.get(instance_id);
+        if (instance != nullptr)
+        {
+            m_batches[instance->batch].transforms[instance->index] = transform;
+        }
+    }
+
+    void InstanceBatcher::set_lod(Id instance_id, uint32_t lod)
+    {
+        auto *instance = m_instances.get(instance_id);
+        if (instance == nullptr || m_batches[instance->batch].lod == lod)
+        {
+            return;
+        }
+
+        // The new batch is found first, since it checks the LOD
+        const auto &batch       = m_batches[instance->batch];
+        const auto  batch_index = find_or_create_batch(batch.mesh, batch.material, lod);
+        const auto  transform   = detach(*instance);
+        attach(instance_id, *instance, batch_index, transform);
+    }
+
+    bool InstanceBatcher::update()
+    {
+        if (!m_layout_dirty)
+        {
+            return false;
+        }
+        m_layout_dirty = false;
+
+        // Sort the batches by material, mesh then LOD, to limit the state changes between draws
+        m_draw_batches.clear();
+        for (const auto &entry : m_batch_indices)
+        {
+            m_draw_batches.push_back(entry.value());
+        }
+        std::sort(m_draw_batches.begin(),
+                  m_draw_batches.end(),
+                  [this](uint32_t a, uint32_t b)
+                  {
+                      const auto &batch_a = m_batches[a];
+                      const auto &batch_b = m_batches[b];
+                      if (batch_a.material != batch_b.material)
+                      {
+                          return batch_a.material < batch_b.material;
+                      }
+                      return batch_a.mesh != batch_b.mesh ? batch_a.mesh < batch_b.mesh : batch_a.lod < batch_b.lod;
+                  });
+
+        // Give each batch its range in the packed instance array
+        m_draws.clear();
+        m_instance_count = 0;
+        for (const auto batch_index : m_draw_batches)
+        {
+            const auto &batch = m_batches[batch_index];
+            m_draws.push_back(InstanceBatch {
+                .mesh           = batch.mesh,
+                .material       = batch.material,
+                .lod            = batch.lod,
+                .first_instance = m_instance_count,
+                .instance_count = static_cast<uint32_t>(batch.members.size()),
+            });
+            m_instance_count += static_cast<uint32_t>(batch.members.size());
+        }
+        return true;
+    }
+} // namespace vre
@@ -0,0 +1,496 @@
+#include "vr_engine/core/renderer/light_clusters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// The views are only enclosed in a shared frustum if all their sides are at least this far from being parallel to its near plane,
+// measured as the forward component of their unit directions
+#define MIN_SHARED_SIDE_FORWARD 0.1f
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VRE_LIGHT_CLUSTERS_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Number of lights bounded together, the width of an SSE register. The scratch arrays are padded to whole blocks.
+#define LIGHT_BLOCK_SIZE 4
+// Relative margin around the slice starts, so that a depth next to a start is bounded in the slice that cluster_of finds for it,
+// whatever the rounding of expf and logf
+#define SLICE_START_TOLERANCE 1e-5f
+
+namespace vre
+{
+    namespace light_clusters_utils
+    {
+        /** Rotation matrix of a unit quaternion: world = matrix * local. */
+        void rotation_matrix(const float q[4], float out_matrix[3][3])
+        {
+            const float x = q[0], y = q[1], z = q[2], w = q[3];
+            out_matrix[0][0] = 1.0f - 2.0f * (y * y + z * z);
+            out_matrix[0][1] = 2.0f * (x * y - z * w);
+            out_matrix[0][2] = 2.0f * (x * z + y * w);
+            out_matrix[1][0] = 2.0f * (x * y + z * w);
+            out_matrix[1][1] = 1.0f - 2.0f * (x * x + z * z);
+            out_matrix[1][2] = 2.0f * (y * z - x * w);
+            out_matrix[2][0] = 2.0f * (x * z - y * w);
+            out_matrix[2][1] = 2.0f * (y * z + x * w);
+            out_matrix[2][2] = 1.0f - 2.0f * (x * x + y * y);
+        }
+
+        /** Moves a world vector into the space of a rotation matrix, i.e. multiplies it by the transposed matrix. */
+        void to_local(const float matrix[3][3], const float v[3], float out_local[3])
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                out_local[i] = matrix[0][i] * v[0] + matrix[1][i] * v[1] + matrix[2][i] * v[2];
+            }
+        }
+
+        void to_world(const float matrix[3][3], const float v[3], float out_world[3])
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                out_world[i] = matrix[i][0] * v[0] + matrix[i][1] * v[1] + matrix[i][2] * v[2];
+            }
+        }
+
+        ClusterGrid make_grid(const float            position[3],
+                              const float            orientation[4],
+                              const float            tangents[4],
+                              float                  depth_offset,
+                              const ClusterSettings &settings)
+        {
+            // tangents are left, right, down, up
+            const auto near = settings.near + depth_offset;
+            const auto far  = std::max(settings.far + depth_offset, near * 1.001f);
+            return ClusterGrid {
+                .position     = {position[0], position[1], position[2]},
+                .tile_count_x = settings.tile_count_x,
+                .orientation  = {orientation[0], orientation[1], orientation[2], orientation[3]},
+                .tan_left     = tangents[0],
+                .tan_down     = tangents[2],
+                .tile_scale_x = static_cast<float>(settings.tile_count_x) / (tangents[1] - tangents[0]),
+                .tile_scale_y = static_cast<float>(settings.tile_count_y) / (tangents[3] - tangents[2]),
+                .near         = near,
+                .slice_scale  = static_cast<float>(settings.slice_count) / logf(far / near),
+                .tile_count_y = settings.tile_count_y,
+                .slice_count  = settings.slice_count,
+            };
+        }
+
+        /**
+         * Builds a frustum that encloses the frusta of all the views. Its orientation is the average of theirs, its sides are the
+         * extreme sides of the views, and its apex is moved back from the average position until it sees all the eyes.
+         * @return false if the views can't be enclosed
+         */
+        bool make_shared_grid(const ClusterView *views, uint32_t view_count, const ClusterSettings &settings, ClusterGrid &out_grid)
+        {
+            // Average of the orientations, in the hemisphere of the first one, and of the positions
+            float orientation[4] = {};
+            float center[3]      = {};
+            for (uint32_t view_i = 0; view_i < view_count; view_i++)
+            {
+                const auto &view = views[view_i];
+                float       dot  = 0.0f;
+                for (uint32_t i = 0; i < 4; i++)
+                {
+                    dot += view.orientation[i] * views[0].orientation[i];
+                }
+                for (uint32_t i = 0; i < 4; i++)
+                {
+                    orientation[i] += dot < 0.0f ? -view.orientation[i] : view.orientation[i];
+                }
+                for (uint32_t i = 0; i < 3; i++)
+                {
+                    center[i] += view.position[i] / static_cast<float>(view_count);
+                }
+            }
+            const auto length = sqrtf(orientation[0] * orientation[0] + orientation[1] * orientation[1]
+                                      + orientation[2] * orientation[2] + orientation[3] * orientation[3]);
+            for (auto &component : orientation)
+            {
+                component /= length;
+            }
+            float shared_rotation[3][3];
+            rotation_matrix(orientation, shared_rotation);
+
+            // The corners of the views are lines from their eye, so their extreme tangents are the ones of the shared frustum
+            float tangents[4] = {INFINITY, -INFINITY, INFINITY, -INFINITY};
+            for (uint32_t view_i = 0; view_i < view_count; view_i++)
+            {
+                const auto &view = views[view_i];
+                float       view_rotation[3][3];
+                rotation_matrix(view.orientation, view_rotation);
+                for (const auto tan_x : {tanf(view.angle_left), tanf(view.angle_right)})
+                {
+                    for (const auto tan_y : {tanf(view.angle_down), tanf(view.angle_up)})
+                    {
+                        const auto  inverse_length = 1.0f / sqrtf(tan_x * tan_x + tan_y * tan_y + 1.0f);
+                        const float corner[3]      = {tan_x * inverse_length, tan_y * inverse_length, -inverse_length};
+                        float       world[3], local[3];
+                        to_world(view_rotation, corner, world);
+                        to_local(shared_rotation, world, local);
+                        if (-local[2] < MIN_SHARED_SIDE_FORWARD)
+                        {
+                            return false;
+                        }
+                        tangents[0] = std::min(tangents[0], local[0] / -local[2]);
+                        tangents[1] = std::max(tangents[1], local[0] / -local[2]);
+                        tangents[2] = std::min(tangents[2], local[1] / -local[2]);
+                        tangents[3] = std::max(tangents[3], local[1] / -local[2]);
+                    }
+                }
+            }
+            // Moving the apex back only widens the frustum if its sides diverge from the center
+            if (tangents[0] >= 0.0f || tangents[1] <= 0.0f || tangents[2] >= 0.0f || tangents[3] <= 0.0f)
+            {
+                return false;
+            }
+
+            // An eye at (x, y) and at a depth f in front of the apex is inside a side of tangent t once x / t <= f
+            float back = 0.0f;
+            for (uint32_t view_i = 0; view_i < view_count; view_i++)
+            {
+                const float offset[3] = {views[view_i].position[0] - center[0],
+                                         views[view_i].position[1] - center[1],
+                                         views[view_i].position[2] - center[2]};
+                float       local[3];
+                to_local(shared_rotation, offset, local);
+                const auto forward = -local[2];
+                back               = std::max({back,
+                                               local[0] / tangents[0] - forward,
+                                               local[0] / tangents[1] - forward,
+                                               local[1] / tangents[2] - forward,
+                                               local[1] / tangents[3] - forward});
+            }
+
+            const float back_offset[3] = {0.0f, 0.0f, back};
+            float       apex_offset[3];
+            to_world(shared_rotation, back_offset, apex_offset);
+            const float apex[3] = {center[0] + apex_offset[0], center[1] + apex_offset[1], center[2] + apex_offset[2]};
+            out_grid            = make_grid(apex, orientation, tangents, back, settings);
+            return true;
+        }
+
+#ifdef VRE_LIGHT_CLUSTERS_USE_SSE2
+        inline __m128 select(__m128 mask, __m128 if_true, __m128 if_false)
+        {
+            return _mm_or_ps(_mm_and_ps(mask, if_true), _mm_andnot_ps(mask, if_false));
+        }
+#endif
+
+        /**
+         * Range of tiles covered by each sphere along an axis of a grid, given the lateral position c and the depth d of its center,
+         * in the space of the grid. The sides of a tile are planes through the apex, and the tangents of the planes that touch a
+         * sphere of radius r are the roots of t^2 (d^2 - r^2) - 2 c d t + c^2 - r^2 = 0. When the sphere reaches behind the apex, it
+         * covers all the tiles. Ranges entirely outside of the frustum are empty.
+         *
+         * Tile coordinates are clamped to [-1, tile_count] before they are truncated, so that the truncation is a floor. The count
+         * must be a multiple of LIGHT_BLOCK_SIZE.
+         */
+        void bound_tiles(const float *lateral,
+                         const float *depths,
+                         const float *radii,
+                         uint32_t     count,
+                         float        tan_min,
+                         float        tile_scale,
+                         float        tile_count,
+                         int32_t     *out_min_tiles,
+                         int32_t     *out_max_tiles)
+        {
+#ifdef VRE_LIGHT_CLUSTERS_USE_SSE2
+            const auto zero      = _mm_setzero_ps();
+            const auto one       = _mm_set1_ps(1.0f);
+            const auto minus_one = _mm_set1_ps(-1.0f);
+            const auto infinity  = _mm_set1_ps(INFINITY);
+            const auto tiles     = _mm_set1_ps(tile_count);
+            const auto last_tile = _mm_set1_ps(tile_count - 1.0f);
+            const auto tan_mins  = _mm_set1_ps(tan_min);
+            const auto scale     = _mm_set1_ps(tile_scale);
+            for (uint32_t i = 0; i < count; i += LIGHT_BLOCK_SIZE)
+            {
+                const auto c         = _mm_loadu_ps(lateral + i);
+                const auto d         = _mm_loadu_ps(depths + i);
+                const auto r         = _mm_loadu_ps(radii + i);
+                const auto in_front  = _mm_cmpgt_ps(d, r);
+                const auto d2_r2     = _mm_sub_ps(_mm_mul_ps(d, d), _mm_mul_ps(r, r));
+                const auto divisor   = select(in_front, d2_r2, one);
+                const auto root      = _mm_mul_ps(r, _mm_sqrt_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(c, c), d2_r2), zero)));
+                const auto cd        = _mm_mul_ps(c, d);
+                const auto low       = select(in_front, _mm_div_ps(_mm_sub_ps(cd, root), divisor), _mm_sub_ps(zero, infinity));
+                const auto high      = select(in_front, _mm_div_ps(_mm_add_ps(cd, root), divisor), infinity);
+                const auto low_tile  = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(low, tan_mins), scale), minus_one), tiles);
+                const auto high_tile = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(high, tan_mins), scale), minus_one), tiles);
+                const auto min_tile  = select(_mm_cmplt_ps(high_tile, zero), tiles, _mm_max_ps(low_tile, zero));
+                const auto max_tile  = _mm_add_ps(_mm_min_ps(high_tile, last_tile), one);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out_min_tiles + i), _mm_cvttps_epi32(min_tile));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out_max_tiles + i),
+                                 _mm_sub_epi32(_mm_cvttps_epi32(max_tile), _mm_set1_epi32(1)));
+            }
+#else
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const auto c         = lateral[i];
+                const auto d         = depths[i];
+                const auto r         = radii[i];
+                const auto in_front  = d > r;
+                const auto d2_r2     = d * d - r * r;
+                const auto divisor   = in_front ? d2_r2 : 1.0f;
+                const auto root      = r * sqrtf(std::max(c * c + d2_r2, 0.0f));
+                const auto low       = in_front ? (c * d - root) / divisor : -INFINITY;
+                const auto high      = in_front ? (c * d + root) / divisor : INFINITY;
+                const auto low_tile  = std::clamp((low - tan_min) * tile_scale, -1.0f, tile_count);
+                const auto high_tile = std::clamp((high - tan_min) * tile_scale, -1.0f, tile_count);
+                out_min_tiles[i]     = static_cast<int32_t>(high_tile < 0.0f ? tile_count : std::max(low_tile, 0.0f));
+                out_max_tiles[i]     = static_cast<int32_t>(std::min(high_tile, tile_count - 1.0f) + 1.0f) - 1;
+            }
+#endif
+        }
+
+        /**
+         * Range of slices covered by the depth range of each sphere. Instead of a logarithm per light, the slice of a depth is the
+         * number of slice starts it reaches, which is floor(log(depth / near) * slice_scale) up to SLICE_START_TOLERANCE. Ranges
+         * entirely outside of the frustum are empty. The count must be a multiple of LIGHT_BLOCK_SIZE.
+         * @param slice_starts depth at which each slice but the first starts, followed by the far depth
+         */
+        void bound_slices(const float *depths,
+                          const float *radii,
+                          uint32_t     count,
+                          const float *slice_starts,
+                          uint32_t     slice_count,
+                          int32_t     *out_min_slices,
+                          int32_t     *out_max_slices)
+        {
+            const auto far_depth = slice_starts[slice_count - 1];
+#ifdef VRE_LIGHT_CLUSTERS_USE_SSE2
+            const auto zero      = _mm_setzero_ps();
+            const auto far       = _mm_set1_ps(far_depth);
+            const auto empty_min = _mm_set1_epi32(1);
+            for (uint32_t i = 0; i < count; i += LIGHT_BLOCK_SIZE)
+            {
+                const auto d          = _mm_loadu_ps(depths + i);
+                const auto r          = _mm_loadu_ps(radii + i);
+                const auto near_side  = _mm_sub_ps(d, r);
+                const auto far_side   = _mm_add_ps(d, r);
+                auto       min_slices = _mm_setzero_si128();
+                auto       max_slices = _mm_setzero_si128();
+                // The comparisons are -1 where the start is reached
+                for (uint32_t slice = 0; slice + 1 < slice_count; slice++)
+                {
+                    const auto late_start  = _mm_set1_ps(slice_starts[slice] * (1.0f + SLICE_START_TOLERANCE));
+                    const auto early_start = _mm_set1_ps(slice_starts[slice] * (1.0f - SLICE_START_TOLERANCE));
+                    min_slices = _mm_sub_epi32(min_slices, _mm_castps_si128(_mm_cmpge_ps(near_side, late_start)));
+                    max_slices = _mm_sub_epi32(max_slices, _mm_castps_si128(_mm_cmpge_ps(far_side, early_start)));
+                }
+                const auto visible = _mm_castps_si128(_mm_and_ps(_mm_cmpgt_ps(far_side, zero), _mm_cmplt_ps(near_side, far)));
+                min_slices         = _mm_or_si128(_mm_and_si128(visible, min_slices), _mm_andnot_si128(visible, empty_min));
+                max_slices         = _mm_and_si128(visible, max_slices);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out_min_slices + i), min_slices);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out_max_slices + i), max_slices);
+            }
+#else
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const auto near_side  = depths[i] - radii[i];
+                const auto far_side   = depths[i] + radii[i];
+                int32_t    min_slices = 0;
+                int32_t    max_slices = 0;
+                for (uint32_t slice = 0; slice + 1 < slice_count; slice++)
+                {
+                    min_slices += near_side >= slice_starts[slice] * (1.0f + SLICE_START_TOLERANCE) ? 1 : 0;
+                    max_slices += far_side >= slice_starts[slice] * (1.0f - SLICE_START_TOLERANCE) ? 1 : 0;
+                }
+                const auto visible = far_side > 0.0f && near_side < far_depth;
+                out_min_slices[i]  = visible ? min_slices : 1;
+                out_max_slices[i]  = visible ? max_slices : 0;
+            }
+#endif
+        }
+    } // namespace light_clusters_utils
+    using namespace light_clusters_utils;
+
+    LightClusterer::LightClusterer(const ClusterSettings &settings) : m_settings(settings)
+    {
+        if (settings.tile_count_x == 0 || settings.tile_count_y == 0 || settings.slice_count == 0 || settings.near <= 0.0f)
+        {
+            throw std::invalid_argument("Light clusters need at least one tile and slice, and a positive near depth");
+        }
+    }
+
+    void LightClusterer::set_views(const ClusterView *views, uint32_t view_count)
+    {
+        m_grids.clear();
+        ClusterGrid shared_grid;
+        if (view_count > 1 && m_settings.share_between_views && make_shared_grid(views, view_count, m_settings, shared_grid))
+        {
+            m_grids.push_back(shared_grid);
+        }
+        else
+        {
+            for (uint32_t view_i = 0; view_i < view_count; view_i++)
+            {
+                const auto &view        = views[view_i];
+                const float tangents[4] = {tanf(view.angle_left), tanf(view.angle_right), tanf(view.angle_down), tanf(view.angle_up)};
+                m_grids.push_back(make_grid(view.position, view.orientation, tangents, 0.0f, m_settings));
+            }
+        }
+
+        const auto clusters_per_grid = m_settings.tile_count_x * m_settings.tile_count_y * m_settings.slice_count;
+        for (uint32_t grid_i = 0; grid_i < m_grids.size(); grid_i++)
+        {
+            m_grids[grid_i].first_cluster = grid_i * clusters_per_grid;
+        }
+        m_clusters.assign(static_cast<size_t>(clusters_per_grid) * m_grids.size(), LightCluster {});
+        m_light_indices.clear();
+    }
+
+    void LightClusterer::bound_lights(const ClusterGrid &grid, const PointLight *lights, uint32_t light_count)
+    {
+        float rotation[3][3];
+        rotation_matrix(grid.orientation, rotation);
+
+        // The scratch arrays are padded to whole blocks, so the SIMD loops have no remainder
+        const auto padded_count = (light_count + LIGHT_BLOCK_SIZE - 1) & ~(LIGHT_BLOCK_SIZE - 1);
+        m_view_x.resize(padded_count);
+        m_view_y.resize(padded_count);
+        m_view_depth.resize(padded_count);
+        m_radius.resize(padded_count);
+        for (auto &range : m_ranges)
+        {
+            range.resize(padded_count);
+        }
+
+        // Positions in the space of the grid. The padding lights are points behind the apex.
+        for (uint32_t i = 0; i < light_count; i++)
+        {
+            const auto dx   = lights[i].position[0] - grid.position[0];
+            const auto dy   = lights[i].position[1] - grid.position[1];
+            const auto dz   = lights[i].position[2] - grid.position[2];
+            m_view_x[i]     = rotation[0][0] * dx + rotation[1][0] * dy + rotation[2][0] * dz;
+            m_view_y[i]     = rotation[0][1] * dx + rotation[1][1] * dy + rotation[2][1] * dz;
+            m_view_depth[i] = -(rotation[0][2] * dx + rotation[1][2] * dy + rotation[2][2] * dz);
+            m_radius[i]     = lights[i].radius;
+        }
+        std::fill(m_view_x.begin() + light_count, m_view_x.end(), 0.0f);
+        std::fill(m_view_y.begin() + light_count, m_view_y.end(), 0.0f);
+        std::fill(m_view_depth.begin() + light_count, m_view_depth.end(), -1.0f);
+        std::fill(m_radius.begin() + light_count, m_radius.end(), 0.0f);
+
+        // Tiles covered by the spheres along both axes, then slices covered by their depth range
+        bound_tiles(m_view_x.data(),
+                    m_view_depth.data(),
+                    m_radius.data(),
+                    padded_count,
+                    grid.tan_left,
+                    grid.tile_scale_x,
+                    static_cast<float>(grid.tile_count_x),
+                    m_ranges[0].data(),
+                    m_ranges[1].data());
+        bound_tiles(m_view_y.data(),
+                    m_view_depth.data(),
+                    m_radius.data(),
+                    padded_count,
+                    grid.tan_down,
+                    grid.tile_scale_y,
+                    static_cast<float>(grid.tile_count_y),
+                    m_ranges[2].data(),
+                    m_ranges[3].data());
+
+        m_slice_starts.resize(grid.slice_count);
+        for (uint32_t slice = 0; slice < grid.slice_count; slice++)
+        {
+            m_slice_starts[slice] = grid.near * expf(static_cast<float>(slice + 1) / grid.slice_scale);
+        }
+        bound_slices(m_view_depth.data(),
+                     m_radius.data(),
+                     padded_count,
+                     m_slice_starts.data(),
+                     grid.slice_count,
+                     m_ranges[4].data(),
+                     m_ranges[5].data());
+    }
+
+    void LightClusterer::bin_lights(const PointLight *lights, uint32_t light_count)
+    {
+        m_light_indices.clear();
+        m_dropped_count = 0;
+
+        for (const auto &grid : m_grids)
+        {
+            bound_lights(grid, lights, light_count);
+
+            // Calls visit with each cluster of the grid covered by each light
+            const auto for_each_cluster = [&](auto &&visit)
+            {
+                for (uint32_t i = 0; i < light_count; i++)
+                {
+                    for (int32_t slice = m_ranges[4][i]; slice <= m_ranges[5][i]; slice++)
+                    {
+                        for (int32_t y = m_ranges[2][i]; y <= m_ranges[3][i]; y++)
+                        {
+                            const auto row = grid.first_cluster + (slice * grid.tile_count_y + y) * grid.tile_count_x;
+                            for (int32_t x = m_ranges[0][i]; x <= m_ranges[1][i]; x++)
+                            {
+                                visit(m_clusters[row + x], i);
+                            }
+                        }
+                    }
+                }
+            };
+
+            // Count the lights of each cluster, then give each cluster its range of the index list and fill it
+            const auto first_cluster = m_clusters.begin() + grid.first_cluster;
+            const auto last_cluster  = first_cluster + grid.tile_count_x * grid.tile_count_y * grid.slice_count;
+            std::fill(first_cluster, last_cluster, LightCluster {});
+            for_each_cluster([](LightCluster &cluster, uint32_t) { cluster.light_count++; });
+
+            auto index_count = static_cast<uint32_t>(m_light_indices.size());
+            for (auto cluster = first_cluster; cluster != last_cluster; ++cluster)
+            {
+                cluster->first_index = index_count;
+                index_count += std::min(cluster->light_count, m_settings.max_lights_per_cluster);
+                cluster->light_count = 0;
+            }
+            m_light_indices.resize(index_count);
+
+            for_each_cluster(
+                [this](LightCluster &cluster, uint32_t light)
+                {
+                    if (cluster.light_count < m_settings.max_lights_per_cluster)
+                    {
+                        m_light_indices[cluster.first_index + cluster.light_count] = light;
+                        cluster.light_count++;
+                    }
+                    else
+                    {
+                        m_dropped_count++;
+                    }
+                });
+        }
+    }
+
+    uint32_t LightClusterer::cluster_of(uint32_t grid_index, const float position[3]) const
+    {
+        const auto &grid = m_grids[grid_index];
+        float       rotation[3][3];
+        rotation_matrix(grid.orientation, rotation);
+        const float offset[3] = {position[0] - grid.position[0], position[1] - grid.position[1], position[2] - grid.position[2]};
+        float       local[3];
+        to_local(rotation, offset, local);
+
+        const auto depth = -local[2];
+        if (depth <= 0.0f)
+        {
+            return UINT32_MAX;
+        }
+        const auto x     = static_cast<int64_t>(floorf((local[0] / depth - grid.tan_left) * grid.tile_scale_x));
+        const auto y     = static_cast<int64_t>(floorf((local[1] / depth - grid.tan_down) * grid.tile_scale_y));
+        const auto slice = static_cast<int64_t>(floorf(logf(std::max(depth, grid.near) / grid.near) * grid.slice_scale));
+        if (x < 0 || x >= grid.tile_count_x || y < 0 || y >= grid.tile_count_y || slice >= grid.slice_count)
+        {
+            return UINT32_MAX;
+        }
+        return grid.first_cluster + static_cast<uint32_t>((slice * grid.tile_count_y + y) * grid.tile_count_x + x);
+    }
+} // namespace vre
@@ -0,0 +1,83 @@
+#include "vr_engine/core/renderer/lod_selector.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Closer than this, the distance to a view is clamped, so that the projected error stays finite
+#define MIN_VIEW_DISTANCE 1e-3f
+
+namespace vre
+{
+    void LodSelector::set_views(const LodView *views, uint32_t view_count, float lod_bias)
+    {
+        m_eyes.clear();
+        for (uint32_t i = 0; i < view_count; i++)
+        {
+            const auto &view = views[i];
+
+            // The projection maps tangents of angles to pixels, so the sides of the field of view give its scale
+            const auto horizontal_scale = static_cast<float>(view.width) / (tanf(view.angle_right) - tanf(view.angle_left));
+            const auto vertical_scale   = static_cast<float>(view.height) / (tanf(view.angle_up) - tanf(view.angle_down));
+            m_eyes.push_back(Eye {
+                .position        = {view.position[0], view.position[1], view.position[2]},
+                .pixels_per_unit = std::max(horizontal_scale, vertical_scale),
+            });
+        }
+        m_pixel_threshold = m_settings.max_pixel_error * exp2f(lod_bias);
+    }
+
+    float LodSelector::projected_error(float error, const float position[3]) const
+    {
+        float pixels = 0.0f;
+        for (const auto &eye : m_eyes)
+        {
+            const float offset[3] = {position[0] - eye.position[0], position[1] - eye.position[1], position[2] - eye.position[2]};
+            const auto  distance  = sqrtf(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]);
+            pixels                = std::max(pixels, error * eye.pixels_per_unit / std::max(distance, MIN_VIEW_DISTANCE));
+        }
+        return pixels;
+    }
+
+    uint32_t LodSelector::select(const MeshLod *lods,
+                                 uint32_t       lod_count,
+                                 const float    position[3],
+                                 float          scale,
+                                 uint32_t       current_lod) const
+    {
+        if (lod_count == 0)
+        {
+            return 0;
+        }
+        current_lod = std::min(current_lod, lod_count - 1);
+
+        // The errors grow with the LOD, so the coarsest acceptable LOD is before the first one that exceeds the threshold
+        const auto pixels_of = [&](uint32_t lod) { return projected_error(lods[lod].error * scale, position); };
+        uint32_t   target    = 0;
+        while (target + 1 < lod_count && pixels_of(target + 1) <= m_pixel_threshold)
+        {
+            target++;
+        }
+
+        if (target > current_lod)
+        {
+            // Coarser: only once the error is clearly below the threshold
+            const auto coarse_threshold = m_pixel_threshold * (1.0f - m_settings.hysteresis);
+            for (auto lod = target; lod > current_lod; lod--)
+            {
+                if (pixels_of(lod) <= coarse_threshold)
+                {
+                    return lod;
+                }
+            }
+        }
+        else if (target < current_lod)
+        {
+            // Finer: only once the error of the current LOD is clearly above the threshold
+            if (pixels_of(current_lod) > m_pixel_threshold * (1.0f + m_settings.hysteresis))
+            {
+                return target;
+            }
+        }
+        return current_lod;
+    }
+} // namespace vre
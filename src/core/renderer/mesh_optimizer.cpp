@@ -0,0 +1,797 @@
+#include "vr_engine/core/renderer/mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace vre
+{
+    // --=== Utils ===--
+
+    namespace mesh_optimizer_utils
+    {
+        // Size of the LRU cache simulated by the vertex cache optimization
+        constexpr uint32_t CACHE_SIZE = 32;
+        // Size of the FIFO cache used to cut the clusters of the overdraw optimization. Smaller than the real one on purpose, so that
+        // the clusters stay small.
+        constexpr uint32_t CLUSTER_CACHE_SIZE = 16;
+        // Scores of Forsyth's algorithm
+        constexpr float    CACHE_DECAY_POWER   = 1.5f;
+        constexpr float    LAST_TRIANGLE_SCORE = 0.75f;
+        constexpr float    VALENCE_BOOST_SCALE = 2.0f;
+        constexpr float    VALENCE_BOOST_POWER = 0.5f;
+        constexpr uint32_t MAX_VALENCE         = 32;
+        constexpr uint32_t NO_TRIANGLE         = UINT32_MAX;
+
+        void check_triangles(const uint32_t *indices, size_t index_count, size_t vertex_count)
+        {
+            if (index_count % 3 != 0)
+            {
+                throw std::invalid_argument("The index count must be a multiple of 3");
+            }
+            for (size_t i = 0; i < index_count; i++)
+            {
+                if (indices[i] >= vertex_count)
+                {
+                    throw std::invalid_argument("Index out of range");
+                }
+            }
+        }
+
+        /** Score of a vertex at the given position in the LRU cache (-1 if it isn't in it), and with live_triangles left to emit. */
+        float vertex_score(int32_t cache_position, uint32_t live_triangles)
+        {
+            // Computed once: the scores only depend on small integers
+            static const auto tables = []()
+            {
+                struct
+                {
+                    float cache[CACHE_SIZE];
+                    float valence[MAX_VALENCE];
+                } result = {};
+                for (uint32_t i = 0; i < CACHE_SIZE; i++)
+                {
+                    // The last triangle's vertices get a fixed score, so that the next triangle doesn't just reuse its edge
+                    result.cache[i] = i < 3 ? LAST_TRIANGLE_SCORE
+                                            : powf(1.0f - static_cast<float>(i - 3) / (CACHE_SIZE - 3), CACHE_DECAY_POWER);
+                }
+                for (uint32_t i = 1; i < MAX_VALENCE; i++)
+                {
+                    result.valence[i] = VALENCE_BOOST_SCALE * powf(static_cast<float>(i), -VALENCE_BOOST_POWER);
+                }
+                return result;
+            }();
+
+            if (live_triangles == 0)
+            {
+                return -1.0f;
+            }
+            const auto cache_score = cache_position >= 0 ? tables.cache[cache_position] : 0.0f;
+            return cache_score + tables.valence[std::min(live_triangles, MAX_VALENCE - 1)];
+        }
+
+        /** FIFO cache simulation. A vertex is in the cache if it was transformed less than cache_size transformations ago. */
+        class FifoCache
+        {
+          private:
+            std::vector<uint32_t> m_timestamps;
+            uint32_t              m_cache_size;
+            uint32_t              m_timestamp;
+
+          public:
+            FifoCache(size_t vertex_count, uint32_t cache_size)
+                : m_timestamps(vertex_count, 0), m_cache_size(cache_size), m_timestamp(cache_size + 1)
+            {
+            }
+
+            /** @return the number of cache misses of the triangle */
+            uint32_t add_triangle(const uint32_t *triangle)
+            {
+                uint32_t misses = 0;
+                for (uint32_t i = 0; i < 3; i++)
+                {
+                    if (m_timestamp - m_timestamps[triangle[i]] > m_cache_size)
+                    {
+                        m_timestamps[triangle[i]] = m_timestamp++;
+                        misses++;
+                    }
+                }
+                return misses;
+            }
+
+            void clear() { m_timestamp += m_cache_size + 1; }
+        };
+
+        struct Cluster
+        {
+            size_t first_index = 0;
+            size_t index_count = 0;
+            float  sort_key    = 0.0f;
+        };
+
+        /** Cuts the triangles in clusters that can be drawn in any order without losing much of the vertex cache efficiency. */
+        std::vector<Cluster> build_clusters(const uint32_t *indices, size_t index_count, size_t vertex_count, float threshold)
+        {
+            const auto triangle_count = index_count / 3;
+
+            // Hard boundaries: the triangles whose vertices are all cache misses start from scratch anyway
+            std::vector<size_t> hard_boundaries = {0};
+            FifoCache           cache(vertex_count, CLUSTER_CACHE_SIZE);
+            cache.add_triangle(indices);
+            for (size_t i = 1; i < triangle_count; i++)
+            {
+                if (cache.add_triangle(indices + i * 3) == 3)
+                {
+                    hard_boundaries.push_back(i);
+                }
+            }
+            hard_boundaries.push_back(triangle_count);
+
+            // Soft boundaries: inside a hard cluster, cut as soon as the part since the last cut is as efficient as the whole cluster,
+            // within the threshold. Each part is simulated from an empty cache, so that it can follow any other cluster.
+            std::vector<Cluster> clusters;
+            for (size_t h = 0; h + 1 < hard_boundaries.size(); h++)
+            {
+                const auto start = hard_boundaries[h];
+                const auto end   = hard_boundaries[h + 1];
+
+                cache.clear();
+                uint32_t hard_misses = 0;
+                for (size_t i = start; i < end; i++)
+                {
+                    hard_misses += cache.add_triangle(indices + i * 3);
+                }
+                const auto max_acmr = threshold * static_cast<float>(hard_misses) / static_cast<float>(end - start);
+
+                cache.clear();
+                auto     cluster_start = start;
+                uint32_t misses        = 0;
+                for (size_t i = start; i < end; i++)
+                {
+                    misses += cache.add_triangle(indices + i * 3);
+                    if (static_cast<float>(misses) <= max_acmr * static_cast<float>(i + 1 - cluster_start) || i + 1 == end)
+                    {
+                        clusters.push_back(Cluster {
+                            .first_index = cluster_start * 3,
+                            .index_count = (i + 1 - cluster_start) * 3,
+                        });
+                        cluster_start = i + 1;
+                        misses        = 0;
+                        cache.clear();
+                    }
+                }
+            }
+            return clusters;
+        }
+
+        inline const float *position_of(const float *positions, size_t position_stride, uint32_t vertex)
+        {
+            return reinterpret_cast<const float *>(reinterpret_cast<const char *>(positions) + vertex * position_stride);
+        }
+
+        /** Normal of the triangle, whose length is twice its area. */
+        inline void triangle_normal(const float *a, const float *b, const float *c, float out_normal[3])
+        {
+            const float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+            const float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+            out_normal[0]     = ab[1] * ac[2] - ab[2] * ac[1];
+            out_normal[1]     = ab[2] * ac[0] - ab[0] * ac[2];
+            out_normal[2]     = ab[0] * ac[1] - ab[1] * ac[0];
+        }
+
+        /**
+         * Sum of the squared distances to a set of planes, weighted by the area of the triangles that define them. Only the upper half
+         * of the symmetric matrix is stored.
+         */
+        struct Quadric
+        {
+            double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+            double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+            double c      = 0.0;
+            double weight = 0.0;
+
+            /** Plane of unit normal n and offset d, such that n.p + d = 0 on the plane. */
+            static Quadric from_plane(const double n[3], double d, double weight)
+            {
+                return Quadric {
+                    .a00    = weight * n[0] * n[0],
+                    .a01    = weight * n[0] * n[1],
+                    .a02    = weight * n[0] * n[2],
+                    .a11    = weight * n[1] * n[1],
+                    .a12    = weight * n[1] * n[2],
+                    .a22    = weight * n[2] * n[2],
+                    .b0     = weight * n[0] * d,
+                    .b1     = weight * n[1] * d,
+                    .b2     = weight * n[2] * d,
+                    .c      = weight * d * d,
+                    .weight = weight,
+                };
+            }
+
+            Quadric &operator+=(const Quadric &other)
+            {
+                a00 += other.a00, a01 += other.a01, a02 += other.a02, a11 += other.a11, a12 += other.a12, a22 += other.a22;
+                b0 += other.b0, b1 += other.b1, b2 += other.b2;
+                c += other.c;
+                weight += other.weight;
+                return *this;
+            }
+
+            /** Weighted mean of the squared distances of the point to the planes. */
+            [[nodiscard]] double mean_error(const float *p) const
+            {
+                const double x = p[0], y = p[1], z = p[2];
+                const auto   error = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                                 + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+                return weight > 0.0 ? std::max(error, 0.0) / weight : 0.0;
+            }
+        };
+
+        /** Plane of unit normal n and offset d, such that n.p + d = 0 on the plane. */
+        struct Plane
+        {
+            double n[3] = {};
+            double d    = 0.0;
+        };
+
+        /** Largest distance of the point to the planes of the list. */
+        double max_plane_distance(const std::vector<Plane> &planes, const std::vector<uint32_t> &plane_indices, const float *p)
+        {
+            double distance = 0.0;
+            for (const auto index : plane_indices)
+            {
+                const auto &plane = planes[index];
+                distance          = std::max(distance, fabs(plane.n[0] * p[0] + plane.n[1] * p[1] + plane.n[2] * p[2] + plane.d));
+            }
+            return distance;
+        }
+
+        struct Collapse
+        {
+            uint32_t from = 0;
+            uint32_t to   = 0;
+            // Mean squared distance of the quadric, which orders the collapses
+            double   cost = 0.0;
+        };
+
+        /**
+         * Vertices that can't move without opening the mesh: the ones on a border edge, used by a single triangle, and the ones that
+         * share their position with another vertex.
+         */
+        std::vector<bool> find_locked_vertices(const uint32_t *indices,
+                                               size_t          index_count,
+                                               const float    *positions,
+                                               size_t          vertex_count,
+                                               size_t          position_stride)
+        {
+            std::vector<bool> locked(vertex_count, false);
+
+            // Border edges appear once in the sorted list of the undirected edges
+            std::vector<uint64_t> edges;
+            edges.reserve(index_count);
+            for (size_t i = 0; i < index_count; i += 3)
+            {
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    const auto a = indices[i + k];
+                    const auto b = indices[i + (k + 1) % 3];
+                    edges.push_back(static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b));
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+            for (size_t i = 0; i < edges.size();)
+            {
+                auto end = i + 1;
+                while (end < edges.size() && edges[end] == edges[i])
+                {
+                    end++;
+                }
+                if (end - i == 1)
+                {
+                    locked[edges[i] >> 32]        = true;
+                    locked[edges[i] & UINT32_MAX] = true;
+                }
+                i = end;
+            }
+
+            // Seams: vertices with the same position are next to each other once sorted by position
+            std::vector<uint32_t> sorted_vertices(vertex_count);
+            for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+            {
+                sorted_vertices[vertex] = vertex;
+            }
+            const auto same_position = [&](uint32_t a, uint32_t b)
+            {
+                const auto *position_a = position_of(positions, position_stride, a);
+                const auto *position_b = position_of(positions, position_stride, b);
+                return memcmp(position_a, position_b, 3 * sizeof(float)) == 0;
+            };
+            std::sort(sorted_vertices.begin(),
+                      sorted_vertices.end(),
+                      [&](uint32_t a, uint32_t b)
+                      {
+                          const auto *position_a = position_of(positions, position_stride, a);
+                          const auto *position_b = position_of(positions, position_stride, b);
+                          return std::lexicographical_compare(position_a, position_a + 3, position_b, position_b + 3);
+                      });
+            for (size_t i = 1; i < vertex_count; i++)
+            {
+                if (same_position(sorted_vertices[i - 1], sorted_vertices[i]))
+                {
+                    locked[sorted_vertices[i - 1]] = true;
+                    locked[sorted_vertices[i]]     = true;
+                }
+            }
+            return locked;
+        }
+    } // namespace mesh_optimizer_utils
+
+    using namespace mesh_optimizer_utils;
+
+    // --=== API ===--
+
+    VertexCacheStats analyze_vertex_cache(const uint32_t *indices, size_t index_count, size_t vertex_count, uint32_t cache_size)
+    {
+        check_triangles(indices, index_count, vertex_count);
+
+        VertexCacheStats stats;
+        FifoCache        cache(vertex_count, cache_size);
+        for (size_t i = 0; i < index_count; i += 3)
+        {
+            stats.vertices_transformed += cache.add_triangle(indices + i);
+        }
+        if (index_count > 0)
+        {
+            stats.acmr = static_cast<float>(stats.vertices_transformed) / static_cast<float>(index_count / 3);
+            stats.atvr = static_cast<float>(stats.vertices_transformed) / static_cast<float>(vertex_count);
+        }
+        return stats;
+    }
+
+    void optimize_vertex_cache(uint32_t *out_indices, const uint32_t *indices, size_t index_count, size_t vertex_count)
+    {
+        check_triangles(indices, index_count, vertex_count);
+        const auto triangle_count = index_count / 3;
+        if (triangle_count == 0)
+        {
+            return;
+        }
+
+        // The input is copied, so that it can be overwritten
+        std::vector<uint32_t> input(indices, indices + index_count);
+
+        // Triangles of each vertex. The first live_triangles[vertex] ones are not emitted yet.
+        std::vector<uint32_t> live_triangles(vertex_count, 0);
+        std::vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+        std::vector<uint32_t> adjacency(index_count);
+        for (const auto vertex : input)
+        {
+            live_triangles[vertex]++;
+        }
+        for (size_t vertex = 0; vertex < vertex_count; vertex++)
+        {
+            adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + live_triangles[vertex];
+        }
+        {
+            std::vector<uint32_t> fill_counts(vertex_count, 0);
+            for (size_t i = 0; i < index_count; i++)
+            {
+                const auto vertex = input[i];
+                adjacency[adjacency_offsets[vertex] + fill_counts[vertex]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        // Initial scores
+        std::vector<int32_t> cache_positions(vertex_count, -1);
+        std::vector<float>   vertex_scores(vertex_count);
+        std::vector<float>   triangle_scores(triangle_count);
+        std::vector<bool>    emitted(triangle_count, false);
+        for (size_t vertex = 0; vertex < vertex_count; vertex++)
+        {
+            vertex_scores[vertex] = vertex_score(-1, live_triangles[vertex]);
+        }
+        uint32_t best_triangle = 0;
+        for (size_t triangle = 0; triangle < triangle_count; triangle++)
+        {
+            const auto *vertices      = &input[triangle * 3];
+            triangle_scores[triangle] = vertex_scores[vertices[0]] + vertex_scores[vertices[1]] + vertex_scores[vertices[2]];
+            if (triangle_scores[triangle] > triangle_scores[best_triangle])
+            {
+                best_triangle = static_cast<uint32_t>(triangle);
+            }
+        }
+
+        uint32_t cache[CACHE_SIZE + 3];
+        uint32_t new_cache[CACHE_SIZE + 3];
+        uint32_t cache_count  = 0;
+        size_t   input_cursor = 0;
+        for (size_t output_triangle = 0; output_triangle < triangle_count; output_triangle++)
+        {
+            // When no triangle in the cache is left, continue with the next one of the input
+            if (best_triangle == NO_TRIANGLE)
+            {
+                while (emitted[input_cursor])
+                {
+                    input_cursor++;
+                }
+                best_triangle = static_cast<uint32_t>(input_cursor);
+            }
+
+            const auto *vertices = &input[best_triangle * 3];
+            memcpy(out_indices + output_triangle * 3, vertices, 3 * sizeof(uint32_t));
+            emitted[best_triangle] = true;
+
+            // The vertices of the triangle go to the front of the cache
+            uint32_t new_cache_count = 0;
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                if (std::find(new_cache, new_cache + new_cache_count, vertices[i]) == new_cache + new_cache_count)
+                {
+                    new_cache[new_cache_count++] = vertices[i];
+                }
+            }
+            for (uint32_t i = 0; i < cache_count; i++)
+            {
+                if (cache[i] != vertices[0] && cache[i] != vertices[1] && cache[i] != vertices[2])
+                {
+                    new_cache[new_cache_count++] = cache[i];
+                }
+            }
+
+            // Remove the triangle from the live triangles of its vertices
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                auto *begin = &adjacency[adjacency_offsets[vertices[i]]];
+                auto *end   = begin + live_triangles[vertices[i]];
+                auto *it    = std::find(begin, end, best_triangle);
+                *it         = *(end - 1);
+                live_triangles[vertices[i]]--;
+            }
+
+            // Update the scores of the vertices that moved in the cache. The ones past its end were evicted.
+            for (uint32_t i = 0; i < new_cache_count; i++)
+            {
+                const auto vertex       = new_cache[i];
+                cache_positions[vertex] = i < CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+                vertex_scores[vertex]   = vertex_score(cache_positions[vertex], live_triangles[vertex]);
+            }
+
+            // Then the scores of their triangles, and pick the best one
+            best_triangle   = NO_TRIANGLE;
+            auto best_score = -1.0f;
+            for (uint32_t i = 0; i < new_cache_count; i++)
+            {
+                const auto vertex = new_cache[i];
+                const auto begin  = adjacency_offsets[vertex];
+                for (uint32_t j = begin; j < begin + live_triangles[vertex]; j++)
+                {
+                    const auto  triangle          = adjacency[j];
+                    const auto *triangle_vertices = &input[triangle * 3];
+                    triangle_scores[triangle]     = vertex_scores[triangle_vertices[0]] + vertex_scores[triangle_vertices[1]]
+                                              + vertex_scores[triangle_vertices[2]];
+                    if (triangle_scores[triangle] > best_score)
+                    {
+                        best_score    = triangle_scores[triangle];
+                        best_triangle = triangle;
+                    }
+                }
+            }
+
+            cache_count = std::min(new_cache_count, CACHE_SIZE);
+            memcpy(cache, new_cache, cache_count * sizeof(uint32_t));
+        }
+    }
+
+    void optimize_overdraw(uint32_t       *out_indices,
+                           const uint32_t *indices,
+                           size_t          index_count,
+                           const float    *positions,
+                           size_t          vertex_count,
+                           size_t          position_stride,
+                           float           threshold)
+    {
+        check_triangles(indices, index_count, vertex_count);
+        if (index_count == 0)
+        {
+            return;
+        }
+
+        std::vector<uint32_t> input(indices, indices + index_count);
+        auto                  clusters = build_clusters(input.data(), index_count, vertex_count, threshold);
+
+        // Area-weighted centroid and normal of each cluster, and of the whole mesh
+        std::vector<float> cluster_data(clusters.size() * 6, 0.0f);
+        float              mesh_centroid[3] = {};
+        float              mesh_area        = 0.0f;
+        for (size_t cluster_index = 0; cluster_index < clusters.size(); cluster_index++)
+        {
+            const auto &cluster  = clusters[cluster_index];
+            auto       *centroid = &cluster_data[cluster_index * 6];
+            auto       *normal   = &cluster_data[cluster_index * 6 + 3];
+            auto        area     = 0.0f;
+            for (size_t i = cluster.first_index; i < cluster.first_index + cluster.index_count; i += 3)
+            {
+                const auto *a = position_of(positions, position_stride, input[i]);
+                const auto *b = position_of(positions, position_stride, input[i + 1]);
+                const auto *c = position_of(positions, position_stride, input[i + 2]);
+
+                const float ab[3]    = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+                const float ac[3]    = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+                const float cross[3] = {
+                    ab[1] * ac[2] - ab[2] * ac[1],
+                    ab[2] * ac[0] - ab[0] * ac[2],
+                    ab[0] * ac[1] - ab[1] * ac[0],
+                };
+                const auto triangle_area = sqrtf(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    centroid[k] += (a[k] + b[k] + c[k]) * triangle_area;
+                    normal[k] += cross[k];
+                }
+                area += triangle_area;
+            }
+
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                mesh_centroid[k] += centroid[k];
+                centroid[k] /= area > 0.0f ? 3.0f * area : 1.0f;
+            }
+            mesh_area += area;
+        }
+        for (auto &coordinate : mesh_centroid)
+        {
+            coordinate /= mesh_area > 0.0f ? 3.0f * mesh_area : 1.0f;
+        }
+
+        // The clusters that are far out in the direction they face are drawn first
+        for (size_t cluster_index = 0; cluster_index < clusters.size(); cluster_index++)
+        {
+            const auto *centroid = &cluster_data[cluster_index * 6];
+            const auto *normal   = &cluster_data[cluster_index * 6 + 3];
+            const auto  length   = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            auto        key      = 0.0f;
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                key += (centroid[k] - mesh_centroid[k]) * normal[k];
+            }
+            clusters[cluster_index].sort_key = length > 0.0f ? key / length : 0.0f;
+        }
+        std::stable_sort(clusters.begin(),
+                         clusters.end(),
+                         [](const Cluster &a, const Cluster &b) { return a.sort_key > b.sort_key; });
+
+        size_t output_index = 0;
+        for (const auto &cluster : clusters)
+        {
+            memcpy(out_indices + output_index, input.data() + cluster.first_index, cluster.index_count * sizeof(uint32_t));
+            output_index += cluster.index_count;
+        }
+    }
+
+    size_t simplify(uint32_t       *out_indices,
+                    const uint32_t *indices,
+                    size_t          index_count,
+                    const float    *positions,
+                    size_t          vertex_count,
+                    size_t          position_stride,
+                    size_t          target_index_count,
+                    float           max_error,
+                    float          *out_error)
+    {
+        check_triangles(indices, index_count, vertex_count);
+
+        std::vector<uint32_t> result(indices, indices + index_count);
+        const auto            locked = find_locked_vertices(indices, index_count, positions, vertex_count, position_stride);
+
+        // Quadric of each vertex: the planes of its triangles. The planes are also kept per vertex, to bound the distance by which the
+        // surface moves: the quadric averages the distances over the areas, which hides the large ones once many planes are merged.
+        std::vector<Quadric>               quadrics(vertex_count);
+        std::vector<Plane>                 planes;
+        std::vector<std::vector<uint32_t>> vertex_planes(vertex_count);
+        for (size_t i = 0; i < index_count; i += 3)
+        {
+            const auto *a = position_of(positions, position_stride, result[i]);
+            const auto *b = position_of(positions, position_stride, result[i + 1]);
+            const auto *c = position_of(positions, position_stride, result[i + 2]);
+            float       normal[3];
+            triangle_normal(a, b, c, normal);
+
+            const auto length = sqrt(static_cast<double>(normal[0]) * normal[0] + static_cast<double>(normal[1]) * normal[1]
+                                     + static_cast<double>(normal[2]) * normal[2]);
+            if (length > 0.0)
+            {
+                const double unit_normal[3] = {normal[0] / length, normal[1] / length, normal[2] / length};
+                const auto   offset         = -(unit_normal[0] * a[0] + unit_normal[1] * a[1] + unit_normal[2] * a[2]);
+                const auto   quadric        = Quadric::from_plane(unit_normal, offset, length * 0.5);
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    quadrics[result[i + k]] += quadric;
+                    vertex_planes[result[i + k]].push_back(static_cast<uint32_t>(planes.size()));
+                }
+                planes.push_back({.n = {unit_normal[0], unit_normal[1], unit_normal[2]}, .d = offset});
+            }
+        }
+
+        // Each pass collapses an independent set of the cheapest edges, then rebuilds the index buffer
+        const auto            max_squared_error = static_cast<double>(max_error) * max_error;
+        double                result_error      = 0.0;
+        std::vector<uint32_t> adjacency_offsets(vertex_count + 1);
+        std::vector<uint32_t> adjacency;
+        std::vector<Collapse> collapses;
+        std::vector<uint32_t> remap(vertex_count);
+        std::vector<bool>     touched(vertex_count);
+        while (result.size() > target_index_count)
+        {
+            // Triangles of each vertex
+            std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+            for (const auto vertex : result)
+            {
+                adjacency_offsets[vertex + 1]++;
+            }
+            for (size_t vertex = 0; vertex < vertex_count; vertex++)
+            {
+                adjacency_offsets[vertex + 1] += adjacency_offsets[vertex];
+            }
+            adjacency.resize(result.size());
+            {
+                auto fill_offsets = adjacency_offsets;
+                for (size_t i = 0; i < result.size(); i++)
+                {
+                    adjacency[fill_offsets[result[i]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+
+            // Candidate collapses, in both directions of each edge
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    const auto a       = result[i + k];
+                    const auto b       = result[i + (k + 1) % 3];
+                    auto       quadric = quadrics[a];
+                    quadric += quadrics[b];
+                    if (!locked[a])
+                    {
+                        collapses.push_back({a, b, quadric.mean_error(position_of(positions, position_stride, b))});
+                    }
+                    if (!locked[b])
+                    {
+                        collapses.push_back({b, a, quadric.mean_error(position_of(positions, position_stride, a))});
+                    }
+                }
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) { return a.cost < b.cost; });
+
+            // A collapse removes two triangles on a closed surface
+            const auto max_collapse_count = std::max<size_t>(1, (result.size() - target_index_count) / 6);
+            size_t     collapse_count     = 0;
+            for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+            {
+                remap[vertex] = vertex;
+            }
+            std::fill(touched.begin(), touched.end(), false);
+            for (const auto &collapse : collapses)
+            {
+                // A mean of squared distances is never above the largest one, so the next collapses move the surface too far as well
+                if (collapse_count >= max_collapse_count || collapse.cost > max_squared_error)
+                {
+                    break;
+                }
+                if (touched[collapse.from] || touched[collapse.to])
+                {
+                    continue;
+                }
+
+                // Distance from the new position of the vertex to the planes of all the triangles merged into both ends of the edge
+                const auto *to_position = position_of(positions, position_stride, collapse.to);
+                const auto  distance    = std::max(max_plane_distance(planes, vertex_planes[collapse.from], to_position),
+                                                   max_plane_distance(planes, vertex_planes[collapse.to], to_position));
+                if (distance > max_error)
+                {
+                    continue;
+                }
+
+                // Reject the collapse if a remaining triangle of the moved vertex would flip
+                bool flips = false;
+                for (auto j = adjacency_offsets[collapse.from]; j < adjacency_offsets[collapse.from + 1] && !flips; j++)
+                {
+                    const auto *triangle = &result[adjacency[j] * 3];
+                    if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                    {
+                        continue;
+                    }
+                    const float *before[3];
+                    const float *after[3];
+                    for (uint32_t k = 0; k < 3; k++)
+                    {
+                        before[k] = position_of(positions, position_stride, triangle[k]);
+                        after[k]  = triangle[k] == collapse.from ? to_position : before[k];
+                    }
+                    float normal_before[3];
+                    float normal_after[3];
+                    triangle_normal(before[0], before[1], before[2], normal_before);
+                    triangle_normal(after[0], after[1], after[2], normal_after);
+                    flips = normal_before[0] * normal_after[0] + normal_before[1] * normal_after[1]
+                                + normal_before[2] * normal_after[2]
+                            <= 0.0f;
+                }
+                if (flips)
+                {
+                    continue;
+                }
+
+                // The triangles around the moved vertex can't change again in this pass
+                remap[collapse.from] = collapse.to;
+                quadrics[collapse.to] += quadrics[collapse.from];
+                auto &merged_planes = vertex_planes[collapse.to];
+                merged_planes.insert(merged_planes.end(), vertex_planes[collapse.from].begin(), vertex_planes[collapse.from].end());
+                std::sort(merged_planes.begin(), merged_planes.end());
+                merged_planes.erase(std::unique(merged_planes.begin(), merged_planes.end()), merged_planes.end());
+                vertex_planes[collapse.from] = {};
+                result_error                 = std::max(result_error, distance);
+                for (auto j = adjacency_offsets[collapse.from]; j < adjacency_offsets[collapse.from + 1]; j++)
+                {
+                    const auto *triangle = &result[adjacency[j] * 3];
+                    touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+                }
+                collapse_count++;
+            }
+            if (collapse_count == 0)
+            {
+                break;
+            }
+
+            // Drop the triangles that became degenerate
+            size_t write_index = 0;
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                const auto a = remap[result[i]];
+                const auto b = remap[result[i + 1]];
+                const auto c = remap[result[i + 2]];
+                if (a != b && b != c && a != c)
+                {
+                    result[write_index++] = a;
+                    result[write_index++] = b;
+                    result[write_index++] = c;
+                }
+            }
+            result.resize(write_index);
+        }
+
+        if (out_error != nullptr)
+        {
+            *out_error = static_cast<float>(result_error);
+        }
+        memcpy(out_indices, result.data(), result.size() * sizeof(uint32_t));
+        return result.size();
+    }
+
+    size_t optimize_vertex_fetch(void       *out_vertices,
+                                 uint32_t   *indices,
+                                 size_t      index_count,
+                                 const void *vertices,
+                                 size_t      vertex_count,
+                                 size_t      vertex_size)
+    {
+        check_triangles(indices, index_count, vertex_count);
+
+        std::vector<uint32_t> remap(vertex_count, UINT32_MAX);
+        uint32_t              next_vertex = 0;
+        for (size_t i = 0; i < index_count; i++)
+        {
+            auto &new_vertex = remap[indices[i]];
+            if (new_vertex == UINT32_MAX)
+            {
+                memcpy(static_cast<char *>(out_vertices) + next_vertex * vertex_size,
+                       static_cast<const char *>(vertices) + indices[i] * vertex_size,
+                       vertex_size);
+                new_vertex = next_vertex++;
+            }
+            indices[i] = new_vertex;
+        }
+        return next_vertex;
+    }
+} // namespace vre
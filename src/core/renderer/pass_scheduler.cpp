@@ -0,0 +1,65 @@
+#include "vr_engine/core/renderer/pass_scheduler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace vre
+{
+    void PassScheduler::begin_frame(bool async_compute)
+    {
+        m_async_compute = async_compute;
+        m_batches.clear();
+        m_pass_batches.clear();
+        std::fill(std::begin(m_open_batches), std::end(m_open_batches), NO_BATCH);
+    }
+
+    uint32_t PassScheduler::add_pass(PassQueue queue, const uint32_t *dependencies, uint32_t dependency_count)
+    {
+        if (!m_async_compute)
+        {
+            queue = PassQueue::GRAPHICS;
+        }
+        const auto queue_index = static_cast<uint32_t>(queue);
+        const auto pass        = static_cast<uint32_t>(m_pass_batches.size());
+
+        // Dependencies on the same queue are ordered by the queue itself. The other ones are waited for with the timeline.
+        uint64_t wait_value = 0;
+        for (uint32_t i = 0; i < dependency_count; i++)
+        {
+            if (dependencies[i] >= pass)
+            {
+                throw std::invalid_argument("A pass can only depend on the passes added before it");
+            }
+            const auto  dependency_batch_index = m_pass_batches[dependencies[i]];
+            const auto &dependency_batch       = m_batches[dependency_batch_index];
+            if (dependency_batch.queue != queue)
+            {
+                wait_value = std::max(wait_value, dependency_batch.signal_value);
+
+                // The batch must be submitted before this pass, so the next passes of its queue go in a new one
+                auto &other_open_batch = m_open_batches[static_cast<uint32_t>(dependency_batch.queue)];
+                if (other_open_batch == dependency_batch_index)
+                {
+                    other_open_batch = NO_BATCH;
+                }
+            }
+        }
+
+        // Start a new batch when the current one would have to wait longer
+        auto &open_batch = m_open_batches[queue_index];
+        if (open_batch == NO_BATCH || wait_value > m_batches[open_batch].wait_value)
+        {
+            open_batch = static_cast<uint32_t>(m_batches.size());
+            m_batches.push_back(PassBatch {
+                .queue        = queue,
+                .passes       = {},
+                .wait_value   = wait_value,
+                .signal_value = ++m_timeline_values[queue_index],
+            });
+        }
+
+        m_batches[open_batch].passes.push_back(pass);
+        m_pass_batches.push_back(open_batch);
+        return pass;
+    }
+} // namespace vre
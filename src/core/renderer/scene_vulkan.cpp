@@ -4,6 +4,8 @@
 #include <vr_engine/utils/data/storage.h>
 #include <vr_engine/utils/global_utils.h>
 #include <vr_engine/utils/io.h>
+#include <vr_engine/utils/log.h>
+#include <vr_engine/utils/profiler.h>
 #include <vr_engine/utils/vulkan_utils.h>
 
 namespace vre
@@ -19,14 +21,14 @@ namespace vre
     struct Scene::Data : ISharedPointerData
     {
         VkDevice              device = VK_NULL_HANDLE;
-        VulkanFunctions       vk_functions;
+        VolkDeviceTable       vk = {};
         Storage<ShaderModule> shader_modules;
 
         ~Data() override
         {
             for (auto &shader_module : shader_modules)
             {
-                vk_functions.vkDestroyShaderModule(device, shader_module.value().module, nullptr);
+                vk.vkDestroyShaderModule(device, shader_module.value().module, nullptr);
             }
         }
     };
@@ -58,12 +60,14 @@ namespace vre
 
     void Scene::bind_renderer(const SceneRendererBinding &binding)
     {
-        data()->device       = binding.device;
-        data()->vk_functions = binding.functions;
+        data()->device = binding.device;
+        data()->vk     = *binding.device_table;
     }
 
     Id Scene::load_shader_module(const char *file_path, ShaderStage stage)
     {
+        VRE_ZONE("Scene::load_shader_module");
+
         ShaderModule module = {
             .stage = convert_shader_stage(stage),
         };
@@ -91,7 +95,7 @@ namespace vre
             .pCode    = code,
         };
         VkShaderModule vk_shader_module;
-        vk_check(data()->vk_functions.vkCreateShaderModule(data()->device, &shader_module_create_info, nullptr, &vk_shader_module),
+        vk_check(data()->vk.vkCreateShaderModule(data()->device, &shader_module_create_info, nullptr, &vk_shader_module),
                  "Could not create shader module");
 
         // Free code
@@ -103,7 +107,7 @@ namespace vre
         // Add it to storage
         Id id = data()->shader_modules.push(module);
 
-        std::cout << "Loaded shader module " << id << ": " << file_path << "\n";
+        VRE_LOG_INFO("Loaded shader module {}: {}", id, file_path);
 
         // Return the id
         return id;
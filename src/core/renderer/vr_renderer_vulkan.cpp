@@ -1,13 +1,30 @@
 #ifdef RENDERER_VULKAN
 #include "vr_engine/core/vr/vr_renderer.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <volk.h>
 #include <vr_engine/core/global.h>
+#include <vr_engine/core/renderer/command_cache.h>
+#include <vr_engine/core/renderer/descriptor_cache.h>
+#include <vr_engine/core/renderer/instance_batcher.h>
+#include <vr_engine/core/renderer/light_clusters.h>
+#include <vr_engine/core/renderer/lod_selector.h>
+#include <vr_engine/core/renderer/pass_scheduler.h>
 #include <vr_engine/core/scene.h>
 #include <vr_engine/core/vr/vr_system.h>
 #include <vr_engine/core/window.h>
+#include <vr_engine/utils/api_trace.h>
+#include <vr_engine/utils/data/map.h>
+#include <vr_engine/utils/data/offset_allocator.h>
+#include <vr_engine/utils/data/small_vector.h>
+#include <vr_engine/utils/data/storage.h>
 #include <vr_engine/utils/global_utils.h>
+#include <vr_engine/utils/log.h>
+#include <vr_engine/utils/metrics.h>
 #include <vr_engine/utils/openxr_utils.h>
+#include <vr_engine/utils/profiler.h>
 #include <vr_engine/utils/vulkan_utils.h>
 
 // Needs to be after volk.h
@@ -34,6 +51,19 @@ namespace vre
 
 #define VIEW_CONFIGURATION_TYPE XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO
 #define NB_OVERLAPPING_FRAMES   2
+// Inline capacities of the small collections. Bigger ones still work, but are allocated on the heap.
+#define INLINE_VIEW_COUNT            2
+#define INLINE_SWAPCHAIN_IMAGE_COUNT 4
+#define INLINE_PROPERTY_COUNT        32
+// Cached commands that were not replayed during this number of frames are freed
+#define MAX_UNUSED_COMMAND_FRAMES 16
+// Passes whose commands are cached in secondary command buffers
+#define VIEW_PASS 1
+// Descriptor pools start with room for this number of sets, and each new pool has twice the room of the previous one
+#define INITIAL_DESCRIPTOR_SETS_PER_POOL 64
+#define MAX_DESCRIPTOR_SETS_PER_POOL     4096
+
+#define LIGHT_RING_PART_COUNT 4
 
     // --=== Structs ===---
 
@@ -58,18 +88,25 @@ namespace vre
     class Allocator
     {
       private:
-        VmaAllocator m_allocator             = VK_NULL_HANDLE;
-        VkDevice     m_device                = VK_NULL_HANDLE;
-        uint32_t     m_graphics_queue_family = 0;
-        uint32_t     m_transfer_queue_family = 0;
+        VmaAllocator           m_allocator             = VK_NULL_HANDLE;
+        VkDevice               m_device                = VK_NULL_HANDLE;
+        const VolkDeviceTable *m_device_table          = nullptr;
+        uint32_t               m_graphics_queue_family = 0;
+        uint32_t               m_transfer_queue_family = 0;
+        uint32_t               m_compute_queue_family  = 0;
+
+        /** Fills the distinct families of the queues that access concurrent resources, and returns their count. */
+        uint32_t concurrent_queue_families(uint32_t out_families[3]) const;
 
       public:
         Allocator() = default;
-        Allocator(VkInstance       instance,
-                  VkDevice         device,
-                  VkPhysicalDevice physical_device,
-                  uint32_t         graphics_queue_family,
-                  uint32_t         transfer_queue_family);
+        Allocator(VkInstance             instance,
+                  VkDevice               device,
+                  const VolkDeviceTable &device_table,
+                  VkPhysicalDevice       physical_device,
+                  uint32_t               graphics_queue_family,
+                  uint32_t               transfer_queue_family,
+                  uint32_t               compute_queue_family);
         Allocator(Allocator &&other) noexcept;
         Allocator &operator=(Allocator &&other) noexcept;
 
@@ -90,7 +127,188 @@ namespace vre
         void                          destroy_buffer(AllocatedBuffer &buffer) const;
         void                         *map_buffer(AllocatedBuffer &buffer) const;
         void                          unmap_buffer(AllocatedBuffer &buffer) const;
+        /** Makes the CPU writes to a mapped range visible to the GPU. Does nothing if the memory is host-coherent. */
+        void                          flush_buffer(AllocatedBuffer &buffer, size_t offset, size_t size) const;
+    };
+    // endregion
+
+    // region Descriptors
+
+    /**
+     * Allocates descriptor sets from a list of pools. When the current pool is out of memory, the next one is used, and a new pool is
+     * created once they are all full, with twice the room of the previous one. reset() gives all the sets back at once but keeps the
+     * pools, so once the pools have grown to the needs of a frame, an allocation is a pointer bump in the driver.
+     *
+     * The pools are sized from the layouts actually allocated: each set of a new pool has room for the most descriptors of each type
+     * that a layout needed so far. A layout that doesn't fit the existing pools thus always fits the next one.
+     */
+    class DescriptorAllocator
+    {
+      private:
+        VkDevice                      m_device        = VK_NULL_HANDLE;
+        const VolkDeviceTable        *m_device_table  = nullptr;
+        // Pools with free space. Sets are allocated from the last one.
+        std::vector<VkDescriptorPool> m_ready_pools   = {};
+        std::vector<VkDescriptorPool> m_full_pools    = {};
+        uint32_t                      m_sets_per_pool = INITIAL_DESCRIPTOR_SETS_PER_POOL;
+        DescriptorCounts              m_set_counts    = {};
+        // Metrics
+        Counter *m_pool_metric = &MetricsRegistry::global().counter("renderer.descriptor_pools");
+
+        VkDescriptorPool create_pool();
+
+      public:
+        DescriptorAllocator() = default;
+        DescriptorAllocator(VkDevice device, const VolkDeviceTable &device_table);
+
+        /** @param counts descriptors of each type in the layout */
+        [[nodiscard]] VkDescriptorSet allocate(VkDescriptorSetLayout layout, const DescriptorCounts &counts);
+        /** Frees all the sets allocated since the last reset. The GPU must be done with them. */
+        void                          reset();
+        void                          destroy();
+    };
+
+    /** A resource bound to a descriptor set. The buffer fields are used for buffer descriptors, the image ones for the others. */
+    struct DescriptorBinding
+    {
+        uint32_t         binding      = 0;
+        VkDescriptorType type         = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        VkBuffer         buffer       = VK_NULL_HANDLE;
+        VkDeviceSize     offset       = 0;
+        VkDeviceSize     range        = VK_WHOLE_SIZE;
+        VkImageView      image_view   = VK_NULL_HANDLE;
+        VkSampler        sampler      = VK_NULL_HANDLE;
+        VkImageLayout    image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    };
+
+    /**
+     * Descriptor set layouts, and the sets that stay the same over many frames, keyed by a content hash of what they were created
+     * with. The persistent sets are allocated from their own pools and written once, so the resources they bind must outlive them.
+     */
+    struct DescriptorCache
+    {
+        KeyedCache<DescriptorKey, VkDescriptorSetLayout> layouts              = {};
+        // Descriptors of each type in the layouts, by layout handle
+        Map<DescriptorCounts>                            layout_counts        = {};
+        KeyedCache<DescriptorKey, VkDescriptorSet>       persistent_sets      = {};
+        DescriptorAllocator                              persistent_allocator = {};
+    };
+
+    // endregion
+
+    // region Geometry
+
+    /** Location of a mesh in the geometry pool. The offsets and sizes are in vertices and indices, not in bytes. */
+    struct Mesh
+    {
+        OffsetAllocation vertices = {};
+        OffsetAllocation indices  = {};
+        // Ranges of the indices of the mesh, from the finest LOD to the coarsest
+        SmallVector<MeshLod, MAX_MESH_LOD_COUNT> lods = {};
+        // Folded in the transforms of the instances when the positions are quantized
+        MeshQuantization quantization = {};
+        bool             is_quantized = false;
+
+        /** Draw of a LOD of the mesh, as expected by vkCmdDrawIndexedIndirect. */
+        [[nodiscard]] inline VkDrawIndexedIndirectCommand draw_command(uint32_t instance_count = 1,
+                                                                       uint32_t first_instance = 0,
+                                                                       uint32_t lod            = 0) const
+        {
+            return VkDrawIndexedIndirectCommand {
+                .indexCount    = lods[lod].index_count,
+                .instanceCount = instance_count,
+                .firstIndex    = indices.offset + lods[lod].first_index,
+                .vertexOffset  = static_cast<int32_t>(vertices.offset),
+                .firstInstance = first_instance,
+            };
+        }
+    };
+
+    struct PendingMeshRelease
+    {
+        Mesh mesh = {};
+        // Frames before this one may still draw the mesh
+        uint64_t frame_number = 0;
+    };
+
+    /**
+     * The vertices and indices of all meshes, sub-allocated in one big device-local buffer of each kind. The buffers are bound once
+     * per frame, and each draw selects its mesh with its offsets. Thus, all the geometry can be drawn with a single indirect draw.
+     */
+    struct GeometryPool
+    {
+        uint32_t                        vertex_stride    = 0;
+        AllocatedBuffer                 vertex_buffer    = {};
+        AllocatedBuffer                 index_buffer     = {};
+        OffsetAllocator                 vertex_allocator = {};
+        OffsetAllocator                 index_allocator  = {};
+        Storage<Mesh>                   meshes           = {};
+        std::vector<PendingMeshRelease> pending_releases = {};
+        // Command buffers that copy the staging buffers to the pool, on the transfer queue
+        VkCommandPool upload_command_pool = VK_NULL_HANDLE;
+        // Metrics
+        Gauge *used_vertices_metric = &MetricsRegistry::global().gauge("renderer.geometry.used_vertices");
+        Gauge *used_indices_metric  = &MetricsRegistry::global().gauge("renderer.geometry.used_indices");
+    };
+
+    /**
+     * Per-frame copy of the instance transforms, and one indirect draw per batch of instances. Each frame in flight has its own
+     * region of the buffers, which stay mapped, so that the next frame can be written while the GPU reads the previous one.
+     *
+     * The batches are sorted by material, so the draws of a material are consecutive and can be issued with a single
+     * vkCmdDrawIndexedIndirect.
+     */
+    struct InstanceRing
+    {
+        // Number of instances, and thus of draws, in the region of a frame
+        uint32_t                      capacity        = 0;
+        AllocatedBuffer               instance_buffer = {};
+        AllocatedBuffer               indirect_buffer = {};
+        InstanceTransform            *instances       = nullptr;
+        VkDrawIndexedIndirectCommand *draw_commands   = nullptr;
+        // Metrics
+        Gauge *instance_metric = &MetricsRegistry::global().gauge("renderer.instances");
+        Gauge *draw_metric     = &MetricsRegistry::global().gauge("renderer.instanced_draws");
     };
+
+    // endregion
+
+    // region Lights
+
+    /** Start of the first part of a region of the light ring, before the cluster grids. */
+    struct LightRingHeader
+    {
+        uint32_t grid_count  = 0;
+        uint32_t light_count = 0;
+        uint32_t padding[2]  = {};
+    };
+
+    /**
+     * Per-frame copy of the lights and of their clusters, read by the shaders of the views. Each frame in flight has its own region
+     * of the buffer, which stays mapped. A region is made of parts bound to consecutive storage buffer bindings:
+     * 0. the header, followed by the cluster grids
+     * 1. the range of the light indices of each cluster
+     * 2. the lights
+     * 3. the light indices of the clusters
+     */
+    struct LightRing
+    {
+        uint32_t        max_light_count                = 0;
+        uint32_t        max_cluster_count              = 0;
+        uint32_t        max_index_count                = 0;
+        // Offsets of the parts in a region, aligned for storage buffers, and their sizes, in bytes
+        VkDeviceSize    offsets[LIGHT_RING_PART_COUNT] = {};
+        VkDeviceSize    sizes[LIGHT_RING_PART_COUNT]   = {};
+        VkDeviceSize    region_size                    = 0;
+        AllocatedBuffer buffer                         = {};
+        uint8_t        *data                           = nullptr;
+        // Layout of the sets that bind the parts of a region
+        VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+        // Metrics
+        Gauge   *light_metric   = &MetricsRegistry::global().gauge("renderer.lights");
+        Counter *dropped_metric = &MetricsRegistry::global().counter("renderer.light_clusters.dropped");
+    };
+
     // endregion
 
     // region Material System
@@ -109,19 +327,38 @@ namespace vre
         VkFramebuffer framebuffer = VK_NULL_HANDLE;
     };
 
+    typedef SmallVector<RenderTarget, INLINE_SWAPCHAIN_IMAGE_COUNT> RenderTargetList;
+
     /** A VR system has several "views" (typically left and right eyes) that can be rendered to. */
     struct VrView
     {
-        XrViewConfigurationView   view_config      = {};
-        XrView                    view             = {};
-        XrSwapchain               xr_swapchain     = XR_NULL_HANDLE;
-        VkExtent2D                swapchain_extent = {};
-        std::vector<RenderTarget> render_targets   = {};
+        XrViewConfigurationView view_config      = {};
+        XrView                  view             = {};
+        XrSwapchain             xr_swapchain     = XR_NULL_HANDLE;
+        VkExtent2D              swapchain_extent = {};
+        RenderTargetList        render_targets   = {};
+    };
+
+    /** A UI panel has its own small swapchain, which is only rendered again when its content changes. */
+    struct UiPanel
+    {
+        XrSwapchain      xr_swapchain     = XR_NULL_HANDLE;
+        VkExtent2D       extent           = {};
+        RenderTargetList render_targets   = {};
+        XrPosef          pose             = {};
+        XrExtent2Df      size             = {};
+        VkClearValue     background_color = {};
+        // Rendering needed during the next frame
+        bool dirty = true;
+        // At least one image was released, so the panel can be submitted
+        bool has_content = false;
     };
 
     struct Queue
     {
         uint32_t family_index = 0;
+        // Index of the queue in its family
+        uint32_t index        = 0;
         VkQueue  queue        = VK_NULL_HANDLE;
     };
 
@@ -132,10 +369,38 @@ namespace vre
         VkFence         render_fence              = VK_NULL_HANDLE;
         VkSemaphore     image_available_semaphore = VK_NULL_HANDLE;
         VkSemaphore     render_finished_semaphore = VK_NULL_HANDLE;
+        // Timestamps written at the beginning and end of the frame, to measure the GPU time
+        VkQueryPool timestamp_query_pool = VK_NULL_HANDLE;
+        bool        has_timestamps       = false;
+        // Indirect draws written in the instance ring for this frame
+        uint32_t draw_count = 0;
+        // Secondary command buffers of the passes, allocated from the command pool of the frame
+        CommandCache<VkCommandBuffer> command_cache = {};
+        // Descriptor sets that only live during the frame
+        DescriptorAllocator descriptors = {};
+        // Binds the region of the frame in the light ring, for the shaders of the views
+        VkDescriptorSet light_descriptor_set = VK_NULL_HANDLE;
+        // Command buffers of the pass batches, for each queue. The graphics ones come from the command pool of the frame.
+        VkCommandPool                   compute_command_pool                    = VK_NULL_HANDLE;
+        SmallVector<VkCommandBuffer, 4> batch_command_buffers[PASS_QUEUE_COUNT] = {};
     };
 
     struct VrRenderer::Data
     {
+        /**
+         * A compute pass recorded each frame before the views, which read its results. It is scheduled on the async compute queue
+         * when there is one, so that it overlaps the rendering of the previous frame. The pass makes its writes available to the
+         * passes that depend on it with a barrier at its end.
+         */
+        struct ComputePass
+        {
+            void (Data::*record)(uint32_t frame_index, VkCommandBuffer command_buffer) = nullptr;
+            // False to keep the pass on the graphics queue, e.g. when it is too short to be worth a submission of its own
+            bool async_compute = true;
+            // Indices of the compute passes whose results the pass reads
+            SmallVector<uint32_t, 4> dependencies = {};
+        };
+
         uint8_t reference_count = 0;
         Window  mirror_window   = {};
         Scene   scene           = {};
@@ -143,6 +408,8 @@ namespace vre
         // Vulkan core
         VkInstance                 vk_instance       = VK_NULL_HANDLE;
         VkDevice                   device            = VK_NULL_HANDLE;
+        // Device level functions are called through this table
+        VolkDeviceTable            device_table      = {};
         VkPhysicalDevice           physical_device   = VK_NULL_HANDLE;
         VkPhysicalDeviceProperties device_properties = {};
 #ifdef USE_VK_VALIDATION_LAYERS
@@ -154,21 +421,106 @@ namespace vre
         VkRenderPass render_pass                   = VK_NULL_HANDLE;
         FrameData    frames[NB_OVERLAPPING_FRAMES] = {};
         uint64_t     current_frame_number          = 0;
+        // With dynamic rendering, there is no render pass: the pipelines are created with this layout of attachments instead
+        bool                             dynamic_rendering       = false;
+        VkPipelineRenderingCreateInfoKHR pipeline_rendering_info = {};
+
+        // GPU timing
+        bool   timestamps_supported = false;
+        double last_gpu_frame_time  = 0.0;
+
+        // Metrics
+        Counter *upload_bytes_metric      = &MetricsRegistry::global().counter("renderer.upload_bytes");
+        Counter *render_pass_metric       = &MetricsRegistry::global().counter("renderer.render_passes");
+        Counter *command_replay_metric    = &MetricsRegistry::global().counter("renderer.command_cache.replays");
+        Counter *command_recording_metric = &MetricsRegistry::global().counter("renderer.command_cache.recordings");
 
         // Queues
         Queue graphics_queue = {};
         Queue transfer_queue = {};
+        Queue compute_queue  = {};
+
+        // Async compute. Each queue signals its timeline semaphore at the end of its pass batches.
+        bool                     async_compute                         = false;
+        VkSemaphore              timeline_semaphores[PASS_QUEUE_COUNT] = {};
+        PassScheduler            pass_scheduler                        = {};
+        std::vector<ComputePass> compute_passes                        = {};
 
         // XR
-        XrInstance                  xr_instance      = XR_NULL_HANDLE;
-        XrSystemId                  system_id        = XR_NULL_SYSTEM_ID;
-        XrGraphicsBindingVulkan2KHR graphics_binding = {};
-        std::vector<VrView>         views            = {};
+        XrInstance                            xr_instance      = XR_NULL_HANDLE;
+        XrSystemId                            system_id        = XR_NULL_SYSTEM_ID;
+        XrGraphicsBindingVulkan2KHR           graphics_binding = {};
+        SmallVector<VrView, INLINE_VIEW_COUNT> views            = {};
+        Storage<UiPanel>                      ui_panels        = {};
+
+        // Descriptors
+        DescriptorCache descriptors = {};
+
+        // Geometry
+        GeometryPool    geometry         = {};
+        InstanceBatcher instance_batcher = {};
+        InstanceRing    instance_ring    = {};
+        LodSelector     lod_selector     = {};
+
+        // Lights
+        Storage<PointLight>     lights          = {};
+        LightClusterer          light_clusterer = {};
+        LightRing               light_ring      = {};
+        // The lights of the frame, gathered from the storage before binning
+        std::vector<PointLight> frame_lights    = {};
 
         // --- Methods ---
         template<typename T>
         void                 copy_buffer_to_gpu(const T &src, AllocatedBuffer &dst, size_t offset = 0);
         [[nodiscard]] size_t pad_uniform_buffer_size(size_t original_size) const;
+        [[nodiscard]] size_t pad_storage_buffer_size(size_t original_size) const;
+        /** Creates an image view for each image of the swapchain, and a framebuffer unless rendering dynamically */
+        void create_render_targets(XrSwapchain swapchain, VkExtent2D extent, RenderTargetList &out_render_targets);
+        void destroy_render_targets(RenderTargetList &render_targets);
+        /**
+         * Begins rendering in the render target, with the render pass or dynamically.
+         * @param secondary_commands if true, the content is recorded in secondary command buffers
+         */
+        void begin_rendering(VkCommandBuffer     command_buffer,
+                             const RenderTarget &render_target,
+                             VkExtent2D          extent,
+                             const VkClearValue &clear_value,
+                             bool                secondary_commands);
+        void end_rendering(VkCommandBuffer command_buffer);
+        /** Copies the data of the mesh to its place in the geometry pool, and waits until it is done. */
+        void upload_mesh(const Mesh &mesh, const void *vertices, const uint32_t *indices);
+        /** Gives the space of the destroyed meshes back to the pool, once no frame in flight can draw them. */
+        void release_meshes();
+        /** Writes the instances and the indirect draws of the frame in its region of the instance ring. */
+        void write_frame_instances(uint32_t frame_index);
+        /** Bins the lights in the clusters of the views, and writes them in the region of the frame in the light ring. */
+        void write_frame_lights(uint32_t frame_index, const XrView *views, uint32_t view_count);
+        /** Returns the secondary command buffer of a view, recorded again only if the inputs of its commands changed. */
+        VkCommandBuffer view_commands(uint32_t frame_index, uint32_t view_index);
+        /** Frees the cached command buffers of all frames. The GPU must be idle. */
+        void clear_command_caches();
+        /** Returns the layout with these bindings, created the first time it is asked for. */
+        VkDescriptorSetLayout descriptor_set_layout(const VkDescriptorSetLayoutBinding *bindings, uint32_t binding_count);
+        /** Descriptors of each type in a layout returned by descriptor_set_layout. */
+        const DescriptorCounts &layout_counts(VkDescriptorSetLayout layout) const;
+        /** Returns the set of the layout bound to these resources, written the first time and then shared by all frames. */
+        VkDescriptorSet persistent_descriptor_set(VkDescriptorSetLayout    layout,
+                                                  const DescriptorBinding *bindings,
+                                                  uint32_t                 binding_count);
+        /** Allocates and writes a set of the layout, which stays valid until the frame is rendered again. */
+        VkDescriptorSet transient_descriptor_set(uint32_t                 frame_index,
+                                                 VkDescriptorSetLayout    layout,
+                                                 const DescriptorBinding *bindings,
+                                                 uint32_t                 binding_count);
+        void            write_descriptor_set(VkDescriptorSet set, const DescriptorBinding *bindings, uint32_t binding_count);
+        /** Returns the index of the pass, to be used as a dependency of the next ones. */
+        uint32_t        add_compute_pass(const ComputePass &pass);
+        /** Returns the command buffer of a batch of the frame, allocated the first time a frame has that many batches. */
+        VkCommandBuffer batch_command_buffer(uint32_t frame_index, PassQueue queue, uint32_t batch_index);
+        /** Records the compute passes of a batch of the frame. */
+        void            record_compute_passes(uint32_t frame_index, const PassBatch &batch, VkCommandBuffer command_buffer);
+        /** Submits a batch, which waits for and signals the timelines of the queues with async compute. */
+        void            submit_batch(const PassBatch &batch, VkCommandBuffer command_buffer, VkFence fence);
     };
 
     // --=== Utils ===--
@@ -194,122 +546,102 @@ namespace vre
 
         // region Instance creation
 
-        bool check_instance_extension_support(const std::vector<const char *> &desired_extensions)
+        bool check_instance_extension_support(const char *const *desired_extensions, size_t desired_extension_count)
         {
-            // Get the number of available desired_extensions
+            // Get the number of available extensions
             uint32_t available_extensions_count = 0;
             vk_check(vkEnumerateInstanceExtensionProperties(nullptr, &available_extensions_count, VK_NULL_HANDLE));
-            // Create an array with enough room and fetch the available desired_extensions
-            std::vector<VkExtensionProperties> available_extensions(available_extensions_count);
+            // Create an array with enough room and fetch the available extensions
+            SmallVector<VkExtensionProperties, INLINE_PROPERTY_COUNT> available_extensions(available_extensions_count);
             vk_check(vkEnumerateInstanceExtensionProperties(nullptr, &available_extensions_count, available_extensions.data()));
 
-            // For each desired extension, rg_renderer_check if it is available
-            bool valid = true;
-            for (const auto &desired_extension : desired_extensions)
+            // Check that each desired extension is available, and stop at the first missing one
+            for (size_t i = 0; i < desired_extension_count; i++)
             {
-                bool       found = false;
-                const auto ext   = std::string(desired_extension);
-
-                // Search available extensions until the desired one is found or not
+                bool found = false;
                 for (const auto &available_extension : available_extensions)
                 {
-                    if (ext == std::string(available_extension.extensionName))
+                    if (strcmp(desired_extensions[i], available_extension.extensionName) == 0)
                     {
                         found = true;
                         break;
                     }
                 }
 
-                // Stop looking if nothing was found
                 if (!found)
                 {
-                    valid = false;
-                    std::cerr << "[Vulkan Error] The extension \"" << ext << "\" is not available.\n";
-                    break;
+                    VRE_LOG_ERROR("The Vulkan extension \"{}\" is not available.", desired_extensions[i]);
+                    return false;
                 }
             }
-
-            return valid;
+            return true;
         }
 
-        bool check_device_extension_support(const VkPhysicalDevice          &physical_device,
-                                            const std::vector<const char *> &desired_extensions)
+        bool check_device_extension_support(VkPhysicalDevice   physical_device,
+                                            const char *const *desired_extensions,
+                                            size_t             desired_extension_count)
         {
-            // Get the number of available desired_extensions
+            // Get the number of available extensions
             uint32_t available_extensions_count = 0;
             vk_check(vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &available_extensions_count, VK_NULL_HANDLE));
-            // Create an array with enough room and fetch the available desired_extensions
-            std::vector<VkExtensionProperties> available_extensions(available_extensions_count);
+            // Create an array with enough room and fetch the available extensions
+            SmallVector<VkExtensionProperties, INLINE_PROPERTY_COUNT> available_extensions(available_extensions_count);
             vk_check(vkEnumerateDeviceExtensionProperties(physical_device,
                                                           nullptr,
                                                           &available_extensions_count,
                                                           available_extensions.data()));
 
-            // For each desired extension, rg_renderer_check if it is available
-            bool valid = true;
-            for (const auto &desired_extension : desired_extensions)
+            // Check that each desired extension is available, and stop at the first missing one
+            for (size_t i = 0; i < desired_extension_count; i++)
             {
-                bool       found = false;
-                const auto ext   = std::string(desired_extension);
-
-                // Search available extensions until the desired one is found or not
+                bool found = false;
                 for (const auto &available_extension : available_extensions)
                 {
-                    if (ext == std::string(available_extension.extensionName))
+                    if (strcmp(desired_extensions[i], available_extension.extensionName) == 0)
                     {
                         found = true;
                         break;
                     }
                 }
 
-                // Stop looking if nothing was found
                 if (!found)
                 {
-                    valid = false;
-                    std::cerr << "[Error] The extension \"" << ext << "\" is not available.\n";
-                    break;
+                    VRE_LOG_ERROR("The extension \"{}\" is not available.", desired_extensions[i]);
+                    return false;
                 }
             }
-
-            return valid;
+            return true;
         }
 
-        bool check_layer_support(const std::vector<const char *> &desired_layers)
+        bool check_layer_support(const char *const *desired_layers, size_t desired_layer_count)
         {
-            // Get the number of available desired_layers
+            // Get the number of available layers
             uint32_t available_layers_count = 0;
             vk_check(vkEnumerateInstanceLayerProperties(&available_layers_count, nullptr));
-            // Create an array with enough room and fetch the available desired_layers
-            std::vector<VkLayerProperties> available_layers(available_layers_count);
+            // Create an array with enough room and fetch the available layers
+            SmallVector<VkLayerProperties, INLINE_PROPERTY_COUNT> available_layers(available_layers_count);
             vk_check(vkEnumerateInstanceLayerProperties(&available_layers_count, available_layers.data()));
 
-            // For each desired layer, rg_renderer_check if it is available
-            bool valid = true;
-            for (const auto &desired_layer : desired_layers)
+            // Check that each desired layer is available, and stop at the first missing one
+            for (size_t i = 0; i < desired_layer_count; i++)
             {
-                bool       found = false;
-                const auto layer = std::string(desired_layer);
-
-                // Search available layers until the desired one is found or not
+                bool found = false;
                 for (const auto &available_layer : available_layers)
                 {
-                    if (layer == std::string(available_layer.layerName))
+                    if (strcmp(desired_layers[i], available_layer.layerName) == 0)
                     {
                         found = true;
                         break;
                     }
                 }
 
-                // Stop looking if nothing was found
                 if (!found)
                 {
-                    valid = false;
-                    std::cerr << "[Error] The layer \"" << layer << "\" is not available.\n";
-                    break;
+                    VRE_LOG_ERROR("The layer \"{}\" is not available.", desired_layers[i]);
+                    return false;
                 }
             }
-
-            return valid;
+            return true;
         }
 
         /**
@@ -326,14 +658,13 @@ namespace vre
         {
             // Inspired by VkBootstrap's default debug messenger. (Made by Charles Giessen)
             // Get severity
-            const char *str_severity;
+            LogLevel level;
             switch (message_severity)
             {
-                case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT: str_severity = "VERBOSE"; break;
-                case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT: str_severity = "ERROR"; break;
-                case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT: str_severity = "WARNING"; break;
-                case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT: str_severity = "INFO"; break;
-                default: str_severity = "UNKNOWN"; break;
+                case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT: level = LogLevel::Trace; break;
+                case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT: level = LogLevel::Error; break;
+                case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT: level = LogLevel::Warning; break;
+                default: level = LogLevel::Info; break;
             }
 
             // Get type
@@ -350,9 +681,8 @@ namespace vre
                 default: str_type = "Unknown"; break;
             }
 
-            // Print the message to stderr if it is an error.
-            auto &output = message_severity == VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT ? std::cerr : std::cout;
-            output << "[Vulkan " << str_severity << ": " << str_type << "]\n" << callback_data->pMessage << "\n";
+            // The message is copied in the record, so the callback doesn't wait for the console
+            Logger::log(level, "[Vulkan: {}] {}", str_type, callback_data->pMessage);
 
             return VK_FALSE;
         }
@@ -366,7 +696,7 @@ namespace vre
             // Get the list of available formats
             uint32_t nb_available_formats = 0;
             xr_check(xrEnumerateSwapchainFormats(session, 0, &nb_available_formats, nullptr));
-            std::vector<int64_t> available_formats(nb_available_formats);
+            SmallVector<int64_t, INLINE_PROPERTY_COUNT> available_formats(nb_available_formats);
             xr_check(xrEnumerateSwapchainFormats(session, nb_available_formats, &nb_available_formats, available_formats.data()));
 
             // Define preferences
@@ -400,37 +730,42 @@ namespace vre
 
     // region Allocator
 
-    Allocator::Allocator(VkInstance       instance,
-                         VkDevice         device,
-                         VkPhysicalDevice physical_device,
-                         uint32_t         graphics_queue_family,
-                         uint32_t         transfer_queue_family)
+    Allocator::Allocator(VkInstance             instance,
+                         VkDevice               device,
+                         const VolkDeviceTable &device_table,
+                         VkPhysicalDevice       physical_device,
+                         uint32_t               graphics_queue_family,
+                         uint32_t               transfer_queue_family,
+                         uint32_t               compute_queue_family)
         : m_device(device),
+          m_device_table(&device_table),
           m_graphics_queue_family(graphics_queue_family),
-          m_transfer_queue_family(transfer_queue_family)
+          m_transfer_queue_family(transfer_queue_family),
+          m_compute_queue_family(compute_queue_family)
     {
+        // Device functions come from the device table, so VMA calls skip the loader trampolines too
         VmaVulkanFunctions vulkan_functions = {
             .vkGetPhysicalDeviceProperties           = vkGetPhysicalDeviceProperties,
             .vkGetPhysicalDeviceMemoryProperties     = vkGetPhysicalDeviceMemoryProperties,
-            .vkAllocateMemory                        = vkAllocateMemory,
-            .vkFreeMemory                            = vkFreeMemory,
-            .vkMapMemory                             = vkMapMemory,
-            .vkUnmapMemory                           = vkUnmapMemory,
-            .vkFlushMappedMemoryRanges               = vkFlushMappedMemoryRanges,
-            .vkInvalidateMappedMemoryRanges          = vkInvalidateMappedMemoryRanges,
-            .vkBindBufferMemory                      = vkBindBufferMemory,
-            .vkBindImageMemory                       = vkBindImageMemory,
-            .vkGetBufferMemoryRequirements           = vkGetBufferMemoryRequirements,
-            .vkGetImageMemoryRequirements            = vkGetImageMemoryRequirements,
-            .vkCreateBuffer                          = vkCreateBuffer,
-            .vkDestroyBuffer                         = vkDestroyBuffer,
-            .vkCreateImage                           = vkCreateImage,
-            .vkDestroyImage                          = vkDestroyImage,
-            .vkCmdCopyBuffer                         = vkCmdCopyBuffer,
-            .vkGetBufferMemoryRequirements2KHR       = vkGetBufferMemoryRequirements2KHR,
-            .vkGetImageMemoryRequirements2KHR        = vkGetImageMemoryRequirements2KHR,
-            .vkBindBufferMemory2KHR                  = vkBindBufferMemory2KHR,
-            .vkBindImageMemory2KHR                   = vkBindImageMemory2KHR,
+            .vkAllocateMemory                        = device_table.vkAllocateMemory,
+            .vkFreeMemory                            = device_table.vkFreeMemory,
+            .vkMapMemory                             = device_table.vkMapMemory,
+            .vkUnmapMemory                           = device_table.vkUnmapMemory,
+            .vkFlushMappedMemoryRanges               = device_table.vkFlushMappedMemoryRanges,
+            .vkInvalidateMappedMemoryRanges          = device_table.vkInvalidateMappedMemoryRanges,
+            .vkBindBufferMemory                      = device_table.vkBindBufferMemory,
+            .vkBindImageMemory                       = device_table.vkBindImageMemory,
+            .vkGetBufferMemoryRequirements           = device_table.vkGetBufferMemoryRequirements,
+            .vkGetImageMemoryRequirements            = device_table.vkGetImageMemoryRequirements,
+            .vkCreateBuffer                          = device_table.vkCreateBuffer,
+            .vkDestroyBuffer                         = device_table.vkDestroyBuffer,
+            .vkCreateImage                           = device_table.vkCreateImage,
+            .vkDestroyImage                          = device_table.vkDestroyImage,
+            .vkCmdCopyBuffer                         = device_table.vkCmdCopyBuffer,
+            .vkGetBufferMemoryRequirements2KHR       = device_table.vkGetBufferMemoryRequirements2KHR,
+            .vkGetImageMemoryRequirements2KHR        = device_table.vkGetImageMemoryRequirements2KHR,
+            .vkBindBufferMemory2KHR                  = device_table.vkBindBufferMemory2KHR,
+            .vkBindImageMemory2KHR                   = device_table.vkBindImageMemory2KHR,
             .vkGetPhysicalDeviceMemoryProperties2KHR = vkGetPhysicalDeviceMemoryProperties2KHR,
         };
         VmaAllocatorCreateInfo allocator_create_info = {
@@ -455,8 +790,10 @@ namespace vre
     Allocator::Allocator(Allocator &&other) noexcept
         : m_allocator(other.m_allocator),
           m_device(other.m_device),
+          m_device_table(other.m_device_table),
           m_graphics_queue_family(other.m_graphics_queue_family),
-          m_transfer_queue_family(other.m_transfer_queue_family)
+          m_transfer_queue_family(other.m_transfer_queue_family),
+          m_compute_queue_family(other.m_compute_queue_family)
     {
         other.m_allocator = VK_NULL_HANDLE;
     }
@@ -470,13 +807,30 @@ namespace vre
                 vmaDestroyAllocator(m_allocator);
                 m_allocator = VK_NULL_HANDLE;
             }
-            m_allocator       = other.m_allocator;
-            m_device          = other.m_device;
-            other.m_allocator = VK_NULL_HANDLE;
+            m_allocator             = other.m_allocator;
+            m_device                = other.m_device;
+            m_device_table          = other.m_device_table;
+            m_graphics_queue_family = other.m_graphics_queue_family;
+            m_transfer_queue_family = other.m_transfer_queue_family;
+            m_compute_queue_family  = other.m_compute_queue_family;
+            other.m_allocator       = VK_NULL_HANDLE;
         }
         return *this;
     }
 
+    uint32_t Allocator::concurrent_queue_families(uint32_t out_families[3]) const
+    {
+        uint32_t count = 0;
+        for (const auto family : {m_graphics_queue_family, m_transfer_queue_family, m_compute_queue_family})
+        {
+            if (std::find(out_families, out_families + count, family) == out_families + count)
+            {
+                out_families[count++] = family;
+            }
+        }
+        return count;
+    }
+
     AllocatedImage Allocator::create_image(VkFormat           image_format,
                                            VkExtent3D         image_extent,
                                            VkImageUsageFlags  image_usage,
@@ -510,15 +864,12 @@ namespace vre
         };
 
         // Sharing mode
-        if (concurrent && m_graphics_queue_family != m_transfer_queue_family)
+        uint32_t queue_families[3] = {};
+        if (const auto queue_family_count = concurrent_queue_families(queue_families); concurrent && queue_family_count > 1)
         {
-            image_create_info.sharingMode             = VK_SHARING_MODE_CONCURRENT;
-            const std::vector<uint32_t> queue_indices = {
-                m_graphics_queue_family,
-                m_transfer_queue_family,
-            };
-            image_create_info.pQueueFamilyIndices   = queue_indices.data();
-            image_create_info.queueFamilyIndexCount = static_cast<uint32_t>(queue_indices.size());
+            image_create_info.sharingMode           = VK_SHARING_MODE_CONCURRENT;
+            image_create_info.pQueueFamilyIndices   = queue_families;
+            image_create_info.queueFamilyIndexCount = queue_family_count;
         }
 
         VmaAllocationCreateInfo alloc_create_info = {
@@ -526,6 +877,9 @@ namespace vre
             .preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         };
 
+        static auto &allocation_metric = MetricsRegistry::global().counter("renderer.allocations");
+        allocation_metric.add();
+
         // Create the image
         vk_check(vmaCreateImage(m_allocator, &image_create_info, &alloc_create_info, &image.image, &image.allocation, nullptr),
                  "Failed to create image");
@@ -554,14 +908,15 @@ namespace vre
                     1,
                 },
         };
-        vk_check(vkCreateImageView(m_device, &image_view_create_info, nullptr, &image.image_view), "Failed to create image view");
+        vk_check(m_device_table->vkCreateImageView(m_device, &image_view_create_info, nullptr, &image.image_view),
+                 "Failed to create image view");
 
         return image;
     }
 
     void Allocator::destroy_image(AllocatedImage &image) const
     {
-        vkDestroyImageView(m_device, image.image_view, nullptr);
+        m_device_table->vkDestroyImageView(m_device, image.image_view, nullptr);
         if (image.allocation != VK_NULL_HANDLE)
         {
             vmaDestroyImage(m_allocator, image.image, image.allocation);
@@ -590,15 +945,12 @@ namespace vre
         };
 
         // Sharing mode
-        if (concurrent && m_graphics_queue_family != m_transfer_queue_family)
+        uint32_t queue_families[3] = {};
+        if (const auto queue_family_count = concurrent_queue_families(queue_families); concurrent && queue_family_count > 1)
         {
-            buffer_create_info.sharingMode            = VK_SHARING_MODE_CONCURRENT;
-            const std::vector<uint32_t> queue_indices = {
-                m_graphics_queue_family,
-                m_transfer_queue_family,
-            };
-            buffer_create_info.pQueueFamilyIndices   = queue_indices.data();
-            buffer_create_info.queueFamilyIndexCount = static_cast<uint32_t>(queue_indices.size());
+            buffer_create_info.sharingMode           = VK_SHARING_MODE_CONCURRENT;
+            buffer_create_info.pQueueFamilyIndices   = queue_families;
+            buffer_create_info.queueFamilyIndexCount = queue_family_count;
         }
 
         // Create an allocation info
@@ -606,6 +958,9 @@ namespace vre
             .usage = memory_usage,
         };
 
+        static auto &allocation_metric = MetricsRegistry::global().counter("renderer.allocations");
+        allocation_metric.add();
+
         // Create the buffer
         vk_check(vmaCreateBuffer(m_allocator,
                                  &buffer_create_info,
@@ -641,6 +996,11 @@ namespace vre
         vmaUnmapMemory(m_allocator, buffer.allocation);
     }
 
+    void Allocator::flush_buffer(AllocatedBuffer &buffer, size_t offset, size_t size) const
+    {
+        vk_check(vmaFlushAllocation(m_allocator, buffer.allocation, offset, size), "Failed to flush buffer");
+    }
+
     template<typename T>
     void VrRenderer::Data::copy_buffer_to_gpu(const T &src, AllocatedBuffer &dst, size_t offset)
     {
@@ -655,6 +1015,7 @@ namespace vre
 
         memcpy(data, &src, sizeof(T));
         allocator.unmap_buffer(dst);
+        upload_bytes_metric->add(sizeof(T));
     }
 
     size_t VrRenderer::Data::pad_uniform_buffer_size(size_t original_size) const
@@ -669,136 +1030,987 @@ namespace vre
         return aligned_size;
     }
 
+    size_t VrRenderer::Data::pad_storage_buffer_size(size_t original_size) const
+    {
+        const size_t &min_alignment = device_properties.limits.minStorageBufferOffsetAlignment;
+        size_t        aligned_size  = original_size;
+        if (min_alignment > 0)
+        {
+            aligned_size = (aligned_size + min_alignment - 1) & ~(min_alignment - 1);
+        }
+        return aligned_size;
+    }
+
     // endregion
 
-    // --=== API ===--
+    // region Descriptors
 
-    // region Init and shared pointer logic
+    DescriptorAllocator::DescriptorAllocator(VkDevice device, const VolkDeviceTable &device_table)
+        : m_device(device),
+          m_device_table(&device_table)
+    {
+    }
 
-    VrRenderer::VrRenderer(XrInstance      xr_instance,
-                           XrSystemId      xr_system_id,
-                           const Settings &settings,
-                           const Scene    &scene,
-                           Window         *mirror_window)
-        : m_data(new Data)
+    VkDescriptorPool DescriptorAllocator::create_pool()
     {
-        m_data->reference_count = 1;
-        if (mirror_window)
+        // Room for the descriptors of each type that the layouts allocated so far needed
+        SmallVector<VkDescriptorPoolSize, 8> pool_sizes;
+        for (const auto &type_count : m_set_counts.counts())
         {
-            m_data->mirror_window = *mirror_window;
+            if (type_count.count > 0)
+            {
+                pool_sizes.push_back({static_cast<VkDescriptorType>(type_count.type), type_count.count * m_sets_per_pool});
+            }
+        }
+        // A pool needs at least one size, even if the layouts have no descriptors
+        if (pool_sizes.empty())
+        {
+            pool_sizes.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, m_sets_per_pool});
         }
 
-        m_data->scene       = scene;
-        m_data->xr_instance = xr_instance;
-        m_data->system_id   = xr_system_id;
+        VkDescriptorPoolCreateInfo pool_create_info {
+            .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .pNext         = nullptr,
+            .flags         = 0,
+            .maxSets       = m_sets_per_pool,
+            .poolSizeCount = static_cast<uint32_t>(pool_sizes.size()),
+            .pPoolSizes    = pool_sizes.data(),
+        };
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        vk_check(m_device_table->vkCreateDescriptorPool(m_device, &pool_create_info, nullptr, &pool),
+                 "Failed to create descriptor pool");
+        m_pool_metric->add();
 
-        // Load XR functions
-        xr_check(xrGetInstanceProcAddr(xr_instance,
-                                       "xrGetVulkanGraphicsDevice2KHR",
-                                       reinterpret_cast<PFN_xrVoidFunction *>(&xrGetVulkanGraphicsDevice2KHR)),
-                 "Failed to load xrGetVulkanGraphicsDevice2KHR");
-        xr_check(xrGetInstanceProcAddr(xr_instance,
-                                       "xrCreateVulkanInstanceKHR",
-                                       reinterpret_cast<PFN_xrVoidFunction *>(&xrCreateVulkanInstanceKHR)),
-                 "Failed to load xrCreateVulkanInstanceKHR");
-        xr_check(xrGetInstanceProcAddr(xr_instance,
-                                       "xrCreateVulkanDeviceKHR",
-                                       reinterpret_cast<PFN_xrVoidFunction *>(&xrCreateVulkanDeviceKHR)),
-                 "Failed to load xrCreateVulkanDeviceKHR");
-        xr_check(xrGetInstanceProcAddr(xr_instance,
-                                       "xrGetVulkanGraphicsRequirements2KHR",
-                                       reinterpret_cast<PFN_xrVoidFunction *>(&xrGetVulkanGraphicsRequirements2KHR)),
-                 "Failed to load xrGetVulkanGraphicsRequirements2KHR");
+        m_sets_per_pool = std::min(m_sets_per_pool * 2, static_cast<uint32_t>(MAX_DESCRIPTOR_SETS_PER_POOL));
+        return pool;
+    }
 
-        // Get requirements
-        XrGraphicsRequirementsVulkanKHR graphics_requirements = {};
-        graphics_requirements.type                            = XR_TYPE_GRAPHICS_REQUIREMENTS_VULKAN_KHR;
-        xr_check(xrGetVulkanGraphicsRequirements2KHR(xr_instance, xr_system_id, &graphics_requirements),
-                 "Failed to get graphics requirements");
+    VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout, const DescriptorCounts &counts)
+    {
+        // The pools created from now on also have room for this layout
+        m_set_counts.include(counts);
+
+        VkDescriptorSetAllocateInfo allocate_info {
+            .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .pNext              = nullptr,
+            .descriptorPool     = VK_NULL_HANDLE,
+            .descriptorSetCount = 1,
+            .pSetLayouts        = &layout,
+        };
+        VkDescriptorSet set    = VK_NULL_HANDLE;
+        VkResult        result = VK_ERROR_OUT_OF_POOL_MEMORY;
 
-        auto vk_version = VK_MAKE_VERSION(XR_VERSION_MAJOR(graphics_requirements.maxApiVersionSupported),
-                                          XR_VERSION_MINOR(graphics_requirements.maxApiVersionSupported),
-                                          0);
-        std::cout << "Using Vulkan backend, version " << make_version(graphics_requirements.maxApiVersionSupported) << "\n";
+        // A full pool, or one sized before this layout was seen, is skipped. The new pool fits the layout, so this ends there.
+        while (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+        {
+            const bool is_new_pool = m_ready_pools.empty();
+            if (is_new_pool)
+            {
+                m_ready_pools.push_back(create_pool());
+            }
+            allocate_info.descriptorPool = m_ready_pools.back();
+            result                       = m_device_table->vkAllocateDescriptorSets(m_device, &allocate_info, &set);
+            if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+            {
+                m_full_pools.push_back(m_ready_pools.back());
+                m_ready_pools.pop_back();
+                if (is_new_pool)
+                {
+                    break;
+                }
+            }
+        }
+        // vk_check only logs a failure, in which case the set stays VK_NULL_HANDLE
+        vk_check(result, "Failed to allocate descriptor set");
+        return set;
+    }
 
-        // Initialize volk
-        vk_check(volkInitialize(), "Couldn't initialize Volk.");
+    void DescriptorAllocator::reset()
+    {
+        for (auto pool : m_ready_pools)
+        {
+            vk_check(m_device_table->vkResetDescriptorPool(m_device, pool, 0), "Failed to reset descriptor pool");
+        }
+        for (auto pool : m_full_pools)
+        {
+            vk_check(m_device_table->vkResetDescriptorPool(m_device, pool, 0), "Failed to reset descriptor pool");
+            m_ready_pools.push_back(pool);
+        }
+        m_full_pools.clear();
+    }
 
-        // region Instance creation
+    void DescriptorAllocator::destroy()
+    {
+        for (auto pool : m_ready_pools)
         {
-            // Set required extensions
-            uint32_t extra_extension_count = 0;
-#ifdef USE_VK_VALIDATION_LAYERS
-            extra_extension_count += 1;
-#endif
-            // Get the extensions that the window and XR system need
-            auto required_extensions = std::vector<const char *>();
+            m_device_table->vkDestroyDescriptorPool(m_device, pool, nullptr);
+        }
+        for (auto pool : m_full_pools)
+        {
+            m_device_table->vkDestroyDescriptorPool(m_device, pool, nullptr);
+        }
+        m_ready_pools.clear();
+        m_full_pools.clear();
+    }
 
-            if (m_data->mirror_window.is_valid())
+    namespace descriptor_utils
+    {
+        /** Key of a Vulkan handle in a map, whose keys can't be null. Non-dispatchable handles are not pointers on 32-bit targets. */
+        template<typename Handle>
+        inline uint64_t handle_key(Handle handle)
+        {
+            uint64_t key = 0;
+            memcpy(&key, &handle, sizeof(Handle));
+            return key;
+        }
+
+        inline bool is_buffer_descriptor(VkDescriptorType type)
+        {
+            switch (type)
             {
-                m_data->mirror_window.get_required_vulkan_extensions(required_extensions);
+                case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+                case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+                case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+                case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC: return true;
+                default: return false;
             }
+        }
+    } // namespace descriptor_utils
+    using namespace descriptor_utils;
 
-            // Add other extensions
-#ifdef USE_VK_VALIDATION_LAYERS
-            required_extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-#endif
+    VkDescriptorSetLayout VrRenderer::Data::descriptor_set_layout(const VkDescriptorSetLayoutBinding *bindings, uint32_t binding_count)
+    {
+        // The fields are added one by one, since the padding of the bindings is not initialized
+        DescriptorKey    key;
+        DescriptorCounts counts;
+        for (uint32_t i = 0; i < binding_count; i++)
+        {
+            const auto &binding = bindings[i];
+            key.add(binding.binding).add(binding.descriptorType).add(binding.descriptorCount).add(binding.stageFlags);
+            if (binding.pImmutableSamplers != nullptr)
+            {
+                key.add_bytes(binding.pImmutableSamplers, binding.descriptorCount * sizeof(VkSampler));
+            }
+            counts.add(binding.descriptorType, binding.descriptorCount);
+        }
+        if (const auto *layout = descriptors.layouts.get(key); layout != nullptr)
+        {
+            return *layout;
+        }
 
-            check(check_instance_extension_support(required_extensions), "Not all required Vulkan extensions are supported.");
+        VkDescriptorSetLayoutCreateInfo layout_create_info {
+            .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .pNext        = nullptr,
+            .flags        = 0,
+            .bindingCount = binding_count,
+            .pBindings    = bindings,
+        };
+        VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+        vk_check(device_table.vkCreateDescriptorSetLayout(device, &layout_create_info, nullptr, &layout),
+                 "Failed to create descriptor set layout");
+        descriptors.layouts.insert(std::move(key), layout);
+        descriptors.layout_counts.set(handle_key(layout), counts);
+        return layout;
+    }
 
-            // Get the validation layers if needed
-#ifdef USE_VK_VALIDATION_LAYERS
-            const std::vector<const char *> enabled_layers = {"VK_LAYER_KHRONOS_validation"};
-            check(check_layer_support(enabled_layers), "Vulkan validation layers requested, but not available.");
-#endif
+    const DescriptorCounts &VrRenderer::Data::layout_counts(VkDescriptorSetLayout layout) const
+    {
+        const auto *counts = descriptors.layout_counts.get(handle_key(layout));
+        check(counts != nullptr, "Descriptor set layout not created by the descriptor cache");
+        return *counts;
+    }
 
-            VkApplicationInfo application_info = {
-                // Struct infos
-                .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
-                .pNext = VK_NULL_HANDLE,
-                // Application infos
-                .pApplicationName   = settings.application_info.name,
-                .applicationVersion = VK_MAKE_VERSION(settings.application_info.version.major,
-                                                      settings.application_info.version.minor,
-                                                      settings.application_info.version.patch),
-                // Engine infos
-                .pEngineName   = ENGINE_NAME,
-                .engineVersion = VK_MAKE_VERSION(ENGINE_VERSION.major, ENGINE_VERSION.minor, ENGINE_VERSION.patch),
-                .apiVersion    = vk_version,
-            };
+    VkDescriptorSet VrRenderer::Data::persistent_descriptor_set(VkDescriptorSetLayout    layout,
+                                                                const DescriptorBinding *bindings,
+                                                                uint32_t                 binding_count)
+    {
+        // The fields are added one by one, since the padding of the bindings is not initialized
+        DescriptorKey key;
+        key.add(layout);
+        for (uint32_t i = 0; i < binding_count; i++)
+        {
+            const auto &binding = bindings[i];
+            key.add(binding.binding)
+                .add(binding.type)
+                .add(binding.buffer)
+                .add(binding.offset)
+                .add(binding.range)
+                .add(binding.image_view)
+                .add(binding.sampler)
+                .add(binding.image_layout);
+        }
+        if (const auto *set = descriptors.persistent_sets.get(key); set != nullptr)
+        {
+            return *set;
+        }
 
-            VkInstanceCreateInfo vk_instance_create_info {
-                // Struct infos
-                .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
-                .pNext = VK_NULL_HANDLE,
-                // App info
-                .pApplicationInfo = &application_info,
-            // Validation layers
-#ifdef USE_VK_VALIDATION_LAYERS
-                .enabledLayerCount   = static_cast<uint32_t>(enabled_layers.size()),
-                .ppEnabledLayerNames = enabled_layers.data(),
-#else
-                .enabledLayerCount   = 0,
-                .ppEnabledLayerNames = nullptr,
-#endif
-                // Extensions
-                .enabledExtensionCount   = static_cast<uint32_t>(required_extensions.size()),
-                .ppEnabledExtensionNames = required_extensions.data(),
-            };
+        const auto set = descriptors.persistent_allocator.allocate(layout, layout_counts(layout));
+        write_descriptor_set(set, bindings, binding_count);
+        descriptors.persistent_sets.insert(std::move(key), set);
+        return set;
+    }
 
-            XrVulkanInstanceCreateInfoKHR vulkan_instance_create_info {XR_TYPE_VULKAN_INSTANCE_CREATE_INFO_KHR};
-            vulkan_instance_create_info.systemId               = xr_system_id;
-            vulkan_instance_create_info.pfnGetInstanceProcAddr = vkGetInstanceProcAddr;
-            vulkan_instance_create_info.vulkanCreateInfo       = &vk_instance_create_info;
+    VkDescriptorSet VrRenderer::Data::transient_descriptor_set(uint32_t                 frame_index,
+                                                               VkDescriptorSetLayout    layout,
+                                                               const DescriptorBinding *bindings,
+                                                               uint32_t                 binding_count)
+    {
+        const auto set = frames[frame_index].descriptors.allocate(layout, layout_counts(layout));
+        write_descriptor_set(set, bindings, binding_count);
+        return set;
+    }
 
-            // Create instance
-            VkResult result;
-            xr_check(xrCreateVulkanInstanceKHR(xr_instance, &vulkan_instance_create_info, &m_data->vk_instance, &result),
-                     "Failed to create Vulkan instance");
-            vk_check(result);
+    void VrRenderer::Data::write_descriptor_set(VkDescriptorSet set, const DescriptorBinding *bindings, uint32_t binding_count)
+    {
+        // The infos are reserved up front, so that the writes can point to them
+        SmallVector<VkDescriptorBufferInfo, 8> buffer_infos;
+        SmallVector<VkDescriptorImageInfo, 8>  image_infos;
+        SmallVector<VkWriteDescriptorSet, 8>   writes;
+        buffer_infos.reserve(binding_count);
+        image_infos.reserve(binding_count);
+        for (uint32_t i = 0; i < binding_count; i++)
+        {
+            const auto &binding   = bindings[i];
+            const bool  is_buffer = is_buffer_descriptor(binding.type);
+            if (is_buffer)
+            {
+                buffer_infos.push_back({binding.buffer, binding.offset, binding.range});
+            }
+            else
+            {
+                image_infos.push_back({binding.sampler, binding.image_view, binding.image_layout});
+            }
+            writes.push_back(VkWriteDescriptorSet {
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .pNext           = nullptr,
+                .dstSet          = set,
+                .dstBinding      = binding.binding,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = binding.type,
+                .pImageInfo      = is_buffer ? nullptr : &image_infos.back(),
+                .pBufferInfo     = is_buffer ? &buffer_infos.back() : nullptr,
+            });
+        }
+        device_table.vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
 
-            // Register instance in Volk
-            volkLoadInstance(m_data->vk_instance);
+    // endregion
+
+    // region Pass scheduling
+
+    uint32_t VrRenderer::Data::add_compute_pass(const ComputePass &pass)
+    {
+        const auto index = static_cast<uint32_t>(compute_passes.size());
+        for (const auto dependency : pass.dependencies)
+        {
+            check(dependency < index, "A compute pass can only depend on the passes added before it");
+        }
+        compute_passes.push_back(pass);
+        return index;
+    }
+
+    VkCommandBuffer VrRenderer::Data::batch_command_buffer(uint32_t frame_index, PassQueue queue, uint32_t batch_index)
+    {
+        auto &frame           = frames[frame_index];
+        auto &command_buffers = frame.batch_command_buffers[static_cast<uint32_t>(queue)];
+        while (command_buffers.size() <= batch_index)
+        {
+            VkCommandBufferAllocateInfo command_buffer_allocate_info = {
+                .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .pNext              = VK_NULL_HANDLE,
+                .commandPool        = queue == PassQueue::COMPUTE ? frame.compute_command_pool : frame.command_pool,
+                .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                .commandBufferCount = 1,
+            };
+            VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+            vk_check(device_table.vkAllocateCommandBuffers(device, &command_buffer_allocate_info, &command_buffer),
+                     "Couldn't allocate pass batch command buffer");
+            command_buffers.push_back(command_buffer);
+        }
+        return command_buffers[batch_index];
+    }
+
+    void VrRenderer::Data::record_compute_passes(uint32_t frame_index, const PassBatch &batch, VkCommandBuffer command_buffer)
+    {
+        // The compute passes are scheduled first, so their index in the frame is the one in the list. The views come after them.
+        for (const auto pass : batch.passes)
+        {
+            if (pass < compute_passes.size())
+            {
+                (this->*compute_passes[pass].record)(frame_index, command_buffer);
+            }
+        }
+    }
+
+    void VrRenderer::Data::submit_batch(const PassBatch &batch, VkCommandBuffer command_buffer, VkFence fence)
+    {
+        const auto  queue_index = static_cast<uint32_t>(batch.queue);
+        const auto &queue       = batch.queue == PassQueue::COMPUTE ? compute_queue : graphics_queue;
+
+        // The results of the other queue are waited for at the first stages that can read them, so that the work before can start
+        const VkPipelineStageFlags wait_stage =
+            batch.queue == PassQueue::COMPUTE
+                ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+                : VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+                      | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        const auto wait_semaphore   = timeline_semaphores[(queue_index + 1) % PASS_QUEUE_COUNT];
+        const auto signal_semaphore = timeline_semaphores[queue_index];
+
+        // Without async compute, all the batches go to the graphics queue, which orders them by itself
+        const uint32_t                wait_count = batch.wait_value > 0 ? 1 : 0;
+        VkTimelineSemaphoreSubmitInfo timeline_submit_info {
+            .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .pNext                     = nullptr,
+            .waitSemaphoreValueCount   = wait_count,
+            .pWaitSemaphoreValues      = &batch.wait_value,
+            .signalSemaphoreValueCount = 1,
+            .pSignalSemaphoreValues    = &batch.signal_value,
+        };
+        VkSubmitInfo submit_info {
+            .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext                = async_compute ? &timeline_submit_info : nullptr,
+            .waitSemaphoreCount   = wait_count,
+            .pWaitSemaphores      = &wait_semaphore,
+            .pWaitDstStageMask    = &wait_stage,
+            .commandBufferCount   = 1,
+            .pCommandBuffers      = &command_buffer,
+            .signalSemaphoreCount = async_compute ? 1u : 0u,
+            .pSignalSemaphores    = &signal_semaphore,
+        };
+        vk_check(device_table.vkQueueSubmit(queue.queue, 1, &submit_info, fence), "Failed to submit pass batch");
+    }
+
+    // endregion
+
+    // region Render targets
+
+    void VrRenderer::Data::create_render_targets(XrSwapchain swapchain, VkExtent2D extent, RenderTargetList &out_render_targets)
+    {
+        VkImageViewCreateInfo image_view_create_info {
+            .sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .pNext    = nullptr,
+            .flags    = 0,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format   = xr_swapchain_format,
+            .components =
+                {
+                    .r = VK_COMPONENT_SWIZZLE_IDENTITY,
+                    .g = VK_COMPONENT_SWIZZLE_IDENTITY,
+                    .b = VK_COMPONENT_SWIZZLE_IDENTITY,
+                    .a = VK_COMPONENT_SWIZZLE_IDENTITY,
+                },
+            .subresourceRange =
+                {
+                    .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel   = 0,
+                    .levelCount     = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount     = 1,
+                },
+        };
+
+        VkFramebufferCreateInfo framebuffer_create_info {
+            .sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+            .pNext           = nullptr,
+            .flags           = 0,
+            .renderPass      = render_pass,
+            .attachmentCount = 1,
+            .layers          = 1,
+        };
+
+        // Get swapchain images
+        uint32_t nb_swapchain_images = 0;
+        xr_check(xrEnumerateSwapchainImages(swapchain, 0, &nb_swapchain_images, nullptr));
+        SmallVector<XrSwapchainImageVulkan2KHR, INLINE_SWAPCHAIN_IMAGE_COUNT> xr_images(nb_swapchain_images,
+                                                                             {XR_TYPE_SWAPCHAIN_IMAGE_VULKAN_KHR});
+        xr_check(xrEnumerateSwapchainImages(swapchain,
+                                            nb_swapchain_images,
+                                            &nb_swapchain_images,
+                                            reinterpret_cast<XrSwapchainImageBaseHeader *>(xr_images.data())));
+
+        // Create render targets
+        out_render_targets.reserve(nb_swapchain_images);
+
+        for (auto image : xr_images)
+        {
+            RenderTarget render_target {image.image};
+
+            // Create image view
+            image_view_create_info.image = render_target.image;
+            vk_check(device_table.vkCreateImageView(device, &image_view_create_info, nullptr, &render_target.image_view),
+                     "Failed to create Vulkan image view for XR swapchain image");
+
+            // Create framebuffer. Dynamic rendering takes the image view directly.
+            if (!dynamic_rendering)
+            {
+                framebuffer_create_info.pAttachments = &render_target.image_view;
+                framebuffer_create_info.width        = extent.width;
+                framebuffer_create_info.height       = extent.height;
+                vk_check(device_table.vkCreateFramebuffer(device, &framebuffer_create_info, nullptr, &render_target.framebuffer),
+                         "Failed to create Vulkan framebuffer for XR swapchain image");
+            }
+
+            // Save
+            out_render_targets.push_back(render_target);
+        }
+    }
+
+    void VrRenderer::Data::destroy_render_targets(RenderTargetList &render_targets)
+    {
+        for (auto &render_target : render_targets)
+        {
+            device_table.vkDestroyFramebuffer(device, render_target.framebuffer, nullptr);
+            device_table.vkDestroyImageView(device, render_target.image_view, nullptr);
+        }
+        render_targets.clear();
+    }
+
+    void VrRenderer::Data::begin_rendering(VkCommandBuffer     command_buffer,
+                                           const RenderTarget &render_target,
+                                           VkExtent2D          extent,
+                                           const VkClearValue &clear_value,
+                                           bool                secondary_commands)
+    {
+        render_pass_metric->add();
+        if (!dynamic_rendering)
+        {
+            VkRenderPassBeginInfo render_pass_begin_info {
+                .sType           = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+                .pNext           = nullptr,
+                .renderPass      = render_pass,
+                .framebuffer     = render_target.framebuffer,
+                .renderArea      = {{0, 0}, extent},
+                .clearValueCount = 1,
+                .pClearValues    = &clear_value,
+            };
+            device_table.vkCmdBeginRenderPass(command_buffer,
+                                              &render_pass_begin_info,
+                                              secondary_commands ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                                                                 : VK_SUBPASS_CONTENTS_INLINE);
+            return;
+        }
+
+        // The render pass did the transition of the image. The previous content is cleared, so it can be discarded.
+        VkImageMemoryBarrier barrier {
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext               = nullptr,
+            .srcAccessMask       = 0,
+            .dstAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout           = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = render_target.image,
+            .subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1},
+        };
+        device_table.vkCmdPipelineBarrier(command_buffer,
+                                          VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                          VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                          0,
+                                          0,
+                                          nullptr,
+                                          0,
+                                          nullptr,
+                                          1,
+                                          &barrier);
+
+        // OpenXR expects the images to be in the color attachment layout when they are released, which is the one they are rendered in
+        VkRenderingAttachmentInfoKHR color_attachment {
+            .sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
+            .pNext       = nullptr,
+            .imageView   = render_target.image_view,
+            .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .resolveMode = VK_RESOLVE_MODE_NONE,
+            .loadOp      = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp     = VK_ATTACHMENT_STORE_OP_STORE,
+            .clearValue  = clear_value,
+        };
+        VkRenderingInfoKHR rendering_info {
+            .sType                = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR,
+            .pNext                = nullptr,
+            .flags                = secondary_commands ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR : 0u,
+            .renderArea           = {{0, 0}, extent},
+            .layerCount           = 1,
+            .viewMask             = 0,
+            .colorAttachmentCount = 1,
+            .pColorAttachments    = &color_attachment,
+            .pDepthAttachment     = nullptr,
+            .pStencilAttachment   = nullptr,
+        };
+        device_table.vkCmdBeginRenderingKHR(command_buffer, &rendering_info);
+    }
+
+    void VrRenderer::Data::end_rendering(VkCommandBuffer command_buffer)
+    {
+        if (dynamic_rendering)
+        {
+            device_table.vkCmdEndRenderingKHR(command_buffer);
+        }
+        else
+        {
+            device_table.vkCmdEndRenderPass(command_buffer);
+        }
+    }
+
+    // endregion
+
+    // region Geometry
+
+    void VrRenderer::Data::upload_mesh(const Mesh &mesh, const void *vertices, const uint32_t *indices)
+    {
+        const auto vertex_bytes = static_cast<size_t>(mesh.vertices.size) * geometry.vertex_stride;
+        const auto index_bytes  = static_cast<size_t>(mesh.indices.size) * sizeof(uint32_t);
+
+        // Fill a host-visible staging buffer
+        auto  staging_buffer = allocator.create_buffer(vertex_bytes + index_bytes,
+                                                       VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                       VMA_MEMORY_USAGE_CPU_ONLY);
+        auto *staging_data   = static_cast<char *>(allocator.map_buffer(staging_buffer));
+        memcpy(staging_data, vertices, vertex_bytes);
+        memcpy(staging_data + vertex_bytes, indices, index_bytes);
+        allocator.unmap_buffer(staging_buffer);
+        upload_bytes_metric->add(vertex_bytes + index_bytes);
+
+        // Copy it to the pool
+        const auto &vk = device_table;
+
+        VkCommandBufferAllocateInfo command_buffer_allocate_info {
+            .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .pNext              = nullptr,
+            .commandPool        = geometry.upload_command_pool,
+            .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        };
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        vk_check(vk.vkAllocateCommandBuffers(device, &command_buffer_allocate_info, &command_buffer),
+                 "Failed to allocate upload command buffer");
+
+        VkCommandBufferBeginInfo command_buffer_begin_info {
+            .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .pNext            = nullptr,
+            .flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            .pInheritanceInfo = nullptr,
+        };
+        vk_check(vk.vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info), "Failed to begin upload command buffer");
+
+        const VkBufferCopy vertex_copy {
+            .srcOffset = 0,
+            .dstOffset = static_cast<VkDeviceSize>(mesh.vertices.offset) * geometry.vertex_stride,
+            .size      = vertex_bytes,
+        };
+        vk.vkCmdCopyBuffer(command_buffer, staging_buffer.buffer, geometry.vertex_buffer.buffer, 1, &vertex_copy);
+        const VkBufferCopy index_copy {
+            .srcOffset = vertex_bytes,
+            .dstOffset = static_cast<VkDeviceSize>(mesh.indices.offset) * sizeof(uint32_t),
+            .size      = index_bytes,
+        };
+        vk.vkCmdCopyBuffer(command_buffer, staging_buffer.buffer, geometry.index_buffer.buffer, 1, &index_copy);
+
+        vk_check(vk.vkEndCommandBuffer(command_buffer), "Failed to end upload command buffer");
+
+        // Meshes are created while loading, so a synchronous upload is enough
+        VkSubmitInfo submit_info {
+            .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext              = nullptr,
+            .commandBufferCount = 1,
+            .pCommandBuffers    = &command_buffer,
+        };
+        vk_check(vk.vkQueueSubmit(transfer_queue.queue, 1, &submit_info, VK_NULL_HANDLE), "Failed to submit mesh upload");
+        vk_check(vk.vkQueueWaitIdle(transfer_queue.queue), "Failed to wait for mesh upload");
+
+        vk.vkFreeCommandBuffers(device, geometry.upload_command_pool, 1, &command_buffer);
+        allocator.destroy_buffer(staging_buffer);
+    }
+
+    void VrRenderer::Data::release_meshes()
+    {
+        // The fence of the current frame was waited, so the frames up to current - NB_OVERLAPPING_FRAMES are done
+        auto &pending_releases = geometry.pending_releases;
+        if (pending_releases.empty())
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < pending_releases.size();)
+        {
+            if (pending_releases[i].frame_number + NB_OVERLAPPING_FRAMES <= current_frame_number + 1)
+            {
+                geometry.vertex_allocator.free(pending_releases[i].mesh.vertices);
+                geometry.index_allocator.free(pending_releases[i].mesh.indices);
+                pending_releases[i] = pending_releases.back();
+                pending_releases.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        geometry.used_vertices_metric->set(geometry.vertex_allocator.size() - geometry.vertex_allocator.free_space());
+        geometry.used_indices_metric->set(geometry.index_allocator.size() - geometry.index_allocator.free_space());
+    }
+
+    void VrRenderer::Data::write_frame_instances(uint32_t frame_index)
+    {
+        // Instances whose LOD changed move to another batch, so the LODs are selected before the batches are rebuilt
+        instance_batcher.select_lods(
+            [this](uint64_t mesh_id, const InstanceTransform &transform, uint32_t current_lod)
+            {
+                const auto *mesh = geometry.meshes.get(mesh_id);
+                if (mesh == nullptr)
+                {
+                    return current_lod;
+                }
+                const float position[3] = {transform.rows[0][3], transform.rows[1][3], transform.rows[2][3]};
+                // The largest scale of the axes, so that the error is never underestimated
+                return lod_selector.select(mesh->lods.data(),
+                                           static_cast<uint32_t>(mesh->lods.size()),
+                                           position,
+                                           max_axis_scale(transform),
+                                           current_lod);
+            });
+
+        // The batches are only rebuilt when instances were added, removed, or changed LOD
+        instance_batcher.update();
+        const auto instance_count = instance_batcher.instance_count();
+        check(instance_count <= instance_ring.capacity, "Too many instances for the instance ring");
+
+        const auto region_start = static_cast<size_t>(frame_index) * instance_ring.capacity;
+        // The quantized positions of cooked meshes are dequantized by the transforms of their instances
+        instance_batcher.write_instances(instance_ring.instances + region_start,
+                                         [this](uint64_t mesh_id) -> const MeshQuantization *
+                                         {
+                                             const auto *mesh = geometry.meshes.get(mesh_id);
+                                             return mesh != nullptr && mesh->is_quantized ? &mesh->quantization : nullptr;
+                                         });
+
+        // One instanced draw per batch. Batches whose mesh was destroyed are skipped.
+        auto &frame      = frames[frame_index];
+        frame.draw_count = 0;
+        for (const auto &batch : instance_batcher.batches())
+        {
+            const auto *mesh = geometry.meshes.get(batch.mesh);
+            if (mesh != nullptr)
+            {
+                instance_ring.draw_commands[region_start + frame.draw_count] = mesh->draw_command(batch.instance_count,
+                                                                                                   batch.first_instance,
+                                                                                                   batch.lod);
+                frame.draw_count++;
+            }
+        }
+
+        allocator.flush_buffer(instance_ring.instance_buffer,
+                               region_start * sizeof(InstanceTransform),
+                               instance_count * sizeof(InstanceTransform));
+        allocator.flush_buffer(instance_ring.indirect_buffer,
+                               region_start * sizeof(VkDrawIndexedIndirectCommand),
+                               frame.draw_count * sizeof(VkDrawIndexedIndirectCommand));
+        upload_bytes_metric->add(instance_count * sizeof(InstanceTransform) + frame.draw_count * sizeof(VkDrawIndexedIndirectCommand));
+        instance_ring.instance_metric->set(instance_count);
+        instance_ring.draw_metric->set(frame.draw_count);
+    }
+
+    void VrRenderer::Data::write_frame_lights(uint32_t frame_index, const XrView *views, uint32_t view_count)
+    {
+        VRE_ZONE("VrRenderer::Data::write_frame_lights");
+        check(view_count <= INLINE_VIEW_COUNT, "Too many views for the light ring");
+
+        // The grids follow the views, so the lights are binned again every frame
+        SmallVector<ClusterView, INLINE_VIEW_COUNT> cluster_views(view_count);
+        for (uint32_t view_i = 0; view_i < view_count; view_i++)
+        {
+            const auto &pose      = views[view_i].pose;
+            const auto &fov       = views[view_i].fov;
+            cluster_views[view_i] = {
+                .position    = {pose.position.x, pose.position.y, pose.position.z},
+                .orientation = {pose.orientation.x, pose.orientation.y, pose.orientation.z, pose.orientation.w},
+                .angle_left  = fov.angleLeft,
+                .angle_right = fov.angleRight,
+                .angle_up    = fov.angleUp,
+                .angle_down  = fov.angleDown,
+            };
+        }
+        light_clusterer.set_views(cluster_views.data(), view_count);
+
+        // The clusterer reads the lights many times, which would be slow from the write-combined memory of the ring
+        frame_lights.clear();
+        for (const auto &entry : lights)
+        {
+            frame_lights.push_back(entry.value());
+        }
+        const auto light_count = static_cast<uint32_t>(frame_lights.size());
+        check(light_count <= light_ring.max_light_count, "Too many lights for the light ring");
+        light_clusterer.bin_lights(frame_lights.data(), light_count);
+
+        const auto &grids    = light_clusterer.grids();
+        const auto &clusters = light_clusterer.clusters();
+        const auto &indices  = light_clusterer.light_indices();
+        check(clusters.size() <= light_ring.max_cluster_count && indices.size() <= light_ring.max_index_count,
+              "Too many clusters for the light ring");
+
+        // Write the parts of the region, and only flush what was written
+        const LightRingHeader header = {
+            .grid_count  = static_cast<uint32_t>(grids.size()),
+            .light_count = light_count,
+        };
+        const auto   region_start                   = static_cast<size_t>(frame_index) * light_ring.region_size;
+        auto        *region                         = light_ring.data + region_start;
+        const size_t written[LIGHT_RING_PART_COUNT] = {
+            sizeof(LightRingHeader) + grids.size() * sizeof(ClusterGrid),
+            clusters.size() * sizeof(LightCluster),
+            frame_lights.size() * sizeof(PointLight),
+            indices.size() * sizeof(uint32_t),
+        };
+        memcpy(region + light_ring.offsets[0], &header, sizeof(LightRingHeader));
+        memcpy(region + light_ring.offsets[0] + sizeof(LightRingHeader), grids.data(), grids.size() * sizeof(ClusterGrid));
+        memcpy(region + light_ring.offsets[1], clusters.data(), written[1]);
+        memcpy(region + light_ring.offsets[2], frame_lights.data(), written[2]);
+        memcpy(region + light_ring.offsets[3], indices.data(), written[3]);
+        for (uint32_t part = 0; part < LIGHT_RING_PART_COUNT; part++)
+        {
+            if (written[part] > 0)
+            {
+                allocator.flush_buffer(light_ring.buffer, region_start + light_ring.offsets[part], written[part]);
+            }
+            upload_bytes_metric->add(written[part]);
+        }
+        light_ring.light_metric->set(light_count);
+        light_ring.dropped_metric->add(light_clusterer.dropped_count());
+    }
+
+    VkCommandBuffer VrRenderer::Data::view_commands(uint32_t frame_index, uint32_t view_index)
+    {
+        auto &frame = frames[frame_index];
+
+        // Everything the commands are recorded with. The instances and the indirect draws are written in the buffers each frame, so
+        // they don't need a new recording.
+        const bool has_geometry    = !geometry.meshes.is_empty();
+        const auto instance_offset = static_cast<VkDeviceSize>(frame_index) * instance_ring.capacity * sizeof(InstanceTransform);
+        const auto hash            = ContentHash()
+                              .add(render_pass)
+                              .add(dynamic_rendering)
+                              .add(xr_swapchain_format)
+                              .add(has_geometry)
+                              .add(geometry.vertex_buffer.buffer)
+                              .add(geometry.index_buffer.buffer)
+                              .add(instance_ring.instance_buffer.buffer)
+                              .add(instance_offset)
+                              .value();
+        const auto lookup = frame.command_cache.lookup(CommandCache<VkCommandBuffer>::key(VIEW_PASS, view_index),
+                                                       hash,
+                                                       current_frame_number);
+        if (lookup.is_recorded)
+        {
+            command_replay_metric->add();
+            return *lookup.buffer;
+        }
+
+        VRE_ZONE("VrRenderer::Data::view_commands");
+        const auto &vk = device_table;
+        if (*lookup.buffer == VK_NULL_HANDLE)
+        {
+            VkCommandBufferAllocateInfo command_buffer_allocate_info = {
+                .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .pNext              = VK_NULL_HANDLE,
+                .commandPool        = frame.command_pool,
+                .level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                .commandBufferCount = 1,
+            };
+            vk_check(vk.vkAllocateCommandBuffers(device, &command_buffer_allocate_info, lookup.buffer),
+                     "Couldn't allocate secondary command buffer");
+        }
+
+        // The buffer is only executed in the render pass of the views, on any of their framebuffers. With dynamic rendering, it is
+        // compatible with any rendering that has the same attachment formats.
+        VkCommandBufferInheritanceRenderingInfoKHR inheritance_rendering_info {
+            .sType                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR,
+            .pNext                   = nullptr,
+            .flags                   = 0,
+            .viewMask                = 0,
+            .colorAttachmentCount    = 1,
+            .pColorAttachmentFormats = &xr_swapchain_format,
+            .depthAttachmentFormat   = VK_FORMAT_UNDEFINED,
+            .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+            .rasterizationSamples    = VK_SAMPLE_COUNT_1_BIT,
+        };
+        VkCommandBufferInheritanceInfo inheritance_info {
+            .sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+            .pNext       = dynamic_rendering ? &inheritance_rendering_info : nullptr,
+            .renderPass  = render_pass,
+            .subpass     = 0,
+            .framebuffer = VK_NULL_HANDLE,
+        };
+        VkCommandBufferBeginInfo command_buffer_begin_info {
+            .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .pNext            = nullptr,
+            .flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+            .pInheritanceInfo = &inheritance_info,
+        };
+        vk_check(vk.vkBeginCommandBuffer(*lookup.buffer, &command_buffer_begin_info), "Failed to begin secondary command buffer");
+
+        // The geometry buffers and the instances of the frame stay bound for the whole pass, whatever the mesh. The vertices are in
+        // binding 0, and the instance transforms in binding 1. The indirect commands of the batches are in the region of the frame in
+        // the indirect buffer, sorted by material, so that each material can draw its batches with a single
+        // vkCmdDrawIndexedIndirect once the material pipelines exist.
+        if (has_geometry)
+        {
+            const VkBuffer     vertex_buffers[]        = {geometry.vertex_buffer.buffer, instance_ring.instance_buffer.buffer};
+            const VkDeviceSize vertex_buffer_offsets[] = {0, instance_offset};
+            vk.vkCmdBindVertexBuffers(*lookup.buffer, 0, 2, vertex_buffers, vertex_buffer_offsets);
+            vk.vkCmdBindIndexBuffer(*lookup.buffer, geometry.index_buffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+        }
+
+        vk_check(vk.vkEndCommandBuffer(*lookup.buffer), "Failed to end secondary command buffer");
+        command_recording_metric->add();
+        return *lookup.buffer;
+    }
+
+    void VrRenderer::Data::clear_command_caches()
+    {
+        for (auto &frame : frames)
+        {
+            frame.command_cache.clear([&](VkCommandBuffer command_buffer)
+                                      { device_table.vkFreeCommandBuffers(device, frame.command_pool, 1, &command_buffer); });
+        }
+    }
+
+    // endregion
+
+    // --=== API ===--
+
+    // region Init and shared pointer logic
+
+    VrRenderer::VrRenderer(XrInstance      xr_instance,
+                           XrSystemId      xr_system_id,
+                           const Settings &settings,
+                           const Scene    &scene,
+                           Window         *mirror_window)
+        : m_data(new Data)
+    {
+        VRE_ZONE("VrRenderer::init");
+
+        m_data->reference_count = 1;
+        if (mirror_window)
+        {
+            m_data->mirror_window = *mirror_window;
+        }
+
+        m_data->scene       = scene;
+        m_data->xr_instance = xr_instance;
+        m_data->system_id   = xr_system_id;
+
+        // Load XR functions
+        xr_check(xrGetInstanceProcAddr(xr_instance,
+                                       "xrGetVulkanGraphicsDevice2KHR",
+                                       reinterpret_cast<PFN_xrVoidFunction *>(&xrGetVulkanGraphicsDevice2KHR)),
+                 "Failed to load xrGetVulkanGraphicsDevice2KHR");
+        xr_check(xrGetInstanceProcAddr(xr_instance,
+                                       "xrCreateVulkanInstanceKHR",
+                                       reinterpret_cast<PFN_xrVoidFunction *>(&xrCreateVulkanInstanceKHR)),
+                 "Failed to load xrCreateVulkanInstanceKHR");
+        xr_check(xrGetInstanceProcAddr(xr_instance,
+                                       "xrCreateVulkanDeviceKHR",
+                                       reinterpret_cast<PFN_xrVoidFunction *>(&xrCreateVulkanDeviceKHR)),
+                 "Failed to load xrCreateVulkanDeviceKHR");
+        xr_check(xrGetInstanceProcAddr(xr_instance,
+                                       "xrGetVulkanGraphicsRequirements2KHR",
+                                       reinterpret_cast<PFN_xrVoidFunction *>(&xrGetVulkanGraphicsRequirements2KHR)),
+                 "Failed to load xrGetVulkanGraphicsRequirements2KHR");
+
+        // Get requirements
+        XrGraphicsRequirementsVulkanKHR graphics_requirements = {};
+        graphics_requirements.type                            = XR_TYPE_GRAPHICS_REQUIREMENTS_VULKAN_KHR;
+        xr_check(xrGetVulkanGraphicsRequirements2KHR(xr_instance, xr_system_id, &graphics_requirements),
+                 "Failed to get graphics requirements");
+
+        auto vk_version = VK_MAKE_VERSION(XR_VERSION_MAJOR(graphics_requirements.maxApiVersionSupported),
+                                          XR_VERSION_MINOR(graphics_requirements.maxApiVersionSupported),
+                                          0);
+        const auto vulkan_version = make_version(graphics_requirements.maxApiVersionSupported);
+        VRE_LOG_INFO("Using Vulkan backend, version {}.{}.{}", vulkan_version.major, vulkan_version.minor, vulkan_version.patch);
+
+        // Initialize volk
+        vk_check(volkInitialize(), "Couldn't initialize Volk.");
+
+        // region Instance creation
+        {
+            // Set required extensions
+            uint32_t extra_extension_count = 0;
+#ifdef USE_VK_VALIDATION_LAYERS
+            extra_extension_count += 1;
+#endif
+            // Get the extensions that the window and XR system need
+            auto required_extensions = std::vector<const char *>();
+
+            if (m_data->mirror_window.is_valid())
+            {
+                m_data->mirror_window.get_required_vulkan_extensions(required_extensions);
+            }
+
+            // Add other extensions
+#ifdef USE_VK_VALIDATION_LAYERS
+            required_extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+#endif
+
+            check(check_instance_extension_support(required_extensions.data(), required_extensions.size()),
+                  "Not all required Vulkan extensions are supported.");
+
+            // Get the validation layers if needed
+#ifdef USE_VK_VALIDATION_LAYERS
+            const SmallVector<const char *, 4> enabled_layers = {"VK_LAYER_KHRONOS_validation"};
+            check(check_layer_support(enabled_layers.data(), enabled_layers.size()),
+                  "Vulkan validation layers requested, but not available.");
+#endif
+
+            VkApplicationInfo application_info = {
+                // Struct infos
+                .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+                .pNext = VK_NULL_HANDLE,
+                // Application infos
+                .pApplicationName   = settings.application_info.name,
+                .applicationVersion = VK_MAKE_VERSION(settings.application_info.version.major,
+                                                      settings.application_info.version.minor,
+                                                      settings.application_info.version.patch),
+                // Engine infos
+                .pEngineName   = ENGINE_NAME,
+                .engineVersion = VK_MAKE_VERSION(ENGINE_VERSION.major, ENGINE_VERSION.minor, ENGINE_VERSION.patch),
+                .apiVersion    = vk_version,
+            };
+
+            VkInstanceCreateInfo vk_instance_create_info {
+                // Struct infos
+                .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+                .pNext = VK_NULL_HANDLE,
+                // App info
+                .pApplicationInfo = &application_info,
+            // Validation layers
+#ifdef USE_VK_VALIDATION_LAYERS
+                .enabledLayerCount   = static_cast<uint32_t>(enabled_layers.size()),
+                .ppEnabledLayerNames = enabled_layers.data(),
+#else
+                .enabledLayerCount   = 0,
+                .ppEnabledLayerNames = nullptr,
+#endif
+                // Extensions
+                .enabledExtensionCount   = static_cast<uint32_t>(required_extensions.size()),
+                .ppEnabledExtensionNames = required_extensions.data(),
+            };
+
+            XrVulkanInstanceCreateInfoKHR vulkan_instance_create_info {XR_TYPE_VULKAN_INSTANCE_CREATE_INFO_KHR};
+            vulkan_instance_create_info.systemId               = xr_system_id;
+            vulkan_instance_create_info.pfnGetInstanceProcAddr = vkGetInstanceProcAddr;
+            vulkan_instance_create_info.vulkanCreateInfo       = &vk_instance_create_info;
+
+            // Create instance
+            VkResult result;
+            xr_check(xrCreateVulkanInstanceKHR(xr_instance, &vulkan_instance_create_info, &m_data->vk_instance, &result),
+                     "Failed to create Vulkan instance");
+            vk_check(result);
+
+            // Register instance in Volk. Device functions are loaded in a table once the device is created, so the global pointers
+            // are not loaded for them.
+            volkLoadInstanceOnly(m_data->vk_instance);
 
             // Create debug messenger
 #ifdef USE_VK_VALIDATION_LAYERS
@@ -838,12 +2050,12 @@ namespace vre
             // Log chosen GPU
             VkPhysicalDeviceProperties physical_device_properties;
             vkGetPhysicalDeviceProperties(m_data->physical_device, &physical_device_properties);
-            std::cout << "Suitable GPU found: " << physical_device_properties.deviceName << std::endl;
+            VRE_LOG_INFO("Suitable GPU found: {}", physical_device_properties.deviceName);
 
             // Get queue families
             uint32_t queue_family_properties_count = 0;
             vkGetPhysicalDeviceQueueFamilyProperties(m_data->physical_device, &queue_family_properties_count, VK_NULL_HANDLE);
-            std::vector<VkQueueFamilyProperties> queue_family_properties(queue_family_properties_count);
+            SmallVector<VkQueueFamilyProperties, INLINE_PROPERTY_COUNT> queue_family_properties(queue_family_properties_count);
             vkGetPhysicalDeviceQueueFamilyProperties(m_data->physical_device,
                                                      &queue_family_properties_count,
                                                      queue_family_properties.data());
@@ -893,11 +2105,72 @@ namespace vre
             // If we didn't find a graphics queue, we can't continue
             check(found_graphics_queue, "Unable to find a graphics queue family_index.");
 
+            // Timestamps are used to measure the GPU time of frames, but they are not required
+            m_data->timestamps_supported = queue_family_properties[m_data->graphics_queue.family_index].timestampValidBits > 0;
+
             // If we didn't find a transfer queue, we can't continue
             check(found_transfer_queue, "Unable to find a transfer queue family_index.");
 
             // Get GPU properties
             vkGetPhysicalDeviceProperties(m_data->physical_device, &m_data->device_properties);
+
+            // Dynamic rendering is optional. It is only used from Vulkan 1.2, where the extensions it depends on are core.
+            if (settings.rendering_settings.dynamic_rendering && vk_version >= VK_API_VERSION_1_2
+                && m_data->device_properties.apiVersion >= VK_API_VERSION_1_2)
+            {
+                const char *dynamic_rendering_extension = VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME;
+                if (check_device_extension_support(m_data->physical_device, &dynamic_rendering_extension, 1))
+                {
+                    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features {
+                        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR,
+                        .pNext = nullptr,
+                    };
+                    VkPhysicalDeviceFeatures2 features {
+                        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                        .pNext = &dynamic_rendering_features,
+                    };
+                    vkGetPhysicalDeviceFeatures2(m_data->physical_device, &features);
+                    m_data->dynamic_rendering = dynamic_rendering_features.dynamicRendering == VK_TRUE;
+                }
+            }
+            VRE_LOG_INFO("Rendering with {}", m_data->dynamic_rendering ? "dynamic rendering" : "a render pass");
+
+            // Async compute needs a family with compute but without graphics, whose queues the GPU schedules alongside the graphics
+            // one, and timeline semaphores to synchronize them, which are core from Vulkan 1.2. Otherwise, the compute passes run on
+            // the graphics queue.
+            m_data->compute_queue.family_index = m_data->graphics_queue.family_index;
+            if (settings.rendering_settings.async_compute && vk_version >= VK_API_VERSION_1_2
+                && m_data->device_properties.apiVersion >= VK_API_VERSION_1_2)
+            {
+                VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features {
+                    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+                    .pNext = nullptr,
+                };
+                VkPhysicalDeviceFeatures2 features {
+                    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                    .pNext = &timeline_semaphore_features,
+                };
+                vkGetPhysicalDeviceFeatures2(m_data->physical_device, &features);
+
+                bool found_compute_queue = false;
+                for (uint32_t i = 0; i < queue_family_properties_count && timeline_semaphore_features.timelineSemaphore; i++)
+                {
+                    const auto flags = queue_family_properties[i].queueFlags;
+                    if (flags & VK_QUEUE_COMPUTE_BIT && !(flags & VK_QUEUE_GRAPHICS_BIT))
+                    {
+                        m_data->compute_queue.family_index = i;
+                        found_compute_queue                = true;
+
+                        // Prefer a family that the uploads don't use
+                        if (i != m_data->transfer_queue.family_index)
+                        {
+                            break;
+                        }
+                    }
+                }
+                m_data->async_compute = found_compute_queue;
+            }
+            VRE_LOG_INFO("Compute passes run on {}", m_data->async_compute ? "an async compute queue" : "the graphics queue");
         }
         // endregion
 
@@ -907,59 +2180,83 @@ namespace vre
 
         {
             // Get required device extensions
-            std::vector<const char *> required_device_extensions;
+            SmallVector<const char *, 4> required_device_extensions;
 
             if (m_data->mirror_window.is_valid())
             {
                 required_device_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
             }
-
-            std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
-            queue_create_infos.reserve(2);
-
-            // Define the parameters for the graphics queue
-            std::vector<float> priorities;
-            priorities.reserve(2);
-            priorities.push_back(1.0f);
-
-            // Add the transfer queue if it is the same as the graphics one
-            if (m_data->graphics_queue.family_index == m_data->transfer_queue.family_index)
+            if (m_data->dynamic_rendering)
             {
-                priorities.push_back(0.7f);
+                required_device_extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+            }
+
+            // The queues are created in their families in this order. When a family doesn't have enough queues, the last ones share
+            // its last queue, in which case their submissions are serialized.
+            Queue *queues[] = {&m_data->graphics_queue, &m_data->transfer_queue, &m_data->compute_queue};
+            SmallVector<uint32_t, INLINE_PROPERTY_COUNT> family_queue_counts(queue_family_properties_count);
+            for (auto *queue : queues)
+            {
+                // Without async compute, the compute passes are submitted to the graphics queue itself
+                if (queue == &m_data->compute_queue && !m_data->async_compute)
+                {
+                    continue;
+                }
+                auto &family_queue_count = family_queue_counts[queue->family_index];
+                queue->index             = std::min(family_queue_count, queue_family_properties[queue->family_index].queueCount - 1);
+                family_queue_count       = queue->index + 1;
             }
-            queue_create_infos.push_back(VkDeviceQueueCreateInfo {
-                // Struct infos
-                .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-                .pNext = nullptr,
-                // Queue info
-                .queueFamilyIndex = m_data->graphics_queue.family_index,
-                .queueCount       = static_cast<uint32_t>(priorities.size()),
-                .pQueuePriorities = priorities.data(),
-            });
 
-            // Define the parameters for the transfer queue
-            float transfer_queue_priority = 1.0f;
-            if (m_data->graphics_queue.family_index != m_data->transfer_queue.family_index)
+            // The first queue of each family has the highest priority, so the graphics one goes first in its family
+            const float                             priorities[] = {1.0f, 0.7f, 0.7f};
+            SmallVector<VkDeviceQueueCreateInfo, 3> queue_create_infos;
+            for (uint32_t i = 0; i < queue_family_properties_count; i++)
             {
-                queue_create_infos.push_back(VkDeviceQueueCreateInfo {
-                    // Struct infos
-                    .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-                    .pNext = nullptr,
-                    // Queue info
-                    .queueFamilyIndex = m_data->transfer_queue.family_index,
-                    .queueCount       = 1,
-                    .pQueuePriorities = &transfer_queue_priority,
-                });
+                if (family_queue_counts[i] > 0)
+                {
+                    queue_create_infos.push_back(VkDeviceQueueCreateInfo {
+                        // Struct infos
+                        .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                        .pNext = nullptr,
+                        // Queue info
+                        .queueFamilyIndex = i,
+                        .queueCount       = family_queue_counts[i],
+                        .pQueuePriorities = priorities,
+                    });
+                }
             }
 
             // Create the logical device
             VkPhysicalDeviceFeatures features      = {};
             features.shaderStorageImageMultisample = VK_TRUE;
 
+            // The optional features are chained when they are used
+            void                                     *enabled_features = nullptr;
+            VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features {
+                .sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+                .pNext             = nullptr,
+                .timelineSemaphore = VK_TRUE,
+            };
+            if (m_data->async_compute)
+            {
+                timeline_semaphore_features.pNext = enabled_features;
+                enabled_features                  = &timeline_semaphore_features;
+            }
+            VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features {
+                .sType            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR,
+                .pNext            = nullptr,
+                .dynamicRendering = VK_TRUE,
+            };
+            if (m_data->dynamic_rendering)
+            {
+                dynamic_rendering_features.pNext = enabled_features;
+                enabled_features                 = &dynamic_rendering_features;
+            }
+
             VkDeviceCreateInfo vk_device_create_info = {
                 // Struct infos
                 .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-                .pNext = nullptr,
+                .pNext = enabled_features,
                 // Queue infos
                 .queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size()),
                 .pQueueCreateInfos    = queue_create_infos.data(),
@@ -987,21 +2284,16 @@ namespace vre
                      "Failed to create Vulkan device");
             vk_check(result);
 
-            // Load device in volk
-            volkLoadDevice(m_data->device);
+            // Load the device functions in a table, so that calls go directly to the driver instead of through the loader
+            // trampolines. Then wrap the loaded functions if the API trace is enabled.
+            volkLoadDeviceTable(&m_data->device_table, m_data->device);
+            install_vulkan_api_trace(m_data->device_table);
+            const auto &vk = m_data->device_table;
 
             // Get created queues
-            vkGetDeviceQueue(m_data->device, m_data->graphics_queue.family_index, 0, &m_data->graphics_queue.queue);
-            // Get the transfer queue. If it is the same as the graphics one, it will be a second queue on the same
-            // family
-            if (m_data->graphics_queue.family_index == m_data->transfer_queue.family_index)
+            for (auto *queue : queues)
             {
-                vkGetDeviceQueue(m_data->device, m_data->transfer_queue.family_index, 1, &m_data->transfer_queue.queue);
-            }
-            // Otherwise, it is in a different family, so the index is 0
-            else
-            {
-                vkGetDeviceQueue(m_data->device, m_data->transfer_queue.family_index, 0, &m_data->transfer_queue.queue);
+                vk.vkGetDeviceQueue(m_data->device, queue->family_index, queue->index, &queue->queue);
             }
         }
 
@@ -1011,9 +2303,67 @@ namespace vre
 
         m_data->allocator = std::move(Allocator(m_data->vk_instance,
                                                 m_data->device,
+                                                m_data->device_table,
                                                 m_data->physical_device,
                                                 m_data->graphics_queue.family_index,
-                                                m_data->transfer_queue.family_index));
+                                                m_data->transfer_queue.family_index,
+                                                m_data->compute_queue.family_index));
+
+        // --=== Geometry ===--
+
+        // region Geometry pool
+
+        {
+            const auto &geometry_settings = settings.geometry_settings;
+            auto       &geometry          = m_data->geometry;
+            geometry.vertex_stride        = geometry_settings.vertex_stride;
+
+            // Shared with the transfer queue, which uploads the meshes
+            geometry.vertex_buffer = m_data->allocator.create_buffer(
+                static_cast<size_t>(geometry_settings.max_vertex_count) * geometry_settings.vertex_stride,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VMA_MEMORY_USAGE_GPU_ONLY,
+                true);
+            geometry.index_buffer = m_data->allocator.create_buffer(
+                static_cast<size_t>(geometry_settings.max_index_count) * sizeof(uint32_t),
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VMA_MEMORY_USAGE_GPU_ONLY,
+                true);
+            geometry.vertex_allocator.reset(geometry_settings.max_vertex_count);
+            geometry.index_allocator.reset(geometry_settings.max_index_count);
+
+            VkCommandPoolCreateInfo upload_command_pool_create_info = {
+                .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .pNext            = VK_NULL_HANDLE,
+                .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                .queueFamilyIndex = m_data->transfer_queue.family_index,
+            };
+            vk_check(m_data->device_table.vkCreateCommandPool(m_data->device,
+                                                              &upload_command_pool_create_info,
+                                                              nullptr,
+                                                              &geometry.upload_command_pool),
+                     "Couldn't create upload command pool");
+
+            // The instance ring has a region per frame in flight, and stays mapped
+            auto &instance_ring    = m_data->instance_ring;
+            instance_ring.capacity = geometry_settings.max_instance_count;
+            instance_ring.instance_buffer =
+                m_data->allocator.create_buffer(static_cast<size_t>(NB_OVERLAPPING_FRAMES) * instance_ring.capacity
+                                                    * sizeof(InstanceTransform),
+                                                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                                VMA_MEMORY_USAGE_CPU_TO_GPU);
+            instance_ring.indirect_buffer =
+                m_data->allocator.create_buffer(static_cast<size_t>(NB_OVERLAPPING_FRAMES) * instance_ring.capacity
+                                                    * sizeof(VkDrawIndexedIndirectCommand),
+                                                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                                VMA_MEMORY_USAGE_CPU_TO_GPU);
+            instance_ring.instances =
+                static_cast<InstanceTransform *>(m_data->allocator.map_buffer(instance_ring.instance_buffer));
+            instance_ring.draw_commands =
+                static_cast<VkDrawIndexedIndirectCommand *>(m_data->allocator.map_buffer(instance_ring.indirect_buffer));
+        }
+
+        // endregion
 
         // --=== XR ===--
 
@@ -1040,6 +2390,12 @@ namespace vre
                 .flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
                 .queueFamilyIndex = m_data->graphics_queue.family_index,
             };
+            VkCommandPoolCreateInfo compute_command_pool_create_info = {
+                .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .pNext            = VK_NULL_HANDLE,
+                .flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                .queueFamilyIndex = m_data->compute_queue.family_index,
+            };
 
             VkFenceCreateInfo fence_create_info = {
                 .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
@@ -1053,13 +2409,35 @@ namespace vre
                 .flags = 0,
             };
 
+            VkQueryPoolCreateInfo query_pool_create_info = {
+                .sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                .pNext      = VK_NULL_HANDLE,
+                .flags      = 0,
+                .queryType  = VK_QUERY_TYPE_TIMESTAMP,
+                .queryCount = 2,
+            };
+
             // For each frame
+            const auto &vk                           = m_data->device_table;
+            m_data->descriptors.persistent_allocator = DescriptorAllocator(m_data->device, vk);
             for (auto &frame : m_data->frames)
             {
                 // Create command pool
-                vk_check(vkCreateCommandPool(m_data->device, &command_pool_create_info, nullptr, &frame.command_pool),
+                vk_check(vk.vkCreateCommandPool(m_data->device, &command_pool_create_info, nullptr, &frame.command_pool),
                          "Couldn't create command pool");
 
+                if (m_data->async_compute)
+                {
+                    vk_check(vk.vkCreateCommandPool(m_data->device,
+                                                    &compute_command_pool_create_info,
+                                                    nullptr,
+                                                    &frame.compute_command_pool),
+                             "Couldn't create compute command pool");
+                }
+
+                // The descriptor pools are created on the first allocations
+                frame.descriptors = DescriptorAllocator(m_data->device, vk);
+
                 // Create command buffers
                 VkCommandBufferAllocateInfo command_buffer_allocate_info = {
                     .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
@@ -1068,17 +2446,110 @@ namespace vre
                     .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
                     .commandBufferCount = 1,
                 };
-                vk_check(vkAllocateCommandBuffers(m_data->device, &command_buffer_allocate_info, &frame.command_buffer),
+                vk_check(vk.vkAllocateCommandBuffers(m_data->device, &command_buffer_allocate_info, &frame.command_buffer),
                          "Couldn't allocate command buffer");
 
                 // Create fence
-                vk_check(vkCreateFence(m_data->device, &fence_create_info, nullptr, &frame.render_fence), "Couldn't create fence");
+                vk_check(vk.vkCreateFence(m_data->device, &fence_create_info, nullptr, &frame.render_fence), "Couldn't create fence");
 
                 // Create semaphores
-                vk_check(vkCreateSemaphore(m_data->device, &semaphore_create_info, nullptr, &frame.image_available_semaphore),
+                vk_check(vk.vkCreateSemaphore(m_data->device, &semaphore_create_info, nullptr, &frame.image_available_semaphore),
                          "Couldn't create image available semaphore");
-                vk_check(vkCreateSemaphore(m_data->device, &semaphore_create_info, nullptr, &frame.render_finished_semaphore),
+                vk_check(vk.vkCreateSemaphore(m_data->device, &semaphore_create_info, nullptr, &frame.render_finished_semaphore),
                          "Couldn't create render semaphore");
+
+                // Create timestamp queries
+                if (m_data->timestamps_supported)
+                {
+                    vk_check(vk.vkCreateQueryPool(m_data->device, &query_pool_create_info, nullptr, &frame.timestamp_query_pool),
+                             "Couldn't create timestamp query pool");
+                }
+            }
+
+            // Create the timelines of the queues
+            if (m_data->async_compute)
+            {
+                VkSemaphoreTypeCreateInfo semaphore_type_create_info = {
+                    .sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+                    .pNext         = VK_NULL_HANDLE,
+                    .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+                    .initialValue  = 0,
+                };
+                VkSemaphoreCreateInfo timeline_semaphore_create_info = {
+                    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                    .pNext = &semaphore_type_create_info,
+                    .flags = 0,
+                };
+                for (auto &timeline_semaphore : m_data->timeline_semaphores)
+                {
+                    vk_check(vk.vkCreateSemaphore(m_data->device, &timeline_semaphore_create_info, nullptr, &timeline_semaphore),
+                             "Couldn't create timeline semaphore");
+                }
+            }
+        }
+
+        // endregion
+
+        // --=== Lights ===--
+
+        // region Light ring
+
+        {
+            const auto           &lighting_settings = settings.lighting_settings;
+            const ClusterSettings cluster_settings  = {
+                .max_lights_per_cluster = lighting_settings.max_lights_per_cluster,
+                .share_between_views    = lighting_settings.share_clusters_between_views,
+            };
+            m_data->light_clusterer = LightClusterer(cluster_settings);
+
+            // Room for a grid per view, in case they can't share one, each filled with lights
+            auto &light_ring             = m_data->light_ring;
+            light_ring.max_light_count   = lighting_settings.max_light_count;
+            light_ring.max_cluster_count = INLINE_VIEW_COUNT * cluster_settings.tile_count_x * cluster_settings.tile_count_y
+                                         * cluster_settings.slice_count;
+            light_ring.max_index_count   = light_ring.max_cluster_count * cluster_settings.max_lights_per_cluster;
+            light_ring.sizes[0]          = sizeof(LightRingHeader) + INLINE_VIEW_COUNT * sizeof(ClusterGrid);
+            light_ring.sizes[1]          = light_ring.max_cluster_count * sizeof(LightCluster);
+            light_ring.sizes[2]          = light_ring.max_light_count * sizeof(PointLight);
+            light_ring.sizes[3]          = static_cast<VkDeviceSize>(light_ring.max_index_count) * sizeof(uint32_t);
+            for (uint32_t part = 0; part < LIGHT_RING_PART_COUNT; part++)
+            {
+                light_ring.offsets[part] = light_ring.region_size;
+                light_ring.region_size   = m_data->pad_storage_buffer_size(light_ring.region_size + light_ring.sizes[part]);
+            }
+            light_ring.buffer = m_data->allocator.create_buffer(NB_OVERLAPPING_FRAMES * light_ring.region_size,
+                                                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                                VMA_MEMORY_USAGE_CPU_TO_GPU);
+            light_ring.data   = static_cast<uint8_t *>(m_data->allocator.map_buffer(light_ring.buffer));
+
+            // The regions don't move, so each frame binds its own with a set written once
+            VkDescriptorSetLayoutBinding layout_bindings[LIGHT_RING_PART_COUNT] = {};
+            for (uint32_t part = 0; part < LIGHT_RING_PART_COUNT; part++)
+            {
+                layout_bindings[part] = {
+                    .binding            = part,
+                    .descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .descriptorCount    = 1,
+                    .stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
+                    .pImmutableSamplers = nullptr,
+                };
+            }
+            light_ring.layout = m_data->descriptor_set_layout(layout_bindings, LIGHT_RING_PART_COUNT);
+            for (uint32_t frame_i = 0; frame_i < NB_OVERLAPPING_FRAMES; frame_i++)
+            {
+                DescriptorBinding bindings[LIGHT_RING_PART_COUNT] = {};
+                for (uint32_t part = 0; part < LIGHT_RING_PART_COUNT; part++)
+                {
+                    bindings[part] = {
+                        .binding = part,
+                        .type    = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                        .buffer  = light_ring.buffer.buffer,
+                        .offset  = frame_i * light_ring.region_size + light_ring.offsets[part],
+                        .range   = light_ring.sizes[part],
+                    };
+                }
+                m_data->frames[frame_i].light_descriptor_set =
+                    m_data->persistent_descriptor_set(light_ring.layout, bindings, LIGHT_RING_PART_COUNT);
             }
         }
 
@@ -1087,12 +2558,8 @@ namespace vre
         // --=== Scene ===--
 
         m_data->scene.bind_renderer(SceneRendererBinding {
-            .device = m_data->device,
-            .functions =
-                {
-                    .vkCreateShaderModule = vkCreateShaderModule,
-                    .vkDestroyShaderModule = vkDestroyShaderModule,
-                },
+            .device       = m_data->device,
+            .device_table = &m_data->device_table,
         });
     }
 
@@ -1156,22 +2623,52 @@ namespace vre
 
             if (m_data->reference_count == 0)
             {
+                const auto &vk = m_data->device_table;
                 for (auto &frame : m_data->frames)
                 {
-                    vkDestroySemaphore(m_data->device, frame.image_available_semaphore, nullptr);
-                    vkDestroySemaphore(m_data->device, frame.render_finished_semaphore, nullptr);
-                    vkDestroyFence(m_data->device, frame.render_fence, nullptr);
-                    vkFreeCommandBuffers(m_data->device, frame.command_pool, 1, &frame.command_buffer);
-                    vkDestroyCommandPool(m_data->device, frame.command_pool, nullptr);
+                    vk.vkDestroySemaphore(m_data->device, frame.image_available_semaphore, nullptr);
+                    vk.vkDestroySemaphore(m_data->device, frame.render_finished_semaphore, nullptr);
+                    vk.vkDestroyFence(m_data->device, frame.render_fence, nullptr);
+                    vk.vkFreeCommandBuffers(m_data->device, frame.command_pool, 1, &frame.command_buffer);
+                    vk.vkDestroyCommandPool(m_data->device, frame.command_pool, nullptr);
+                    vk.vkDestroyCommandPool(m_data->device, frame.compute_command_pool, nullptr);
+                    frame.descriptors.destroy();
+                    if (frame.timestamp_query_pool != VK_NULL_HANDLE)
+                    {
+                        vk.vkDestroyQueryPool(m_data->device, frame.timestamp_query_pool, nullptr);
+                    }
+                }
+
+                for (auto timeline_semaphore : m_data->timeline_semaphores)
+                {
+                    vk.vkDestroySemaphore(m_data->device, timeline_semaphore, nullptr);
                 }
 
                 // Destroy render pass
-                vkDestroyRenderPass(m_data->device, m_data->render_pass, nullptr);
+                vk.vkDestroyRenderPass(m_data->device, m_data->render_pass, nullptr);
+
+                // Destroy descriptors
+                m_data->descriptors.persistent_allocator.destroy();
+                for (const auto &entry : m_data->descriptors.layouts)
+                {
+                    vk.vkDestroyDescriptorSetLayout(m_data->device, entry.value, nullptr);
+                }
+
+                // Destroy geometry pool
+                vk.vkDestroyCommandPool(m_data->device, m_data->geometry.upload_command_pool, nullptr);
+                m_data->allocator.destroy_buffer(m_data->geometry.vertex_buffer);
+                m_data->allocator.destroy_buffer(m_data->geometry.index_buffer);
+                m_data->allocator.unmap_buffer(m_data->instance_ring.instance_buffer);
+                m_data->allocator.unmap_buffer(m_data->instance_ring.indirect_buffer);
+                m_data->allocator.destroy_buffer(m_data->instance_ring.instance_buffer);
+                m_data->allocator.destroy_buffer(m_data->instance_ring.indirect_buffer);
+                m_data->allocator.unmap_buffer(m_data->light_ring.buffer);
+                m_data->allocator.destroy_buffer(m_data->light_ring.buffer);
 
                 // Destroy allocator
                 m_data->allocator.~Allocator();
 
-                vkDestroyDevice(m_data->device, nullptr);
+                vk.vkDestroyDevice(m_data->device, nullptr);
 
 #ifdef USE_VK_VALIDATION_LAYERS
                 vkDestroyDebugUtilsMessengerEXT(m_data->vk_instance, m_data->debug_messenger, nullptr);
@@ -1202,12 +2699,28 @@ namespace vre
 
     void VrRenderer::init_vr_views(XrSession session) const
     {
+        VRE_ZONE("VrRenderer::init_vr_views");
+
         // Choose swapchain format
         m_data->xr_swapchain_format = choose_xr_swapchain_format(session);
 
         // --=== Render pass ===--
 
         // region Init render pass
+        if (m_data->dynamic_rendering)
+        {
+            // The attachments are given when recording, the pipelines only need their formats
+            m_data->pipeline_rendering_info = {
+                .sType                   = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR,
+                .pNext                   = nullptr,
+                .viewMask                = 0,
+                .colorAttachmentCount    = 1,
+                .pColorAttachmentFormats = &m_data->xr_swapchain_format,
+                .depthAttachmentFormat   = VK_FORMAT_UNDEFINED,
+                .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+            };
+        }
+        else
         {
             VkAttachmentDescription attachments[] = {
                 // Color attachment for XR views
@@ -1219,7 +2732,8 @@ namespace vre
                     .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
                     .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
                     .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
-                    .finalLayout    = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                    // OpenXR expects swapchain images to be in this layout when they are released
+                    .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
                 },
             };
 
@@ -1242,7 +2756,8 @@ namespace vre
                 .subpassCount    = 1,
                 .pSubpasses      = &subpass_description,
             };
-            vk_check(vkCreateRenderPass(m_data->device, &render_pass_create_info, nullptr, &m_data->render_pass),
+            const auto &vk = m_data->device_table;
+            vk_check(vk.vkCreateRenderPass(m_data->device, &render_pass_create_info, nullptr, &m_data->render_pass),
                      "Failed to create Vulkan render pass");
         }
         // endregion
@@ -1259,7 +2774,7 @@ namespace vre
                                                        0,
                                                        &nb_views,
                                                        nullptr));
-            std::vector<XrViewConfigurationView> view_configs(nb_views, {XR_TYPE_VIEW_CONFIGURATION_VIEW});
+            SmallVector<XrViewConfigurationView, INLINE_VIEW_COUNT> view_configs(nb_views, {XR_TYPE_VIEW_CONFIGURATION_VIEW});
             xr_check(xrEnumerateViewConfigurationViews(m_data->xr_instance,
                                                        m_data->system_id,
                                                        VIEW_CONFIGURATION_TYPE,
@@ -1282,38 +2797,6 @@ namespace vre
                 .mipCount    = 1, // No mipmaps
             };
 
-            VkImageViewCreateInfo image_view_create_info {
-                .sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-                .pNext    = nullptr,
-                .flags    = 0,
-                .viewType = VK_IMAGE_VIEW_TYPE_2D,
-                .format   = m_data->xr_swapchain_format,
-                .components =
-                    {
-                        .r = VK_COMPONENT_SWIZZLE_IDENTITY,
-                        .g = VK_COMPONENT_SWIZZLE_IDENTITY,
-                        .b = VK_COMPONENT_SWIZZLE_IDENTITY,
-                        .a = VK_COMPONENT_SWIZZLE_IDENTITY,
-                    },
-                .subresourceRange =
-                    {
-                        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-                        .baseMipLevel   = 0,
-                        .levelCount     = 1,
-                        .baseArrayLayer = 0,
-                        .layerCount     = 1,
-                    },
-            };
-
-            VkFramebufferCreateInfo framebuffer_create_info {
-                .sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-                .pNext           = nullptr,
-                .flags           = 0,
-                .renderPass      = m_data->render_pass,
-                .attachmentCount = 1,
-                .layers          = 1,
-            };
-
             for (uint32_t view_i = 0; view_i < nb_views; view_i++)
             {
                 VrView view = {
@@ -1330,37 +2813,8 @@ namespace vre
                 // Create swapchain
                 xr_check(xrCreateSwapchain(session, &swapchain_create_info, &view.xr_swapchain), "Failed to create OpenXR swapchain");
 
-                // Get swapchain images
-                uint32_t nb_swapchain_images = 0;
-                xr_check(xrEnumerateSwapchainImages(view.xr_swapchain, 0, &nb_swapchain_images, nullptr));
-                std::vector<XrSwapchainImageVulkan2KHR> xr_images(nb_swapchain_images, {XR_TYPE_SWAPCHAIN_IMAGE_VULKAN_KHR});
-                xr_check(xrEnumerateSwapchainImages(view.xr_swapchain,
-                                                    nb_swapchain_images,
-                                                    &nb_swapchain_images,
-                                                    reinterpret_cast<XrSwapchainImageBaseHeader *>(xr_images.data())));
-
                 // Create render targets
-                view.render_targets.reserve(nb_swapchain_images);
-
-                for (auto image : xr_images)
-                {
-                    RenderTarget render_target {image.image};
-
-                    // Create image view
-                    image_view_create_info.image = render_target.image;
-                    vk_check(vkCreateImageView(m_data->device, &image_view_create_info, nullptr, &render_target.image_view),
-                             "Failed to create Vulkan image view for XR swapchain image");
-
-                    // Create framebuffer
-                    framebuffer_create_info.pAttachments = &render_target.image_view;
-                    framebuffer_create_info.width        = view.swapchain_extent.width;
-                    framebuffer_create_info.height       = view.swapchain_extent.height;
-                    vk_check(vkCreateFramebuffer(m_data->device, &framebuffer_create_info, nullptr, &render_target.framebuffer),
-                             "Failed to create Vulkan framebuffer for XR swapchain image");
-
-                    // Save
-                    view.render_targets.push_back(render_target);
-                }
+                m_data->create_render_targets(view.xr_swapchain, view.swapchain_extent, view.render_targets);
 
                 // Save
                 m_data->views.push_back(view);
@@ -1372,19 +2826,26 @@ namespace vre
     void VrRenderer::wait_idle() const
     {
         // Wait
-        vk_check(vkDeviceWaitIdle(m_data->device), "Failed to wait for device to become idle");
+        vk_check(m_data->device_table.vkDeviceWaitIdle(m_data->device), "Failed to wait for device to become idle");
     }
 
     void VrRenderer::cleanup_vr_views() const
     {
+        // The cached commands were recorded for the render pass of the views
+        m_data->clear_command_caches();
+
+        // UI panels swapchains belong to the session too
+        for (auto &entry : m_data->ui_panels)
+        {
+            auto &panel = entry.value();
+            m_data->destroy_render_targets(panel.render_targets);
+            xr_check(xrDestroySwapchain(panel.xr_swapchain), "Failed to destroy UI panel swapchain");
+        }
+        m_data->ui_panels.clear();
+
         for (VrView &view : m_data->views)
         {
-            for (auto &render_target : view.render_targets)
-            {
-                vkDestroyFramebuffer(m_data->device, render_target.framebuffer, nullptr);
-                vkDestroyImageView(m_data->device, render_target.image_view, nullptr);
-            }
-            view.render_targets.clear();
+            m_data->destroy_render_targets(view.render_targets);
 
             if (view.xr_swapchain)
             {
@@ -1394,6 +2855,477 @@ namespace vre
         m_data->views.clear();
     }
 
+    uint32_t VrRenderer::view_count() const
+    {
+        return static_cast<uint32_t>(m_data->views.size());
+    }
+
+    double VrRenderer::last_gpu_frame_time() const
+    {
+        return m_data->last_gpu_frame_time;
+    }
+
+    void VrRenderer::publish_table_stats() const
+    {
+        m_data->geometry.meshes.stats().publish("renderer.meshes");
+        m_data->instance_batcher.instance_table_stats().publish("renderer.instances");
+        m_data->instance_batcher.batch_index_stats().publish("renderer.batch_indices");
+        m_data->lights.stats().publish("renderer.lights");
+        m_data->ui_panels.stats().publish("renderer.ui_panels");
+        m_data->descriptors.layout_counts.stats().publish("renderer.descriptor_layouts");
+    }
+
+    // endregion
+
+    // region Rendering
+
+    void VrRenderer::render_views(const XrView                     *views,
+                                  uint32_t                          view_count,
+                                  float                             resolution_scale,
+                                  float                             lod_bias,
+                                  XrCompositionLayerProjectionView *out_projection_views) const
+    {
+        VRE_ZONE("VrRenderer::render_views");
+
+        check(view_count <= m_data->views.size(), "More views were given than there are swapchains");
+
+        // Wait until the GPU is done with the frame that used the same resources
+        const auto &vk    = m_data->device_table;
+        const auto  frame_index = static_cast<uint32_t>(m_data->current_frame_number % NB_OVERLAPPING_FRAMES);
+        auto       &frame       = m_data->frames[frame_index];
+        vk_check(vk.vkWaitForFences(m_data->device, 1, &frame.render_fence, VK_TRUE, UINT64_MAX), "Failed to wait for render fence");
+        vk_check(vk.vkResetFences(m_data->device, 1, &frame.render_fence), "Failed to reset render fence");
+        m_data->release_meshes();
+        frame.descriptors.reset();
+        frame.command_cache.evict_unused(m_data->current_frame_number,
+                                         MAX_UNUSED_COMMAND_FRAMES,
+                                         [&](VkCommandBuffer command_buffer)
+                                         { vk.vkFreeCommandBuffers(m_data->device, frame.command_pool, 1, &command_buffer); });
+
+        // The LODs are selected from the resolution at which each view is rendered this frame
+        SmallVector<LodView, INLINE_VIEW_COUNT> lod_views(view_count);
+        for (uint32_t view_i = 0; view_i < view_count; view_i++)
+        {
+            const auto &extent = m_data->views[view_i].swapchain_extent;
+            const auto &pose   = views[view_i].pose.position;
+            const auto &fov    = views[view_i].fov;
+            lod_views[view_i]  = {
+                .position    = {pose.x, pose.y, pose.z},
+                .angle_left  = fov.angleLeft,
+                .angle_right = fov.angleRight,
+                .angle_up    = fov.angleUp,
+                .angle_down  = fov.angleDown,
+                .width       = std::max(1u, static_cast<uint32_t>(static_cast<float>(extent.width) * resolution_scale)),
+                .height      = std::max(1u, static_cast<uint32_t>(static_cast<float>(extent.height) * resolution_scale)),
+            };
+        }
+        m_data->lod_selector.set_views(lod_views.data(), view_count, lod_bias);
+        m_data->write_frame_instances(frame_index);
+        m_data->write_frame_lights(frame_index, views, view_count);
+
+        // The previous use of this frame is done, so its timestamps are available
+        if (frame.has_timestamps)
+        {
+            uint64_t timestamps[2] = {};
+            if (vk.vkGetQueryPoolResults(m_data->device,
+                                      frame.timestamp_query_pool,
+                                      0,
+                                      2,
+                                      sizeof(timestamps),
+                                      timestamps,
+                                      sizeof(uint64_t),
+                                      VK_QUERY_RESULT_64_BIT)
+                == VK_SUCCESS)
+            {
+                // Timestamp period is in nanoseconds per tick
+                const double ticks          = static_cast<double>(timestamps[1] - timestamps[0]);
+                m_data->last_gpu_frame_time = ticks * m_data->device_properties.limits.timestampPeriod * 1e-9;
+            }
+        }
+
+        // Begin recording
+        vk_check(vk.vkResetCommandBuffer(frame.command_buffer, 0), "Failed to reset command buffer");
+        VkCommandBufferBeginInfo command_buffer_begin_info {
+            .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .pNext            = nullptr,
+            .flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            .pInheritanceInfo = nullptr,
+        };
+
+        // Schedule the passes of the frame. The views read the results of all the compute passes, so they come last, in the last
+        // batch, which is recorded in the command buffer of the frame.
+        auto &scheduler = m_data->pass_scheduler;
+        scheduler.begin_frame(m_data->async_compute);
+        SmallVector<uint32_t, 8> view_dependencies;
+        for (const auto &pass : m_data->compute_passes)
+        {
+            view_dependencies.push_back(scheduler.add_pass(pass.async_compute ? PassQueue::COMPUTE : PassQueue::GRAPHICS,
+                                                           pass.dependencies.data(),
+                                                           static_cast<uint32_t>(pass.dependencies.size())));
+        }
+        scheduler.add_pass(PassQueue::GRAPHICS, view_dependencies.data(), static_cast<uint32_t>(view_dependencies.size()));
+
+        // Submit the batches before it. On the async compute queue, they overlap the rendering of the previous frame.
+        const auto &batches                        = scheduler.batches();
+        uint32_t    batch_counts[PASS_QUEUE_COUNT] = {};
+        for (size_t batch_i = 0; batch_i + 1 < batches.size(); batch_i++)
+        {
+            const auto &batch          = batches[batch_i];
+            const auto  command_buffer = m_data->batch_command_buffer(frame_index,
+                                                                     batch.queue,
+                                                                     batch_counts[static_cast<uint32_t>(batch.queue)]++);
+            vk_check(vk.vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info), "Failed to begin command buffer");
+            m_data->record_compute_passes(frame_index, batch, command_buffer);
+            vk_check(vk.vkEndCommandBuffer(command_buffer), "Failed to end command buffer");
+            m_data->submit_batch(batch, command_buffer, VK_NULL_HANDLE);
+        }
+
+        vk_check(vk.vkBeginCommandBuffer(frame.command_buffer, &command_buffer_begin_info), "Failed to begin command buffer");
+
+        if (m_data->timestamps_supported)
+        {
+            vk.vkCmdResetQueryPool(frame.command_buffer, frame.timestamp_query_pool, 0, 2);
+            vk.vkCmdWriteTimestamp(frame.command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.timestamp_query_pool, 0);
+        }
+
+        // The compute passes that run on the graphics queue right before the views
+        m_data->record_compute_passes(frame_index, batches.back(), frame.command_buffer);
+
+        XrSwapchainImageAcquireInfo acquire_info {
+            .type = XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO,
+            .next = XR_NULL_HANDLE,
+        };
+        XrSwapchainImageWaitInfo wait_info {
+            .type    = XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO,
+            .next    = XR_NULL_HANDLE,
+            .timeout = XR_INFINITE_DURATION,
+        };
+        VkClearValue clear_value {
+            .color = {{0.0f, 0.0f, 0.0f, 1.0f}},
+        };
+
+        // Render the UI panels whose content changed. The other ones keep their last released image.
+        for (auto &entry : m_data->ui_panels)
+        {
+            auto &panel = entry.value();
+            if (!panel.dirty)
+            {
+                continue;
+            }
+
+            uint32_t image_index = 0;
+            xr_check(xrAcquireSwapchainImage(panel.xr_swapchain, &acquire_info, &image_index), "Failed to acquire UI panel image");
+            {
+                VRE_API_CALL("xrWaitSwapchainImage", true);
+                xr_check(xrWaitSwapchainImage(panel.xr_swapchain, &wait_info), "Failed to wait for UI panel image");
+            }
+
+            // For now, the content of a panel is its background
+            const auto &render_target = panel.render_targets[image_index];
+            m_data->begin_rendering(frame.command_buffer, render_target, panel.extent, panel.background_color, false);
+            m_data->end_rendering(frame.command_buffer);
+        }
+
+        for (uint32_t view_i = 0; view_i < view_count; view_i++)
+        {
+            auto &view = m_data->views[view_i];
+            view.view  = views[view_i];
+
+            // Only render in a part of the swapchain image when the resolution is scaled down
+            const VkExtent2D render_extent {
+                std::max(1u, static_cast<uint32_t>(static_cast<float>(view.swapchain_extent.width) * resolution_scale)),
+                std::max(1u, static_cast<uint32_t>(static_cast<float>(view.swapchain_extent.height) * resolution_scale)),
+            };
+
+            // Get the next image of the swapchain
+            uint32_t image_index = 0;
+            xr_check(xrAcquireSwapchainImage(view.xr_swapchain, &acquire_info, &image_index), "Failed to acquire swapchain image");
+            {
+                VRE_API_CALL("xrWaitSwapchainImage", true);
+                xr_check(xrWaitSwapchainImage(view.xr_swapchain, &wait_info), "Failed to wait for swapchain image");
+            }
+
+            // Record the view. Its commands are replayed from the cache while they don't change.
+            const auto view_commands = m_data->view_commands(frame_index, view_i);
+            m_data->begin_rendering(frame.command_buffer, view.render_targets[image_index], render_extent, clear_value, true);
+            vk.vkCmdExecuteCommands(frame.command_buffer, 1, &view_commands);
+            m_data->end_rendering(frame.command_buffer);
+
+            // Describe where the compositor should find the view
+            out_projection_views[view_i] = XrCompositionLayerProjectionView {
+                .type = XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW,
+                .next = XR_NULL_HANDLE,
+                .pose = view.view.pose,
+                .fov  = view.view.fov,
+                .subImage =
+                    {
+                        .swapchain = view.xr_swapchain,
+                        .imageRect =
+                            {
+                                .offset = {0, 0},
+                                .extent =
+                                    {
+                                        static_cast<int32_t>(render_extent.width),
+                                        static_cast<int32_t>(render_extent.height),
+                                    },
+                            },
+                        .imageArrayIndex = 0,
+                    },
+            };
+        }
+
+        if (m_data->timestamps_supported)
+        {
+            vk.vkCmdWriteTimestamp(frame.command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestamp_query_pool, 1);
+            frame.has_timestamps = true;
+        }
+
+        vk_check(vk.vkEndCommandBuffer(frame.command_buffer), "Failed to end command buffer");
+
+        // Submit. The images must be released after the submission, since the runtime will use them right after. The fence also
+        // covers the compute passes, since the views waited for them.
+        m_data->submit_batch(batches.back(), frame.command_buffer, frame.render_fence);
+
+        XrSwapchainImageReleaseInfo release_info {
+            .type = XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO,
+            .next = XR_NULL_HANDLE,
+        };
+        for (uint32_t view_i = 0; view_i < view_count; view_i++)
+        {
+            xr_check(xrReleaseSwapchainImage(m_data->views[view_i].xr_swapchain, &release_info), "Failed to release swapchain image");
+        }
+        for (auto &entry : m_data->ui_panels)
+        {
+            auto &panel = entry.value();
+            if (panel.dirty)
+            {
+                xr_check(xrReleaseSwapchainImage(panel.xr_swapchain, &release_info), "Failed to release UI panel image");
+                panel.dirty       = false;
+                panel.has_content = true;
+            }
+        }
+
+        m_data->current_frame_number++;
+    }
+
+    // endregion
+
+    // region Meshes
+
+    uint64_t VrRenderer::create_mesh(const void             *vertices,
+                                     uint32_t                vertex_count,
+                                     const uint32_t         *indices,
+                                     uint32_t                index_count,
+                                     const MeshLod          *lods,
+                                     uint32_t                lod_count,
+                                     const MeshQuantization *quantization) const
+    {
+        check(vertex_count > 0 && index_count > 0, "A mesh needs vertices and indices");
+        check(lod_count <= MAX_MESH_LOD_COUNT, "Too many LODs");
+
+        // Without LODs, the whole index buffer is the only one
+        SmallVector<MeshLod, MAX_MESH_LOD_COUNT> mesh_lods;
+        if (lod_count == 0)
+        {
+            mesh_lods.push_back({.first_index = 0, .index_count = index_count, .error = 0.0f});
+        }
+        for (uint32_t i = 0; i < lod_count; i++)
+        {
+            check(lods[i].index_count > 0 && lods[i].first_index <= index_count
+                      && lods[i].index_count <= index_count - lods[i].first_index,
+                  "LOD out of the range of the indices");
+            mesh_lods.push_back(lods[i]);
+        }
+
+        auto &geometry = m_data->geometry;
+        Mesh  mesh     = {
+            .vertices     = geometry.vertex_allocator.allocate(vertex_count),
+            .indices      = geometry.index_allocator.allocate(index_count),
+            .lods         = mesh_lods,
+            .quantization = quantization == nullptr ? MeshQuantization {} : *quantization,
+            .is_quantized = quantization != nullptr,
+        };
+        if (!mesh.vertices.is_valid() || !mesh.indices.is_valid())
+        {
+            geometry.vertex_allocator.free(mesh.vertices);
+            geometry.index_allocator.free(mesh.indices);
+            check(false, "Not enough space left in the geometry pool");
+        }
+
+        m_data->upload_mesh(mesh, vertices, indices);
+        geometry.used_vertices_metric->set(geometry.vertex_allocator.size() - geometry.vertex_allocator.free_space());
+        geometry.used_indices_metric->set(geometry.index_allocator.size() - geometry.index_allocator.free_space());
+
+        return geometry.meshes.push(mesh);
+    }
+
+    void VrRenderer::destroy_mesh(uint64_t mesh_id) const
+    {
+        auto &geometry = m_data->geometry;
+        auto  mesh     = geometry.meshes.get(mesh_id);
+        if (mesh == nullptr)
+        {
+            return;
+        }
+
+        // The space is reused once the frames in flight are done with the mesh
+        geometry.pending_releases.push_back(PendingMeshRelease {
+            .mesh         = *mesh,
+            .frame_number = m_data->current_frame_number,
+        });
+        geometry.meshes.remove(mesh_id);
+    }
+
+    uint64_t VrRenderer::add_instance(uint64_t mesh_id, uint64_t material_id, const InstanceTransform &transform) const
+    {
+        check(m_data->geometry.meshes.exists(mesh_id), "Unknown mesh");
+        return m_data->instance_batcher.add_instance(mesh_id, material_id, transform);
+    }
+
+    void VrRenderer::remove_instance(uint64_t instance_id) const
+    {
+        m_data->instance_batcher.remove_instance(instance_id);
+    }
+
+    void VrRenderer::set_instance_transform(uint64_t instance_id, const InstanceTransform &transform) const
+    {
+        m_data->instance_batcher.set_transform(instance_id, transform);
+    }
+
+    // endregion
+
+    // region Lights
+
+    uint64_t VrRenderer::add_light(const PointLight &light) const
+    {
+        check(light.radius > 0.0f, "A light needs a positive radius");
+        check(m_data->lights.count() < m_data->light_ring.max_light_count, "Too many lights for the light ring");
+        return m_data->lights.push(light);
+    }
+
+    void VrRenderer::remove_light(uint64_t light_id) const
+    {
+        m_data->lights.remove(light_id);
+    }
+
+    void VrRenderer::set_light(uint64_t light_id, const PointLight &light) const
+    {
+        check(light.radius > 0.0f, "A light needs a positive radius");
+        auto *current = m_data->lights.get(light_id);
+        check(current != nullptr, "Unknown light");
+        *current = light;
+    }
+
+    // endregion
+
+    // region UI panels
+
+    uint64_t VrRenderer::create_ui_panel(XrSession session, const UiPanelSettings &settings) const
+    {
+        // The swapchain format is chosen by init_vr_views, with and without a render pass
+        check(m_data->xr_swapchain_format != VK_FORMAT_UNDEFINED, "VR views must be initialized before UI panels");
+
+        UiPanel panel {
+            .extent = {settings.resolution.width, settings.resolution.height},
+            .pose =
+                {
+                    .orientation = {settings.orientation[0], settings.orientation[1], settings.orientation[2], settings.orientation[3]},
+                    .position    = {settings.position[0], settings.position[1], settings.position[2]},
+                },
+            .size = {settings.width, settings.height},
+            .background_color =
+                {
+                    .color = {{
+                        settings.background_color[0],
+                        settings.background_color[1],
+                        settings.background_color[2],
+                        settings.background_color[3],
+                    }},
+                },
+        };
+
+        // Same format as the views, so that the same render pass can be used
+        XrSwapchainCreateInfo swapchain_create_info {
+            .type        = XR_TYPE_SWAPCHAIN_CREATE_INFO,
+            .next        = nullptr,
+            .createFlags = 0,
+            .usageFlags  = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT,
+            .format      = m_data->xr_swapchain_format,
+            .sampleCount = 1,
+            .width       = panel.extent.width,
+            .height      = panel.extent.height,
+            .faceCount   = 1,
+            .arraySize   = 1,
+            .mipCount    = 1,
+        };
+        xr_check(xrCreateSwapchain(session, &swapchain_create_info, &panel.xr_swapchain), "Failed to create UI panel swapchain");
+        m_data->create_render_targets(panel.xr_swapchain, panel.extent, panel.render_targets);
+
+        return m_data->ui_panels.push(std::move(panel));
+    }
+
+    void VrRenderer::destroy_ui_panel(uint64_t panel_id) const
+    {
+        auto panel = m_data->ui_panels.get(panel_id);
+        if (panel == nullptr)
+        {
+            return;
+        }
+
+        // The framebuffers may still be used by a frame in flight. Destroying panels is rare, so just wait.
+        wait_idle();
+
+        m_data->destroy_render_targets(panel->render_targets);
+        xr_check(xrDestroySwapchain(panel->xr_swapchain), "Failed to destroy UI panel swapchain");
+        m_data->ui_panels.remove(panel_id);
+    }
+
+    void VrRenderer::invalidate_ui_panel(uint64_t panel_id) const
+    {
+        auto panel = m_data->ui_panels.get(panel_id);
+        check(panel != nullptr, "Invalid UI panel");
+        panel->dirty = true;
+    }
+
+    uint32_t VrRenderer::ui_panel_count() const
+    {
+        return static_cast<uint32_t>(m_data->ui_panels.count());
+    }
+
+    uint32_t VrRenderer::fill_ui_layers(XrSpace space, XrCompositionLayerQuad *out_layers) const
+    {
+        uint32_t nb_layers = 0;
+        for (const auto &entry : m_data->ui_panels)
+        {
+            const auto &panel = entry.value();
+            if (!panel.has_content)
+            {
+                continue;
+            }
+
+            out_layers[nb_layers++] = XrCompositionLayerQuad {
+                .type          = XR_TYPE_COMPOSITION_LAYER_QUAD,
+                .next          = XR_NULL_HANDLE,
+                .layerFlags    = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT,
+                .space         = space,
+                .eyeVisibility = XR_EYE_VISIBILITY_BOTH,
+                .subImage =
+                    {
+                        .swapchain = panel.xr_swapchain,
+                        .imageRect =
+                            {
+                                .offset = {0, 0},
+                                .extent = {static_cast<int32_t>(panel.extent.width), static_cast<int32_t>(panel.extent.height)},
+                            },
+                        .imageArrayIndex = 0,
+                    },
+                .pose = panel.pose,
+                .size = panel.size,
+            };
+        }
+        return nb_layers;
+    }
+
     // endregion
 
 } // namespace vre
@@ -0,0 +1,143 @@
+#include "vr_engine/core/vr/frame_governor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vre
+{
+    // --=== Utils ===--
+
+    namespace frame_governor_utils
+    {
+        float lerp(float a, float b, float t)
+        {
+            return a + (b - a) * t;
+        }
+    } // namespace frame_governor_utils
+    using namespace frame_governor_utils;
+
+    // --=== PID controller ===--
+
+    float PidController::update(float error)
+    {
+        // Velocity form: the change of kp * e + ki * sum(e) + kd * delta(e) since the previous update
+        const float delta        = m_has_previous ? error - m_previous_error : 0.0f;
+        const float second_delta = m_has_previous ? delta - m_previous_delta : 0.0f;
+        m_previous_error         = error;
+        m_previous_delta         = delta;
+        m_has_previous           = true;
+
+        return m_kp * delta + m_ki * error + m_kd * second_delta;
+    }
+
+    void PidController::reset()
+    {
+        m_previous_error = 0.0f;
+        m_previous_delta = 0.0f;
+        m_has_previous   = false;
+    }
+
+    // --=== Frame governor ===--
+
+    FrameGovernor::FrameGovernor() : FrameGovernor(FrameGovernorSettings {}) {}
+
+    FrameGovernor::FrameGovernor(const FrameGovernorSettings &settings)
+        : m_settings(settings),
+          m_controller(settings.proportional_gain, settings.integral_gain, settings.derivative_gain),
+          m_quality(settings.max_quality)
+    {
+    }
+
+    void FrameGovernor::set_target_frame_time(double target_frame_time)
+    {
+        if (target_frame_time > 0.0 && target_frame_time != m_target_frame_time)
+        {
+            m_target_frame_time = target_frame_time;
+            // The accumulated error was relative to the old budget
+            m_controller.reset();
+        }
+    }
+
+    double FrameGovernor::headroom() const
+    {
+        const double frame_cost = std::max(m_cpu_time, m_gpu_time);
+        return 1.0 - frame_cost / m_target_frame_time;
+    }
+
+    void FrameGovernor::report_frame(double cpu_time, double gpu_time)
+    {
+        // Smooth the measures to ignore isolated spikes
+        if (m_frame_count == 0)
+        {
+            m_cpu_time = cpu_time;
+            m_gpu_time = gpu_time;
+        }
+        else
+        {
+            m_cpu_time += (cpu_time - m_cpu_time) * m_settings.smoothing;
+            m_gpu_time += (gpu_time - m_gpu_time) * m_settings.smoothing;
+        }
+        m_frame_count++;
+
+        // Positive error: we have more headroom than needed, so the quality can go up
+        const auto error = static_cast<float>(headroom()) - m_settings.target_headroom;
+
+        // The controller gives the change of the factor, so the clamping can't wind it up when the quality is saturated
+        m_quality_factor = std::clamp(m_quality_factor + m_controller.update(error), 0.0f, 1.0f);
+        update_quality_levels();
+    }
+
+    void FrameGovernor::update_quality_levels()
+    {
+        const auto &lo = m_settings.min_quality;
+        const auto &hi = m_settings.max_quality;
+        const float t  = m_quality_factor;
+
+        m_quality.resolution_scale = lerp(lo.resolution_scale, hi.resolution_scale, t);
+        m_quality.lod_bias         = lerp(lo.lod_bias, hi.lod_bias, t);
+        m_quality.shadow_distance  = lerp(lo.shadow_distance, hi.shadow_distance, t);
+        m_quality.foveation_level =
+            static_cast<uint32_t>(std::lround(lerp(static_cast<float>(lo.foveation_level), static_cast<float>(hi.foveation_level), t)));
+    }
+
+    uint32_t FrameGovernor::choose_refresh_rate(const float *available_rates, uint32_t rate_count, uint32_t current_rate_index)
+    {
+        if (rate_count == 0 || current_rate_index >= rate_count)
+        {
+            return current_rate_index;
+        }
+
+        // Let the quality settle before taking another decision
+        if (m_frame_count - m_last_rate_change < m_settings.refresh_rate_evaluation_interval)
+        {
+            return current_rate_index;
+        }
+
+        uint32_t chosen = current_rate_index;
+
+        if (m_quality_factor <= 0.0f && headroom() < 0.0)
+        {
+            // Even the lowest quality doesn't fit: lower the refresh rate
+            if (current_rate_index > 0)
+            {
+                chosen = current_rate_index - 1;
+            }
+        }
+        else if (m_quality_factor >= 1.0f && current_rate_index + 1 < rate_count)
+        {
+            // The full quality fits: check if it would still fit at the higher rate
+            const double frame_cost      = std::max(m_cpu_time, m_gpu_time);
+            const double next_frame_time = 1.0 / available_rates[current_rate_index + 1];
+            if (frame_cost < next_frame_time * (1.0 - m_settings.target_headroom))
+            {
+                chosen = current_rate_index + 1;
+            }
+        }
+
+        if (chosen != current_rate_index)
+        {
+            m_last_rate_change = m_frame_count;
+        }
+        return chosen;
+    }
+} // namespace vre
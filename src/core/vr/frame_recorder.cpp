@@ -0,0 +1,176 @@
+#include "vr_engine/core/vr/frame_recorder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace vre
+{
+    // --=== Utils ===--
+
+    namespace frame_recorder_utils
+    {
+        // Bump the version when the layout of a record changes
+        constexpr char     FILE_MAGIC[4] = {'V', 'R', 'E', 'R'};
+        constexpr uint32_t FILE_VERSION  = 1;
+
+        enum class RecordTag : uint8_t
+        {
+            FRAME = 1,
+            EVENT = 2,
+        };
+
+        template<typename T>
+        void write_value(FILE *file, const T &value)
+        {
+            fwrite(&value, sizeof(T), 1, file);
+        }
+
+        template<typename T>
+        bool read_value(FILE *file, T &value)
+        {
+            return fread(&value, sizeof(T), 1, file) == 1;
+        }
+    } // namespace frame_recorder_utils
+    using namespace frame_recorder_utils;
+
+    // --=== Recorder ===--
+
+    FrameRecorder::~FrameRecorder()
+    {
+        close();
+    }
+
+    bool FrameRecorder::open(const char *path)
+    {
+        close();
+
+        m_file = fopen(path, "wb");
+        if (m_file == nullptr)
+        {
+            return false;
+        }
+
+        fwrite(FILE_MAGIC, sizeof(FILE_MAGIC), 1, m_file);
+        write_value(m_file, FILE_VERSION);
+        return true;
+    }
+
+    void FrameRecorder::close()
+    {
+        if (m_file != nullptr)
+        {
+            fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    void FrameRecorder::record_frame(const RecordedFrame &frame)
+    {
+        if (m_file == nullptr)
+        {
+            return;
+        }
+
+        const auto view_count = std::min(frame.view_count, RecordedFrame::MAX_VIEWS);
+
+        write_value(m_file, RecordTag::FRAME);
+        write_value(m_file, frame.frame_index);
+        write_value(m_file, frame.predicted_display_time);
+        write_value(m_file, frame.predicted_display_period);
+        write_value(m_file, frame.view_state_flags);
+        write_value(m_file, view_count);
+        fwrite(frame.views, sizeof(RecordedView), view_count, m_file);
+    }
+
+    void FrameRecorder::record_event(const RecordedEvent &event)
+    {
+        if (m_file == nullptr)
+        {
+            return;
+        }
+
+        write_value(m_file, RecordTag::EVENT);
+        write_value(m_file, event);
+    }
+
+    // --=== Replayer ===--
+
+    FrameReplayer::~FrameReplayer()
+    {
+        close();
+    }
+
+    bool FrameReplayer::open(const char *path)
+    {
+        close();
+
+        m_file = fopen(path, "rb");
+        if (m_file == nullptr)
+        {
+            return false;
+        }
+
+        char     magic[sizeof(FILE_MAGIC)];
+        uint32_t version = 0;
+        if (fread(magic, sizeof(magic), 1, m_file) != 1 || memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0
+            || !read_value(m_file, version) || version != FILE_VERSION)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void FrameReplayer::close()
+    {
+        if (m_file != nullptr)
+        {
+            fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    bool FrameReplayer::next_frame(RecordedFrame &frame)
+    {
+        m_events.clear();
+        if (m_file == nullptr)
+        {
+            return false;
+        }
+
+        RecordTag tag;
+        while (read_value(m_file, tag))
+        {
+            if (tag == RecordTag::EVENT)
+            {
+                RecordedEvent event;
+                if (!read_value(m_file, event))
+                {
+                    break;
+                }
+                m_events.push_back(event);
+            }
+            else if (tag == RecordTag::FRAME)
+            {
+                frame = {};
+                if (!read_value(m_file, frame.frame_index) || !read_value(m_file, frame.predicted_display_time)
+                    || !read_value(m_file, frame.predicted_display_period) || !read_value(m_file, frame.view_state_flags)
+                    || !read_value(m_file, frame.view_count) || frame.view_count > RecordedFrame::MAX_VIEWS
+                    || fread(frame.views, sizeof(RecordedView), frame.view_count, m_file) != frame.view_count)
+                {
+                    break;
+                }
+                return true;
+            }
+            else
+            {
+                // Unknown record, the rest of the file can't be trusted
+                break;
+            }
+        }
+
+        // End of the file, or truncated record
+        close();
+        return false;
+    }
+} // namespace vre
@@ -1,22 +1,34 @@
 #include "vr_engine/core/vr/vr_system.h"
 
-#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
 #include <vr_engine/core/global.h>
 #include <vr_engine/core/scene.h>
+#include <vr_engine/core/vr/frame_governor.h>
+#include <vr_engine/core/vr/frame_recorder.h>
 #include <vr_engine/core/vr/vr_renderer.h>
+#include <vr_engine/utils/api_trace.h>
+#include <vr_engine/utils/data/small_vector.h>
 #include <vr_engine/utils/global_utils.h>
+#include <vr_engine/utils/log.h>
+#include <vr_engine/utils/metrics.h>
 #include <vr_engine/utils/openxr_utils.h>
-
-#ifndef _MSC_VER
-// Not used with MSVC
-#include <cstring>
-#endif
+#include <vr_engine/utils/profiler.h>
 
 namespace vre
 {
     // ---=== Constants ===---
 
-#define FORM_FACTOR XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY
+#define FORM_FACTOR             XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY
+#define VIEW_CONFIGURATION_TYPE XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO
+// Time to sleep between two event polls when the session is not running, to avoid a busy loop while the headset is off-face
+#define IDLE_POLL_INTERVAL_MS 10
+// Inline capacities of the small collections. Bigger ones still work, but are allocated on the heap.
+#define INLINE_VIEW_COUNT     2
+#define INLINE_LAYER_COUNT    8
+#define INLINE_PROPERTY_COUNT 32
 
     constexpr XrPosef XR_POSE_IDENTITY = {{0.f, 0.f, 0.f, 1.f}, {0.f, 0.f, 0.f}};
 
@@ -26,24 +38,65 @@ namespace vre
     PFN_xrCreateDebugUtilsMessengerEXT  xrCreateDebugUtilsMessengerEXT  = nullptr;
     PFN_xrDestroyDebugUtilsMessengerEXT xrDestroyDebugUtilsMessengerEXT = nullptr;
 #endif
+    PFN_xrEnumerateDisplayRefreshRatesFB xrEnumerateDisplayRefreshRatesFB = nullptr;
+    PFN_xrGetDisplayRefreshRateFB        xrGetDisplayRefreshRateFB        = nullptr;
+    PFN_xrRequestDisplayRefreshRateFB    xrRequestDisplayRefreshRateFB    = nullptr;
 
     // --=== Structs ===---
 
     struct VrSystem::Data
     {
-        uint8_t    reference_count = 0;
-        VrRenderer renderer        = {};
-        Scene      scene           = {};
+        uint8_t             reference_count      = 0;
+        VrRenderer          renderer             = {};
+        Scene               scene                = {};
+        PerformanceSettings performance_settings = {};
 
         XrInstance instance = XR_NULL_HANDLE;
 #ifdef USE_OPENXR_VALIDATION_LAYERS
         XrDebugUtilsMessengerEXT debug_messenger = XR_NULL_HANDLE;
 #endif
-        XrSystemId system_id       = XR_NULL_SYSTEM_ID;
-        XrSession  session         = XR_NULL_HANDLE;
-        bool       session_running = false;
+        XrSystemId             system_id       = XR_NULL_SYSTEM_ID;
+        XrSession              session         = XR_NULL_HANDLE;
+        XrSessionState         session_state   = XR_SESSION_STATE_UNKNOWN;
+        bool                   session_running = false;
+        XrEnvironmentBlendMode blend_mode      = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
 
         XrSpace reference_space = XR_NULL_HANDLE;
+
+        // Per-frame data, allocated once when the views are known
+        SmallVector<XrView, INLINE_VIEW_COUNT>                                views            = {};
+        SmallVector<XrCompositionLayerProjectionView, INLINE_VIEW_COUNT>      projection_views = {};
+        SmallVector<XrCompositionLayerQuad, INLINE_LAYER_COUNT>               ui_layers        = {};
+        SmallVector<const XrCompositionLayerBaseHeader *, INLINE_LAYER_COUNT> layers           = {};
+
+        // Performance
+        FrameGovernor         governor                   = {};
+        bool                  refresh_rate_ext_enabled   = false;
+        SmallVector<float, 8> available_refresh_rates    = {};
+        uint32_t              current_refresh_rate_index = 0;
+
+        // Record and replay
+        FrameRecorder recorder        = {};
+        FrameReplayer replayer        = {};
+        uint64_t      frame_index     = 0;
+        bool          replay_finished = false;
+
+        // Metrics
+        Histogram *wait_frame_time_metric = &MetricsRegistry::global().histogram("xr.wait_frame_ns");
+        Histogram *cpu_frame_time_metric  = &MetricsRegistry::global().histogram("xr.cpu_frame_ns");
+        Histogram *gpu_frame_time_metric  = &MetricsRegistry::global().histogram("renderer.gpu_frame_ns");
+        Gauge     *quality_factor_metric  = &MetricsRegistry::global().gauge("xr.quality_factor");
+        Gauge     *refresh_rate_metric    = &MetricsRegistry::global().gauge("xr.refresh_rate_hz");
+        Counter   *discarded_frame_metric = &MetricsRegistry::global().counter("xr.discarded_frames");
+
+        // --- Methods ---
+        void handle_session_state_change(const XrEventDataSessionStateChanged &event, bool &should_quit);
+        void init_refresh_rates();
+        void update_refresh_rate();
+        void resize_layer_arrays();
+        void record_event(RecordedEventType type, uint32_t value = 0, float from_rate = 0.0f, float to_rate = 0.0f);
+        void record_or_replay_views(const XrFrameState &frame_state, XrViewState &view_state, uint32_t nb_views);
+        void replay_events();
     };
 
     // ---=== Utils ===---
@@ -63,87 +116,121 @@ namespace vre
             }
         }
 
+        std::string xr_session_state_to_string(XrSessionState state)
+        {
+            switch (state)
+            {
+                case XR_SESSION_STATE_UNKNOWN: return "Unknown";
+                case XR_SESSION_STATE_IDLE: return "Idle";
+                case XR_SESSION_STATE_READY: return "Ready";
+                case XR_SESSION_STATE_SYNCHRONIZED: return "Synchronized";
+                case XR_SESSION_STATE_VISIBLE: return "Visible";
+                case XR_SESSION_STATE_FOCUSED: return "Focused";
+                case XR_SESSION_STATE_STOPPING: return "Stopping";
+                case XR_SESSION_STATE_LOSS_PENDING: return "Loss pending";
+                case XR_SESSION_STATE_EXITING: return "Exiting";
+                default: return std::to_string(state);
+            }
+        }
+
+        RecordedPose to_recorded_pose(const XrPosef &pose)
+        {
+            return RecordedPose {
+                .orientation = {pose.orientation.x, pose.orientation.y, pose.orientation.z, pose.orientation.w},
+                .position    = {pose.position.x, pose.position.y, pose.position.z},
+            };
+        }
+
+        XrPosef to_xr_pose(const RecordedPose &pose)
+        {
+            return XrPosef {
+                .orientation = {pose.orientation[0], pose.orientation[1], pose.orientation[2], pose.orientation[3]},
+                .position    = {pose.position[0], pose.position[1], pose.position[2]},
+            };
+        }
+
         // endregion
 
         // Check support
 
-        bool check_xr_instance_extension_support(const std::vector<const char *> &desired_extensions)
+        /** Fetches the instance extensions that the runtime supports. */
+        SmallVector<XrExtensionProperties, INLINE_PROPERTY_COUNT> get_available_xr_instance_extensions()
         {
-            // Get the number of available desired_extensions
             uint32_t available_extensions_count = 0;
             xr_check(xrEnumerateInstanceExtensionProperties(nullptr, 0, &available_extensions_count, nullptr));
-            // Create an array with enough room and fetch the available desired_extensions
-            std::vector<XrExtensionProperties> available_extensions(available_extensions_count, {XR_TYPE_EXTENSION_PROPERTIES});
+            SmallVector<XrExtensionProperties, INLINE_PROPERTY_COUNT> available_extensions(available_extensions_count,
+                                                                                           {XR_TYPE_EXTENSION_PROPERTIES});
             xr_check(xrEnumerateInstanceExtensionProperties(nullptr,
                                                             available_extensions_count,
                                                             &available_extensions_count,
                                                             available_extensions.data()));
+            return available_extensions;
+        }
 
-            // For each desired extension, rg_renderer_check if it is available
-            bool valid = true;
-            for (const auto &desired_extension : desired_extensions)
+        bool is_extension_in(const SmallVector<XrExtensionProperties, INLINE_PROPERTY_COUNT> &available_extensions,
+                             const char                                                      *extension)
+        {
+            for (const auto &available_extension : available_extensions)
             {
-                bool       found = false;
-                const auto ext   = std::string(desired_extension);
-
-                // Search available extensions until the desired one is found or not
-                for (const auto &available_extension : available_extensions)
+                if (strcmp(extension, available_extension.extensionName) == 0)
                 {
-                    if (ext == std::string(available_extension.extensionName))
-                    {
-                        found = true;
-                        break;
-                    }
+                    return true;
                 }
+            }
+            return false;
+        }
 
-                // Stop looking if nothing was found
-                if (!found)
+        bool check_xr_instance_extension_support(const char *const *desired_extensions, size_t desired_extension_count)
+        {
+            const auto available_extensions = get_available_xr_instance_extensions();
+
+            // Check that each desired extension is available, and stop at the first missing one
+            for (size_t i = 0; i < desired_extension_count; i++)
+            {
+                if (!is_extension_in(available_extensions, desired_extensions[i]))
                 {
-                    valid = false;
-                    std::cerr << "[Error] The extension \"" << ext << "\" is not available.\n";
-                    break;
+                    VRE_LOG_ERROR("The extension \"{}\" is not available.", desired_extensions[i]);
+                    return false;
                 }
             }
+            return true;
+        }
 
-            return valid;
+        bool is_xr_instance_extension_available(const char *extension)
+        {
+            return is_extension_in(get_available_xr_instance_extensions(), extension);
         }
 
-        bool check_layer_support(const std::vector<const char *> &desired_layers)
+        bool check_layer_support(const char *const *desired_layers, size_t desired_layer_count)
         {
             // Get the number of available API layers
             uint32_t available_layers_count = 0;
             xr_check(xrEnumerateApiLayerProperties(0, &available_layers_count, nullptr));
             // Create an array with enough room and fetch the available layers
-            std::vector<XrApiLayerProperties> available_layers(available_layers_count, {XR_TYPE_API_LAYER_PROPERTIES});
+            SmallVector<XrApiLayerProperties, INLINE_PROPERTY_COUNT> available_layers(available_layers_count,
+                                                                                      {XR_TYPE_API_LAYER_PROPERTIES});
             xr_check(xrEnumerateApiLayerProperties(available_layers_count, &available_layers_count, available_layers.data()));
 
-            // For each desired layer, rg_renderer_check if it is available
-            bool valid = true;
-            for (const auto &desired_layer : desired_layers)
+            // Check that each desired layer is available, and stop at the first missing one
+            for (size_t i = 0; i < desired_layer_count; i++)
             {
-                bool       found = false;
-                const auto layer = std::string(desired_layer);
-
-                // Search available layers until the desired one is found or not
+                bool found = false;
                 for (const auto &available_layer : available_layers)
                 {
-                    if (layer == std::string(available_layer.layerName))
+                    if (strcmp(desired_layers[i], available_layer.layerName) == 0)
                     {
                         found = true;
                         break;
                     }
                 }
 
-                // Stop looking if nothing was found
                 if (!found)
                 {
-                    valid = false;
-                    std::cerr << "[Error] The layer \"" << layer << "\" is not available.\n";
-                    break;
+                    VRE_LOG_ERROR("The layer \"{}\" is not available.", desired_layers[i]);
+                    return false;
                 }
             }
-
-            return valid;
+            return true;
         }
 
         XrReferenceSpaceType choose_reference_space_type(XrSession session)
@@ -157,7 +244,7 @@ namespace vre
             // Get available space types
             uint32_t available_spaces_count = 0;
             xr_check(xrEnumerateReferenceSpaces(session, 0, &available_spaces_count, nullptr));
-            std::vector<XrReferenceSpaceType> available_spaces(available_spaces_count);
+            SmallVector<XrReferenceSpaceType, 8> available_spaces(available_spaces_count);
             xr_check(xrEnumerateReferenceSpaces(session, available_spaces_count, &available_spaces_count, available_spaces.data()));
 
             // Choose the first available space type
@@ -176,6 +263,23 @@ namespace vre
             throw;
         }
 
+        XrEnvironmentBlendMode choose_environment_blend_mode(XrInstance instance, XrSystemId system_id)
+        {
+            // Get available blend modes. The runtime lists them in order of preference.
+            uint32_t available_modes_count = 0;
+            xr_check(xrEnumerateEnvironmentBlendModes(instance, system_id, VIEW_CONFIGURATION_TYPE, 0, &available_modes_count, nullptr));
+            SmallVector<XrEnvironmentBlendMode, 4> available_modes(available_modes_count);
+            xr_check(xrEnumerateEnvironmentBlendModes(instance,
+                                                      system_id,
+                                                      VIEW_CONFIGURATION_TYPE,
+                                                      available_modes_count,
+                                                      &available_modes_count,
+                                                      available_modes.data()));
+
+            check(!available_modes.empty(), "No supported environment blend mode found.");
+            return available_modes[0];
+        }
+
         // endregion
 
         // region Debug utils
@@ -194,14 +298,13 @@ namespace vre
         {
             // Inspired by VkBootstrap's default debug messenger. (Made by Charles Giessen)
             // Get severity
-            const char *str_severity;
+            LogLevel level;
             switch (message_severity)
             {
-                case XR_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT: str_severity = "VERBOSE"; break;
-                case XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT: str_severity = "ERROR"; break;
-                case XR_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT: str_severity = "WARNING"; break;
-                case XR_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT: str_severity = "INFO"; break;
-                default: str_severity = "UNKNOWN"; break;
+                case XR_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT: level = LogLevel::Trace; break;
+                case XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT: level = LogLevel::Error; break;
+                case XR_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT: level = LogLevel::Warning; break;
+                default: level = LogLevel::Info; break;
             }
 
             // Get type
@@ -218,15 +321,29 @@ namespace vre
                 default: str_type = "Unknown"; break;
             }
 
-            // Print the message to stderr if it is an error.
-            auto &output = message_severity == XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT ? std::cerr : std::cout;
-            output << "[OpenXR " << str_severity << ": " << str_type << "]\n" << callback_data->message << "\n";
+            // The message is copied in the record, so the callback doesn't wait for the console
+            Logger::log(level, "[OpenXR: {}] {}", str_type, callback_data->message);
 
             return XR_FALSE;
         }
 
         // endregion
 
+        /**
+         * Logs the failure of a call of the frame loop. Their success codes other than XR_SUCCESS, such as XR_FRAME_DISCARDED and
+         * XR_SESSION_LOSS_PENDING, are part of the normal flow and are handled by the caller.
+         * @return true if the call succeeded
+         */
+        bool frame_call_succeeded(XrResult result, const char *error_message)
+        {
+            if (XR_FAILED(result))
+            {
+                xr_check(result, error_message);
+                return false;
+            }
+            return true;
+        }
+
     } // namespace xr
     using namespace xr;
 
@@ -234,11 +351,13 @@ namespace vre
 
     VrSystem::VrSystem(const Settings &settings, const Scene &scene)
         : m_data(new Data {
-            .reference_count = 1,
-            .scene = scene,
+            .reference_count      = 1,
+            .scene                = scene,
+            .performance_settings = settings.performance_settings,
         })
     {
-        std::cout << "Using OpenXR, version " << make_version(XR_CURRENT_API_VERSION) << "\n";
+        const auto openxr_version = make_version(XR_CURRENT_API_VERSION);
+        VRE_LOG_INFO("Using OpenXR, version {}.{}.{}", openxr_version.major, openxr_version.minor, openxr_version.patch);
 
         // === Create instance ===
         {
@@ -257,19 +376,28 @@ namespace vre
 #endif
 
             // Create instance
-            std::vector<const char *> required_extensions = {
+            SmallVector<const char *, 4> required_extensions = {
 #ifdef USE_OPENXR_VALIDATION_LAYERS
                 XR_EXT_DEBUG_UTILS_EXTENSION_NAME,
 #endif
                 VrRenderer::get_required_openxr_extension(),
             };
 
-            check(check_xr_instance_extension_support(required_extensions), "Not all required OpenXR extensions are supported.");
+            check(check_xr_instance_extension_support(required_extensions.data(), required_extensions.size()),
+                  "Not all required OpenXR extensions are supported.");
+
+            // Optional extensions. A replay also changes the refresh rate, as in the recording.
+            if ((settings.performance_settings.adaptive_refresh_rate || settings.performance_settings.replay_path != nullptr)
+                && is_xr_instance_extension_available(XR_FB_DISPLAY_REFRESH_RATE_EXTENSION_NAME))
+            {
+                required_extensions.push_back(XR_FB_DISPLAY_REFRESH_RATE_EXTENSION_NAME);
+                m_data->refresh_rate_ext_enabled = true;
+            }
 
 #ifdef USE_OPENXR_VALIDATION_LAYERS
-            std::vector<const char *> enabled_layers;
-            enabled_layers.push_back("XR_APILAYER_LUNARG_core_validation");
-            check(check_layer_support(enabled_layers), "OpenXR validation layers requested, but not available.");
+            const SmallVector<const char *, 4> enabled_layers = {"XR_APILAYER_LUNARG_core_validation"};
+            check(check_layer_support(enabled_layers.data(), enabled_layers.size()),
+                  "OpenXR validation layers requested, but not available.");
 #endif
 
             XrInstanceCreateInfo instance_create_info {
@@ -296,8 +424,12 @@ namespace vre
             };
             xr_check(xrGetInstanceProperties(m_data->instance, &instance_properties), "Failed to get instance properties");
 
-            std::cout << "Using runtime \"" << instance_properties.runtimeName << "\", version "
-                      << make_version(instance_properties.runtimeVersion) << "\n";
+            const auto runtime_version = make_version(instance_properties.runtimeVersion);
+            VRE_LOG_INFO("Using runtime \"{}\", version {}.{}.{}",
+                         instance_properties.runtimeName,
+                         runtime_version.major,
+                         runtime_version.minor,
+                         runtime_version.patch);
         }
 
         // === Load dynamic functions ===
@@ -312,6 +444,21 @@ namespace vre
                                            reinterpret_cast<PFN_xrVoidFunction *>(&xrDestroyDebugUtilsMessengerEXT)),
                      "Failed to load xrDestroyDebugUtilsMessengerEXT");
 #endif
+            if (m_data->refresh_rate_ext_enabled)
+            {
+                xr_check(xrGetInstanceProcAddr(m_data->instance,
+                                               "xrEnumerateDisplayRefreshRatesFB",
+                                               reinterpret_cast<PFN_xrVoidFunction *>(&xrEnumerateDisplayRefreshRatesFB)),
+                         "Failed to load xrEnumerateDisplayRefreshRatesFB");
+                xr_check(xrGetInstanceProcAddr(m_data->instance,
+                                               "xrGetDisplayRefreshRateFB",
+                                               reinterpret_cast<PFN_xrVoidFunction *>(&xrGetDisplayRefreshRateFB)),
+                         "Failed to load xrGetDisplayRefreshRateFB");
+                xr_check(xrGetInstanceProcAddr(m_data->instance,
+                                               "xrRequestDisplayRefreshRateFB",
+                                               reinterpret_cast<PFN_xrVoidFunction *>(&xrRequestDisplayRefreshRateFB)),
+                         "Failed to load xrRequestDisplayRefreshRateFB");
+            }
         }
 
         // === Create debug messenger ===
@@ -350,7 +497,32 @@ namespace vre
             };
             xr_check(xrGetSystemProperties(m_data->instance, m_data->system_id, &system_properties),
                      "Failed to get system properties");
-            std::cout << "System name: " << system_properties.systemName << "\n";
+            VRE_LOG_INFO("System name: {}", system_properties.systemName);
+        }
+
+        // === Record and replay ===
+        const auto &performance_settings = settings.performance_settings;
+        if (performance_settings.record_path != nullptr)
+        {
+            if (m_data->recorder.open(performance_settings.record_path))
+            {
+                VRE_LOG_INFO("Recording the session to \"{}\"", performance_settings.record_path);
+            }
+            else
+            {
+                VRE_LOG_ERROR("Failed to create the recording \"{}\"", performance_settings.record_path);
+            }
+        }
+        if (performance_settings.replay_path != nullptr)
+        {
+            if (m_data->replayer.open(performance_settings.replay_path))
+            {
+                VRE_LOG_INFO("Replaying the poses of \"{}\"", performance_settings.replay_path);
+            }
+            else
+            {
+                VRE_LOG_ERROR("Failed to open the recording \"{}\"", performance_settings.replay_path);
+            }
         }
     }
 
@@ -473,7 +645,7 @@ namespace vre
             auto space_type = choose_reference_space_type(m_data->session);
 
             // Print space type
-            std::cout << "Chosen space type: " << xr_reference_space_type_to_string(space_type) << std::endl;
+            VRE_LOG_INFO("Chosen space type: {}", xr_reference_space_type_to_string(space_type));
 
             // Create space
             XrReferenceSpaceCreateInfo ref_space_info {
@@ -486,8 +658,570 @@ namespace vre
                      "Failed to create reference space");
         }
 
+        // Choose how the rendered views are blended with the real world
+        m_data->blend_mode = choose_environment_blend_mode(m_data->instance, m_data->system_id);
+
         // Init VR views (swapchains)
         m_data->renderer.init_vr_views(m_data->session);
+
+        // Allocate per-frame view arrays once, so that the frame loop doesn't allocate
+        const auto nb_views = m_data->renderer.view_count();
+        m_data->views.resize(nb_views, {XR_TYPE_VIEW});
+        m_data->projection_views.resize(nb_views, {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW});
+        m_data->resize_layer_arrays();
+
+        // Get the refresh rates supported by the display
+        m_data->init_refresh_rates();
+    }
+
+    // endregion
+
+    // region Performance
+
+    void VrSystem::Data::init_refresh_rates()
+    {
+        if (!refresh_rate_ext_enabled)
+        {
+            return;
+        }
+
+        uint32_t nb_rates = 0;
+        xr_check(xrEnumerateDisplayRefreshRatesFB(session, 0, &nb_rates, nullptr));
+        available_refresh_rates.resize(nb_rates);
+        xr_check(xrEnumerateDisplayRefreshRatesFB(session, nb_rates, &nb_rates, available_refresh_rates.data()));
+        // The governor expects them in increasing order
+        std::sort(available_refresh_rates.begin(), available_refresh_rates.end());
+
+        float current_rate = 0.0f;
+        xr_check(xrGetDisplayRefreshRateFB(session, &current_rate), "Failed to get display refresh rate");
+
+        for (uint32_t i = 0; i < nb_rates; i++)
+        {
+            VRE_LOG_INFO("Available refresh rate: {}Hz", available_refresh_rates[i]);
+            if (available_refresh_rates[i] == current_rate)
+            {
+                current_refresh_rate_index = i;
+            }
+        }
+        VRE_LOG_INFO("Current refresh rate: {}Hz", current_rate);
+        refresh_rate_metric->set(current_rate);
+    }
+
+    void VrSystem::Data::update_refresh_rate()
+    {
+        // During a replay, the refresh rate follows the recording instead
+        if (!refresh_rate_ext_enabled || available_refresh_rates.empty() || replayer.is_open())
+        {
+            return;
+        }
+
+        const auto chosen_index = governor.choose_refresh_rate(available_refresh_rates.data(),
+                                                               static_cast<uint32_t>(available_refresh_rates.size()),
+                                                               current_refresh_rate_index);
+        if (chosen_index != current_refresh_rate_index)
+        {
+            // The change is confirmed by an event, which updates the current index
+            xr_check(xrRequestDisplayRefreshRateFB(session, available_refresh_rates[chosen_index]),
+                     "Failed to request display refresh rate");
+        }
+    }
+
+    // endregion
+
+    // region UI panels
+
+    void VrSystem::Data::resize_layer_arrays()
+    {
+        // One quad layer per panel, plus the projection layer
+        const auto nb_panels = renderer.ui_panel_count();
+        ui_layers.resize(nb_panels, {XR_TYPE_COMPOSITION_LAYER_QUAD});
+        layers.reserve(nb_panels + 1);
+    }
+
+    Id VrSystem::create_ui_panel(const UiPanelSettings &settings)
+    {
+        check(m_data->session != XR_NULL_HANDLE, "Session not created");
+
+        auto id = m_data->renderer.create_ui_panel(m_data->session, settings);
+        m_data->resize_layer_arrays();
+        return id;
+    }
+
+    void VrSystem::destroy_ui_panel(Id panel_id)
+    {
+        m_data->renderer.destroy_ui_panel(panel_id);
+    }
+
+    void VrSystem::invalidate_ui_panel(Id panel_id)
+    {
+        m_data->renderer.invalidate_ui_panel(panel_id);
+    }
+
+    // endregion
+
+    // region Meshes
+
+    Id VrSystem::create_mesh(const void             *vertices,
+                             uint32_t                vertex_count,
+                             const uint32_t         *indices,
+                             uint32_t                index_count,
+                             const MeshLod          *lods,
+                             uint32_t                lod_count,
+                             const MeshQuantization *quantization)
+    {
+        check(m_data->renderer.is_valid(), "Renderer not created");
+        return m_data->renderer.create_mesh(vertices, vertex_count, indices, index_count, lods, lod_count, quantization);
+    }
+
+    void VrSystem::destroy_mesh(Id mesh_id)
+    {
+        m_data->renderer.destroy_mesh(mesh_id);
+    }
+
+    Id VrSystem::add_instance(Id mesh_id, Id material_id, const InstanceTransform &transform)
+    {
+        check(m_data->renderer.is_valid(), "Renderer not created");
+        return m_data->renderer.add_instance(mesh_id, material_id, transform);
+    }
+
+    void VrSystem::remove_instance(Id instance_id)
+    {
+        m_data->renderer.remove_instance(instance_id);
+    }
+
+    void VrSystem::set_instance_transform(Id instance_id, const InstanceTransform &transform)
+    {
+        m_data->renderer.set_instance_transform(instance_id, transform);
+    }
+
+    Id VrSystem::add_light(const PointLight &light)
+    {
+        check(m_data->renderer.is_valid(), "Renderer not created");
+        return m_data->renderer.add_light(light);
+    }
+
+    void VrSystem::remove_light(Id light_id)
+    {
+        m_data->renderer.remove_light(light_id);
+    }
+
+    void VrSystem::set_light(Id light_id, const PointLight &light)
+    {
+        m_data->renderer.set_light(light_id, light);
+    }
+
+    // endregion
+
+    // region Record and replay
+
+    void VrSystem::Data::record_event(RecordedEventType type, uint32_t value, float from_rate, float to_rate)
+    {
+        recorder.record_event(RecordedEvent {
+            .frame_index = frame_index,
+            .type        = type,
+            .value       = value,
+            .from_rate   = from_rate,
+            .to_rate     = to_rate,
+        });
+    }
+
+    void VrSystem::Data::record_or_replay_views(const XrFrameState &frame_state, XrViewState &view_state, uint32_t nb_views)
+    {
+        // Replace the tracked views by the recorded ones, and replay the events recorded before the frame. The frame timing still
+        // comes from the runtime.
+        RecordedFrame frame;
+        if (replayer.is_open())
+        {
+            if (replayer.next_frame(frame))
+            {
+                replay_events();
+                view_state.viewStateFlags = frame.view_state_flags;
+                for (uint32_t i = 0; i < std::min(nb_views, frame.view_count); i++)
+                {
+                    views[i].pose           = to_xr_pose(frame.views[i].pose);
+                    views[i].fov.angleLeft  = frame.views[i].fov[0];
+                    views[i].fov.angleRight = frame.views[i].fov[1];
+                    views[i].fov.angleUp    = frame.views[i].fov[2];
+                    views[i].fov.angleDown  = frame.views[i].fov[3];
+                }
+            }
+            else
+            {
+                VRE_LOG_INFO("End of the replay after {} frames", frame_index);
+                replay_finished = true;
+            }
+        }
+
+        if (recorder.is_open())
+        {
+            frame = {
+                .frame_index              = frame_index,
+                .predicted_display_time   = frame_state.predictedDisplayTime,
+                .predicted_display_period = frame_state.predictedDisplayPeriod,
+                .view_state_flags         = view_state.viewStateFlags,
+                .view_count               = std::min(nb_views, RecordedFrame::MAX_VIEWS),
+            };
+            for (uint32_t i = 0; i < frame.view_count; i++)
+            {
+                frame.views[i] = RecordedView {
+                    .pose = to_recorded_pose(views[i].pose),
+                    .fov  = {views[i].fov.angleLeft, views[i].fov.angleRight, views[i].fov.angleUp, views[i].fov.angleDown},
+                };
+            }
+            recorder.record_frame(frame);
+        }
+
+        frame_index++;
+    }
+
+    void VrSystem::Data::replay_events()
+    {
+        // The session itself is driven by the runtime, so the recorded session states are not applied: the replay ends where the
+        // recorded session did. The refresh rate changes are requested again, so that the frames are paced as in the recording.
+        for (const auto &event : replayer.events())
+        {
+            switch (event.type)
+            {
+                case RecordedEventType::SESSION_STATE_CHANGED:
+                {
+                    const auto state = static_cast<XrSessionState>(event.value);
+                    if (state == XR_SESSION_STATE_STOPPING || state == XR_SESSION_STATE_EXITING
+                        || state == XR_SESSION_STATE_LOSS_PENDING)
+                    {
+                        VRE_LOG_INFO("The recorded session ended after {} frames", frame_index);
+                        replay_finished = true;
+                    }
+                    break;
+                }
+                case RecordedEventType::INSTANCE_LOSS_PENDING:
+                {
+                    VRE_LOG_INFO("The recorded instance was lost after {} frames", frame_index);
+                    replay_finished = true;
+                    break;
+                }
+                case RecordedEventType::REFRESH_RATE_CHANGED:
+                {
+                    const auto it = std::find(available_refresh_rates.begin(), available_refresh_rates.end(), event.to_rate);
+                    if (!refresh_rate_ext_enabled || it == available_refresh_rates.end())
+                    {
+                        VRE_LOG_WARNING("Can't replay the change of refresh rate to {}Hz", event.to_rate);
+                    }
+                    else if (static_cast<uint32_t>(it - available_refresh_rates.begin()) != current_refresh_rate_index)
+                    {
+                        // As with the governor, the change is confirmed by an event, which updates the current index
+                        xr_check(xrRequestDisplayRefreshRateFB(session, event.to_rate), "Failed to request display refresh rate");
+                    }
+                    break;
+                }
+                case RecordedEventType::EVENTS_LOST:
+                {
+                    VRE_LOG_WARNING("{} OpenXR events were lost during the recording", event.value);
+                    break;
+                }
+            }
+        }
+    }
+
+    // endregion
+
+    // region Session state machine
+
+    void VrSystem::Data::handle_session_state_change(const XrEventDataSessionStateChanged &event, bool &should_quit)
+    {
+        VRE_LOG_INFO("Session state changed: {} -> {}",
+                     xr_session_state_to_string(session_state),
+                     xr_session_state_to_string(event.state));
+        session_state = event.state;
+
+        switch (session_state)
+        {
+            case XR_SESSION_STATE_READY:
+            {
+                // The runtime wants us to start the frame loop
+                XrSessionBeginInfo session_begin_info {
+                    .type                         = XR_TYPE_SESSION_BEGIN_INFO,
+                    .next                         = XR_NULL_HANDLE,
+                    .primaryViewConfigurationType = VIEW_CONFIGURATION_TYPE,
+                };
+                xr_check(xrBeginSession(session, &session_begin_info), "Failed to begin session");
+                session_running = true;
+                break;
+            }
+            case XR_SESSION_STATE_STOPPING:
+            {
+                // The runtime wants us to stop the frame loop (e.g. the headset was removed)
+                xr_check(xrEndSession(session), "Failed to end session");
+                session_running = false;
+                break;
+            }
+            case XR_SESSION_STATE_EXITING:
+            case XR_SESSION_STATE_LOSS_PENDING:
+            {
+                // The session is over. Loss pending could be recovered by recreating the session once the runtime is available
+                // again, but we don't support it yet.
+                session_running = false;
+                should_quit     = true;
+                break;
+            }
+            // Synchronized, visible and focused only change what is rendered, which is checked in render_frame
+            default: break;
+        }
+    }
+
+    bool VrSystem::handle_events()
+    {
+        VRE_ZONE("VrSystem::handle_events");
+        check(m_data->session != XR_NULL_HANDLE, "Session not created");
+
+        bool should_quit = false;
+
+        // Drain the event queue. xrPollEvent never blocks: it returns XR_EVENT_UNAVAILABLE when the queue is empty.
+        XrEventDataBuffer event {XR_TYPE_EVENT_DATA_BUFFER};
+        XrResult          result;
+        while ((result = xrPollEvent(m_data->instance, &event)) == XR_SUCCESS)
+        {
+            switch (event.type)
+            {
+                case XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED:
+                {
+                    const auto &state_event = *reinterpret_cast<XrEventDataSessionStateChanged *>(&event);
+                    m_data->record_event(RecordedEventType::SESSION_STATE_CHANGED, static_cast<uint32_t>(state_event.state));
+                    m_data->handle_session_state_change(state_event, should_quit);
+                    break;
+                }
+                case XR_TYPE_EVENT_DATA_INSTANCE_LOSS_PENDING:
+                {
+                    VRE_LOG_WARNING("OpenXR instance loss pending, exiting.");
+                    m_data->record_event(RecordedEventType::INSTANCE_LOSS_PENDING);
+                    should_quit = true;
+                    break;
+                }
+                case XR_TYPE_EVENT_DATA_DISPLAY_REFRESH_RATE_CHANGED_FB:
+                {
+                    const auto &rate_event = *reinterpret_cast<XrEventDataDisplayRefreshRateChangedFB *>(&event);
+                    VRE_LOG_INFO("Display refresh rate changed: {}Hz -> {}Hz",
+                                 rate_event.fromDisplayRefreshRate,
+                                 rate_event.toDisplayRefreshRate);
+                    m_data->record_event(RecordedEventType::REFRESH_RATE_CHANGED,
+                                         0,
+                                         rate_event.fromDisplayRefreshRate,
+                                         rate_event.toDisplayRefreshRate);
+
+                    auto &rates = m_data->available_refresh_rates;
+                    auto  it    = std::find(rates.begin(), rates.end(), rate_event.toDisplayRefreshRate);
+                    if (it != rates.end())
+                    {
+                        m_data->current_refresh_rate_index = static_cast<uint32_t>(it - rates.begin());
+                    }
+                    m_data->refresh_rate_metric->set(rate_event.toDisplayRefreshRate);
+                    break;
+                }
+                case XR_TYPE_EVENT_DATA_EVENTS_LOST:
+                {
+                    const auto &lost_event = *reinterpret_cast<XrEventDataEventsLost *>(&event);
+                    VRE_LOG_WARNING("{} OpenXR events were lost.", lost_event.lostEventCount);
+                    m_data->record_event(RecordedEventType::EVENTS_LOST, lost_event.lostEventCount);
+                    break;
+                }
+                default: break;
+            }
+
+            // Reset the buffer for the next event
+            event = {XR_TYPE_EVENT_DATA_BUFFER};
+        }
+
+        if (result != XR_EVENT_UNAVAILABLE)
+        {
+            xr_check(result, "Failed to poll events");
+        }
+
+        // A replayed run ends with its recording
+        return should_quit || m_data->replay_finished;
+    }
+
+    bool VrSystem::is_session_running() const
+    {
+        return m_data->session_running;
+    }
+
+    void VrSystem::publish_table_stats() const
+    {
+        if (m_data->renderer.is_valid())
+        {
+            m_data->renderer.publish_table_stats();
+        }
+    }
+
+    const QualityLevels &VrSystem::quality_levels() const
+    {
+        return m_data->governor.quality();
+    }
+
+    void VrSystem::render_frame()
+    {
+        VRE_ZONE("VrSystem::render_frame");
+
+        if (!m_data->session_running)
+        {
+            // No frame loop outside of a running session. The runtime doesn't throttle us in that case, so we do it ourselves.
+            std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_POLL_INTERVAL_MS));
+            return;
+        }
+
+        // Wait for the runtime to tell us when to start the next frame. This is what throttles the frame loop.
+        XrFrameWaitInfo frame_wait_info {
+            .type = XR_TYPE_FRAME_WAIT_INFO,
+            .next = XR_NULL_HANDLE,
+        };
+        XrFrameState frame_state {
+            .type = XR_TYPE_FRAME_STATE,
+            .next = XR_NULL_HANDLE,
+        };
+        const auto wait_start = std::chrono::steady_clock::now();
+        XrResult   wait_result;
+        {
+            VRE_ZONE("xrWaitFrame");
+            VRE_API_CALL("xrWaitFrame", true);
+            wait_result = xrWaitFrame(m_data->session, &frame_wait_info, &frame_state);
+        }
+        if (!frame_call_succeeded(wait_result, "Failed to wait for frame"))
+        {
+            // No frame was started, so there is nothing to end
+            return;
+        }
+
+        // The CPU time of the frame is what we do between the end of the wait and the submission
+        const auto cpu_frame_start = std::chrono::steady_clock::now();
+        const auto wait_time       = std::chrono::duration_cast<std::chrono::nanoseconds>(cpu_frame_start - wait_start);
+        m_data->wait_frame_time_metric->record(wait_time.count());
+
+        // The predicted period follows the current refresh rate, even without the refresh rate extension
+        m_data->governor.set_target_frame_time(static_cast<double>(frame_state.predictedDisplayPeriod) * 1e-9);
+
+        XrFrameBeginInfo frame_begin_info {
+            .type = XR_TYPE_FRAME_BEGIN_INFO,
+            .next = XR_NULL_HANDLE,
+        };
+        XrResult begin_result;
+        {
+            VRE_API_CALL("xrBeginFrame", false);
+            begin_result = xrBeginFrame(m_data->session, &frame_begin_info);
+        }
+        if (!frame_call_succeeded(begin_result, "Failed to begin frame"))
+        {
+            return;
+        }
+        if (begin_result == XR_FRAME_DISCARDED)
+        {
+            // The previous frame was begun but never ended, and the runtime dropped it. This one goes on normally.
+            m_data->discarded_frame_metric->add();
+        }
+
+        // Only spend GPU time if the result will actually be displayed. Once the session is about to be lost, the frames are only
+        // ended until the state change stops the loop.
+        const bool is_visible = m_data->session_state == XR_SESSION_STATE_VISIBLE || m_data->session_state == XR_SESSION_STATE_FOCUSED;
+        const bool is_loss_pending = wait_result == XR_SESSION_LOSS_PENDING || begin_result == XR_SESSION_LOSS_PENDING;
+        const bool should_render   = frame_state.shouldRender == XR_TRUE && is_visible && !is_loss_pending;
+
+        XrCompositionLayerProjection projection_layer {
+            .type       = XR_TYPE_COMPOSITION_LAYER_PROJECTION,
+            .next       = XR_NULL_HANDLE,
+            .layerFlags = 0,
+            .space      = m_data->reference_space,
+        };
+        // Reuse the layer array to avoid allocations in the frame loop
+        auto &layers = m_data->layers;
+        layers.clear();
+
+        if (should_render)
+        {
+            // Get the pose and field of view of each view for the predicted display time
+            XrViewLocateInfo view_locate_info {
+                .type                  = XR_TYPE_VIEW_LOCATE_INFO,
+                .next                  = XR_NULL_HANDLE,
+                .viewConfigurationType = VIEW_CONFIGURATION_TYPE,
+                .displayTime           = frame_state.predictedDisplayTime,
+                .space                 = m_data->reference_space,
+            };
+            XrViewState view_state {
+                .type = XR_TYPE_VIEW_STATE,
+                .next = XR_NULL_HANDLE,
+            };
+            uint32_t   nb_views      = 0;
+            const auto locate_result = xrLocateViews(m_data->session,
+                                                     &view_locate_info,
+                                                     &view_state,
+                                                     static_cast<uint32_t>(m_data->views.size()),
+                                                     &nb_views,
+                                                     m_data->views.data());
+            const bool views_located = frame_call_succeeded(locate_result, "Failed to locate views");
+            if (views_located)
+            {
+                m_data->record_or_replay_views(frame_state, view_state, nb_views);
+            }
+
+            // Tracking may be lost, in which case there is nothing meaningful to render
+            const auto required_flags = XR_VIEW_STATE_POSITION_VALID_BIT | XR_VIEW_STATE_ORIENTATION_VALID_BIT;
+            if (views_located && (view_state.viewStateFlags & required_flags) == required_flags)
+            {
+                m_data->renderer.render_views(m_data->views.data(),
+                                              nb_views,
+                                              m_data->governor.quality().resolution_scale,
+                                              m_data->governor.quality().lod_bias,
+                                              m_data->projection_views.data());
+
+                projection_layer.viewCount = nb_views;
+                projection_layer.views     = m_data->projection_views.data();
+                layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader *>(&projection_layer));
+            }
+
+            // UI panels are drawn over the scene by the compositor
+            const auto nb_ui_layers = m_data->renderer.fill_ui_layers(m_data->reference_space, m_data->ui_layers.data());
+            for (uint32_t i = 0; i < nb_ui_layers; i++)
+            {
+                layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader *>(&m_data->ui_layers[i]));
+            }
+        }
+
+        const auto cpu_frame_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - cpu_frame_start).count();
+
+        // The frame must always be ended, even if nothing was rendered
+        XrFrameEndInfo frame_end_info {
+            .type                 = XR_TYPE_FRAME_END_INFO,
+            .next                 = XR_NULL_HANDLE,
+            .displayTime          = frame_state.predictedDisplayTime,
+            .environmentBlendMode = m_data->blend_mode,
+            .layerCount           = static_cast<uint32_t>(layers.size()),
+            .layers               = layers.data(),
+        };
+        {
+            VRE_ZONE("xrEndFrame");
+            VRE_API_CALL("xrEndFrame", true);
+            frame_call_succeeded(xrEndFrame(m_data->session, &frame_end_info), "Failed to end frame");
+        }
+
+        // Frames that were not rendered don't tell anything about the cost
+        if (should_render)
+        {
+            const auto gpu_frame_time = m_data->renderer.last_gpu_frame_time();
+            m_data->cpu_frame_time_metric->record(static_cast<uint64_t>(cpu_frame_time * 1e9));
+            if (gpu_frame_time > 0.0)
+            {
+                m_data->gpu_frame_time_metric->record(static_cast<uint64_t>(gpu_frame_time * 1e9));
+            }
+
+            // Adapt the quality to the measured cost
+            if (m_data->performance_settings.adaptive_quality)
+            {
+                m_data->governor.report_frame(cpu_frame_time, gpu_frame_time);
+                m_data->quality_factor_metric->set(m_data->governor.quality_factor());
+                VRE_COUNTER("Quality factor", m_data->governor.quality_factor());
+            }
+        }
+        if (m_data->performance_settings.adaptive_refresh_rate)
+        {
+            m_data->update_refresh_rate();
+        }
     }
 
     // endregion
@@ -5,6 +5,7 @@
 #include <vector>
 #include <SDL2/SDL.h>
 #include <vr_engine/core/global.h>
+#include <vr_engine/utils/log.h>
 
 #ifdef RENDERER_VULKAN
 #include <SDL2/SDL_vulkan.h>
@@ -45,7 +46,8 @@ namespace vre
             SDL_SetMainReady();
             if (SDL_Init(SDL_INIT_VIDEO) != 0)
             {
-                std::cerr << "SDL_Init Error: " << SDL_GetError() << std::endl;
+                VRE_LOG_ERROR("SDL_Init Error: {}", SDL_GetError());
+                Logger::flush();
                 exit(1);
             }
             m_initialized = true;
@@ -71,7 +73,8 @@ namespace vre
     {
         if (result != SDL_TRUE)
         {
-            std::cerr << "[SDL Error] Got SDL_FALSE !\n";
+            VRE_LOG_ERROR("[SDL Error] Got SDL_FALSE !");
+            Logger::flush();
             exit(1);
         }
     }
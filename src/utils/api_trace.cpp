@@ -0,0 +1,74 @@
+#include "vr_engine/utils/api_trace.h"
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vr_engine/utils/profiler.h>
+
+namespace vre
+{
+    // --=== Registry ===--
+
+    namespace api_trace_utils
+    {
+        struct ApiTraceRegistry
+        {
+            std::mutex mutex;
+            // A deque keeps the entries at the same address when it grows
+            std::deque<ApiEntryPoint> entry_points;
+
+            static ApiTraceRegistry &get()
+            {
+                static ApiTraceRegistry registry;
+                return registry;
+            }
+        };
+    } // namespace api_trace_utils
+    using namespace api_trace_utils;
+
+    // --=== API ===--
+
+    ApiEntryPoint &ApiTrace::entry_point(const char *name, bool is_timed)
+    {
+        auto                       &registry = ApiTraceRegistry::get();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        for (auto &entry_point : registry.entry_points)
+        {
+            if (std::string(entry_point.name) == name)
+            {
+                return entry_point;
+            }
+        }
+
+        auto       &metrics     = MetricsRegistry::global();
+        const auto  prefix      = std::string("api.") + name;
+        auto       &entry_point = registry.entry_points.emplace_back();
+
+        entry_point.name                    = name;
+        entry_point.is_timed                = is_timed;
+        entry_point.call_count_metric       = &metrics.counter(prefix + ".calls");
+        entry_point.frame_call_count_metric = &metrics.gauge(prefix + ".calls_per_frame");
+        if (is_timed)
+        {
+            entry_point.duration_metric = &metrics.histogram(prefix + "_ns");
+        }
+        return entry_point;
+    }
+
+    void ApiTrace::end_frame()
+    {
+        auto                       &registry = ApiTraceRegistry::get();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        uint64_t total_call_count = 0;
+        for (auto &entry_point : registry.entry_points)
+        {
+            const auto call_count = entry_point.frame_call_count.exchange(0, std::memory_order_relaxed);
+            entry_point.call_count_metric->add(call_count);
+            entry_point.frame_call_count_metric->set(static_cast<double>(call_count));
+            total_call_count += call_count;
+        }
+        VRE_COUNTER("API calls", total_call_count);
+    }
+} // namespace vre
@@ -9,12 +9,16 @@
 #include <cstring>
 #include <stdexcept>
 #include <vr_engine/utils/data/optional.h>
+#include <vr_engine/utils/log.h>
+#include <vr_engine/utils/metrics.h>
 
 // --=== Constants ===--
 
 #define FNV_OFFSET       14695981039346656037ULL
 #define FNV_PRIME        1099511628211ULL
 #define DEFAULT_CAPACITY 2
+// In debug, a warning is logged the first time an insertion probes more slots than this
+#define PROBE_LENGTH_WARNING_THRESHOLD 32
 
 namespace vre
 {
@@ -25,6 +29,8 @@ namespace vre
         Entry *entries;
         size_t capacity;
         size_t count;
+        size_t expansion_count       = 0;
+        bool   probe_warning_emitted = false;
     };
 
     // --=== Utils ===---
@@ -42,11 +48,12 @@ namespace vre
         return hash;
     }
 
-    void set_entry(HashMap::Entry       *entries,
-                   const size_t         &capacity,
-                   const HashMap::Key   &key,
-                   const HashMap::Value &value,
-                   size_t               *count = nullptr)
+    // Returns the probe length of the slot where the entry was set
+    size_t set_entry(HashMap::Entry       *entries,
+                     const size_t         &capacity,
+                     const HashMap::Key   &key,
+                     const HashMap::Value &value,
+                     size_t               *count = nullptr)
     {
         // Prevent the use of the zero key, which is reserved for the empty entry
         if (key == HashMap::NULL_KEY)
@@ -55,7 +62,8 @@ namespace vre
         }
 
         // Compute the index of the key in the array
-        size_t index = hash(key) & static_cast<uint64_t>(capacity - 1);
+        size_t index        = hash(key) & static_cast<uint64_t>(capacity - 1);
+        size_t probe_length = 0;
 
         while (entries[index].key != HashMap::NULL_KEY)
         {
@@ -65,11 +73,12 @@ namespace vre
             {
                 // Edit value
                 entries[index].value = value;
-                return;
+                return probe_length;
             }
 
             // Else, increment to find the next suitable slot
             index++;
+            probe_length++;
             // Wrap around to stay inside the array
             if (index >= capacity)
             {
@@ -88,6 +97,7 @@ namespace vre
         }
         entries[index].key   = key;
         entries[index].value = value;
+        return probe_length;
     }
 
     // --=== Constructors ===--
@@ -105,9 +115,10 @@ namespace vre
 
     HashMap::HashMap(const HashMap &other)
         : m_data(new Data {
-            .entries  = new Entry[other.m_data->capacity],
-            .capacity = other.m_data->capacity,
-            .count    = other.m_data->count,
+            .entries         = new Entry[other.m_data->capacity],
+            .capacity        = other.m_data->capacity,
+            .count           = other.m_data->count,
+            .expansion_count = other.m_data->expansion_count,
         })
     {
         // Copy entries
@@ -142,9 +153,10 @@ namespace vre
 
             // Copy new m_data
             m_data = new Data {
-                .entries  = new Entry[other.m_data->capacity],
-                .capacity = other.m_data->capacity,
-                .count    = other.m_data->count,
+                .entries         = new Entry[other.m_data->capacity],
+                .capacity        = other.m_data->capacity,
+                .count           = other.m_data->count,
+                .expansion_count = other.m_data->expansion_count,
             };
             // Copy entries
             memcpy(m_data->entries, other.m_data->entries, sizeof(Entry) * m_data->capacity);
@@ -205,6 +217,7 @@ namespace vre
         // Update m_data
         m_data->capacity = new_capacity;
         m_data->entries  = new_entries;
+        m_data->expansion_count++;
     }
 
     // --=== Public methods ===--
@@ -261,7 +274,19 @@ namespace vre
             expand();
         }
 
-        return set_entry(m_data->entries, m_data->capacity, key, value, &m_data->count);
+        [[maybe_unused]] const auto probe_length = set_entry(m_data->entries, m_data->capacity, key, value, &m_data->count);
+
+#ifdef DEBUG
+        // Long probes mean that the keys are badly distributed. Only warn once per map to avoid flooding the log.
+        if (probe_length > PROBE_LENGTH_WARNING_THRESHOLD && !m_data->probe_warning_emitted)
+        {
+            m_data->probe_warning_emitted = true;
+            VRE_LOG_WARNING("Hash map insertion probed {} slots (count: {}, capacity: {}). Keys may be badly distributed.",
+                            probe_length,
+                            m_data->count,
+                            m_data->capacity);
+        }
+#endif
     }
 
     void HashMap::remove(const HashMap::Key &key)
@@ -395,6 +420,80 @@ namespace vre
         return res.has_value();
     }
 
+    HashMapStats HashMap::stats() const
+    {
+        HashMapStats stats = {
+            .count           = m_data->count,
+            .capacity        = m_data->capacity,
+            .load_factor     = static_cast<float>(m_data->count) / static_cast<float>(m_data->capacity),
+            .expansion_count = m_data->expansion_count,
+        };
+
+        // The map is never full, so there is always an empty slot. Start the scan after it, so that clusters that wrap around the
+        // end of the array are measured in one piece.
+        const size_t mask  = m_data->capacity - 1;
+        size_t       start = 0;
+        while (m_data->entries[start].key != NULL_KEY)
+        {
+            start++;
+        }
+
+        size_t total_probe_length = 0;
+        size_t cluster_size       = 0;
+        for (size_t i = 1; i <= m_data->capacity; i++)
+        {
+            const size_t index = (start + i) & mask;
+            const auto  &entry = m_data->entries[index];
+
+            if (entry.key != NULL_KEY)
+            {
+                // Distance to the slot given by the hash, with wrap around
+                const size_t probe_length = (index - (hash(entry.key) & mask)) & mask;
+                total_probe_length += probe_length;
+                if (probe_length > stats.max_probe_length)
+                {
+                    stats.max_probe_length = probe_length;
+                }
+                cluster_size++;
+            }
+            else if (cluster_size > 0)
+            {
+                // End of a cluster: find its bucket, which is the position of the highest bit of the size
+                size_t bucket = 0;
+                while ((cluster_size >> (bucket + 1)) != 0 && bucket + 1 < HashMapStats::CLUSTER_SIZE_BUCKET_COUNT)
+                {
+                    bucket++;
+                }
+                stats.cluster_size_histogram[bucket]++;
+                cluster_size = 0;
+            }
+        }
+
+        if (m_data->count > 0)
+        {
+            stats.mean_probe_length = static_cast<float>(total_probe_length) / static_cast<float>(m_data->count);
+        }
+        return stats;
+    }
+
+    void HashMapStats::publish(const std::string &name) const
+    {
+        auto      &metrics = MetricsRegistry::global();
+        const auto prefix  = "hash_map." + name + ".";
+
+        metrics.gauge(prefix + "count").set(static_cast<double>(count));
+        metrics.gauge(prefix + "capacity").set(static_cast<double>(capacity));
+        metrics.gauge(prefix + "load_factor").set(load_factor);
+        metrics.gauge(prefix + "max_probe_length").set(static_cast<double>(max_probe_length));
+        metrics.gauge(prefix + "mean_probe_length").set(mean_probe_length);
+        metrics.gauge(prefix + "expansions").set(static_cast<double>(expansion_count));
+        for (size_t i = 0; i < CLUSTER_SIZE_BUCKET_COUNT; i++)
+        {
+            // Named after the smallest size of the bucket, e.g. "clusters_4" for the clusters of 4 to 7 slots
+            metrics.gauge(prefix + "clusters_" + std::to_string(size_t(1) << i)).set(static_cast<double>(cluster_size_histogram[i]));
+        }
+    }
+
 
     // Iterator
 
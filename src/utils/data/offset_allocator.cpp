@@ -0,0 +1,263 @@
+/**
+ * Implementation of the offset allocator.
+ */
+
+#include "vr_engine/utils/data/offset_allocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace vre
+{
+    // --=== Utils ===--
+
+    namespace offset_allocator_utils
+    {
+        /** Bin whose ranges have a size in [2^bin, 2^(bin+1)[. */
+        inline uint32_t bin_of(uint32_t size)
+        {
+            return static_cast<uint32_t>(std::bit_width(size)) - 1;
+        }
+
+        /** Smallest bin whose ranges are all at least as big as the size. BIN_COUNT if there is none. */
+        inline uint32_t first_fitting_bin(uint32_t size)
+        {
+            return std::has_single_bit(size) ? bin_of(size) : bin_of(size) + 1;
+        }
+    } // namespace offset_allocator_utils
+
+    using namespace offset_allocator_utils;
+
+    // --=== Nodes ===--
+
+    uint32_t OffsetAllocator::create_node(uint32_t offset, uint32_t size)
+    {
+        uint32_t node_index;
+        if (!m_unused_nodes.empty())
+        {
+            node_index = m_unused_nodes.back();
+            m_unused_nodes.pop_back();
+        }
+        else
+        {
+            node_index = static_cast<uint32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+
+        m_nodes[node_index] = Node {
+            .offset = offset,
+            .size   = size,
+        };
+        return node_index;
+    }
+
+    void OffsetAllocator::destroy_node(uint32_t node_index)
+    {
+        // So that a second free of the same allocation is detected
+        m_nodes[node_index].used = false;
+        m_unused_nodes.push_back(node_index);
+    }
+
+    void OffsetAllocator::insert_free_node(uint32_t node_index)
+    {
+        auto      &node = m_nodes[node_index];
+        const auto bin  = bin_of(node.size);
+
+        node.used          = false;
+        node.previous_free = NO_NODE;
+        node.next_free     = m_bin_heads[bin];
+        if (node.next_free != NO_NODE)
+        {
+            m_nodes[node.next_free].previous_free = node_index;
+        }
+        m_bin_heads[bin] = node_index;
+        m_non_empty_bins |= 1u << bin;
+    }
+
+    void OffsetAllocator::remove_free_node(uint32_t node_index)
+    {
+        const auto &node = m_nodes[node_index];
+        if (node.previous_free != NO_NODE)
+        {
+            m_nodes[node.previous_free].next_free = node.next_free;
+        }
+        else
+        {
+            // The node was the head of its bin
+            const auto bin   = bin_of(node.size);
+            m_bin_heads[bin] = node.next_free;
+            if (node.next_free == NO_NODE)
+            {
+                m_non_empty_bins &= ~(1u << bin);
+            }
+        }
+        if (node.next_free != NO_NODE)
+        {
+            m_nodes[node.next_free].previous_free = node.previous_free;
+        }
+    }
+
+    uint32_t OffsetAllocator::find_free_node(uint32_t size) const
+    {
+        // Any range of these bins is big enough
+        const auto first_bin = first_fitting_bin(size);
+        if (first_bin < BIN_COUNT)
+        {
+            const auto fitting_bins = m_non_empty_bins & ~((1u << first_bin) - 1);
+            if (fitting_bins != 0)
+            {
+                return m_bin_heads[std::countr_zero(fitting_bins)];
+            }
+        }
+
+        // Otherwise, only the bin of the size can contain a range that is big enough
+        for (auto node_index = m_bin_heads[bin_of(size)]; node_index != NO_NODE; node_index = m_nodes[node_index].next_free)
+        {
+            if (m_nodes[node_index].size >= size)
+            {
+                return node_index;
+            }
+        }
+        return NO_NODE;
+    }
+
+    // --=== API ===--
+
+    OffsetAllocator::OffsetAllocator(uint32_t size)
+    {
+        reset(size);
+    }
+
+    void OffsetAllocator::reset(uint32_t size)
+    {
+        m_size             = size;
+        m_free_space       = size;
+        m_allocation_count = 0;
+        m_non_empty_bins   = 0;
+        std::fill(std::begin(m_bin_heads), std::end(m_bin_heads), NO_NODE);
+        m_nodes.clear();
+        m_unused_nodes.clear();
+
+        // The whole space is one free range
+        if (size > 0)
+        {
+            insert_free_node(create_node(0, size));
+        }
+    }
+
+    OffsetAllocation OffsetAllocator::allocate(uint32_t size)
+    {
+        if (size == 0 || size > m_free_space)
+        {
+            return {};
+        }
+
+        const auto node_index = find_free_node(size);
+        if (node_index == NO_NODE)
+        {
+            return {};
+        }
+        remove_free_node(node_index);
+
+        // Give the rest of the range back to the bins
+        const auto remaining_size = m_nodes[node_index].size - size;
+        if (remaining_size > 0)
+        {
+            const auto remaining_index = create_node(m_nodes[node_index].offset + size, remaining_size);
+            // Creating the node may have moved the others
+            auto &node      = m_nodes[node_index];
+            auto &remaining = m_nodes[remaining_index];
+
+            remaining.previous_neighbor = node_index;
+            remaining.next_neighbor     = node.next_neighbor;
+            if (node.next_neighbor != NO_NODE)
+            {
+                m_nodes[node.next_neighbor].previous_neighbor = remaining_index;
+            }
+            node.next_neighbor = remaining_index;
+            node.size          = size;
+            insert_free_node(remaining_index);
+        }
+
+        auto &node = m_nodes[node_index];
+        node.used  = true;
+        m_free_space -= size;
+        m_allocation_count++;
+
+        return OffsetAllocation {
+            .offset = node.offset,
+            .size   = size,
+            .node   = node_index,
+        };
+    }
+
+    void OffsetAllocator::free(const OffsetAllocation &allocation)
+    {
+        if (!allocation.is_valid())
+        {
+            return;
+        }
+        if (allocation.node >= m_nodes.size() || !m_nodes[allocation.node].used
+            || m_nodes[allocation.node].offset != allocation.offset)
+        {
+            throw std::invalid_argument("The allocation is not in use in this allocator");
+        }
+
+        auto node_index = allocation.node;
+        m_free_space += m_nodes[node_index].size;
+        m_allocation_count--;
+
+        // Merge with the previous range if it is free
+        const auto previous_index = m_nodes[node_index].previous_neighbor;
+        if (previous_index != NO_NODE && !m_nodes[previous_index].used)
+        {
+            remove_free_node(previous_index);
+            auto &previous         = m_nodes[previous_index];
+            auto &node             = m_nodes[node_index];
+            previous.size          += node.size;
+            previous.next_neighbor = node.next_neighbor;
+            if (node.next_neighbor != NO_NODE)
+            {
+                m_nodes[node.next_neighbor].previous_neighbor = previous_index;
+            }
+            destroy_node(node_index);
+            node_index = previous_index;
+        }
+
+        // Merge with the next range if it is free
+        const auto next_index = m_nodes[node_index].next_neighbor;
+        if (next_index != NO_NODE && !m_nodes[next_index].used)
+        {
+            remove_free_node(next_index);
+            auto &node         = m_nodes[node_index];
+            auto &next         = m_nodes[next_index];
+            node.size          += next.size;
+            node.next_neighbor = next.next_neighbor;
+            if (next.next_neighbor != NO_NODE)
+            {
+                m_nodes[next.next_neighbor].previous_neighbor = node_index;
+            }
+            destroy_node(next_index);
+        }
+
+        insert_free_node(node_index);
+    }
+
+    uint32_t OffsetAllocator::largest_free_range() const
+    {
+        if (m_non_empty_bins == 0)
+        {
+            return 0;
+        }
+
+        // The biggest ranges are in the highest non-empty bin
+        uint32_t largest = 0;
+        for (auto node_index = m_bin_heads[BIN_COUNT - 1 - std::countl_zero(m_non_empty_bins)]; node_index != NO_NODE;
+             node_index      = m_nodes[node_index].next_free)
+        {
+            largest = std::max(largest, m_nodes[node_index].size);
+        }
+        return largest;
+    }
+} // namespace vre
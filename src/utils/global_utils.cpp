@@ -1,11 +1,15 @@
 #include "vr_engine/utils/global_utils.h"
 
+#include <vr_engine/utils/log.h>
+
 namespace vre {
     void check(bool result, const std::string &error_message)
     {
         if (!result)
         {
-            std::cerr << "[Error] " << error_message << " Aborting.\n";
+            VRE_LOG_ERROR("{} Aborting.", error_message);
+            // The logger is asynchronous: make sure everything is written before exiting
+            Logger::flush();
             // Completely halt the program
             // TODO maybe recoverable ?
             exit(1);
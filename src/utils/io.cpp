@@ -2,11 +2,14 @@
 
 #include <cstdio>
 #include <stdexcept>
+#include <vr_engine/utils/profiler.h>
 
 namespace vre
 {
     void *load_binary_file(const char *path, size_t *size)
     {
+        VRE_ZONE("load_binary_file");
+
         // Open file
         FILE *file = fopen(path, "rb");
         if (!file)
@@ -0,0 +1,455 @@
+#include "vr_engine/utils/log.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vr_engine/utils/data/spsc_queue.h>
+
+// --=== Constants ===--
+
+// Number of records per thread. Must be a power of 2.
+#define LOG_QUEUE_CAPACITY (1 << 10)
+// Time between two drains of the queues by the logger thread. It doubles after each drain that found nothing, up to the maximum.
+#define LOG_DRAIN_MIN_INTERVAL_MS 2
+#define LOG_DRAIN_MAX_INTERVAL_MS 64
+// Number of records after which a thread wakes the logger thread, so that a burst doesn't wait for a long interval
+#define LOG_WAKE_RECORD_COUNT (LOG_QUEUE_CAPACITY / 4)
+
+namespace vre
+{
+    using log_impl::ArgumentType;
+    using log_impl::LogRecord;
+
+    // --=== Types ===--
+
+    /** Records of a thread. The owning thread is the producer, the drain is the consumer. */
+    struct LogThreadQueue
+    {
+        SpscQueue<LogRecord, LOG_QUEUE_CAPACITY> records;
+        std::atomic<uint64_t>                    dropped = 0;
+        // Only used by the owning thread
+        uint32_t records_since_wake = 0;
+    };
+
+    struct LoggerRegistry
+    {
+        // Queues are never freed before the end of the program: the queue of an exited thread goes to the free list, and is reused
+        // by the next thread. The records it still holds are drained as usual.
+        std::mutex                                   queues_mutex;
+        std::vector<std::unique_ptr<LogThreadQueue>> queues;
+        std::vector<LogThreadQueue *>                free_queues;
+
+        std::mutex                            sinks_mutex;
+        std::vector<std::shared_ptr<LogSink>> sinks;
+        bool                                  sinks_configured = false;
+        ConsoleLogSink                        default_sink;
+
+        // Only one drain can run at a time, since it is the consumer of the queues
+        std::mutex             drain_mutex;
+        std::vector<LogRecord> pending_records;
+        uint64_t               reported_dropped = 0;
+
+        std::mutex              thread_mutex;
+        std::condition_variable thread_condition;
+        bool                    should_stop = false;
+        std::thread             thread;
+
+        LoggerRegistry()
+        {
+            thread = std::thread(
+                [this]()
+                {
+                    std::unique_lock lock(thread_mutex);
+                    uint32_t         interval_ms = LOG_DRAIN_MIN_INTERVAL_MS;
+                    while (!should_stop)
+                    {
+                        thread_condition.wait_for(lock, std::chrono::milliseconds(interval_ms));
+
+                        lock.unlock();
+                        const bool has_drained = drain();
+                        lock.lock();
+
+                        // Back off while nothing is logged
+                        interval_ms = has_drained ? LOG_DRAIN_MIN_INTERVAL_MS
+                                                  : std::min<uint32_t>(interval_ms * 2, LOG_DRAIN_MAX_INTERVAL_MS);
+                    }
+                });
+        }
+
+        ~LoggerRegistry()
+        {
+            {
+                std::lock_guard lock(thread_mutex);
+                should_stop = true;
+            }
+            thread_condition.notify_one();
+            thread.join();
+
+            // Write what was logged in the meantime
+            drain();
+        }
+
+        LogThreadQueue *acquire_queue()
+        {
+            std::lock_guard lock(queues_mutex);
+            if (!free_queues.empty())
+            {
+                auto *queue = free_queues.back();
+                free_queues.pop_back();
+                return queue;
+            }
+            return queues.emplace_back(std::make_unique<LogThreadQueue>()).get();
+        }
+
+        void release_queue(LogThreadQueue *queue)
+        {
+            std::lock_guard lock(queues_mutex);
+            free_queues.push_back(queue);
+        }
+
+        /** Wakes the logger thread without waiting for the end of its interval. */
+        void wake() { thread_condition.notify_one(); }
+
+        void write_to_sinks(LogLevel level, const std::string &message)
+        {
+            if (!sinks_configured)
+            {
+                default_sink.write(level, message);
+                return;
+            }
+            for (auto &sink : sinks)
+            {
+                sink->write(level, message);
+            }
+        }
+
+        /** Writes the records of all threads to the sinks. Returns false if there was nothing to write. */
+        bool drain();
+    };
+
+    // --=== Utils ===--
+
+    namespace log_utils
+    {
+        std::atomic<uint8_t> runtime_level = 0;
+
+        LoggerRegistry &registry()
+        {
+            static LoggerRegistry instance;
+            return instance;
+        }
+
+        /** Queue of the current thread, returned to the registry when the thread exits. */
+        struct ThreadQueueHandle
+        {
+            LogThreadQueue *queue = registry().acquire_queue();
+
+            ~ThreadQueueHandle() { registry().release_queue(queue); }
+        };
+
+        inline LogThreadQueue &thread_queue()
+        {
+            // The queue is only acquired once per thread
+            thread_local ThreadQueueHandle handle;
+            return *handle.queue;
+        }
+
+        const char *level_to_string(LogLevel level)
+        {
+            switch (level)
+            {
+                case LogLevel::Trace: return "Trace";
+                case LogLevel::Info: return "Info";
+                case LogLevel::Warning: return "Warning";
+                case LogLevel::Error: return "Error";
+                default: return "Unknown";
+            }
+        }
+
+        /** Reads the arguments of a record in order. */
+        class ArgumentReader
+        {
+          private:
+            const LogRecord &m_record;
+            size_t           m_offset = 0;
+            uint8_t          m_index  = 0;
+
+            template<typename T>
+            T read()
+            {
+                T value;
+                memcpy(&value, m_record.payload + m_offset, sizeof(T));
+                m_offset += sizeof(T);
+                return value;
+            }
+
+          public:
+            explicit ArgumentReader(const LogRecord &record) : m_record(record) {}
+
+            /** Appends the next argument to the output. Returns false if there are no arguments left. */
+            bool append_next(std::string &output)
+            {
+                if (m_index >= m_record.argument_count)
+                {
+                    return false;
+                }
+                m_index++;
+
+                const auto type = static_cast<ArgumentType>(m_record.payload[m_offset++]);
+                char       buffer[32];
+                switch (type)
+                {
+                    case ArgumentType::INT:
+                        snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(read<int64_t>()));
+                        output += buffer;
+                        break;
+                    case ArgumentType::UINT:
+                        snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(read<uint64_t>()));
+                        output += buffer;
+                        break;
+                    case ArgumentType::DOUBLE:
+                        snprintf(buffer, sizeof(buffer), "%g", read<double>());
+                        output += buffer;
+                        break;
+                    case ArgumentType::BOOL: output += read<bool>() ? "true" : "false"; break;
+                    case ArgumentType::STRING:
+                    {
+                        const auto length = read<uint16_t>();
+                        output.append(reinterpret_cast<const char *>(m_record.payload + m_offset), length);
+                        m_offset += length;
+                        break;
+                    }
+                    case ArgumentType::POINTER:
+                        snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(read<uintptr_t>()));
+                        output += buffer;
+                        break;
+                }
+                return true;
+            }
+        };
+    } // namespace log_utils
+    using namespace log_utils;
+
+    // --=== Records ===--
+
+    namespace log_impl
+    {
+        LogRecord *begin_record()
+        {
+            auto &queue  = thread_queue();
+            auto *record = queue.records.begin_push();
+            if (record == nullptr)
+            {
+                queue.dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            record->timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
+            return record;
+        }
+
+        void end_record()
+        {
+            auto &queue = thread_queue();
+            queue.records.end_push();
+            if (++queue.records_since_wake == LOG_WAKE_RECORD_COUNT)
+            {
+                queue.records_since_wake = 0;
+                registry().wake();
+            }
+        }
+
+        bool is_level_enabled(LogLevel level)
+        {
+            return static_cast<uint8_t>(level) >= runtime_level.load(std::memory_order_relaxed);
+        }
+    } // namespace log_impl
+
+    bool LoggerRegistry::drain()
+    {
+        std::lock_guard drain_lock(drain_mutex);
+
+        // Collect the records of all threads
+        uint64_t dropped = 0;
+        {
+            std::lock_guard lock(queues_mutex);
+            for (auto &queue : queues)
+            {
+                queue->records.consume_all([&](const LogRecord &record) { pending_records.push_back(record); });
+                dropped += queue->dropped.load(std::memory_order_relaxed);
+            }
+        }
+
+        if (pending_records.empty() && dropped == reported_dropped)
+        {
+            return false;
+        }
+
+        // Restore the global order between threads
+        std::stable_sort(pending_records.begin(),
+                         pending_records.end(),
+                         [](const LogRecord &a, const LogRecord &b) { return a.timestamp < b.timestamp; });
+
+        std::lock_guard sinks_lock(sinks_mutex);
+        for (const auto &record : pending_records)
+        {
+            write_to_sinks(record.level, Logger::format(record));
+        }
+        pending_records.clear();
+
+        if (dropped > reported_dropped)
+        {
+            const auto message = std::to_string(dropped - reported_dropped) + " log messages were dropped because a queue was full.";
+            write_to_sinks(LogLevel::Warning, "[Warning] " + message);
+            reported_dropped = dropped;
+        }
+
+        if (!sinks_configured)
+        {
+            default_sink.flush();
+        }
+        for (auto &sink : sinks)
+        {
+            sink->flush();
+        }
+        return true;
+    }
+
+    // --=== Logger ===--
+
+    std::string Logger::format(const LogRecord &record)
+    {
+        std::string output = "[";
+        output += level_to_string(record.level);
+        output += "] ";
+
+        ArgumentReader reader(record);
+        for (const char *c = record.format; *c != '\0'; c++)
+        {
+            // Replace each placeholder with the next argument. Placeholders without argument are kept as is.
+            if (c[0] == '{' && c[1] == '}' && reader.append_next(output))
+            {
+                c++;
+            }
+            else
+            {
+                output += *c;
+            }
+        }
+        return output;
+    }
+
+    void Logger::add_sink(const std::shared_ptr<LogSink> &sink)
+    {
+        auto           &reg = registry();
+        std::lock_guard lock(reg.sinks_mutex);
+        reg.sinks.push_back(sink);
+        reg.sinks_configured = true;
+    }
+
+    void Logger::clear_sinks()
+    {
+        // Write the pending messages in the old sinks
+        flush();
+
+        auto           &reg = registry();
+        std::lock_guard lock(reg.sinks_mutex);
+        reg.sinks.clear();
+        reg.sinks_configured = true;
+    }
+
+    void Logger::set_level(LogLevel level)
+    {
+        runtime_level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+    }
+
+    void Logger::flush()
+    {
+        registry().drain();
+    }
+
+    uint64_t Logger::dropped_message_count()
+    {
+        auto           &reg = registry();
+        std::lock_guard lock(reg.queues_mutex);
+
+        uint64_t total = 0;
+        for (auto &queue : reg.queues)
+        {
+            total += queue->dropped.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    // --=== Sinks ===--
+
+    void ConsoleLogSink::write(LogLevel level, const std::string &message)
+    {
+        FILE *output = level >= LogLevel::Warning ? stderr : stdout;
+        fwrite(message.data(), 1, message.size(), output);
+        fputc('\n', output);
+    }
+
+    void ConsoleLogSink::flush()
+    {
+        fflush(stdout);
+        fflush(stderr);
+    }
+
+    FileLogSink::FileLogSink(const char *path) : m_file(fopen(path, "w")) {}
+
+    FileLogSink::~FileLogSink()
+    {
+        if (m_file != nullptr)
+        {
+            fclose(m_file);
+        }
+    }
+
+    void FileLogSink::write(LogLevel, const std::string &message)
+    {
+        if (m_file != nullptr)
+        {
+            fwrite(message.data(), 1, message.size(), m_file);
+            fputc('\n', m_file);
+        }
+    }
+
+    void FileLogSink::flush()
+    {
+        if (m_file != nullptr)
+        {
+            fflush(m_file);
+        }
+    }
+
+    struct MemoryLogSink::Data
+    {
+        mutable std::mutex       mutex;
+        std::vector<std::string> messages;
+    };
+
+    MemoryLogSink::MemoryLogSink() : m_data(std::make_unique<Data>()) {}
+
+    MemoryLogSink::~MemoryLogSink() = default;
+
+    void MemoryLogSink::write(LogLevel, const std::string &message)
+    {
+        std::lock_guard lock(m_data->mutex);
+        m_data->messages.push_back(message);
+    }
+
+    std::vector<std::string> MemoryLogSink::messages() const
+    {
+        std::lock_guard lock(m_data->mutex);
+        return m_data->messages;
+    }
+
+    void MemoryLogSink::clear()
+    {
+        std::lock_guard lock(m_data->mutex);
+        m_data->messages.clear();
+    }
+} // namespace vre
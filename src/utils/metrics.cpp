@@ -0,0 +1,445 @@
+#include "vr_engine/utils/metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vre
+{
+    // --=== Utils ===--
+
+    namespace metrics_utils
+    {
+        template<typename T>
+        struct NamedMetric
+        {
+            std::string        name;
+            std::unique_ptr<T> metric;
+        };
+
+        template<typename T>
+        T &find_or_create(std::vector<NamedMetric<T>> &metrics, const std::string &name)
+        {
+            // Linear search: metrics are looked up once, then their reference is kept
+            for (auto &named_metric : metrics)
+            {
+                if (named_metric.name == name)
+                {
+                    return *named_metric.metric;
+                }
+            }
+            return *metrics.emplace_back(NamedMetric<T> {name, std::make_unique<T>()}).metric;
+        }
+
+        void update_min(std::atomic<uint64_t> &target, uint64_t value)
+        {
+            auto current = target.load(std::memory_order_relaxed);
+            while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        void update_max(std::atomic<uint64_t> &target, uint64_t value)
+        {
+            auto current = target.load(std::memory_order_relaxed);
+            while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        /**
+         * Computes the summary of bucket counts. Values are only known up to their bucket, so the percentiles use the middle of the
+         * bucket, clamped to the known bounds.
+         */
+        HistogramSummary summarize(const uint64_t *counts, uint64_t sum, uint64_t known_min, uint64_t known_max)
+        {
+            HistogramSummary summary;
+            int64_t          first = -1;
+            int64_t          last  = -1;
+            for (uint32_t i = 0; i < Histogram::BUCKET_COUNT; i++)
+            {
+                if (counts[i] != 0)
+                {
+                    summary.count += counts[i];
+                    if (first < 0)
+                    {
+                        first = i;
+                    }
+                    last = i;
+                }
+            }
+            if (summary.count == 0)
+            {
+                return summary;
+            }
+
+            summary.min  = std::max(Histogram::bucket_lower_bound(static_cast<uint32_t>(first)), known_min);
+            summary.max  = std::min(Histogram::bucket_upper_bound(static_cast<uint32_t>(last)), known_max);
+            summary.mean = static_cast<double>(sum) / static_cast<double>(summary.count);
+
+            const double quantiles[3] = {0.50, 0.95, 0.99};
+            uint64_t    *outputs[3]   = {&summary.p50, &summary.p95, &summary.p99};
+            uint32_t     q            = 0;
+            uint64_t     cumulated    = 0;
+            for (uint32_t i = static_cast<uint32_t>(first); i <= static_cast<uint32_t>(last) && q < 3; i++)
+            {
+                cumulated += counts[i];
+                while (q < 3 && static_cast<double>(cumulated) >= quantiles[q] * static_cast<double>(summary.count))
+                {
+                    const auto lower = Histogram::bucket_lower_bound(i);
+                    const auto upper = Histogram::bucket_upper_bound(i);
+                    *outputs[q]      = std::clamp(lower + (upper - lower) / 2, summary.min, summary.max);
+                    q++;
+                }
+            }
+            return summary;
+        }
+    } // namespace metrics_utils
+    using namespace metrics_utils;
+
+    // --=== Histogram ===--
+
+    uint32_t Histogram::bucket_index(uint64_t value)
+    {
+        if (value < SUB_BUCKET_COUNT)
+        {
+            return static_cast<uint32_t>(value);
+        }
+
+        // Keep the SUB_BUCKET_BITS + 1 most significant bits
+        const auto shift    = static_cast<uint32_t>(std::bit_width(value)) - 1 - SUB_BUCKET_BITS;
+        const auto mantissa = static_cast<uint32_t>(value >> shift);
+        return shift * SUB_BUCKET_COUNT + mantissa;
+    }
+
+    uint64_t Histogram::bucket_lower_bound(uint32_t index)
+    {
+        if (index < 2 * SUB_BUCKET_COUNT)
+        {
+            return index;
+        }
+        const uint32_t shift    = index / SUB_BUCKET_COUNT - 1;
+        const uint64_t mantissa = index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+        return mantissa << shift;
+    }
+
+    uint64_t Histogram::bucket_upper_bound(uint32_t index)
+    {
+        if (index < 2 * SUB_BUCKET_COUNT)
+        {
+            return index;
+        }
+        const uint32_t shift = index / SUB_BUCKET_COUNT - 1;
+        return bucket_lower_bound(index) + ((uint64_t(1) << shift) - 1);
+    }
+
+    void Histogram::record(uint64_t value)
+    {
+        m_counts[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+        update_min(m_min, value);
+        update_max(m_max, value);
+    }
+
+    HistogramSummary Histogram::summary() const
+    {
+        std::vector<uint64_t> counts(BUCKET_COUNT);
+        for (uint32_t i = 0; i < BUCKET_COUNT; i++)
+        {
+            counts[i] = m_counts[i].load(std::memory_order_relaxed);
+        }
+        return summarize(counts.data(),
+                         m_sum.load(std::memory_order_relaxed),
+                         m_min.load(std::memory_order_relaxed),
+                         m_max.load(std::memory_order_relaxed));
+    }
+
+    HistogramSummary Histogram::window_summary() const
+    {
+        std::vector<uint64_t> counts(BUCKET_COUNT);
+        for (uint32_t i = 0; i < BUCKET_COUNT; i++)
+        {
+            counts[i] = m_counts[i].load(std::memory_order_relaxed) - m_window_start_counts[i];
+        }
+        // The exact bounds are only known for the whole lifetime, so the window ones are derived from the buckets
+        return summarize(counts.data(),
+                         m_sum.load(std::memory_order_relaxed) - m_window_start_sum,
+                         m_min.load(std::memory_order_relaxed),
+                         m_max.load(std::memory_order_relaxed));
+    }
+
+    void Histogram::end_window()
+    {
+        for (uint32_t i = 0; i < BUCKET_COUNT; i++)
+        {
+            m_window_start_counts[i] = m_counts[i].load(std::memory_order_relaxed);
+        }
+        m_window_start_sum = m_sum.load(std::memory_order_relaxed);
+    }
+
+    // --=== Registry ===--
+
+    struct MetricsRegistry::Data
+    {
+        mutable std::mutex                  mutex;
+        std::vector<NamedMetric<Counter>>   counters;
+        std::vector<NamedMetric<Gauge>>     gauges;
+        std::vector<NamedMetric<Histogram>> histograms;
+    };
+
+    MetricsRegistry::MetricsRegistry() : m_data(std::make_unique<Data>()) {}
+
+    MetricsRegistry::~MetricsRegistry() = default;
+
+    MetricsRegistry &MetricsRegistry::global()
+    {
+        static MetricsRegistry instance;
+        return instance;
+    }
+
+    Counter &MetricsRegistry::counter(const std::string &name)
+    {
+        std::lock_guard lock(m_data->mutex);
+        return find_or_create(m_data->counters, name);
+    }
+
+    Gauge &MetricsRegistry::gauge(const std::string &name)
+    {
+        std::lock_guard lock(m_data->mutex);
+        return find_or_create(m_data->gauges, name);
+    }
+
+    Histogram &MetricsRegistry::histogram(const std::string &name)
+    {
+        std::lock_guard lock(m_data->mutex);
+        return find_or_create(m_data->histograms, name);
+    }
+
+    void MetricsRegistry::end_window()
+    {
+        std::lock_guard lock(m_data->mutex);
+        for (auto &histogram : m_data->histograms)
+        {
+            histogram.metric->end_window();
+        }
+    }
+
+    MetricsSnapshot MetricsRegistry::snapshot(double timestamp) const
+    {
+        MetricsSnapshot snapshot = {.timestamp = timestamp};
+
+        std::lock_guard lock(m_data->mutex);
+        snapshot.counters.reserve(m_data->counters.size());
+        for (const auto &counter : m_data->counters)
+        {
+            snapshot.counters.push_back({counter.name, counter.metric->value()});
+        }
+        snapshot.gauges.reserve(m_data->gauges.size());
+        for (const auto &gauge : m_data->gauges)
+        {
+            snapshot.gauges.push_back({gauge.name, gauge.metric->value()});
+        }
+        snapshot.histograms.reserve(m_data->histograms.size());
+        for (const auto &histogram : m_data->histograms)
+        {
+            snapshot.histograms.push_back({histogram.name, histogram.metric->window_summary()});
+        }
+        return snapshot;
+    }
+
+    bool MetricsRegistry::append_csv(const char *path, double timestamp) const
+    {
+        return snapshot(timestamp).append_csv(path);
+    }
+
+    bool MetricsRegistry::write_json(const char *path) const
+    {
+        return snapshot(0.0).write_json(path);
+    }
+
+    // --=== Snapshots ===--
+
+    bool MetricsSnapshot::append_csv(const char *path) const
+    {
+        FILE *file = fopen(path, "a");
+        if (!file)
+        {
+            return false;
+        }
+
+        // Only write the header once
+        fseek(file, 0, SEEK_END);
+        if (ftell(file) == 0)
+        {
+            fputs("timestamp,name,type,value,count,min,mean,p50,p95,p99,max\n", file);
+        }
+
+        for (const auto &counter : counters)
+        {
+            fprintf(file,
+                    "%.3f,%s,counter,%llu,,,,,,,\n",
+                    timestamp,
+                    counter.name.c_str(),
+                    static_cast<unsigned long long>(counter.value));
+        }
+        for (const auto &gauge : gauges)
+        {
+            if (std::isfinite(gauge.value))
+            {
+                fprintf(file, "%.3f,%s,gauge,%g,,,,,,,\n", timestamp, gauge.name.c_str(), gauge.value);
+            }
+            else
+            {
+                fprintf(file, "%.3f,%s,gauge,,,,,,,,\n", timestamp, gauge.name.c_str());
+            }
+        }
+        for (const auto &histogram : histograms)
+        {
+            const auto &s = histogram.value;
+            fprintf(file,
+                    "%.3f,%s,histogram,,%llu,%llu,%.3f,%llu,%llu,%llu,%llu\n",
+                    timestamp,
+                    histogram.name.c_str(),
+                    static_cast<unsigned long long>(s.count),
+                    static_cast<unsigned long long>(s.min),
+                    s.mean,
+                    static_cast<unsigned long long>(s.p50),
+                    static_cast<unsigned long long>(s.p95),
+                    static_cast<unsigned long long>(s.p99),
+                    static_cast<unsigned long long>(s.max));
+        }
+
+        return fclose(file) == 0;
+    }
+
+    bool MetricsSnapshot::write_json(const char *path) const
+    {
+        FILE *file = fopen(path, "w");
+        if (!file)
+        {
+            return false;
+        }
+
+        fputs("{\n  \"counters\": {", file);
+        for (size_t i = 0; i < counters.size(); i++)
+        {
+            fprintf(file,
+                    "%s\n    \"%s\": %llu",
+                    i == 0 ? "" : ",",
+                    counters[i].name.c_str(),
+                    static_cast<unsigned long long>(counters[i].value));
+        }
+
+        fputs("\n  },\n  \"gauges\": {", file);
+        for (size_t i = 0; i < gauges.size(); i++)
+        {
+            // JSON has no representation for NaN and infinities
+            fprintf(file, "%s\n    \"%s\": ", i == 0 ? "" : ",", gauges[i].name.c_str());
+            if (std::isfinite(gauges[i].value))
+            {
+                fprintf(file, "%g", gauges[i].value);
+            }
+            else
+            {
+                fputs("null", file);
+            }
+        }
+
+        fputs("\n  },\n  \"histograms\": {", file);
+        for (size_t i = 0; i < histograms.size(); i++)
+        {
+            const auto &s = histograms[i].value;
+            fprintf(file,
+                    "%s\n    \"%s\": {\"count\": %llu, \"min\": %llu, \"mean\": %.3f, \"p50\": %llu, \"p95\": %llu, \"p99\": %llu, "
+                    "\"max\": %llu}",
+                    i == 0 ? "" : ",",
+                    histograms[i].name.c_str(),
+                    static_cast<unsigned long long>(s.count),
+                    static_cast<unsigned long long>(s.min),
+                    s.mean,
+                    static_cast<unsigned long long>(s.p50),
+                    static_cast<unsigned long long>(s.p95),
+                    static_cast<unsigned long long>(s.p99),
+                    static_cast<unsigned long long>(s.max));
+        }
+        fputs("\n  }\n}\n", file);
+
+        return fclose(file) == 0;
+    }
+
+    // --=== Writer ===--
+
+    struct MetricsWriter::Data
+    {
+        std::string csv_path;
+        std::string json_path;
+
+        std::mutex                   mutex;
+        std::condition_variable      condition;
+        std::vector<MetricsSnapshot> pending     = {};
+        bool                         should_stop = false;
+        std::thread                  thread;
+
+        void run()
+        {
+            std::vector<MetricsSnapshot> snapshots;
+            std::unique_lock             lock(mutex);
+            while (true)
+            {
+                condition.wait(lock, [this]() { return should_stop || !pending.empty(); });
+                if (pending.empty())
+                {
+                    return;
+                }
+                std::swap(snapshots, pending);
+
+                lock.unlock();
+                for (const auto &snapshot : snapshots)
+                {
+                    if (!csv_path.empty())
+                    {
+                        snapshot.append_csv(csv_path.c_str());
+                    }
+                }
+                // Only the last snapshot is kept in the JSON file
+                if (!json_path.empty())
+                {
+                    snapshots.back().write_json(json_path.c_str());
+                }
+                snapshots.clear();
+                lock.lock();
+            }
+        }
+    };
+
+    MetricsWriter::MetricsWriter(const char *csv_path, const char *json_path) : m_data(std::make_unique<Data>())
+    {
+        m_data->csv_path  = csv_path != nullptr ? csv_path : "";
+        m_data->json_path = json_path != nullptr ? json_path : "";
+        m_data->thread    = std::thread([data = m_data.get()]() { data->run(); });
+    }
+
+    MetricsWriter::~MetricsWriter()
+    {
+        {
+            std::lock_guard lock(m_data->mutex);
+            m_data->should_stop = true;
+        }
+        m_data->condition.notify_one();
+        m_data->thread.join();
+    }
+
+    void MetricsWriter::write(MetricsSnapshot &&snapshot)
+    {
+        {
+            std::lock_guard lock(m_data->mutex);
+            m_data->pending.push_back(std::move(snapshot));
+        }
+        m_data->condition.notify_one();
+    }
+} // namespace vre
@@ -1,7 +1,7 @@
 #include "vr_engine/utils/openxr_utils.h"
 
-#include <iostream>
 #include <vr_engine/core/global.h>
+#include <vr_engine/utils/log.h>
 
 namespace vre
 {
@@ -10,6 +10,8 @@ namespace vre
         switch (result)
         {
             case XR_SUCCESS: return "XR_SUCCESS";
+            case XR_FRAME_DISCARDED: return "XR_FRAME_DISCARDED";
+            case XR_SESSION_LOSS_PENDING: return "XR_SESSION_LOSS_PENDING";
             case XR_ERROR_API_VERSION_UNSUPPORTED: return "XR_ERROR_API_VERSION_UNSUPPORTED";
             case XR_ERROR_FUNCTION_UNSUPPORTED: return "XR_ERROR_FUNCTION_UNSUPPORTED";
             case XR_ERROR_GRAPHICS_DEVICE_INVALID: return "XR_ERROR_GRAPHICS_DEVICE_INVALID";
@@ -25,12 +27,12 @@ namespace vre
         if (result != XR_SUCCESS)
         {
             // Pretty print error
-            std::cerr << "[OpenXR Error] An OpenXR function call returned XrResult = " << xr_result_to_string(result) << "\n";
+            VRE_LOG_ERROR("An OpenXR function call returned XrResult = {}", xr_result_to_string(result));
 
             // Optional custom error message precision
             if (!error_message.empty())
             {
-                std::cerr << "Precision: " << error_message << "\n";
+                VRE_LOG_ERROR("Precision: {}", error_message);
             }
         }
     }
@@ -0,0 +1,271 @@
+#include "vr_engine/utils/profiler.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vr_engine/utils/data/spsc_queue.h>
+
+// --=== Constants ===--
+
+// Number of events per thread. Must be a power of 2.
+#define PROFILER_BUFFER_CAPACITY (1 << 16)
+
+namespace vre
+{
+    // --=== Types ===--
+
+    /**
+     * Events of a thread. The owning thread is the only producer, and the export is the only consumer. Events are dropped when the
+     * buffer is full, so that the producer never waits.
+     */
+    struct ProfilerThreadBuffer
+    {
+        SpscQueue<ProfilerEvent, PROFILER_BUFFER_CAPACITY> events;
+        std::atomic<uint64_t>                              dropped     = 0;
+        uint32_t                                           thread_id   = 0;
+        std::atomic<const char *>                          thread_name = nullptr;
+
+        inline void push(const ProfilerEvent &event)
+        {
+            if (!events.try_push(event))
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    /**
+     * Owns the buffers of all threads. Buffers are never freed before the end of the program: the buffer of an exited thread goes to
+     * the free list, and is reused by a new thread once its events were exported or cleared, so that they keep the id of their
+     * thread in the trace.
+     */
+    struct ProfilerRegistry
+    {
+        std::mutex                                         mutex;
+        std::vector<std::unique_ptr<ProfilerThreadBuffer>> buffers;
+        std::vector<ProfilerThreadBuffer *>                free_buffers;
+        uint32_t                                           thread_count = 0;
+
+        ProfilerThreadBuffer *acquire_buffer()
+        {
+            std::lock_guard       lock(mutex);
+            ProfilerThreadBuffer *buffer = nullptr;
+            for (auto it = free_buffers.begin(); it != free_buffers.end(); ++it)
+            {
+                if ((*it)->events.size() == 0)
+                {
+                    buffer = *it;
+                    free_buffers.erase(it);
+                    break;
+                }
+            }
+            if (buffer == nullptr)
+            {
+                buffer = buffers.emplace_back(std::make_unique<ProfilerThreadBuffer>()).get();
+            }
+
+            // Each thread has its own id, even with a reused buffer
+            buffer->thread_id = ++thread_count;
+            buffer->thread_name.store(nullptr, std::memory_order_relaxed);
+            return buffer;
+        }
+
+        void release_buffer(ProfilerThreadBuffer *buffer)
+        {
+            std::lock_guard lock(mutex);
+            free_buffers.push_back(buffer);
+        }
+    };
+
+    // --=== Utils ===--
+
+    namespace profiler_utils
+    {
+        /**
+         * Reference points to convert ticks to real time. They are taken during the static initialization, and not with the registry,
+         * which is only created by the first event: a zone takes its start tick before it pushes that event.
+         */
+        const uint64_t                              start_ticks = Profiler::now();
+        const std::chrono::steady_clock::time_point start_time  = std::chrono::steady_clock::now();
+
+        ProfilerRegistry &registry()
+        {
+            static ProfilerRegistry instance;
+            return instance;
+        }
+
+        /** Buffer of the current thread, returned to the registry when the thread exits. */
+        struct ThreadBufferHandle
+        {
+            ProfilerThreadBuffer *buffer = registry().acquire_buffer();
+
+            ~ThreadBufferHandle() { registry().release_buffer(buffer); }
+        };
+
+        inline ProfilerThreadBuffer &thread_buffer()
+        {
+            // The buffer is only acquired once per thread
+            thread_local ThreadBufferHandle handle;
+            return *handle.buffer;
+        }
+
+        void write_escaped_string(FILE *file, const char *str)
+        {
+            fputc('"', file);
+            for (const char *c = str; *c != '\0'; c++)
+            {
+                if (*c == '"' || *c == '\\')
+                {
+                    fputc('\\', file);
+                }
+                fputc(*c, file);
+            }
+            fputc('"', file);
+        }
+    } // namespace profiler_utils
+    using namespace profiler_utils;
+
+    // --=== API ===--
+
+    void Profiler::record_zone(const char *name, uint64_t start, uint64_t end)
+    {
+        ProfilerEvent event;
+        event.name      = name;
+        event.timestamp = start;
+        event.duration  = end - start;
+        event.type      = ProfilerEventType::ZONE;
+        thread_buffer().push(event);
+    }
+
+    void Profiler::frame_mark()
+    {
+        ProfilerEvent event;
+        event.name      = "Frame";
+        event.timestamp = now();
+        event.type      = ProfilerEventType::FRAME_MARK;
+        thread_buffer().push(event);
+    }
+
+    void Profiler::counter(const char *name, double value)
+    {
+        ProfilerEvent event;
+        event.name      = name;
+        event.timestamp = now();
+        event.value     = value;
+        event.type      = ProfilerEventType::COUNTER;
+        thread_buffer().push(event);
+    }
+
+    void Profiler::set_thread_name(const char *name)
+    {
+        thread_buffer().thread_name.store(name, std::memory_order_release);
+    }
+
+    void Profiler::clear()
+    {
+        auto           &reg = registry();
+        std::lock_guard lock(reg.mutex);
+        for (auto &buffer : reg.buffers)
+        {
+            buffer->events.clear();
+            buffer->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t Profiler::dropped_event_count()
+    {
+        auto           &reg = registry();
+        std::lock_guard lock(reg.mutex);
+
+        uint64_t total = 0;
+        for (auto &buffer : reg.buffers)
+        {
+            total += buffer->dropped.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    bool Profiler::export_chrome_trace(const char *path)
+    {
+        FILE *file = fopen(path, "w");
+        if (!file)
+        {
+            return false;
+        }
+
+        auto           &reg = registry();
+        std::lock_guard lock(reg.mutex);
+
+        // Compute the duration of a tick, in microseconds, from the elapsed time since the start
+        const auto   end_ticks  = now();
+        const auto   end_time   = std::chrono::steady_clock::now();
+        const double elapsed_us = std::chrono::duration<double, std::micro>(end_time - start_time).count();
+        const double tick_us    = end_ticks > start_ticks ? elapsed_us / static_cast<double>(end_ticks - start_ticks) : 0.0;
+
+        // Zones started during the static initialization of other files can still be older than the reference
+        auto to_us = [&](uint64_t ticks)
+        {
+            return ticks > start_ticks ? static_cast<double>(ticks - start_ticks) * tick_us : 0.0;
+        };
+
+        fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file);
+        bool first = true;
+
+        for (auto &buffer : reg.buffers)
+        {
+            const auto tid = buffer->thread_id;
+
+            // Thread name metadata
+            const char *thread_name = buffer->thread_name.load(std::memory_order_acquire);
+            if (thread_name != nullptr)
+            {
+                fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", tid);
+                write_escaped_string(file, thread_name);
+                fputs("}}", file);
+                first = false;
+            }
+
+            // Drain the buffer
+            buffer->events.consume_all(
+                [&](const ProfilerEvent &event)
+                {
+                    // JSON has no representation for NaN and infinities
+                    if (event.type == ProfilerEventType::COUNTER && !std::isfinite(event.value))
+                    {
+                        return;
+                    }
+
+                    fputs(first ? "{\"name\":" : ",\n{\"name\":", file);
+                    write_escaped_string(file, event.name);
+                    first = false;
+
+                    switch (event.type)
+                    {
+                        case ProfilerEventType::ZONE:
+                            fprintf(file,
+                                    ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                                    tid,
+                                    to_us(event.timestamp),
+                                    static_cast<double>(event.duration) * tick_us);
+                            break;
+                        case ProfilerEventType::FRAME_MARK:
+                            fprintf(file, ",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", tid, to_us(event.timestamp));
+                            break;
+                        case ProfilerEventType::COUNTER:
+                            fprintf(file,
+                                    ",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%g}}",
+                                    tid,
+                                    to_us(event.timestamp),
+                                    event.value);
+                            break;
+                    }
+                });
+        }
+
+        fputs("\n]}\n", file);
+        return fclose(file) == 0;
+    }
+} // namespace vre
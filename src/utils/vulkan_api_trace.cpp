@@ -0,0 +1,143 @@
+#ifdef RENDERER_VULKAN
+
+#include "vr_engine/utils/vulkan_utils.h"
+
+#include <volk.h>
+#include <vr_engine/utils/api_trace.h>
+#include <vr_engine/utils/profiler.h>
+
+namespace vre
+{
+#ifdef ENABLE_API_TRACE
+
+    // --=== Traced functions ===--
+
+    // Functions that can block the calling thread. Their duration is measured.
+#define VRE_VULKAN_TIMED_FUNCTIONS(X) \
+    X(vkWaitForFences)                \
+    X(vkQueueSubmit)                  \
+    X(vkQueueWaitIdle)                \
+    X(vkDeviceWaitIdle)               \
+    X(vkAllocateMemory)
+
+    // Functions that are only counted
+#define VRE_VULKAN_COUNTED_FUNCTIONS(X) \
+    X(vkAllocateCommandBuffers)         \
+    X(vkAllocateDescriptorSets)         \
+    X(vkBeginCommandBuffer)             \
+    X(vkBindBufferMemory)               \
+    X(vkBindImageMemory)                \
+    X(vkCmdBeginRenderPass)             \
+    X(vkCmdBeginRenderingKHR)           \
+    X(vkCmdBindDescriptorSets)          \
+    X(vkCmdBindIndexBuffer)             \
+    X(vkCmdBindPipeline)                \
+    X(vkCmdBindVertexBuffers)           \
+    X(vkCmdCopyBuffer)                  \
+    X(vkCmdCopyBufferToImage)           \
+    X(vkCmdDispatch)                    \
+    X(vkCmdDraw)                        \
+    X(vkCmdDrawIndexed)                 \
+    X(vkCmdDrawIndexedIndirect)         \
+    X(vkCmdEndRenderPass)               \
+    X(vkCmdEndRenderingKHR)             \
+    X(vkCmdExecuteCommands)             \
+    X(vkCmdPipelineBarrier)             \
+    X(vkCmdPushConstants)               \
+    X(vkCmdResetQueryPool)              \
+    X(vkCmdSetScissor)                  \
+    X(vkCmdSetViewport)                 \
+    X(vkCmdWriteTimestamp)              \
+    X(vkCreateBuffer)                   \
+    X(vkCreateFence)                    \
+    X(vkCreateFramebuffer)              \
+    X(vkCreateImage)                    \
+    X(vkCreateImageView)                \
+    X(vkCreateSemaphore)                \
+    X(vkCreateShaderModule)             \
+    X(vkDestroyBuffer)                  \
+    X(vkDestroyImage)                   \
+    X(vkEndCommandBuffer)               \
+    X(vkFreeMemory)                     \
+    X(vkGetQueryPoolResults)            \
+    X(vkMapMemory)                      \
+    X(vkResetCommandBuffer)             \
+    X(vkResetDescriptorPool)            \
+    X(vkResetFences)                    \
+    X(vkUnmapMemory)                    \
+    X(vkUpdateDescriptorSets)
+
+    namespace vulkan_api_trace_utils
+    {
+        template<typename T>
+        struct MemberType;
+
+        template<typename Class, typename Value>
+        struct MemberType<Value Class::*>
+        {
+            using type = Value;
+        };
+
+        /**
+         * Wrapper of a function of the device table. The pointer in the table is replaced by the wrapper, which counts the call, then
+         * calls the original function. The original is stored statically, so only one device can be traced.
+         */
+        template<auto Function, typename Pfn = typename MemberType<decltype(Function)>::type>
+        struct TracedFunction;
+
+        template<auto Function, typename Result, typename... Args>
+        struct TracedFunction<Function, Result(VKAPI_PTR *)(Args...)>
+        {
+            static inline Result(VKAPI_PTR *original)(Args...) = nullptr;
+            static inline ApiEntryPoint *entry_point             = nullptr;
+
+            static Result VKAPI_PTR call(Args... args)
+            {
+                ApiCall api_call(*entry_point);
+#ifdef ENABLE_PROFILER
+                // Only blocking functions are worth a zone in the trace
+                if (entry_point->is_timed)
+                {
+                    ProfilerZone zone(entry_point->name);
+                    return original(args...);
+                }
+#endif
+                return original(args...);
+            }
+
+            static void install(VolkDeviceTable &device_table, const char *name, bool is_timed)
+            {
+                auto &function = device_table.*Function;
+                // Functions of extensions that are not enabled are not loaded
+                if (function == nullptr || function == &call)
+                {
+                    return;
+                }
+                original    = function;
+                entry_point = &ApiTrace::entry_point(name, is_timed);
+                function    = &call;
+            }
+        };
+    } // namespace vulkan_api_trace_utils
+    using namespace vulkan_api_trace_utils;
+
+#endif
+
+    // --=== API ===--
+
+    void install_vulkan_api_trace([[maybe_unused]] VolkDeviceTable &device_table)
+    {
+#ifdef ENABLE_API_TRACE
+#define VRE_INSTALL_TIMED(function)   TracedFunction<&VolkDeviceTable::function>::install(device_table, #function, true);
+#define VRE_INSTALL_COUNTED(function) TracedFunction<&VolkDeviceTable::function>::install(device_table, #function, false);
+
+        VRE_VULKAN_TIMED_FUNCTIONS(VRE_INSTALL_TIMED)
+        VRE_VULKAN_COUNTED_FUNCTIONS(VRE_INSTALL_COUNTED)
+
+#undef VRE_INSTALL_TIMED
+#undef VRE_INSTALL_COUNTED
+#endif
+    }
+} // namespace vre
+
+#endif
@@ -1,7 +1,8 @@
 #ifdef RENDERER_VULKAN
 
 #include "vr_engine/utils/vulkan_utils.h"
-#include <iostream>
+
+#include <vr_engine/utils/log.h>
 
 namespace vre {
 
@@ -24,18 +25,18 @@ namespace vre {
         // Warnings
         if (result == VK_SUBOPTIMAL_KHR)
         {
-            std::cout << "[Vulkan Warning] A Vulkan function call returned VkResult = " << vk_result_to_string(result) << "\n";
+            VRE_LOG_WARNING("A Vulkan function call returned VkResult = {}", vk_result_to_string(result));
         }
         // Errors
         else if (result != VK_SUCCESS)
         {
             // Pretty print error
-            std::cerr << "[Vulkan Error] A Vulkan function call returned VkResult = " << vk_result_to_string(result) << "\n";
+            VRE_LOG_ERROR("A Vulkan function call returned VkResult = {}", vk_result_to_string(result));
 
             // Optional custom error message precision
             if (!error_message.empty())
             {
-                std::cerr << "Precision: " << error_message << "\n";
+                VRE_LOG_ERROR("Precision: {}", error_message);
             }
         }
     }
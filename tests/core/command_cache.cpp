@@ -0,0 +1,57 @@
+#include <test_framework/test_framework.hpp>
+#include <vector>
+#include <vr_engine/core/renderer/command_cache.h>
+
+using namespace vre;
+
+#define VIEW_PASS 1
+
+TEST
+{
+    EXPECT_THROWS(CommandCache<int>::key(0, 1));
+
+    // The hash depends on every input, and on their order
+    const auto hash_a = ContentHash().add(1u).add(2.0f).value();
+    EXPECT_EQ(hash_a, ContentHash().add(1u).add(2.0f).value());
+    EXPECT_TRUE(hash_a != ContentHash().add(1u).add(3.0f).value());
+    EXPECT_TRUE(ContentHash().add(1u).add(2u).value() != ContentHash().add(2u).add(1u).value());
+
+    CommandCache<int> cache;
+    const auto        left  = CommandCache<int>::key(VIEW_PASS, 0);
+    const auto        right = CommandCache<int>::key(VIEW_PASS, 1);
+
+    // The first lookup of a key gives a null buffer to allocate and record
+    auto lookup = cache.lookup(left, hash_a, 1);
+    EXPECT_FALSE(lookup.is_recorded);
+    EXPECT_EQ(*lookup.buffer, 0);
+    *lookup.buffer = 42;
+
+    // Then the buffer is replayed while the hash is the same
+    lookup = cache.lookup(left, hash_a, 2);
+    EXPECT_TRUE(lookup.is_recorded);
+    EXPECT_EQ(*lookup.buffer, 42);
+
+    // And recorded again in place when the hash changes, or when the entry is invalidated
+    lookup = cache.lookup(left, hash_a + 1, 3);
+    EXPECT_FALSE(lookup.is_recorded);
+    EXPECT_EQ(*lookup.buffer, 42);
+    EXPECT_TRUE(cache.lookup(left, hash_a + 1, 4).is_recorded);
+    cache.invalidate(left);
+    EXPECT_FALSE(cache.lookup(left, hash_a + 1, 5).is_recorded);
+    cache.invalidate_all();
+    EXPECT_FALSE(cache.lookup(left, hash_a + 1, 6).is_recorded);
+
+    // Entries that are not looked up anymore are evicted, and their buffer released
+    *cache.lookup(right, hash_a, 6).buffer = 7;
+    std::vector<int> released;
+    const auto       release = [&](int buffer) { released.push_back(buffer); };
+    cache.lookup(left, hash_a + 1, 10);
+    cache.evict_unused(10, 2, release);
+    EXPECT_EQ(cache.count(), static_cast<size_t>(1));
+    EXPECT_TRUE((released == std::vector<int> {7}));
+    EXPECT_TRUE(cache.lookup(left, hash_a + 1, 11).is_recorded);
+
+    cache.clear(release);
+    EXPECT_EQ(cache.count(), static_cast<size_t>(0));
+    EXPECT_TRUE((released == std::vector<int> {7, 42}));
+}
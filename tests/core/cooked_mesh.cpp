@@ -0,0 +1,119 @@
+#include <cmath>
+#include <cstring>
+#include <test_framework/test_framework.hpp>
+#include <vector>
+#include <vr_engine/core/renderer/cooked_mesh.h>
+
+using namespace vre;
+
+#define GRID_SIZE 16
+
+TEST
+{
+    // Quantization
+    EXPECT_EQ(quantize_unorm16(0.0f), static_cast<uint16_t>(0));
+    EXPECT_EQ(quantize_unorm16(1.0f), static_cast<uint16_t>(65535));
+    EXPECT_EQ(quantize_snorm16(-1.0f), static_cast<int16_t>(-32767));
+    EXPECT_EQ(quantize_half(1.0f), static_cast<uint16_t>(0x3C00));
+    EXPECT_EQ(quantize_half(-2.0f), static_cast<uint16_t>(0xC000));
+    EXPECT_EQ(quantize_half(65504.0f), static_cast<uint16_t>(0x7BFF));
+    EXPECT_EQ(quantize_half(1e6f), static_cast<uint16_t>(0x7C00));
+    EXPECT_TRUE(dequantize_half(quantize_half(0.5f)) == 0.5f);
+    EXPECT_TRUE(fabsf(dequantize_half(quantize_half(0.3333f)) - 0.3333f) < 1e-3f);
+    EXPECT_TRUE(fabsf(dequantize_half(quantize_half(3e-5f)) - 3e-5f) < 1e-7f);
+
+    const float normals[][3] = {
+        {0.0f, 0.0f, 1.0f},
+        {0.0f, 0.0f, -1.0f},
+        {0.6f, -0.8f, 0.0f},
+        {0.48f, 0.6f, -0.64f},
+        {-0.57735f, -0.57735f, -0.57735f},
+    };
+    for (const auto &normal : normals)
+    {
+        int16_t encoded[2];
+        float   decoded[3];
+        encode_octahedral(normal, encoded);
+        decode_octahedral(encoded, decoded);
+        EXPECT_TRUE(normal[0] * decoded[0] + normal[1] * decoded[1] + normal[2] * decoded[2] > 0.9999f);
+    }
+
+    // Cook a grid, whose vertices are given in reverse order and with an unused one
+    std::vector<MeshVertex> vertices((GRID_SIZE + 1) * (GRID_SIZE + 1) + 1);
+    for (uint32_t y = 0; y <= GRID_SIZE; y++)
+    {
+        for (uint32_t x = 0; x <= GRID_SIZE; x++)
+        {
+            auto &vertex = vertices[vertices.size() - 1 - (y * (GRID_SIZE + 1) + x)];
+            vertex       = {
+                .position = {static_cast<float>(x) * 0.5f - 2.0f, static_cast<float>(y) * 0.25f, 3.0f},
+                .normal   = {0.0f, 0.0f, 1.0f},
+                .uv       = {static_cast<float>(x) / GRID_SIZE, static_cast<float>(y) / GRID_SIZE},
+            };
+        }
+    }
+    std::vector<uint32_t> indices;
+    const auto            vertex_index = [&](uint32_t x, uint32_t y)
+    { return static_cast<uint32_t>(vertices.size() - 1 - (y * (GRID_SIZE + 1) + x)); };
+    for (uint32_t y = 0; y < GRID_SIZE; y++)
+    {
+        for (uint32_t x = 0; x < GRID_SIZE; x++)
+        {
+            indices.insert(indices.end(), {vertex_index(x, y), vertex_index(x + 1, y), vertex_index(x, y + 1)});
+            indices.insert(indices.end(), {vertex_index(x + 1, y), vertex_index(x + 1, y + 1), vertex_index(x, y + 1)});
+        }
+    }
+    EXPECT_THROWS(cook_mesh(vertices.data(), 0, indices.data(), indices.size()));
+
+    const auto mesh = cook_mesh(vertices.data(), vertices.size(), indices.data(), indices.size());
+    EXPECT_EQ(mesh.vertices.size(), vertices.size() - 1);
+    EXPECT_EQ(mesh.indices[0], 0u);
+
+    // The flat grid simplifies down to a few triangles, without error
+    EXPECT_TRUE(mesh.lods.size() >= 2);
+    EXPECT_EQ(static_cast<size_t>(mesh.lods[0].index_count), indices.size());
+    EXPECT_TRUE(mesh.lods.back().index_count < indices.size() / 4 && mesh.lods.back().error < 1e-3f);
+    EXPECT_EQ(mesh.lods.back().first_index + mesh.lods.back().index_count, static_cast<uint32_t>(mesh.indices.size()));
+    EXPECT_TRUE(mesh.position_offset[0] == -2.0f && mesh.position_scale[0] == 8.0f && mesh.position_scale[2] == 0.0f);
+
+    // Each vertex of the cooked mesh decodes to its vertex of the grid
+    bool attributes_match = true;
+    for (const auto index : mesh.indices)
+    {
+        const auto &cooked = mesh.vertices[index];
+        float       position[3];
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            position[k] = mesh.position_offset[k] + static_cast<float>(cooked.position[k]) / 65535.0f * mesh.position_scale[k];
+        }
+        const auto  x     = lroundf((position[0] + 2.0f) * 2.0f);
+        const auto  y     = lroundf(position[1] * 4.0f);
+        const auto &input = vertices[vertex_index(static_cast<uint32_t>(x), static_cast<uint32_t>(y))];
+        float       normal[3];
+        decode_octahedral(cooked.normal, normal);
+        attributes_match = attributes_match && fabsf(position[0] - input.position[0]) < 1e-3f
+                        && fabsf(position[1] - input.position[1]) < 1e-3f && position[2] == 3.0f && normal[2] > 0.9999f
+                        && fabsf(dequantize_half(cooked.uv[0]) - input.uv[0]) < 1e-3f
+                        && fabsf(dequantize_half(cooked.uv[1]) - input.uv[1]) < 1e-3f;
+    }
+    EXPECT_TRUE(attributes_match);
+
+    // Files
+    const auto data = serialize_cooked_mesh(mesh);
+    EXPECT_EQ(data.size(),
+              44 + mesh.lods.size() * sizeof(MeshLod) + mesh.vertices.size() * sizeof(CookedVertex)
+                  + mesh.indices.size() * sizeof(uint32_t));
+    const auto loaded = deserialize_cooked_mesh(data.data(), data.size());
+    EXPECT_TRUE(loaded.indices == mesh.indices);
+    EXPECT_TRUE(loaded.lods.size() == mesh.lods.size() && loaded.lods.back().index_count == mesh.lods.back().index_count);
+    EXPECT_TRUE(memcmp(loaded.vertices.data(), mesh.vertices.data(), mesh.vertices.size() * sizeof(CookedVertex)) == 0);
+    EXPECT_TRUE(loaded.position_scale[1] == mesh.position_scale[1]);
+    EXPECT_THROWS(deserialize_cooked_mesh(data.data(), data.size() - 1));
+    auto corrupted = data;
+    corrupted[0]   = 0;
+    EXPECT_THROWS(deserialize_cooked_mesh(corrupted.data(), corrupted.size()));
+
+    save_cooked_mesh("cooked_mesh_test.vrm", mesh);
+    EXPECT_TRUE(load_cooked_mesh("cooked_mesh_test.vrm").indices == mesh.indices);
+    EXPECT_THROWS(load_cooked_mesh("missing_cooked_mesh.vrm"));
+}
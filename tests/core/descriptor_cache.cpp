@@ -0,0 +1,80 @@
+#include <test_framework/test_framework.hpp>
+#include <vr_engine/core/renderer/descriptor_cache.h>
+
+using namespace vre;
+
+// A key whose hash only depends on its first byte, to force collisions
+struct CollidingKey
+{
+    uint8_t bytes[2] = {};
+
+    [[nodiscard]] uint64_t hash() const { return bytes[0]; }
+    [[nodiscard]] bool     operator==(const CollidingKey &other) const
+    {
+        return bytes[0] == other.bytes[0] && bytes[1] == other.bytes[1];
+    }
+};
+
+TEST
+{
+    // Counts of a layout, and of the sets of a pool that must hold several layouts
+    DescriptorCounts uniforms;
+    uniforms.add(6, 1);
+    uniforms.add(6, 2);
+    EXPECT_EQ(uniforms.count(6), 3u);
+    EXPECT_EQ(uniforms.count(7), 0u);
+
+    DescriptorCounts storage;
+    storage.add(7, 4);
+    DescriptorCounts pool;
+    EXPECT_TRUE(pool.include(uniforms));
+    EXPECT_TRUE(pool.include(storage));
+    EXPECT_FALSE(pool.include(uniforms));
+    EXPECT_EQ(pool.count(6), 3u);
+    EXPECT_EQ(pool.count(7), 4u);
+    EXPECT_TRUE(pool.contains(uniforms));
+    EXPECT_TRUE(pool.contains(storage));
+    storage.add(7, 1);
+    EXPECT_FALSE(pool.contains(storage));
+    EXPECT_TRUE(pool.include(storage));
+    EXPECT_EQ(pool.count(7), 5u);
+
+    // Keys are compared entirely
+    const uint32_t binding = 3;
+    DescriptorKey  key;
+    key.add(binding).add(uint64_t {42});
+    DescriptorKey same_key;
+    same_key.add(binding).add(uint64_t {42});
+    DescriptorKey other_key;
+    other_key.add(binding).add(uint64_t {43});
+    EXPECT_TRUE(key == same_key);
+    EXPECT_EQ(key.hash(), same_key.hash());
+    EXPECT_FALSE(key == other_key);
+
+    KeyedCache<DescriptorKey, uint32_t> layouts;
+    EXPECT_TRUE(layouts.get(key) == nullptr);
+    layouts.insert(key, 1);
+    layouts.insert(other_key, 2);
+    EXPECT_EQ(*layouts.get(same_key), 1u);
+    EXPECT_EQ(*layouts.get(other_key), 2u);
+    EXPECT_EQ(layouts.count(), static_cast<size_t>(2));
+
+    // Keys with the same hash don't share their value
+    KeyedCache<CollidingKey, uint32_t> colliding;
+    colliding.insert({.bytes = {1, 1}}, 11);
+    colliding.insert({.bytes = {1, 2}}, 12);
+    colliding.insert({.bytes = {0, 1}}, 1);
+    EXPECT_EQ(*colliding.get({.bytes = {1, 1}}), 11u);
+    EXPECT_EQ(*colliding.get({.bytes = {1, 2}}), 12u);
+    EXPECT_EQ(*colliding.get({.bytes = {0, 1}}), 1u);
+    EXPECT_TRUE(colliding.get({.bytes = {1, 3}}) == nullptr);
+
+    uint32_t sum = 0;
+    for (const auto &entry : colliding)
+    {
+        sum += entry.value;
+    }
+    EXPECT_EQ(sum, 24u);
+    colliding.clear();
+    EXPECT_TRUE(colliding.get({.bytes = {1, 1}}) == nullptr);
+}
@@ -0,0 +1,76 @@
+#include <cmath>
+#include <test_framework/test_framework.hpp>
+#include <vr_engine/core/vr/frame_governor.h>
+
+using namespace vre;
+
+TEST
+{
+    FrameGovernor governor;
+    governor.set_target_frame_time(1.0 / 90.0);
+
+    // Starts at full quality
+    EXPECT_TRUE(governor.quality_factor() == 1.0f);
+    EXPECT_TRUE(governor.quality().resolution_scale == 1.0f);
+
+    // Frames that are way too slow should bring the quality down to its minimum
+    for (int i = 0; i < 500; i++)
+    {
+        governor.report_frame(0.005, 0.020);
+    }
+    EXPECT_TRUE(governor.headroom() < 0.0);
+    EXPECT_TRUE(governor.quality_factor() == 0.0f);
+    EXPECT_TRUE(governor.quality().resolution_scale < 1.0f);
+    EXPECT_TRUE(governor.quality().lod_bias > 0.0f);
+    EXPECT_TRUE(governor.quality().foveation_level > 0);
+
+    // Since the quality can't go lower, the governor asks for a lower refresh rate
+    const float rates[] = {72.0f, 80.0f, 90.0f, 120.0f};
+    EXPECT_EQ(governor.choose_refresh_rate(rates, 4, 2), 1u);
+    // Decisions are spaced, so asking again right after doesn't change anything
+    EXPECT_EQ(governor.choose_refresh_rate(rates, 4, 1), 1u);
+
+    // Fast frames bring the quality back up
+    for (int i = 0; i < 500; i++)
+    {
+        governor.report_frame(0.002, 0.003);
+    }
+    EXPECT_TRUE(governor.headroom() > 0.5);
+    EXPECT_TRUE(governor.quality_factor() == 1.0f);
+    EXPECT_TRUE(governor.quality().resolution_scale == 1.0f);
+    EXPECT_EQ(governor.quality().foveation_level, 0u);
+
+    // The frame fits in the budget of the higher rate, so it can be raised
+    EXPECT_EQ(governor.choose_refresh_rate(rates, 4, 2), 3u);
+    // Nothing higher is available
+    for (int i = 0; i < 500; i++)
+    {
+        governor.report_frame(0.002, 0.003);
+    }
+    EXPECT_EQ(governor.choose_refresh_rate(rates, 4, 3), 3u);
+
+    // Frames close to the target with enough headroom are stable
+    governor.set_target_frame_time(1.0 / 72.0);
+    for (int i = 0; i < 500; i++)
+    {
+        governor.report_frame(0.004, 0.010);
+    }
+    EXPECT_TRUE(governor.quality_factor() == 1.0f);
+
+    // Step response: the cost of a frame depends on the quality, and suddenly exceeds the budget at full quality. The factor must
+    // settle where the cost leaves the target headroom, without overshooting it nor oscillating around it.
+    FrameGovernor stepped;
+    stepped.set_target_frame_time(1.0 / 90.0);
+    const float settled_factor  = (0.9f / 90.0f - 0.008f) / 0.006f;
+    float       previous_factor = stepped.quality_factor();
+    uint32_t    rising_frames   = 0;
+    for (int i = 0; i < 600; i++)
+    {
+        stepped.report_frame(0.002, 0.008 + 0.006 * stepped.quality_factor());
+        EXPECT_TRUE(stepped.quality_factor() > settled_factor - 0.01f);
+        rising_frames += stepped.quality_factor() > previous_factor + 1e-4f ? 1 : 0;
+        previous_factor = stepped.quality_factor();
+    }
+    EXPECT_EQ(rising_frames, 0u);
+    EXPECT_TRUE(fabsf(stepped.quality_factor() - settled_factor) < 0.01f);
+}
@@ -0,0 +1,88 @@
+#include <cstdio>
+#include <test_framework/test_framework.hpp>
+#include <vr_engine/core/vr/frame_recorder.h>
+
+using namespace vre;
+
+TEST
+{
+    const char *path = "frames.vrerec";
+
+    // Record a short session: a state change, then frames with a moving head
+    FrameRecorder recorder;
+    ASSERT_TRUE(recorder.open(path));
+    recorder.record_event(RecordedEvent {
+        .frame_index = 0,
+        .type        = RecordedEventType::SESSION_STATE_CHANGED,
+        .value       = 5,
+    });
+    for (uint64_t i = 0; i < 100; i++)
+    {
+        RecordedFrame frame {
+            .frame_index              = i,
+            .predicted_display_time   = static_cast<int64_t>(1000000 + i * 11111111),
+            .predicted_display_period = 11111111,
+            .view_state_flags         = 0xF,
+            .view_count               = 2,
+        };
+        for (uint32_t view = 0; view < 2; view++)
+        {
+            frame.views[view].pose.position[0] = view == 0 ? -0.032f : 0.032f;
+            frame.views[view].pose.position[1] = 1.7f + static_cast<float>(i) * 0.001f;
+            frame.views[view].fov[0]           = -0.8f;
+            frame.views[view].fov[1]           = 0.8f;
+        }
+        if (i == 50)
+        {
+            recorder.record_event(RecordedEvent {
+                .frame_index = i,
+                .type        = RecordedEventType::REFRESH_RATE_CHANGED,
+                .from_rate   = 90.0f,
+                .to_rate     = 72.0f,
+            });
+        }
+        recorder.record_frame(frame);
+    }
+    recorder.close();
+
+    // Replay it
+    FrameReplayer replayer;
+    ASSERT_TRUE(replayer.open(path));
+
+    RecordedFrame frame;
+    uint64_t      frame_count = 0;
+    while (replayer.next_frame(frame))
+    {
+        ASSERT_EQ(frame.frame_index, frame_count);
+        EXPECT_EQ(frame.predicted_display_time, static_cast<int64_t>(1000000 + frame_count * 11111111));
+        EXPECT_EQ(frame.view_count, 2u);
+        EXPECT_TRUE(frame.views[0].pose.position[0] == -0.032f);
+        EXPECT_TRUE(frame.views[1].pose.position[1] == 1.7f + static_cast<float>(frame_count) * 0.001f);
+        EXPECT_TRUE(frame.views[1].pose.orientation[3] == 1.0f);
+        EXPECT_TRUE(frame.views[1].fov[1] == 0.8f);
+
+        // Events come with the frame that followed them
+        if (frame_count == 0 || frame_count == 50)
+        {
+            ASSERT_EQ(replayer.events().size(), static_cast<size_t>(1));
+            EXPECT_TRUE(replayer.events()[0].type
+                        == (frame_count == 0 ? RecordedEventType::SESSION_STATE_CHANGED : RecordedEventType::REFRESH_RATE_CHANGED));
+        }
+        else
+        {
+            EXPECT_TRUE(replayer.events().empty());
+        }
+        frame_count++;
+    }
+    EXPECT_EQ(frame_count, static_cast<uint64_t>(100));
+    EXPECT_FALSE(replayer.is_open());
+
+    // Files that were not written by the recorder are rejected
+    FILE *file = fopen(path, "wb");
+    ASSERT_TRUE(file != nullptr);
+    fputs("not a recording", file);
+    fclose(file);
+    EXPECT_FALSE(replayer.open(path));
+
+    remove(path);
+}
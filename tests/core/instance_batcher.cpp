@@ -0,0 +1,134 @@
+#include <cmath>
+#include <test_framework/test_framework.hpp>
+#include <vector>
+#include <vr_engine/core/renderer/instance_batcher.h>
+
+using namespace vre;
+
+InstanceTransform translation(float x)
+{
+    InstanceTransform transform;
+    transform.rows[0][3] = x;
+    return transform;
+}
+
+TEST
+{
+    InstanceBatcher batcher;
+    EXPECT_FALSE(batcher.update());
+    EXPECT_EQ(batcher.instance_count(), 0u);
+    EXPECT_THROWS(batcher.add_instance(0, 1, {}));
+    EXPECT_THROWS(batcher.add_instance(1ull << 28, 1, {}));
+
+    // Two meshes with the same material, and one mesh with two materials
+    const auto a = batcher.add_instance(1, 2, translation(1.0f));
+    const auto b = batcher.add_instance(1, 2, translation(2.0f));
+    const auto c = batcher.add_instance(3, 2, translation(3.0f));
+    const auto d = batcher.add_instance(1, 1, translation(4.0f));
+    const auto e = batcher.add_instance(1, 2, translation(5.0f));
+
+    // The layout is not valid until it is rebuilt
+    std::vector<InstanceTransform> transforms(5);
+    EXPECT_THROWS(batcher.write_instances(transforms.data()));
+    EXPECT_TRUE(batcher.update());
+    EXPECT_FALSE(batcher.update());
+
+    // Sorted by material, then mesh
+    const auto &batches = batcher.batches();
+    EXPECT_EQ(batches.size(), static_cast<size_t>(3));
+    EXPECT_TRUE(batches[0].mesh == 1 && batches[0].material == 1 && batches[0].instance_count == 1);
+    EXPECT_TRUE(batches[1].mesh == 1 && batches[1].material == 2 && batches[1].instance_count == 3);
+    EXPECT_TRUE(batches[2].mesh == 3 && batches[2].material == 2 && batches[2].instance_count == 1);
+    EXPECT_EQ(batches[1].first_instance, 1u);
+    EXPECT_EQ(batches[2].first_instance, 4u);
+    EXPECT_EQ(batcher.instance_count(), 5u);
+    EXPECT_EQ(batcher.instance_table_stats().count, static_cast<size_t>(5));
+    EXPECT_EQ(batcher.batch_index_stats().count, static_cast<size_t>(3));
+
+    batcher.write_instances(transforms.data());
+    EXPECT_TRUE(transforms[0].rows[0][3] == 4.0f);
+    EXPECT_TRUE(transforms[1].rows[0][3] == 1.0f && transforms[2].rows[0][3] == 2.0f && transforms[3].rows[0][3] == 5.0f);
+    EXPECT_TRUE(transforms[4].rows[0][3] == 3.0f);
+
+    // Moving an instance doesn't change the layout
+    batcher.set_transform(b, translation(6.0f));
+    EXPECT_FALSE(batcher.update());
+    batcher.write_instances(transforms.data());
+    EXPECT_TRUE(transforms[2].rows[0][3] == 6.0f);
+
+    // Removing an instance keeps the others packed
+    batcher.remove_instance(a);
+    EXPECT_TRUE(batcher.update());
+    EXPECT_EQ(batcher.instance_count(), 4u);
+    EXPECT_EQ(batches[1].instance_count, 2u);
+    batcher.write_instances(transforms.data());
+    EXPECT_TRUE(transforms[1].rows[0][3] == 5.0f && transforms[2].rows[0][3] == 6.0f);
+
+    // The moved instance can still be updated and removed
+    batcher.set_transform(e, translation(7.0f));
+    batcher.write_instances(transforms.data());
+    EXPECT_TRUE(transforms[1].rows[0][3] == 7.0f);
+
+    // Empty batches disappear, and their slot is reused
+    batcher.remove_instance(d);
+    batcher.remove_instance(c);
+    batcher.update();
+    EXPECT_EQ(batches.size(), static_cast<size_t>(1));
+    batcher.add_instance(4, 4, translation(8.0f));
+    batcher.update();
+    EXPECT_EQ(batches.size(), static_cast<size_t>(2));
+    EXPECT_TRUE(batches[1].mesh == 4 && batches[1].first_instance == 2);
+
+    // Changing the LOD moves the instance to the batch of the LOD, after the one of LOD 0
+    batcher.set_lod(e, 2);
+    EXPECT_THROWS(batcher.set_lod(b, MAX_MESH_LOD_COUNT));
+    batcher.update();
+    EXPECT_EQ(batches.size(), static_cast<size_t>(3));
+    EXPECT_TRUE(batches[0].lod == 0 && batches[0].instance_count == 1 && batches[1].lod == 2 && batches[1].instance_count == 1);
+    batcher.write_instances(transforms.data());
+    EXPECT_TRUE(transforms[0].rows[0][3] == 6.0f && transforms[1].rows[0][3] == 7.0f);
+
+    // LODs selected from the transforms
+    batcher.select_lods([](uint64_t, const InstanceTransform &transform, uint32_t) { return transform.rows[0][3] > 6.5f ? 1u : 0u; });
+    EXPECT_TRUE(batcher.update());
+    EXPECT_TRUE(batches[0].lod == 0 && batches[1].lod == 1);
+    EXPECT_FALSE((batcher.select_lods([](uint64_t, const InstanceTransform &, uint32_t lod) { return lod; }), batcher.update()));
+
+    batcher.remove_instance(b);
+    batcher.remove_instance(e);
+    // Unknown ids are ignored
+    batcher.remove_instance(e);
+    batcher.update();
+    EXPECT_EQ(batcher.instance_count(), 1u);
+
+    // The scale of a rotated axis is the norm of its column: 2 along x, rotated by 45 degrees around z
+    const float       diagonal = sqrtf(0.5f);
+    InstanceTransform stretched;
+    stretched.rows[0][0] = 2.0f * diagonal;
+    stretched.rows[0][1] = -diagonal;
+    stretched.rows[1][0] = 2.0f * diagonal;
+    stretched.rows[1][1] = diagonal;
+    EXPECT_TRUE(fabsf(max_axis_scale(stretched) - 2.0f) < 1e-5f);
+
+    // The quantization of a mesh is folded in the transforms of its instances: a stored position of (1, 1, 1) in an instance
+    // rotated by 90 degrees around z and moved by 10 along x ends up at the rotated (1 + 2, 2 + 4, 3 + 8), moved
+    const MeshQuantization quantization = {.position_offset = {1.0f, 2.0f, 3.0f}, .position_scale = {2.0f, 4.0f, 8.0f}};
+    InstanceTransform      rotated      = translation(10.0f);
+    rotated.rows[0][0] = rotated.rows[1][1] = 0.0f;
+    rotated.rows[0][1]                      = -1.0f;
+    rotated.rows[1][0]                      = 1.0f;
+    const auto quantized                    = batcher.add_instance(5, 1, rotated);
+    batcher.update();
+    batcher.write_instances(transforms.data(),
+                            [&](uint64_t mesh) { return mesh == 5 ? &quantization : static_cast<const MeshQuantization *>(nullptr); });
+    // Sorted by material, the quantized instance comes before the one left of mesh 4
+    EXPECT_EQ(batches[0].mesh, static_cast<uint64_t>(5));
+    float world[3];
+    for (uint32_t row = 0; row < 3; row++)
+    {
+        world[row] = transforms[0].rows[row][0] + transforms[0].rows[row][1] + transforms[0].rows[row][2] + transforms[0].rows[row][3];
+    }
+    EXPECT_TRUE(world[0] == 10.0f - 6.0f && world[1] == 3.0f && world[2] == 11.0f);
+    EXPECT_TRUE(transforms[1].rows[0][0] == 1.0f && transforms[1].rows[0][3] == 8.0f);
+    batcher.remove_instance(quantized);
+}
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cmath>
+#include <test_framework/test_framework.hpp>
+#include <vr_engine/core/renderer/light_clusters.h>
+
+using namespace vre;
+
+TEST
+{
+    EXPECT_THROWS(LightClusterer({.tile_count_x = 0}));
+
+    // Two eyes looking down -z, 6 cm apart, with the asymmetric fields of view of a headset
+    const ClusterView views[2] = {
+        {.position = {-0.03f, 0.0f, 0.0f}, .angle_left = -0.9f, .angle_right = 0.7f, .angle_up = 0.8f, .angle_down = -0.8f},
+        {.position = {0.03f, 0.0f, 0.0f}, .angle_left = -0.7f, .angle_right = 0.9f, .angle_up = 0.8f, .angle_down = -0.8f},
+    };
+    const ClusterSettings settings = {.tile_count_x = 8, .tile_count_y = 8, .slice_count = 16, .max_lights_per_cluster = 4};
+
+    // The eyes share a grid, whose apex is behind them, and which sees everything that they see
+    LightClusterer clusterer(settings);
+    clusterer.set_views(views, 2);
+    EXPECT_EQ(clusterer.grids().size(), static_cast<size_t>(1));
+    const auto &grid = clusterer.grids()[0];
+    EXPECT_TRUE(grid.position[2] > 0.0f);
+    EXPECT_TRUE(fabsf(grid.tan_left - tanf(-0.9f)) < 1e-4f);
+    EXPECT_EQ(clusterer.clusters().size(), static_cast<size_t>(8 * 8 * 16));
+    for (const auto &view : views)
+    {
+        for (const auto tan_x : {tanf(view.angle_left), tanf(view.angle_right)})
+        {
+            const float far_corner[3] = {view.position[0] + tan_x * 50.0f, 0.0f, -50.0f};
+            EXPECT_TRUE(clusterer.cluster_of(0, far_corner) != UINT32_MAX);
+        }
+    }
+
+    // A light only reaches the clusters around it, and the clusters of the fragments it lights contain it
+    const PointLight lights[] = {
+        {.position = {0.0f, 0.0f, -5.0f}, .radius = 0.5f},
+        {.position = {2.0f, 1.0f, -10.0f}, .radius = 1.0f},
+        // Behind the eyes, and beyond the far plane
+        {.position = {0.0f, 0.0f, 5.0f}, .radius = 1.0f},
+        {.position = {0.0f, 0.0f, -200.0f}, .radius = 1.0f},
+    };
+    clusterer.bin_lights(lights, 4);
+    const auto contains = [](const LightClusterer &clusters, uint32_t cluster_index, uint32_t light)
+    {
+        const auto &cluster = clusters.clusters()[cluster_index];
+        const auto  first   = clusters.light_indices().begin() + cluster.first_index;
+        return std::find(first, first + cluster.light_count, light) != first + cluster.light_count;
+    };
+    for (uint32_t light = 0; light < 2; light++)
+    {
+        const auto &position     = lights[light].position;
+        const auto  radius       = lights[light].radius * 0.99f;
+        const float samples[][3] = {
+            {position[0], position[1], position[2]},
+            {position[0] + radius, position[1], position[2]},
+            {position[0], position[1] - radius, position[2]},
+            {position[0], position[1], position[2] + radius},
+            {position[0], position[1], position[2] - radius},
+        };
+        for (const auto &sample : samples)
+        {
+            EXPECT_TRUE(contains(clusterer, clusterer.cluster_of(0, sample), light));
+        }
+    }
+    const float far_away[3] = {-3.0f, -3.0f, -5.0f};
+    EXPECT_FALSE(contains(clusterer, clusterer.cluster_of(0, far_away), 0));
+    EXPECT_TRUE(clusterer.light_indices().size() < static_cast<size_t>(2 * 8 * 8 * 16));
+    for (uint32_t i = 0; i < clusterer.light_indices().size(); i++)
+    {
+        EXPECT_TRUE(clusterer.light_indices()[i] < 2);
+    }
+    EXPECT_EQ(clusterer.dropped_count(), 0u);
+
+    // Full clusters drop the extra lights
+    const PointLight crowd[6] = {lights[0], lights[0], lights[0], lights[0], lights[0], lights[0]};
+    clusterer.bin_lights(crowd, 6);
+    const float center[3] = {0.0f, 0.0f, -5.0f};
+    EXPECT_EQ(clusterer.clusters()[clusterer.cluster_of(0, center)].light_count, 4u);
+    EXPECT_TRUE(clusterer.dropped_count() > 0);
+
+    // Without sharing, or when the views can't be enclosed, each view has its own grid
+    LightClusterer separate({.share_between_views = false});
+    separate.set_views(views, 2);
+    EXPECT_EQ(separate.grids().size(), static_cast<size_t>(2));
+    EXPECT_EQ(separate.grids()[1].first_cluster, 16u * 16u * 24u);
+    separate.bin_lights(lights, 1);
+    EXPECT_TRUE(contains(separate, separate.cluster_of(0, center), 0));
+    EXPECT_TRUE(contains(separate, separate.cluster_of(1, center), 0));
+
+    ClusterView wide_views[2] = {views[0], views[1]};
+    wide_views[0].angle_left  = -1.55f;
+    clusterer.set_views(wide_views, 2);
+    EXPECT_EQ(clusterer.grids().size(), static_cast<size_t>(2));
+}
@@ -0,0 +1,58 @@
+#include <array>
+#include <cmath>
+#include <test_framework/test_framework.hpp>
+#include <vr_engine/core/renderer/lod_selector.h>
+
+using namespace vre;
+
+TEST
+{
+    // 90 degrees of field of view over 2000 pixels: an error of one unit at one unit of distance covers 1000 pixels
+    const auto    quarter_turn = static_cast<float>(M_PI / 4.0);
+    const LodView view         = {
+        .angle_left  = -quarter_turn,
+        .angle_right = quarter_turn,
+        .angle_up    = quarter_turn,
+        .angle_down  = -quarter_turn,
+        .width       = 2000,
+        .height      = 2000,
+    };
+    const MeshLod lods[] = {
+        {.first_index = 0, .index_count = 300, .error = 0.0f},
+        {.first_index = 300, .index_count = 150, .error = 0.001f},
+        {.first_index = 450, .index_count = 60, .error = 0.01f},
+        {.first_index = 510, .index_count = 24, .error = 0.1f},
+    };
+    const auto at = [](float distance) { return std::array<float, 3> {0.0f, 0.0f, -distance}; };
+
+    LodSelector selector({.max_pixel_error = 1.0f, .hysteresis = 0.2f});
+    selector.set_views(&view, 1, 0.0f);
+    EXPECT_TRUE(fabsf(selector.projected_error(0.001f, at(1.0f).data()) - 1.0f) < 1e-3f);
+    EXPECT_EQ(selector.select(nullptr, 0, at(1.0f).data(), 1.0f, 3), 0u);
+
+    // Coarser LODs are only selected once their error is clearly below the threshold
+    EXPECT_EQ(selector.select(lods, 4, at(1.0f).data(), 1.0f, 0), 0u);
+    EXPECT_EQ(selector.select(lods, 4, at(2.0f).data(), 1.0f, 0), 1u);
+    EXPECT_EQ(selector.select(lods, 4, at(200.0f).data(), 1.0f, 0), 3u);
+    EXPECT_EQ(selector.select(lods, 4, at(200.0f).data(), 1.0f, 7), 3u);
+
+    // And finer LODs once the error of the current one is clearly above the threshold
+    EXPECT_EQ(selector.select(lods, 4, at(1.1f).data(), 1.0f, 1), 1u);
+    EXPECT_EQ(selector.select(lods, 4, at(0.9f).data(), 1.0f, 1), 1u);
+    EXPECT_EQ(selector.select(lods, 4, at(0.8f).data(), 1.0f, 1), 0u);
+
+    // The scale of the instance scales the errors
+    EXPECT_EQ(selector.select(lods, 4, at(2.0f).data(), 2.0f, 0), 0u);
+
+    // The bias of the frame governor allows bigger errors
+    selector.set_views(&view, 1, 1.0f);
+    EXPECT_EQ(selector.select(lods, 4, at(1.0f).data(), 1.0f, 0), 1u);
+
+    // The view in which the error is the biggest decides: here, the second one has twice the resolution
+    LodView views[2] = {view, view};
+    views[1].width   = 4000;
+    views[1].height  = 4000;
+    selector.set_views(views, 2, 0.0f);
+    EXPECT_TRUE(fabsf(selector.projected_error(0.001f, at(1.0f).data()) - 2.0f) < 1e-3f);
+    EXPECT_EQ(selector.select(lods, 4, at(2.0f).data(), 1.0f, 0), 0u);
+}
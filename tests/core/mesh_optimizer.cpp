@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <array>
+#include <random>
+#include <test_framework/test_framework.hpp>
+#include <vector>
+#include <vr_engine/core/renderer/mesh_optimizer.h>
+
+using namespace vre;
+
+#define GRID_SIZE  32
+#define CACHE_SIZE 16
+
+// Triangles of a list, as sorted triplets, so that two lists can be compared whatever their order
+std::vector<std::array<uint32_t, 3>> sorted_triangles(const std::vector<uint32_t> &indices)
+{
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        triangles.push_back({indices[i], indices[i + 1], indices[i + 2]});
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+TEST
+{
+    // Grid of quads, with the triangles shuffled
+    std::vector<float>    positions;
+    std::vector<uint32_t> indices;
+    for (uint32_t y = 0; y <= GRID_SIZE; y++)
+    {
+        for (uint32_t x = 0; x <= GRID_SIZE; x++)
+        {
+            positions.insert(positions.end(), {static_cast<float>(x), static_cast<float>(y), 0.0f});
+        }
+    }
+    std::vector<std::array<uint32_t, 3>> grid_triangles;
+    for (uint32_t y = 0; y < GRID_SIZE; y++)
+    {
+        for (uint32_t x = 0; x < GRID_SIZE; x++)
+        {
+            const auto corner = y * (GRID_SIZE + 1) + x;
+            grid_triangles.push_back({corner, corner + 1, corner + GRID_SIZE + 1});
+            grid_triangles.push_back({corner + 1, corner + GRID_SIZE + 2, corner + GRID_SIZE + 1});
+        }
+    }
+    std::shuffle(grid_triangles.begin(), grid_triangles.end(), std::mt19937(42));
+    for (const auto &triangle : grid_triangles)
+    {
+        indices.insert(indices.end(), triangle.begin(), triangle.end());
+    }
+    const auto vertex_count = positions.size() / 3;
+
+    EXPECT_THROWS(optimize_vertex_cache(indices.data(), indices.data(), 4, vertex_count));
+    std::vector<uint32_t> out_of_range = {0, 1, static_cast<uint32_t>(vertex_count)};
+    EXPECT_THROWS(analyze_vertex_cache(out_of_range.data(), out_of_range.size(), vertex_count, CACHE_SIZE));
+
+    // The vertex cache optimization keeps the triangles, and gets close to the 0.5 of a perfect grid ordering
+    const auto shuffled_stats = analyze_vertex_cache(indices.data(), indices.size(), vertex_count, CACHE_SIZE);
+    auto       optimized      = indices;
+    optimize_vertex_cache(optimized.data(), optimized.data(), optimized.size(), vertex_count);
+    const auto optimized_stats = analyze_vertex_cache(optimized.data(), optimized.size(), vertex_count, CACHE_SIZE);
+    EXPECT_TRUE(sorted_triangles(optimized) == sorted_triangles(indices));
+    EXPECT_TRUE(shuffled_stats.acmr > 2.0f);
+    EXPECT_TRUE(optimized_stats.acmr < 0.8f);
+    EXPECT_TRUE(optimized_stats.atvr < 1.6f);
+
+    // The overdraw optimization keeps the triangles, and most of the cache efficiency
+    auto overdraw_optimized = optimized;
+    optimize_overdraw(overdraw_optimized.data(),
+                      overdraw_optimized.data(),
+                      overdraw_optimized.size(),
+                      positions.data(),
+                      vertex_count,
+                      3 * sizeof(float),
+                      1.05f);
+    const auto overdraw_stats = analyze_vertex_cache(overdraw_optimized.data(), overdraw_optimized.size(), vertex_count, CACHE_SIZE);
+    EXPECT_TRUE(sorted_triangles(overdraw_optimized) == sorted_triangles(indices));
+    EXPECT_TRUE(overdraw_stats.acmr < optimized_stats.acmr * 1.1f);
+
+    // Two separate quads facing +z: the one in front is drawn first
+    const std::vector<float>    layer_positions = {
+        0, 0, -1, 1, 0, -1, 0, 1, -1, 1, 1, -1, // Back
+        0, 0, 1,  1, 0, 1,  0, 1, 1,  1, 1, 1,  // Front
+    };
+    std::vector<uint32_t> layers = {0, 1, 2, 1, 3, 2, 4, 5, 6, 5, 7, 6};
+    optimize_overdraw(layers.data(), layers.data(), layers.size(), layer_positions.data(), 8, 3 * sizeof(float), 1.05f);
+    EXPECT_TRUE(std::all_of(layers.begin(), layers.begin() + 6, [](uint32_t vertex) { return vertex >= 4; }));
+
+    // The simplification of a flat grid removes most of the inner vertices without moving the surface, keeps the border, and
+    // doesn't flip triangles
+    std::vector<uint32_t> simplified(indices.size());
+    float                 simplification_error = 1.0f;
+    const auto            simplified_count     = simplify(simplified.data(),
+                                                          indices.data(),
+                                                          indices.size(),
+                                                          positions.data(),
+                                                          vertex_count,
+                                                          3 * sizeof(float),
+                                                          0,
+                                                          1e-3f,
+                                                          &simplification_error);
+    simplified.resize(simplified_count);
+    EXPECT_TRUE(simplified_count > 0 && simplified_count < indices.size() / 4);
+    EXPECT_TRUE(simplification_error < 1e-3f);
+    bool flipped        = false;
+    bool corner_is_used = false;
+    for (size_t i = 0; i < simplified.size(); i += 3)
+    {
+        const auto *a  = &positions[simplified[i] * 3];
+        const auto *b  = &positions[simplified[i + 1] * 3];
+        const auto *c  = &positions[simplified[i + 2] * 3];
+        flipped        = flipped || (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]) <= 0.0f;
+        corner_is_used = corner_is_used || simplified[i] == 0 || simplified[i + 1] == 0 || simplified[i + 2] == 0;
+    }
+    EXPECT_FALSE(flipped);
+    EXPECT_TRUE(corner_is_used);
+
+    // The target stops the simplification early
+    const auto half_count = simplify(simplified.data(),
+                                     indices.data(),
+                                     indices.size(),
+                                     positions.data(),
+                                     vertex_count,
+                                     3 * sizeof(float),
+                                     indices.size() / 2,
+                                     1.0f);
+    EXPECT_TRUE(half_count <= indices.size() / 2 && half_count >= indices.size() / 2 - 60);
+
+    // A spike of height 1 in the middle of the grid is kept under a smaller error, even though the flat triangles around it weigh
+    // much more, and the error of a simplification that removes it is at least its height
+    auto                  spike_positions = positions;
+    const uint32_t        spike           = GRID_SIZE / 2 * (GRID_SIZE + 1) + GRID_SIZE / 2;
+    std::vector<uint32_t> spike_simplified(indices.size());
+    spike_positions[spike * 3 + 2] = 1.0f;
+    for (const auto spike_max_error : {0.25f, 10.0f})
+    {
+        float      spike_error = -1.0f;
+        const auto spike_count = simplify(spike_simplified.data(),
+                                          indices.data(),
+                                          indices.size(),
+                                          spike_positions.data(),
+                                          vertex_count,
+                                          3 * sizeof(float),
+                                          0,
+                                          spike_max_error,
+                                          &spike_error);
+        const auto spike_end     = spike_simplified.begin() + static_cast<ptrdiff_t>(spike_count);
+        const auto spike_is_kept = std::find(spike_simplified.begin(), spike_end, spike) != spike_end;
+        EXPECT_TRUE(spike_error <= spike_max_error);
+        EXPECT_TRUE(spike_is_kept || spike_error >= 1.0f);
+        EXPECT_EQ(spike_is_kept, spike_max_error < 1.0f);
+    }
+
+    // The vertex fetch optimization numbers the vertices in the order of their first use, and drops the unused ones
+    std::vector<uint32_t> fetch_indices = {3, 1, 4, 4, 1, 0};
+    const uint32_t        vertices[]    = {10, 11, 12, 13, 14};
+    uint32_t              fetch_vertices[5];
+    const auto            kept_count =
+        optimize_vertex_fetch(fetch_vertices, fetch_indices.data(), fetch_indices.size(), vertices, 5, sizeof(uint32_t));
+    EXPECT_EQ(kept_count, static_cast<size_t>(4));
+    EXPECT_TRUE((fetch_indices == std::vector<uint32_t> {0, 1, 2, 2, 1, 3}));
+    EXPECT_TRUE(fetch_vertices[0] == 13 && fetch_vertices[1] == 11 && fetch_vertices[2] == 14 && fetch_vertices[3] == 10);
+}
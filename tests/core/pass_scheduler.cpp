@@ -0,0 +1,66 @@
+#include <test_framework/test_framework.hpp>
+#include <vr_engine/core/renderer/pass_scheduler.h>
+
+using namespace vre;
+
+TEST
+{
+    PassScheduler scheduler;
+
+    // A frame where the views read the results of GPU culling and skinning, and the Hi-Z of the views is built asynchronously
+    scheduler.begin_frame(true);
+    const auto     culling                  = scheduler.add_pass(PassQueue::COMPUTE, nullptr, 0);
+    const auto     skinning                 = scheduler.add_pass(PassQueue::COMPUTE, nullptr, 0);
+    const auto     shadows                  = scheduler.add_pass(PassQueue::GRAPHICS, nullptr, 0);
+    const uint32_t view_dependencies[]      = {culling, skinning, shadows};
+    const auto     views                    = scheduler.add_pass(PassQueue::GRAPHICS, view_dependencies, 3);
+    const auto     hi_z                     = scheduler.add_pass(PassQueue::COMPUTE, &views, 1);
+    const auto     late_culling             = scheduler.add_pass(PassQueue::COMPUTE, nullptr, 0);
+    const uint32_t composite_dependencies[] = {views, hi_z};
+    const auto     composite                = scheduler.add_pass(PassQueue::GRAPHICS, composite_dependencies, 2);
+
+    // The shadows don't wait for the compute passes, and the passes that do start new batches
+    const auto &batches = scheduler.batches();
+    EXPECT_EQ(batches.size(), static_cast<size_t>(5));
+    EXPECT_EQ(scheduler.batch_of(culling), 0u);
+    EXPECT_EQ(scheduler.batch_of(skinning), 0u);
+    EXPECT_EQ(scheduler.batch_of(shadows), 1u);
+    EXPECT_EQ(scheduler.batch_of(views), 2u);
+    EXPECT_EQ(scheduler.batch_of(hi_z), 3u);
+    EXPECT_EQ(scheduler.batch_of(late_culling), 3u);
+    EXPECT_EQ(scheduler.batch_of(composite), 4u);
+
+    EXPECT_TRUE(batches[0].queue == PassQueue::COMPUTE);
+    EXPECT_EQ(batches[0].wait_value, static_cast<uint64_t>(0));
+    EXPECT_EQ(batches[0].signal_value, static_cast<uint64_t>(1));
+    EXPECT_EQ(batches[1].wait_value, static_cast<uint64_t>(0));
+    EXPECT_EQ(batches[1].signal_value, static_cast<uint64_t>(1));
+    EXPECT_EQ(batches[2].passes.size(), static_cast<size_t>(1));
+    EXPECT_EQ(batches[2].wait_value, static_cast<uint64_t>(1));
+    EXPECT_EQ(batches[2].signal_value, static_cast<uint64_t>(2));
+    EXPECT_EQ(batches[3].wait_value, static_cast<uint64_t>(2));
+    EXPECT_EQ(batches[3].signal_value, static_cast<uint64_t>(2));
+    EXPECT_EQ(batches[4].wait_value, static_cast<uint64_t>(2));
+    EXPECT_EQ(batches[4].signal_value, static_cast<uint64_t>(3));
+
+    // A dependency must come before its pass
+    const uint32_t future_pass = 100;
+    EXPECT_THROWS(scheduler.add_pass(PassQueue::GRAPHICS, &future_pass, 1));
+
+    // The timelines keep growing from one frame to the next
+    scheduler.begin_frame(true);
+    const auto next_culling = scheduler.add_pass(PassQueue::COMPUTE, nullptr, 0);
+    scheduler.add_pass(PassQueue::GRAPHICS, &next_culling, 1);
+    EXPECT_EQ(scheduler.batches()[0].signal_value, static_cast<uint64_t>(3));
+    EXPECT_EQ(scheduler.batches()[1].wait_value, static_cast<uint64_t>(3));
+    EXPECT_EQ(scheduler.timeline_value(PassQueue::GRAPHICS), static_cast<uint64_t>(4));
+
+    // Without async compute, everything runs in a single graphics batch
+    scheduler.begin_frame(false);
+    const auto sync_culling = scheduler.add_pass(PassQueue::COMPUTE, nullptr, 0);
+    scheduler.add_pass(PassQueue::GRAPHICS, &sync_culling, 1);
+    EXPECT_EQ(scheduler.batches().size(), static_cast<size_t>(1));
+    EXPECT_TRUE(scheduler.batches()[0].queue == PassQueue::GRAPHICS);
+    EXPECT_EQ(scheduler.batches()[0].passes.size(), static_cast<size_t>(2));
+    EXPECT_EQ(scheduler.batches()[0].wait_value, static_cast<uint64_t>(0));
+}
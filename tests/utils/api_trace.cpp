@@ -0,0 +1,49 @@
+#include <chrono>
+#include <test_framework/test_framework.hpp>
+#include <thread>
+#include <vr_engine/utils/api_trace.h>
+
+using namespace vre;
+
+TEST
+{
+    auto &submit = ApiTrace::entry_point("vkQueueSubmit", true);
+    auto &draw   = ApiTrace::entry_point("vkCmdDraw");
+
+    // The same name always returns the same entry point
+    EXPECT_TRUE(&submit == &ApiTrace::entry_point("vkQueueSubmit", true));
+    EXPECT_TRUE(submit.is_timed);
+    EXPECT_FALSE(draw.is_timed);
+    EXPECT_NULL(draw.duration_metric);
+
+    // First frame
+    for (int i = 0; i < 100; i++)
+    {
+        ApiCall call(draw);
+    }
+    {
+        ApiCall call(submit);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    ApiTrace::end_frame();
+
+    auto &metrics = MetricsRegistry::global();
+    EXPECT_TRUE(metrics.gauge("api.vkCmdDraw.calls_per_frame").value() == 100.0);
+    EXPECT_TRUE(metrics.gauge("api.vkQueueSubmit.calls_per_frame").value() == 1.0);
+    EXPECT_EQ(draw.frame_call_count.load(), static_cast<uint64_t>(0));
+
+    const auto submit_duration = metrics.histogram("api.vkQueueSubmit_ns").summary();
+    EXPECT_EQ(submit_duration.count, static_cast<uint64_t>(1));
+    EXPECT_TRUE(submit_duration.max >= 2000000);
+
+    // Second frame: the per-frame count is reset, the total accumulates
+    for (int i = 0; i < 50; i++)
+    {
+        ApiCall call(draw);
+    }
+    ApiTrace::end_frame();
+    EXPECT_TRUE(metrics.gauge("api.vkCmdDraw.calls_per_frame").value() == 50.0);
+    EXPECT_EQ(metrics.counter("api.vkCmdDraw.calls").value(), static_cast<uint64_t>(150));
+    EXPECT_TRUE(metrics.gauge("api.vkQueueSubmit.calls_per_frame").value() == 0.0);
+    EXPECT_EQ(metrics.counter("api.vkQueueSubmit.calls").value(), static_cast<uint64_t>(1));
+}
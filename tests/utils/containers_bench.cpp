@@ -0,0 +1,68 @@
+#include <test_framework/test_framework.hpp>
+#include <vector>
+#include <vr_engine/utils/data/hash_map.h>
+#include <vr_engine/utils/data/optional.h>
+#include <vr_engine/utils/data/storage.h>
+
+using namespace vre;
+
+// Benchmarks of the hot paths of the containers. The results are printed, and the allocation counts are checked since
+// lookups in the frame loop must never allocate.
+
+#define ELEMENT_COUNT 10000
+
+TEST
+{
+    // The allocation counter sees the allocations of the benchmarked block
+    BENCH("std::vector allocation")
+    {
+        std::vector<int> vector(16);
+        DO_NOT_OPTIMIZE(vector.data());
+    }
+    EXPECT_TRUE(LAST_BENCH_RESULT.allocations == 1.0);
+    EXPECT_TRUE(LAST_BENCH_RESULT.mean_ns > 0.0);
+    EXPECT_TRUE(LAST_BENCH_RESULT.min_ns <= LAST_BENCH_RESULT.mean_ns);
+    EXPECT_TRUE(LAST_BENCH_RESULT.confidence_ns >= 0.0);
+
+    HashMap map;
+    for (uint64_t i = 1; i <= ELEMENT_COUNT; i++)
+    {
+        map.set(i, static_cast<size_t>(i * 2));
+    }
+
+    uint64_t key = 0;
+    BENCH("HashMap::get, 10k elements")
+    {
+        key    = key % ELEMENT_COUNT + 1;
+        auto v = map.get(key);
+        DO_NOT_OPTIMIZE(v);
+    }
+    EXPECT_TRUE(LAST_BENCH_RESULT.allocations == 0.0);
+
+    Storage<uint64_t>                  storage;
+    std::vector<Storage<uint64_t>::Id> ids;
+    for (uint64_t i = 0; i < ELEMENT_COUNT; i++)
+    {
+        ids.push_back(storage.push(i));
+    }
+
+    size_t index = 0;
+    BENCH("Storage::get, 10k elements")
+    {
+        index = (index + 7919) % ids.size();
+        DO_NOT_OPTIMIZE(*storage.get(ids[index]));
+    }
+    EXPECT_TRUE(LAST_BENCH_RESULT.allocations == 0.0);
+
+    uint64_t sum = 0;
+    BENCH("Storage iteration, 10k elements")
+    {
+        for (const auto &entry : storage)
+        {
+            sum += entry.value();
+        }
+        CLOBBER_MEMORY();
+    }
+    DO_NOT_OPTIMIZE(sum);
+    EXPECT_TRUE(LAST_BENCH_RESULT.allocations == 0.0);
+}
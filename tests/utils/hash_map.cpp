@@ -2,6 +2,7 @@
 
 #include <test_framework/test_framework.hpp>
 #include <vr_engine/utils/data/hash_map.h>
+#include <vr_engine/utils/metrics.h>
 
 TEST
 {
@@ -96,4 +97,36 @@ TEST
     EXPECT_EQ(map[27454].as_size, new_value2);
     // Get for non-existing key returns nullptr
     EXPECT_EQ(map[9999999].as_size, static_cast<size_t>(0));
-}
\ No newline at end of file
+
+    // Stats
+    vre::HashMap stats_map;
+    auto         stats = stats_map.stats();
+    EXPECT_EQ(stats.count, static_cast<size_t>(0));
+    EXPECT_EQ(stats.max_probe_length, static_cast<size_t>(0));
+    EXPECT_EQ(stats.expansion_count, static_cast<size_t>(0));
+
+    for (uint64_t i = 1; i <= 100; i++)
+    {
+        stats_map.set(i, static_cast<size_t>(i));
+    }
+    stats = stats_map.stats();
+    EXPECT_EQ(stats.count, static_cast<size_t>(100));
+    // The map expands when it is half full: 2 -> 4 -> ... -> 256
+    EXPECT_EQ(stats.capacity, static_cast<size_t>(256));
+    EXPECT_EQ(stats.expansion_count, static_cast<size_t>(7));
+    EXPECT_TRUE(stats.load_factor > 0.39f && stats.load_factor < 0.40f);
+    EXPECT_TRUE(stats.mean_probe_length <= static_cast<float>(stats.max_probe_length));
+
+    // Each entry belongs to exactly one cluster, so the histogram can't have more clusters than entries, and at least one
+    size_t cluster_count = 0;
+    for (auto bucket_count : stats.cluster_size_histogram)
+    {
+        cluster_count += bucket_count;
+    }
+    EXPECT_TRUE(cluster_count > 0 && cluster_count <= stats.count);
+
+    // Published stats
+    stats.publish("test");
+    EXPECT_EQ(vre::MetricsRegistry::global().gauge("hash_map.test.count").value(), 100.0);
+    EXPECT_EQ(vre::MetricsRegistry::global().gauge("hash_map.test.expansions").value(), 7.0);
+}
@@ -0,0 +1,109 @@
+#include <string>
+#include <test_framework/test_framework.hpp>
+#include <thread>
+#include <vr_engine/utils/log.h>
+
+using namespace vre;
+
+enum class Color
+{
+    RED,
+    GREEN,
+};
+
+TEST
+{
+    auto sink = std::make_shared<MemoryLogSink>();
+    Logger::add_sink(sink);
+
+    // Formatting of the supported argument types
+    const std::string name = "world";
+    Logger::log(LogLevel::Info, "Hello {}!", name);
+    Logger::log(LogLevel::Warning, "{} {} {} {} {}", -42, 42u, 1.5, true, Color::GREEN);
+    Logger::log(LogLevel::Error, "{} {}", "literal", static_cast<const char *>(nullptr));
+    // Missing arguments keep their placeholder, extra ones are ignored
+    Logger::log(LogLevel::Info, "{} and {}", 1);
+    Logger::log(LogLevel::Info, "No placeholder", 1, 2);
+    Logger::flush();
+
+    auto messages = sink->messages();
+    ASSERT_EQ(messages.size(), static_cast<size_t>(5));
+    EXPECT_EQ(messages[0], std::string("[Info] Hello world!"));
+    EXPECT_EQ(messages[1], std::string("[Warning] -42 42 1.5 true 1"));
+    EXPECT_EQ(messages[2], std::string("[Error] literal (null)"));
+    EXPECT_EQ(messages[3], std::string("[Info] 1 and {}"));
+    EXPECT_EQ(messages[4], std::string("[Info] No placeholder"));
+    sink->clear();
+
+    // Long strings are truncated instead of overflowing the record
+    Logger::log(LogLevel::Info, "{}", std::string(1000, 'a'));
+    Logger::flush();
+    messages = sink->messages();
+    ASSERT_EQ(messages.size(), static_cast<size_t>(1));
+    EXPECT_TRUE(messages[0].size() < 300);
+    sink->clear();
+
+    // Runtime filtering
+    Logger::set_level(LogLevel::Warning);
+    Logger::log(LogLevel::Info, "Filtered");
+    Logger::log(LogLevel::Error, "Not filtered");
+    Logger::set_level(LogLevel::Trace);
+    Logger::flush();
+    messages = sink->messages();
+    ASSERT_EQ(messages.size(), static_cast<size_t>(1));
+    EXPECT_EQ(messages[0], std::string("[Error] Not filtered"));
+    sink->clear();
+
+    // Messages from several threads are all written, in order for each thread
+    std::thread threads[4];
+    for (int t = 0; t < 4; t++)
+    {
+        threads[t] = std::thread(
+            [t]()
+            {
+                for (int i = 0; i < 100; i++)
+                {
+                    Logger::log(LogLevel::Info, "{} {}", t, i);
+                }
+            });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    Logger::flush();
+    messages = sink->messages();
+    EXPECT_EQ(messages.size(), static_cast<size_t>(400));
+
+    int last_index[4] = {-1, -1, -1, -1};
+    for (const auto &message : messages)
+    {
+        int t = 0, i = 0;
+        ASSERT_EQ(sscanf(message.c_str(), "[Info] %d %d", &t, &i), 2);
+        EXPECT_TRUE(i > last_index[t]);
+        last_index[t] = i;
+    }
+    EXPECT_EQ(Logger::dropped_message_count(), static_cast<uint64_t>(0));
+    sink->clear();
+
+    // A thread reusing the queue of an exited thread logs after the records the exited thread left in it
+    for (int t = 0; t < 2; t++)
+    {
+        std::thread(
+            [t]()
+            {
+                for (int i = 0; i < 10; i++)
+                {
+                    Logger::log(LogLevel::Info, "{} {}", t, i);
+                }
+            })
+            .join();
+    }
+    Logger::flush();
+    messages = sink->messages();
+    ASSERT_EQ(messages.size(), static_cast<size_t>(20));
+    EXPECT_EQ(messages[9], std::string("[Info] 0 9"));
+    EXPECT_EQ(messages[10], std::string("[Info] 1 0"));
+
+    Logger::clear_sinks();
+}
@@ -0,0 +1,149 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <test_framework/test_framework.hpp>
+#include <thread>
+#include <vr_engine/utils/metrics.h>
+
+using namespace vre;
+
+std::string read_file(const char *path)
+{
+    std::string content;
+    FILE       *file = fopen(path, "r");
+    if (file != nullptr)
+    {
+        char line[512];
+        while (fgets(line, sizeof(line), file))
+        {
+            content += line;
+        }
+        fclose(file);
+    }
+    return content;
+}
+
+TEST
+{
+    // Buckets are contiguous and cover the whole range
+    EXPECT_EQ(Histogram::bucket_index(0), 0u);
+    EXPECT_EQ(Histogram::bucket_index(UINT64_MAX), Histogram::BUCKET_COUNT - 1);
+    for (uint32_t i = 0; i + 1 < Histogram::BUCKET_COUNT; i++)
+    {
+        ASSERT_EQ(Histogram::bucket_upper_bound(i) + 1, Histogram::bucket_lower_bound(i + 1));
+        ASSERT_EQ(Histogram::bucket_index(Histogram::bucket_lower_bound(i)), i);
+        ASSERT_EQ(Histogram::bucket_index(Histogram::bucket_upper_bound(i)), i);
+    }
+    EXPECT_EQ(Histogram::bucket_upper_bound(Histogram::BUCKET_COUNT - 1), static_cast<uint64_t>(UINT64_MAX));
+
+    MetricsRegistry registry;
+
+    // The same name always returns the same metric
+    auto &frames = registry.counter("engine.frames");
+    EXPECT_TRUE(&frames == &registry.counter("engine.frames"));
+
+    // Counters can be incremented from several threads
+    std::thread threads[4];
+    for (auto &thread : threads)
+    {
+        thread = std::thread(
+            [&frames]()
+            {
+                for (int i = 0; i < 1000; i++)
+                {
+                    frames.add();
+                }
+            });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(frames.value(), static_cast<uint64_t>(4000));
+
+    auto &rate = registry.gauge("xr.refresh_rate_hz");
+    rate.set(90.0);
+    EXPECT_TRUE(rate.value() == 90.0);
+
+    // Percentiles of a uniform distribution, within the precision of the buckets
+    auto &frame_time = registry.histogram("engine.frame_time_ns");
+    for (uint64_t i = 1; i <= 10000; i++)
+    {
+        frame_time.record(i * 1000);
+    }
+    auto summary = frame_time.summary();
+    EXPECT_EQ(summary.count, static_cast<uint64_t>(10000));
+    EXPECT_EQ(summary.min, static_cast<uint64_t>(1000));
+    EXPECT_EQ(summary.max, static_cast<uint64_t>(10000000));
+    EXPECT_TRUE(summary.mean > 5000000.0 && summary.mean < 5001000.0);
+
+    const double tolerance = 1.0 / Histogram::SUB_BUCKET_COUNT;
+    EXPECT_TRUE(std::abs(static_cast<double>(summary.p50) / 5000000.0 - 1.0) < tolerance);
+    EXPECT_TRUE(std::abs(static_cast<double>(summary.p95) / 9500000.0 - 1.0) < tolerance);
+    EXPECT_TRUE(std::abs(static_cast<double>(summary.p99) / 9900000.0 - 1.0) < tolerance);
+
+    // Windows only contain the values since the last window end
+    registry.end_window();
+    EXPECT_EQ(frame_time.window_summary().count, static_cast<uint64_t>(0));
+    for (int i = 0; i < 100; i++)
+    {
+        frame_time.record(20000);
+    }
+    auto window = frame_time.window_summary();
+    EXPECT_EQ(window.count, static_cast<uint64_t>(100));
+    EXPECT_TRUE(window.mean == 20000.0);
+    EXPECT_TRUE(std::abs(static_cast<double>(window.p99) / 20000.0 - 1.0) < tolerance);
+    EXPECT_TRUE(window.max < 1000000);
+    EXPECT_EQ(frame_time.summary().count, static_cast<uint64_t>(10100));
+
+    // Dumps
+    const char *csv_path  = "metrics.csv";
+    const char *json_path = "metrics.json";
+    remove(csv_path);
+    EXPECT_TRUE(registry.append_csv(csv_path, 1.0));
+    EXPECT_TRUE(registry.append_csv(csv_path, 2.0));
+    EXPECT_TRUE(registry.write_json(json_path));
+
+    std::string csv;
+    FILE       *file = fopen(csv_path, "r");
+    ASSERT_TRUE(file != nullptr);
+    char line[512];
+    int  line_count = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        csv += line;
+        line_count++;
+    }
+    fclose(file);
+    // Header, then 3 metrics per dump
+    EXPECT_EQ(line_count, 7);
+    EXPECT_TRUE(csv.find("2.000,engine.frames,counter,4000") != std::string::npos);
+    EXPECT_TRUE(csv.find("1.000,engine.frame_time_ns,histogram,,100,") != std::string::npos);
+
+    std::string json;
+    file = fopen(json_path, "r");
+    ASSERT_TRUE(file != nullptr);
+    while (fgets(line, sizeof(line), file))
+    {
+        json += line;
+    }
+    fclose(file);
+    EXPECT_TRUE(json.find("\"engine.frames\": 4000") != std::string::npos);
+    EXPECT_TRUE(json.find("\"xr.refresh_rate_hz\": 90") != std::string::npos);
+    EXPECT_TRUE(json.find("\"engine.frame_time_ns\": {\"count\": 100,") != std::string::npos);
+
+    // The writer writes the snapshots on its own thread, before its destruction. Non-finite gauges keep the JSON valid.
+    registry.gauge("xr.refresh_rate_hz").set(std::nan(""));
+    {
+        MetricsWriter writer(csv_path, json_path);
+        writer.write(registry.snapshot(3.0));
+        writer.write(registry.snapshot(4.0));
+    }
+    csv = read_file(csv_path);
+    EXPECT_TRUE(csv.find("3.000,xr.refresh_rate_hz,gauge,,") != std::string::npos);
+    EXPECT_TRUE(csv.find("4.000,engine.frames,counter,4000") != std::string::npos);
+    EXPECT_TRUE(read_file(json_path).find("\"xr.refresh_rate_hz\": null") != std::string::npos);
+
+    remove(csv_path);
+    remove(json_path);
+}
@@ -0,0 +1,113 @@
+#include <atomic>
+#include <memory>
+#include <test_framework/test_framework.hpp>
+#include <thread>
+#include <vector>
+#include <vr_engine/utils/data/mpmc_queue.h>
+
+using namespace vre;
+
+#define PRODUCER_COUNT      4
+#define CONSUMER_COUNT      4
+#define VALUES_PER_PRODUCER 50000
+
+TEST
+{
+    // Single thread
+    MpmcQueue<uint32_t, 4> queue;
+    uint32_t               value = 0;
+    EXPECT_FALSE(queue.try_pop(value));
+    EXPECT_TRUE(queue.try_push(1u));
+
+    const uint32_t batch[4] = {2, 3, 4, 5};
+    EXPECT_EQ(queue.try_push(batch, 4), static_cast<size_t>(3));
+    EXPECT_FALSE(queue.try_push(6u));
+    EXPECT_EQ(queue.size(), static_cast<size_t>(4));
+
+    uint32_t popped[8] = {};
+    EXPECT_EQ(queue.try_pop(popped, 3), static_cast<size_t>(3));
+    EXPECT_TRUE(popped[0] == 1 && popped[1] == 2 && popped[2] == 3);
+    EXPECT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, 4u);
+    EXPECT_FALSE(queue.try_pop(value));
+
+    // Stress: values encode their producer and their index. Each value must be received exactly once, and the values of a producer
+    // must be received in order by each consumer.
+    auto                     stress_queue = std::make_unique<MpmcQueue<uint64_t, 1024>>();
+    std::atomic<uint64_t>    received_count = 0;
+    std::vector<uint32_t>    received_per_value(PRODUCER_COUNT * VALUES_PER_PRODUCER, 0);
+    std::atomic<bool>        in_order = true;
+    std::vector<std::thread> threads;
+
+    for (uint64_t producer = 0; producer < PRODUCER_COUNT; producer++)
+    {
+        threads.emplace_back(
+            [&, producer]()
+            {
+                uint64_t next = 0;
+                uint64_t values[8];
+                while (next < VALUES_PER_PRODUCER)
+                {
+                    // Alternate between single and batched pushes
+                    const auto count = std::min<uint64_t>(next % 2 == 0 ? 1 : 8, VALUES_PER_PRODUCER - next);
+                    for (uint64_t i = 0; i < count; i++)
+                    {
+                        values[i] = producer * VALUES_PER_PRODUCER + next + i;
+                    }
+                    const auto pushed_count = stress_queue->try_push(values, count);
+                    next += pushed_count;
+
+                    // Let the consumers run when the queue is full, in case the threads share cores
+                    if (pushed_count == 0)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+    }
+    for (uint32_t consumer = 0; consumer < CONSUMER_COUNT; consumer++)
+    {
+        threads.emplace_back(
+            [&]()
+            {
+                uint64_t last_index[PRODUCER_COUNT];
+                bool     has_last[PRODUCER_COUNT] = {};
+                uint64_t values[6];
+                while (received_count.load(std::memory_order_relaxed) < PRODUCER_COUNT * VALUES_PER_PRODUCER)
+                {
+                    const auto count = stress_queue->try_pop(values, 6);
+                    if (count == 0)
+                    {
+                        std::this_thread::yield();
+                    }
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        const auto producer = values[i] / VALUES_PER_PRODUCER;
+                        const auto index    = values[i] % VALUES_PER_PRODUCER;
+                        if (has_last[producer] && index <= last_index[producer])
+                        {
+                            in_order = false;
+                        }
+                        has_last[producer]   = true;
+                        last_index[producer] = index;
+                        // Each value has its own slot, so there is no race
+                        received_per_value[values[i]]++;
+                    }
+                    received_count.fetch_add(count, std::memory_order_relaxed);
+                }
+            });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    bool received_once = true;
+    for (auto count : received_per_value)
+    {
+        received_once = received_once && count == 1;
+    }
+    EXPECT_TRUE(received_once);
+    EXPECT_TRUE(in_order.load());
+    EXPECT_EQ(stress_queue->size(), static_cast<size_t>(0));
+}
@@ -0,0 +1,100 @@
+#include <random>
+#include <test_framework/test_framework.hpp>
+#include <vector>
+#include <vr_engine/utils/data/offset_allocator.h>
+
+using namespace vre;
+
+#define STRESS_SPACE_SIZE      (1 << 16)
+#define STRESS_OPERATION_COUNT 20000
+
+TEST
+{
+    OffsetAllocator allocator(1000);
+    EXPECT_EQ(allocator.free_space(), 1000u);
+    EXPECT_EQ(allocator.largest_free_range(), 1000u);
+    EXPECT_FALSE(allocator.allocate(0).is_valid());
+    EXPECT_FALSE(allocator.allocate(1001).is_valid());
+
+    // Allocations are contiguous when the space is not fragmented
+    const auto a = allocator.allocate(100);
+    const auto b = allocator.allocate(300);
+    const auto c = allocator.allocate(600);
+    EXPECT_TRUE(a.is_valid() && b.is_valid() && c.is_valid());
+    EXPECT_EQ(a.offset, 0u);
+    EXPECT_EQ(b.offset, 100u);
+    EXPECT_EQ(c.offset, 400u);
+    EXPECT_EQ(allocator.free_space(), 0u);
+    EXPECT_FALSE(allocator.allocate(1).is_valid());
+
+    // A freed range is reused
+    allocator.free(b);
+    EXPECT_EQ(allocator.largest_free_range(), 300u);
+    const auto d = allocator.allocate(200);
+    EXPECT_EQ(d.offset, 100u);
+    EXPECT_EQ(allocator.largest_free_range(), 100u);
+
+    // A range that fits is found even if it is in a bin whose ranges are not all big enough (300 is in the bin of 256)
+    allocator.free(d);
+    const auto e = allocator.allocate(290);
+    EXPECT_EQ(e.offset, 100u);
+    allocator.free(e);
+
+    // Double free
+    EXPECT_THROWS(allocator.free(e));
+
+    // Free ranges are merged with both neighbors
+    allocator.free(a);
+    EXPECT_EQ(allocator.largest_free_range(), 400u);
+    allocator.free(c);
+    EXPECT_EQ(allocator.largest_free_range(), 1000u);
+    EXPECT_EQ(allocator.allocation_count(), 0u);
+    EXPECT_EQ(allocator.allocate(1000).offset, 0u);
+
+    allocator.reset(64);
+    EXPECT_EQ(allocator.size(), 64u);
+    EXPECT_EQ(allocator.allocate(64).offset, 0u);
+
+    // Stress: random allocations and frees must never overlap, and everything must merge back at the end
+    OffsetAllocator               stress_allocator(STRESS_SPACE_SIZE);
+    std::vector<OffsetAllocation> allocations;
+    std::vector<uint8_t>          owners(STRESS_SPACE_SIZE, 0);
+    std::mt19937                  random(42);
+    bool                          overlap = false;
+    for (uint32_t i = 0; i < STRESS_OPERATION_COUNT; i++)
+    {
+        if (allocations.empty() || random() % 3 != 0)
+        {
+            const auto allocation = stress_allocator.allocate(1 + random() % 1024);
+            if (allocation.is_valid())
+            {
+                for (uint32_t offset = allocation.offset; offset < allocation.offset + allocation.size; offset++)
+                {
+                    overlap = overlap || owners[offset] != 0;
+                    owners[offset] = 1;
+                }
+                allocations.push_back(allocation);
+            }
+        }
+        else
+        {
+            const auto index      = random() % allocations.size();
+            const auto allocation = allocations[index];
+            allocations[index]    = allocations.back();
+            allocations.pop_back();
+            for (uint32_t offset = allocation.offset; offset < allocation.offset + allocation.size; offset++)
+            {
+                owners[offset] = 0;
+            }
+            stress_allocator.free(allocation);
+        }
+    }
+    EXPECT_FALSE(overlap);
+
+    for (const auto &allocation : allocations)
+    {
+        stress_allocator.free(allocation);
+    }
+    EXPECT_EQ(stress_allocator.free_space(), static_cast<uint32_t>(STRESS_SPACE_SIZE));
+    EXPECT_EQ(stress_allocator.largest_free_range(), static_cast<uint32_t>(STRESS_SPACE_SIZE));
+}
@@ -0,0 +1,112 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <test_framework/test_framework.hpp>
+#include <thread>
+#include <vr_engine/utils/profiler.h>
+
+using namespace vre;
+
+std::string read_file(const char *path)
+{
+    std::string content;
+    FILE       *file = fopen(path, "r");
+    if (file)
+    {
+        char   buffer[4096];
+        size_t read_count;
+        while ((read_count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            content.append(buffer, read_count);
+        }
+        fclose(file);
+    }
+    return content;
+}
+
+size_t count_occurrences(const std::string &str, const std::string &pattern)
+{
+    size_t count = 0;
+    for (auto pos = str.find(pattern); pos != std::string::npos; pos = str.find(pattern, pos + pattern.size()))
+    {
+        count++;
+    }
+    return count;
+}
+
+TEST
+{
+    const char *path = "profiler_trace.json";
+
+    // The first zone is recorded before any other profiler call, so its start is older than the creation of the buffers
+    {
+        ProfilerZone zone("First");
+    }
+    EXPECT_TRUE(Profiler::export_chrome_trace(path));
+    auto       trace    = read_file(path);
+    const auto first_ts = trace.find("\"ts\":");
+    EXPECT_TRUE(first_ts != std::string::npos);
+    const double first_us = strtod(trace.c_str() + first_ts + 5, nullptr);
+    EXPECT_TRUE(first_us >= 0.0 && first_us < 60e6);
+
+    // Use the class directly, so that the test doesn't depend on ENABLE_PROFILER
+    Profiler::set_thread_name("Test thread");
+    for (int i = 0; i < 10; i++)
+    {
+        {
+            ProfilerZone zone("Outer");
+            ProfilerZone inner_zone("Inner \"quoted\"");
+        }
+        Profiler::counter("Counter", i);
+        Profiler::frame_mark();
+    }
+
+    // Events from other threads are collected too
+    std::thread(
+        []()
+        {
+            Profiler::set_thread_name("Worker thread");
+            ProfilerZone zone("Worker");
+        })
+        .join();
+
+    EXPECT_TRUE(Profiler::export_chrome_trace(path));
+    trace = read_file(path);
+
+    EXPECT_EQ(count_occurrences(trace, "\"name\":\"Outer\",\"ph\":\"X\""), static_cast<size_t>(10));
+    EXPECT_EQ(count_occurrences(trace, "\"name\":\"Inner \\\"quoted\\\"\",\"ph\":\"X\""), static_cast<size_t>(10));
+    EXPECT_EQ(count_occurrences(trace, "\"ph\":\"C\""), static_cast<size_t>(10));
+    EXPECT_EQ(count_occurrences(trace, "\"ph\":\"i\""), static_cast<size_t>(10));
+    EXPECT_EQ(count_occurrences(trace, "\"name\":\"Worker\""), static_cast<size_t>(1));
+    EXPECT_EQ(count_occurrences(trace, "\"args\":{\"name\":\"Test thread\"}"), static_cast<size_t>(1));
+    EXPECT_EQ(count_occurrences(trace, "\"args\":{\"name\":\"Worker thread\"}"), static_cast<size_t>(1));
+    EXPECT_EQ(Profiler::dropped_event_count(), static_cast<uint64_t>(0));
+
+    // The export drains the buffers
+    EXPECT_TRUE(Profiler::export_chrome_trace(path));
+    trace = read_file(path);
+    EXPECT_EQ(count_occurrences(trace, "\"ph\":\"X\""), static_cast<size_t>(0));
+
+    // Once drained, the buffer of the exited worker is reused by the next thread, without its name
+    std::thread([]() { ProfilerZone zone("Reused"); }).join();
+    // Non-finite counters are skipped, since JSON can't represent them
+    Profiler::counter("Not a number", std::nan(""));
+    Profiler::counter("Infinite", HUGE_VAL);
+    EXPECT_TRUE(Profiler::export_chrome_trace(path));
+    trace = read_file(path);
+    EXPECT_EQ(count_occurrences(trace, "\"name\":\"Reused\""), static_cast<size_t>(1));
+    EXPECT_EQ(count_occurrences(trace, "Worker thread"), static_cast<size_t>(0));
+    EXPECT_EQ(count_occurrences(trace, "\"ph\":\"C\""), static_cast<size_t>(0));
+
+    // Events are dropped instead of blocking when a buffer is full
+    for (int i = 0; i < 100000; i++)
+    {
+        ProfilerZone zone("Spam");
+    }
+    EXPECT_TRUE(Profiler::dropped_event_count() > 0);
+    Profiler::clear();
+    EXPECT_EQ(Profiler::dropped_event_count(), static_cast<uint64_t>(0));
+
+    remove(path);
+}
@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <test_framework/test_framework.hpp>
+#include <vr_engine/utils/profiler.h>
+
+using namespace vre;
+
+// Benchmark of the cost of a zone. Zones stay in the frame loop, so a zone must cost less than the budget. The budget is only
+// checked in optimized builds.
+
+#define ZONE_BUDGET_NS       50.0
+// Cost of a clock read on bare metal. Hypervisors that trap the reads make them much slower: the excess doesn't depend on the
+// profiler, so it is added to the budget for each of the two reads of a zone.
+#define NATIVE_CLOCK_NS      10.0
+// Zones recorded between two clears, so that the benchmark never measures the drops of a full buffer
+#define ZONES_BETWEEN_CLEARS 32768
+
+TEST
+{
+    // The first zone of the thread acquires its buffer
+    {
+        ProfilerZone zone("Warm-up");
+    }
+    Profiler::clear();
+
+    uint64_t ticks = 0;
+    BENCH("Profiler::now")
+    {
+        ticks += Profiler::now();
+    }
+    DO_NOT_OPTIMIZE(ticks);
+    const double clock_excess_ns = std::max(0.0, LAST_BENCH_RESULT.mean_ns - NATIVE_CLOCK_NS);
+
+    uint32_t zone_count = 0;
+    BENCH("ProfilerZone")
+    {
+        {
+            ProfilerZone zone("Zone");
+        }
+        if (++zone_count == ZONES_BETWEEN_CLEARS)
+        {
+            zone_count = 0;
+            Profiler::clear();
+        }
+    }
+    EXPECT_TRUE(LAST_BENCH_RESULT.allocations == 0.0);
+#ifdef NDEBUG
+    EXPECT_TRUE(LAST_BENCH_RESULT.mean_ns < ZONE_BUDGET_NS + 2.0 * clock_excess_ns);
+#endif
+    EXPECT_EQ(Profiler::dropped_event_count(), static_cast<uint64_t>(0));
+
+    Profiler::clear();
+}
@@ -0,0 +1,85 @@
+#include <memory>
+#include <string>
+#include <test_framework/test_framework.hpp>
+#include <vr_engine/utils/data/small_vector.h>
+
+using namespace vre;
+
+TEST
+{
+    // Inline storage
+    SmallVector<uint32_t, 4> vector;
+    EXPECT_TRUE(vector.empty());
+    EXPECT_EQ(vector.capacity(), static_cast<size_t>(4));
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        vector.push_back(i);
+    }
+    EXPECT_FALSE(vector.is_on_heap());
+    EXPECT_EQ(vector.size(), static_cast<size_t>(4));
+    EXPECT_EQ(vector[3], 3u);
+
+    // Spill to the heap, keeping the elements
+    vector.push_back(4);
+    EXPECT_TRUE(vector.is_on_heap());
+    EXPECT_EQ(vector.capacity(), static_cast<size_t>(8));
+    uint32_t sum = 0;
+    for (auto value : vector)
+    {
+        sum += value;
+    }
+    EXPECT_EQ(sum, 10u);
+
+    // The heap buffer is kept when cleared
+    vector.clear();
+    EXPECT_TRUE(vector.empty());
+    EXPECT_TRUE(vector.is_on_heap());
+
+    // Resize and initializer list
+    SmallVector<uint32_t, 2> resized(3, 7u);
+    EXPECT_EQ(resized.size(), static_cast<size_t>(3));
+    EXPECT_EQ(resized.back(), 7u);
+    resized.resize(1);
+    EXPECT_EQ(resized.size(), static_cast<size_t>(1));
+    resized.resize(2);
+    EXPECT_EQ(resized[1], 0u);
+    EXPECT_THROWS(resized.at(2));
+
+    SmallVector<const char *, 4> names = {"a", "b"};
+    EXPECT_EQ(names.size(), static_cast<size_t>(2));
+    EXPECT_EQ(std::string(names[1]), std::string("b"));
+
+    // Elements with a destructor, inline and on the heap
+    auto counter = std::make_shared<int>(0);
+    {
+        SmallVector<std::shared_ptr<int>, 2> pointers;
+        pointers.push_back(counter);
+        pointers.push_back(counter);
+        EXPECT_EQ(counter.use_count(), 3l);
+
+        // Copy
+        auto copy = pointers;
+        EXPECT_EQ(counter.use_count(), 5l);
+
+        // Move of an inline vector moves the elements
+        auto moved = std::move(copy);
+        EXPECT_EQ(counter.use_count(), 5l);
+        EXPECT_TRUE(copy.empty());
+
+        // Growth with an argument that points into the vector itself
+        pointers.push_back(pointers[0]);
+        EXPECT_TRUE(pointers.is_on_heap());
+        EXPECT_EQ(counter.use_count(), 6l);
+
+        // Move of a heap vector steals the buffer
+        const auto *buffer = pointers.data();
+        moved              = std::move(pointers);
+        EXPECT_EQ(counter.use_count(), 4l);
+        EXPECT_TRUE(moved.data() == buffer);
+        EXPECT_FALSE(pointers.is_on_heap());
+
+        moved.pop_back();
+        EXPECT_EQ(counter.use_count(), 3l);
+    }
+    EXPECT_EQ(counter.use_count(), 1l);
+}
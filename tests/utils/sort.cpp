@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <random>
+#include <test_framework/test_framework.hpp>
+#include <vector>
+#include <vr_engine/utils/sort.h>
+
+using namespace vre;
+
+TEST
+{
+    std::mt19937_64 random(42);
+
+    // Small inputs use the insertion sort, bigger ones the radix passes
+    for (size_t count : {0, 1, 10, 64, 65, 1000, 100000})
+    {
+        std::vector<uint64_t> keys(count);
+        for (auto &key : keys)
+        {
+            key = random();
+        }
+        auto expected = keys;
+        std::sort(expected.begin(), expected.end());
+
+        auto keys_11 = keys;
+        radix_sort(keys_11);
+        EXPECT_TRUE(keys_11 == expected);
+
+        auto keys_8 = keys;
+        radix_sort<8>(keys_8);
+        EXPECT_TRUE(keys_8 == expected);
+    }
+
+    // 32-bit keys, where only the low bits change: the passes on the high digits are skipped
+    std::vector<uint32_t> small_keys(5000);
+    for (auto &key : small_keys)
+    {
+        key = 0xAB000000 | static_cast<uint32_t>(random() & 0xFFF);
+    }
+    auto expected_small_keys = small_keys;
+    std::sort(expected_small_keys.begin(), expected_small_keys.end());
+    radix_sort(small_keys);
+    EXPECT_TRUE(small_keys == expected_small_keys);
+
+    // Key-value sort is stable: the values of equal keys stay in insertion order
+    std::vector<uint32_t> keys(20000);
+    std::vector<uint32_t> values(keys.size());
+    for (uint32_t i = 0; i < keys.size(); i++)
+    {
+        keys[i]   = static_cast<uint32_t>(random() % 100);
+        values[i] = i;
+    }
+    auto parallel_keys   = keys;
+    auto parallel_values = values;
+
+    std::vector<uint32_t> missing_values(keys.size() - 1);
+    EXPECT_THROWS(radix_sort(keys, missing_values));
+    EXPECT_THROWS(parallel_radix_sort(keys, missing_values));
+    radix_sort(keys, values);
+    bool is_stable = true;
+    for (size_t i = 1; i < keys.size(); i++)
+    {
+        is_stable = is_stable && (keys[i - 1] < keys[i] || (keys[i - 1] == keys[i] && values[i - 1] < values[i]));
+    }
+    EXPECT_TRUE(is_stable);
+
+    // The parallel sort must give the same result, even with more threads than cores
+    std::vector<uint64_t> big_keys(1 << 20);
+    for (auto &key : big_keys)
+    {
+        key = random() >> 8;
+    }
+    auto expected_big_keys = big_keys;
+    std::sort(expected_big_keys.begin(), expected_big_keys.end());
+    parallel_radix_sort(big_keys, 7);
+    EXPECT_TRUE(big_keys == expected_big_keys);
+
+    parallel_keys.resize(1 << 18);
+    parallel_values.resize(parallel_keys.size());
+    for (uint32_t i = 0; i < parallel_keys.size(); i++)
+    {
+        parallel_keys[i]   = static_cast<uint32_t>(random() % 1000);
+        parallel_values[i] = i;
+    }
+    parallel_radix_sort(parallel_keys, parallel_values, 4);
+    is_stable = true;
+    for (size_t i = 1; i < parallel_keys.size(); i++)
+    {
+        is_stable = is_stable
+                    && (parallel_keys[i - 1] < parallel_keys[i]
+                        || (parallel_keys[i - 1] == parallel_keys[i] && parallel_values[i - 1] < parallel_values[i]));
+    }
+    EXPECT_TRUE(is_stable);
+}
@@ -0,0 +1,94 @@
+#include <memory>
+#include <test_framework/test_framework.hpp>
+#include <thread>
+#include <vr_engine/utils/data/spsc_queue.h>
+
+using namespace vre;
+
+#define STRESS_VALUE_COUNT 200000
+
+TEST
+{
+    // Single thread
+    SpscQueue<uint32_t, 4> queue;
+    uint32_t               value = 0;
+    EXPECT_FALSE(queue.try_pop(value));
+    EXPECT_TRUE(queue.try_push(1u));
+    EXPECT_TRUE(queue.try_push(2u));
+    EXPECT_EQ(queue.size(), static_cast<size_t>(2));
+
+    // Batches are cut to the free room
+    const uint32_t batch[3] = {3, 4, 5};
+    EXPECT_EQ(queue.try_push(batch, 3), static_cast<size_t>(2));
+    EXPECT_FALSE(queue.try_push(6u));
+
+    uint32_t popped[8] = {};
+    EXPECT_EQ(queue.try_pop(popped, 8), static_cast<size_t>(4));
+    EXPECT_TRUE(popped[0] == 1 && popped[1] == 2 && popped[2] == 3 && popped[3] == 4);
+
+    // In place push, wrapping around the end of the ring
+    *queue.begin_push() = 7;
+    queue.end_push();
+    EXPECT_TRUE(queue.try_push(8u));
+    uint32_t sum = 0;
+    EXPECT_EQ(queue.consume_all([&](const uint32_t &consumed) { sum += consumed; }), static_cast<size_t>(2));
+    EXPECT_EQ(sum, 15u);
+    EXPECT_EQ(queue.size(), static_cast<size_t>(0));
+
+    EXPECT_TRUE(queue.try_push(9u));
+    queue.clear();
+    EXPECT_FALSE(queue.try_pop(value));
+
+    // Stress: the consumer must see every value exactly once, in order. Batches of various sizes mix the two kinds of operations.
+    auto stress_queue = std::make_unique<SpscQueue<uint64_t, 256>>();
+    std::thread producer(
+        [&]()
+        {
+            uint64_t next = 0;
+            uint64_t values[7];
+            while (next < STRESS_VALUE_COUNT)
+            {
+                size_t pushed_count = 0;
+                if (next % 3 == 0)
+                {
+                    pushed_count = stress_queue->try_push(next) ? 1 : 0;
+                }
+                else
+                {
+                    const auto count = std::min<uint64_t>(7, STRESS_VALUE_COUNT - next);
+                    for (uint64_t i = 0; i < count; i++)
+                    {
+                        values[i] = next + i;
+                    }
+                    pushed_count = stress_queue->try_push(values, count);
+                }
+                next += pushed_count;
+
+                // Let the consumer run when the queue is full, in case both threads share a core
+                if (pushed_count == 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+    uint64_t expected = 0;
+    bool     in_order = true;
+    uint64_t values[5];
+    while (expected < STRESS_VALUE_COUNT)
+    {
+        const auto count = stress_queue->try_pop(values, 5);
+        if (count == 0)
+        {
+            std::this_thread::yield();
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            in_order = in_order && values[i] == expected;
+            expected++;
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(stress_queue->size(), static_cast<size_t>(0));
+}
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <vr_engine/core/renderer/cooked_mesh.h>
+#include <vr_engine/core/renderer/mesh_optimizer.h>
+
+using namespace vre;
+
+/**
+ * Cooks a Wavefront OBJ mesh into the format loaded by the engine: see cooked_mesh.h for the optimizations and the vertex layout.
+ *
+ * Usage: asset_cooker [--overdraw-threshold <ratio>] <input.obj> <output.vrm>
+ *
+ * Polygons are triangulated as fans. The LODs are printed with their triangle count and error, along with the statistics of the
+ * vertex cache and of the vertex memory before and after.
+ */
+
+#define STATS_CACHE_SIZE 16
+
+struct ObjMesh
+{
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t>   indices;
+};
+
+/** Index of an OBJ attribute, which is 1-based, or relative to the end when negative. -1 if it is missing. */
+int32_t resolve_index(const std::string &token, size_t count)
+{
+    if (token.empty())
+    {
+        return -1;
+    }
+    const auto index    = std::stol(token);
+    const auto resolved = index < 0 ? static_cast<int64_t>(count) + index : index - 1;
+    if (resolved < 0 || resolved >= static_cast<int64_t>(count))
+    {
+        throw std::runtime_error("OBJ index out of range: " + token);
+    }
+    return static_cast<int32_t>(resolved);
+}
+
+ObjMesh load_obj(const char *path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open file \"" + std::string(path) + "\"");
+    }
+
+    std::vector<float>                         positions;
+    std::vector<float>                         normals;
+    std::vector<float>                         uvs;
+    std::map<std::array<int32_t, 3>, uint32_t> vertex_indices;
+    ObjMesh                                    mesh;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string        type;
+        stream >> type;
+        if (type == "v" || type == "vn")
+        {
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+            stream >> x >> y >> z;
+            auto &attribute = type == "v" ? positions : normals;
+            attribute.insert(attribute.end(), {x, y, z});
+        }
+        else if (type == "vt")
+        {
+            float u = 0.0f, v = 0.0f;
+            stream >> u >> v;
+            // OBJ has the origin of the texture at the bottom left, Vulkan at the top left
+            uvs.insert(uvs.end(), {u, 1.0f - v});
+        }
+        else if (type == "f")
+        {
+            // Each corner is position/uv/normal, where the uv and the normal are optional
+            std::vector<uint32_t> corners;
+            std::string           corner;
+            while (stream >> corner)
+            {
+                std::array<std::string, 3> tokens;
+                size_t                     token_index = 0;
+                for (const auto character : corner)
+                {
+                    if (character == '/')
+                    {
+                        token_index = std::min<size_t>(token_index + 1, 2);
+                    }
+                    else
+                    {
+                        tokens[token_index] += character;
+                    }
+                }
+                const std::array<int32_t, 3> key = {
+                    resolve_index(tokens[0], positions.size() / 3),
+                    resolve_index(tokens[1], uvs.size() / 2),
+                    resolve_index(tokens[2], normals.size() / 3),
+                };
+                if (key[0] < 0)
+                {
+                    throw std::runtime_error("OBJ face corner without a position: " + corner);
+                }
+
+                // Corners with the same attributes share their vertex
+                auto [it, inserted] = vertex_indices.emplace(key, static_cast<uint32_t>(mesh.vertices.size()));
+                if (inserted)
+                {
+                    MeshVertex vertex;
+                    memcpy(vertex.position, &positions[key[0] * 3], sizeof(vertex.position));
+                    if (key[1] >= 0)
+                    {
+                        memcpy(vertex.uv, &uvs[key[1] * 2], sizeof(vertex.uv));
+                    }
+                    if (key[2] >= 0)
+                    {
+                        memcpy(vertex.normal, &normals[key[2] * 3], sizeof(vertex.normal));
+                    }
+                    mesh.vertices.push_back(vertex);
+                }
+                corners.push_back(it->second);
+            }
+
+            for (size_t i = 2; i < corners.size(); i++)
+            {
+                mesh.indices.insert(mesh.indices.end(), {corners[0], corners[i - 1], corners[i]});
+            }
+        }
+    }
+    return mesh;
+}
+
+int main(int argc, char **argv)
+{
+    CookSettings settings;
+    const char  *input_path  = nullptr;
+    const char  *output_path = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--overdraw-threshold") == 0 && i + 1 < argc)
+        {
+            settings.overdraw_threshold = static_cast<float>(atof(argv[++i]));
+        }
+        else if (input_path == nullptr)
+        {
+            input_path = argv[i];
+        }
+        else
+        {
+            output_path = argv[i];
+        }
+    }
+
+    if (input_path == nullptr || output_path == nullptr)
+    {
+        fprintf(stderr, "Usage: asset_cooker [--overdraw-threshold <ratio>] <input.obj> <output.vrm>\n");
+        return 1;
+    }
+
+    try
+    {
+        const auto input = load_obj(input_path);
+        const auto mesh  = cook_mesh(input.vertices.data(),
+                                    input.vertices.size(),
+                                    input.indices.data(),
+                                    input.indices.size(),
+                                    settings);
+        save_cooked_mesh(output_path, mesh);
+
+        // The statistics of the cooked mesh are the ones of its full LOD
+        const auto full_index_count = mesh.lods[0].index_count;
+        const auto input_stats =
+            analyze_vertex_cache(input.indices.data(), input.indices.size(), input.vertices.size(), STATS_CACHE_SIZE);
+        const auto cooked_stats = analyze_vertex_cache(mesh.indices.data(), full_index_count, mesh.vertices.size(), STATS_CACHE_SIZE);
+        const auto input_bytes  = input.vertices.size() * sizeof(MeshVertex);
+        const auto cooked_bytes = mesh.vertices.size() * sizeof(CookedVertex);
+        printf("%s: %zu vertices, %u triangles\n", input_path, mesh.vertices.size(), full_index_count / 3);
+        printf("  ACMR          %.3f -> %.3f\n", input_stats.acmr, cooked_stats.acmr);
+        printf("  ATVR          %.3f -> %.3f\n", input_stats.atvr, cooked_stats.atvr);
+        printf("  Vertex bytes  %zu -> %zu\n", input_bytes, cooked_bytes);
+        printf("  Vertex fetch  %zu -> %zu bytes per frame\n",
+               input_stats.vertices_transformed * sizeof(MeshVertex),
+               cooked_stats.vertices_transformed * sizeof(CookedVertex));
+        for (size_t lod = 0; lod < mesh.lods.size(); lod++)
+        {
+            printf("  LOD %zu         %u triangles, error %g\n", lod, mesh.lods[lod].index_count / 3, mesh.lods[lod].error);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        fprintf(stderr, "Failed to cook \"%s\": %s\n", input_path, e.what());
+        return 1;
+    }
+    return 0;
+}
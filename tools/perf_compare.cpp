@@ -0,0 +1,121 @@
+#include <benchmark.h>
+#include <filesystem>
+
+using namespace vre::bench;
+
+/**
+ * Compares the results of several runs of a benchmark with a baseline. Used by the performance tests.
+ *
+ * The median of each phase is first reduced over the runs by taking their median, so that a single noisy run doesn't fail the
+ * comparison. The exit code is 1 if any phase is slower than the baseline by more than the tolerance.
+ *
+ * Usage: perf_compare --baseline <path> [--tolerance <fraction>] [--update] <run.json>...
+ *
+ * With --update, the baseline is replaced by the reduced results instead of being compared.
+ */
+
+std::vector<BenchmarkResult> reduce_runs(const std::vector<std::vector<BenchmarkResult>> &runs)
+{
+    std::vector<BenchmarkResult> reduced;
+    for (const auto &first : runs[0])
+    {
+        std::vector<double> medians;
+        std::vector<double> mins;
+        for (const auto &run : runs)
+        {
+            auto it = std::find_if(run.begin(), run.end(), [&](const BenchmarkResult &other) { return other.name == first.name; });
+            if (it != run.end())
+            {
+                medians.push_back(it->median_ns);
+                mins.push_back(it->min_ns);
+            }
+        }
+        std::sort(medians.begin(), medians.end());
+
+        reduced.push_back(BenchmarkResult {
+            .name       = first.name,
+            .median_ns  = medians[medians.size() / 2],
+            .min_ns     = *std::min_element(mins.begin(), mins.end()),
+            .iterations = first.iterations * static_cast<uint32_t>(medians.size()),
+        });
+    }
+    return reduced;
+}
+
+int main(int argc, char **argv)
+{
+    const char               *baseline_path = nullptr;
+    double                    tolerance     = 0.2;
+    bool                      update        = false;
+    std::vector<const char *> run_paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+        {
+            baseline_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+        {
+            tolerance = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--update") == 0)
+        {
+            update = true;
+        }
+        else
+        {
+            run_paths.push_back(argv[i]);
+        }
+    }
+
+    if (baseline_path == nullptr || run_paths.empty())
+    {
+        fprintf(stderr, "Usage: perf_compare --baseline <path> [--tolerance <fraction>] [--update] <run.json>...\n");
+        return 1;
+    }
+
+    std::vector<std::vector<BenchmarkResult>> runs;
+    for (const auto *path : run_paths)
+    {
+        auto run = read_results(path);
+        if (run.empty())
+        {
+            fprintf(stderr, "Failed to read results \"%s\"\n", path);
+            return 1;
+        }
+        runs.push_back(std::move(run));
+    }
+    const auto results = reduce_runs(runs);
+
+    if (update)
+    {
+        if (!write_results(baseline_path, std::filesystem::path(baseline_path).stem().string(), results))
+        {
+            fprintf(stderr, "Failed to write baseline \"%s\"\n", baseline_path);
+            return 1;
+        }
+        printf("Updated baseline \"%s\" from %zu runs.\n", baseline_path, runs.size());
+        return 0;
+    }
+
+    const auto baseline = read_results(baseline_path);
+    if (baseline.empty())
+    {
+        fprintf(stderr,
+                "Failed to read baseline \"%s\". Run the performance tests with VRE_UPDATE_PERF_BASELINES=1 to create it.\n",
+                baseline_path);
+        return 1;
+    }
+
+    const auto regression_count = compare_results(results, baseline, tolerance);
+    printf("\nMedian of %zu runs, tolerance %.0f%%.\n", runs.size(), tolerance * 100.0);
+    if (regression_count > 0)
+    {
+        printf("%u phase(s) regressed. If the slowdown is expected, refresh the baseline with VRE_UPDATE_PERF_BASELINES=1.\n",
+               regression_count);
+        return 1;
+    }
+    printf("No regression.\n");
+    return 0;
+}